@@ -1,606 +1,1172 @@
-/****************************************************************************
-Copyright (c) 2010 cocos2d-x.org
-
-http://www.cocos2d-x.org
-
-Permission is hereby granted, free of charge, to any person obtaining a copy
-of this software and associated documentation files (the "Software"), to deal
-in the Software without restriction, including without limitation the rights
-to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-copies of the Software, and to permit persons to whom the Software is
-furnished to do so, subject to the following conditions:
-
-The above copyright notice and this permission notice shall be included in
-all copies or substantial portions of the Software.
-
-THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
-IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
-FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
-AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
-LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
-THE SOFTWARE.
-****************************************************************************/
-
-#include <map>
-#include <string>
-#include <stdio.h>
-#include <unistd.h>
-
-#include <AL/al.h>
-#include <AL/alc.h>
-#include <AL/alut.h>
-#include <sys/stat.h>
-
-#ifndef DISABLE_VORBIS
-#include <vorbis/vorbisfile.h>
-#endif
-
-#include "SimpleAudioEngine.h"
-#include "cocos2d.h"
-USING_NS_CC;
-
-using namespace std;
-
-namespace CocosDenshion
-{
-	struct soundData {
-		ALuint buffer;
-		ALuint source;
-		bool   isLooped;
-	};
-
-	typedef map<string, soundData *> EffectsMap;
-	EffectsMap s_effects;
-
-	typedef enum {
-		PLAYING,
-		STOPPED,
-		PAUSED,
-	} playStatus;
-
-	static float s_volume 				   = 1.0f;
-	static float s_effectVolume			   = 1.0f;
-
-	struct backgroundMusicData {
-		ALuint buffer;
-		ALuint source;
-	};
-	typedef map<string, backgroundMusicData *> BackgroundMusicsMap;
-	BackgroundMusicsMap s_backgroundMusics;
-
-	static ALuint s_backgroundSource = AL_NONE;
-
-	static SimpleAudioEngine  *s_engine = 0;
-
-	static int checkALError(const char *funcName)
-	{
-		int err = alGetError();
-
-		if (err != AL_NO_ERROR)
-		{
-			switch (err)
-			{
-				case AL_INVALID_NAME:
-					fprintf(stderr, "AL_INVALID_NAME in %s\n", funcName);
-					break;
-
-				case AL_INVALID_ENUM:
-					fprintf(stderr, "AL_INVALID_ENUM in %s\n", funcName);
-					break;
-
-				case AL_INVALID_VALUE:
-					fprintf(stderr, "AL_INVALID_VALUE in %s\n", funcName);
-					break;
-
-				case AL_INVALID_OPERATION:
-					fprintf(stderr, "AL_INVALID_OPERATION in %s\n", funcName);
-					break;
-
-				case AL_OUT_OF_MEMORY:
-					fprintf(stderr, "AL_OUT_OF_MEMORY in %s\n", funcName);
-					break;
-			}
-		}
-
-		return err;
-	}
-
-    static void stopBackground(bool bReleaseData)
-    {
-		alSourceStop(s_backgroundSource);
-
-		if (bReleaseData)
-		{
-			for (BackgroundMusicsMap::iterator it = s_backgroundMusics.begin(); it != s_backgroundMusics.end(); ++it)
-			{
-				if (it->second->source == s_backgroundSource)
-				{
-					alDeleteBuffers(1, &it->second->buffer);
-					checkALError("stopBackground:alDeleteBuffers");
-					alDeleteSources(1, &it->second->source);
-					checkALError("stopBackground:alDeleteSources");
-					delete it->second;
-					s_backgroundMusics.erase(it);
-					break;
-				}
-			}
-		}
-
-		s_backgroundSource = AL_NONE;
-    }
-
-    static void setBackgroundVolume(float volume)
-    {
-    	alSourcef(s_backgroundSource, AL_GAIN, volume);
-    }
-
-	SimpleAudioEngine::SimpleAudioEngine()
-	{
-		alutInit(0, 0);
-	  checkALError("SimpleAudioEngine:alutInit");
-	}
-
-	SimpleAudioEngine::~SimpleAudioEngine()
-	{
-		alutExit();
-	}
-
-	SimpleAudioEngine* SimpleAudioEngine::sharedEngine()
-	{
-		if (!s_engine)
-			s_engine = new SimpleAudioEngine();
-        
-		return s_engine;
-	}
-
-	void SimpleAudioEngine::end()
-	{
-		checkALError("end:init");
-
-		// clear all the sounds
-	    EffectsMap::const_iterator end = s_effects.end();
-	    for (EffectsMap::iterator it = s_effects.begin(); it != end; it++)
-	    {
-	        alSourceStop(it->second->source);
-	        checkALError("end:alSourceStop");
-			alDeleteBuffers(1, &it->second->buffer);
-			checkALError("end:alDeleteBuffers");
-			alDeleteSources(1, &it->second->source);
-			checkALError("end:alDeleteSources");
-			delete it->second;
-	    }
-	    s_effects.clear();
-
-		// and the background too
-		stopBackground(true);
-
-		for (BackgroundMusicsMap::iterator it = s_backgroundMusics.begin(); it != s_backgroundMusics.end(); ++it)
-		{
-			alSourceStop(it->second->source);
-			checkALError("end:alSourceStop");
-			alDeleteBuffers(1, &it->second->buffer);
-			checkALError("end:alDeleteBuffers");
-			alDeleteSources(1, &it->second->source);
-			checkALError("end:alDeleteSources");
-			delete it->second;
-		}
-		s_backgroundMusics.clear();
-	}
-	
-#ifndef DISABLE_VORBIS
-
-	//
-	// OGG support
-	//
-	static bool isOGGFile(const char *pszFilePath)
-	{
-		FILE			*file;
-		OggVorbis_File   ogg_file;
-		int				 result;
-
-		file = fopen(pszFilePath, "rb");
-		result = ov_test(file, &ogg_file, 0, 0);
-		ov_clear(&ogg_file);
-
-		return (result == 0);
-	}
-
-	static ALuint createBufferFromOGG(const char *pszFilePath)
-	{
-		ALuint 			buffer;
-		OggVorbis_File  ogg_file;
-		vorbis_info*    info;
-		ALenum 			format;
-		int 			result;
-		int 			section;
-		unsigned int 	size = 0;
-
-		if (ov_fopen(pszFilePath, &ogg_file) < 0)
-		{
-			ov_clear(&ogg_file);
-			fprintf(stderr, "Could not open OGG file %s\n", pszFilePath);
-			return -1;
-		}
-
-		info = ov_info(&ogg_file, -1);
-
-		if (info->channels == 1)
-			format = AL_FORMAT_MONO16;
-		else
-			format = AL_FORMAT_STEREO16;
-
-		// size = #samples * #channels * 2 (for 16 bit)
-		unsigned int data_size = ov_pcm_total(&ogg_file, -1) * info->channels * 2;
-		char* data = new char[data_size];
-
-		while (size < data_size)
-		{
-			result = ov_read(&ogg_file, data + size, data_size - size, 0, 2, 1, &section);
-			if (result > 0)
-			{
-				size += result;
-			}
-			else if (result < 0)
-			{
-				delete [] data;
-				fprintf(stderr, "OGG file problem %s\n", pszFilePath);
-				return -1;
-			}
-			else
-			{
-				break;
-			}
-		}
-
-		if (size == 0)
-		{
-			delete [] data;
-			fprintf(stderr, "Unable to read OGG data\n");
-			return -1;
-		}
-
-		// clear al errors
-		checkALError("createBufferFromOGG:init");
-
-	    // Load audio data into a buffer.
-	    alGenBuffers(1, &buffer);
-
-	    if (checkALError("createBufferFromOGG:alGenBuffers") != AL_NO_ERROR)
-	    {
-	        fprintf(stderr, "Couldn't generate a buffer for OGG file\n");
-	        delete [] data;
-	        return buffer;
-	    }
-
-		alBufferData(buffer, format, data, data_size, info->rate);
-		checkALError("createBufferFromOGG:alBufferData");
-
-		delete [] data;
-		ov_clear(&ogg_file);
-
-		return buffer;
-	}
-#endif
-
-	//
-	// background audio
-	//
-    void SimpleAudioEngine::preloadBackgroundMusic(const char* pszFilePath)
-	{
-		// Changing file path to full path
-    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
-
-    	BackgroundMusicsMap::const_iterator it = s_backgroundMusics.find(fullPath);
-		if (it == s_backgroundMusics.end())
-		{
-			ALuint buffer = AL_NONE;
-#ifndef DISABLE_VORBIS			
-			if (isOGGFile(fullPath.data()))
-			{
-				buffer = createBufferFromOGG(fullPath.data());
-			}
-			else
-#endif			
-				buffer = alutCreateBufferFromFile(fullPath.data());
-			
-
-			checkALError("preloadBackgroundMusic:createBuffer");
-
-			if (buffer == AL_NONE)
-			{
-				fprintf(stderr, "Error loading file: '%s'\n", fullPath.data());
-				alDeleteBuffers(1, &buffer);
-				return;
-			}
-
-			ALuint source = AL_NONE;
-			alGenSources(1, &source);
-			checkALError("preloadBackgroundMusic:alGenSources");
-
-			alSourcei(source, AL_BUFFER, buffer);
-			checkALError("preloadBackgroundMusic:alSourcei");
-
-			backgroundMusicData* data = new backgroundMusicData();
-			data->buffer = buffer;
-			data->source = source;
-			s_backgroundMusics.insert(BackgroundMusicsMap::value_type(fullPath, data));
-		}
-	}
-
-	void SimpleAudioEngine::playBackgroundMusic(const char* pszFilePath, bool bLoop)
-	{
-		if (s_backgroundSource != AL_NONE)
-			stopBackgroundMusic(false);
-
-		// Changing file path to full path
-    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
-
-    	BackgroundMusicsMap::const_iterator it = s_backgroundMusics.find(fullPath);
-		if (it == s_backgroundMusics.end())
-		{
-			preloadBackgroundMusic(fullPath.c_str());
-			it = s_backgroundMusics.find(fullPath);
-		}
-
-		if (it != s_backgroundMusics.end())
-		{
-			s_backgroundSource = it->second->source;
-			alSourcei(s_backgroundSource, AL_LOOPING, bLoop ? AL_TRUE : AL_FALSE);
-			alSourcePlay(s_backgroundSource);
-			checkALError("playBackgroundMusic:alSourcePlay");
-		}
-	}
-
-	void SimpleAudioEngine::stopBackgroundMusic(bool bReleaseData)
-	{
-		stopBackground(bReleaseData);
-	}
-
-	void SimpleAudioEngine::pauseBackgroundMusic()
-	{
-		ALint state;
-		alGetSourcei(s_backgroundSource, AL_SOURCE_STATE, &state);
-		if (state == AL_PLAYING)
-			alSourcePause(s_backgroundSource);
-		checkALError("pauseBackgroundMusic:alSourcePause");
-	}
-
-	void SimpleAudioEngine::resumeBackgroundMusic()
-	{
-		ALint state;
-		alGetSourcei(s_backgroundSource, AL_SOURCE_STATE, &state);
-		if (state == AL_PAUSED)
-			alSourcePlay(s_backgroundSource);
-		checkALError("resumeBackgroundMusic:alSourcePlay");
-	} 
-
-	void SimpleAudioEngine::rewindBackgroundMusic()
-	{
-		alSourceRewind(s_backgroundSource);
-		checkALError("rewindBackgroundMusic:alSourceRewind");
-	}
-
-	bool SimpleAudioEngine::willPlayBackgroundMusic()
-	{
-		return true;
-	}
-
-	bool SimpleAudioEngine::isBackgroundMusicPlaying()
-	{
-	    ALint play_status;
-	    alGetSourcei(s_backgroundSource, AL_SOURCE_STATE, &play_status);
-
-		return (play_status == AL_PLAYING);
-	}
-
-	float SimpleAudioEngine::getBackgroundMusicVolume()
-	{
-		return s_volume;
-	}
-
-	void SimpleAudioEngine::setBackgroundMusicVolume(float volume)
-	{
-		if (s_volume != volume && volume >= -0.0001 && volume <= 1.0001)
-		{
-    		s_volume = volume;
-
-			setBackgroundVolume(volume);
-		}
-	}
-
-	//
-	// Effect audio (using OpenAL)
-	//
-	float SimpleAudioEngine::getEffectsVolume()
-	{
-		return s_effectVolume;
-	}
-
-	void SimpleAudioEngine::setEffectsVolume(float volume)
-	{
-		if (volume != s_effectVolume)
-		{
-			EffectsMap::const_iterator end = s_effects.end();
-			for (EffectsMap::const_iterator it = s_effects.begin(); it != end; it++)
-			{
-				alSourcef(it->second->source, AL_GAIN, volume);
-			}
-
-			s_effectVolume = volume;
-		}
-	}
-
-	unsigned int SimpleAudioEngine::playEffect(const char* pszFilePath, bool bLoop)
-	{
-		// Changing file path to full path
-    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
-
-		EffectsMap::iterator iter = s_effects.find(fullPath);
-
-		if (iter == s_effects.end())
-		{
-			preloadEffect(fullPath.c_str());
-
-			// let's try again
-			iter = s_effects.find(fullPath);
-			if (iter == s_effects.end())
-			{
-				fprintf(stderr, "could not find play sound %s\n", fullPath.c_str());
-				return -1;
-			}
-		}
-
-		checkALError("playEffect:init");
-		iter->second->isLooped = bLoop;
-		alSourcei(iter->second->source, AL_LOOPING, iter->second->isLooped ? AL_TRUE : AL_FALSE);
-		alSourcePlay(iter->second->source);
-		checkALError("playEffect:alSourcePlay");
-
-		return iter->second->source;
-	}
-
-	void SimpleAudioEngine::stopEffect(unsigned int nSoundId)
-	{
-		alSourceStop(nSoundId);
-		checkALError("stopEffect:alSourceStop");
-	}
-
-	void SimpleAudioEngine::preloadEffect(const char* pszFilePath)
-	{
-		// Changing file path to full path
-    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
-
-		EffectsMap::iterator iter = s_effects.find(fullPath);
-
-		// check if we have this already
-		if (iter == s_effects.end())
-		{
-			ALuint 		buffer;
-			ALuint 		source;
-			soundData  *data = new soundData;
-			string 	    path = fullPath;
-
-			checkALError("preloadEffect:init");
-#ifndef DISABLE_VORBIS
-			if (isOGGFile(path.data()))
-			{
-				buffer = createBufferFromOGG(path.data());
-			}
-			else
-#endif			
-			{
-				buffer = alutCreateBufferFromFile(path.data());
-				checkALError("preloadEffect:createBufferFromFile");
-			}
-
-			if (buffer == AL_NONE)
-			{
-				fprintf(stderr, "Error loading file: '%s'\n", path.data());
-				alDeleteBuffers(1, &buffer);
-				return;
-			}
-
-			alGenSources(1, &source);
-
-			if (checkALError("preloadEffect:alGenSources") != AL_NO_ERROR)
-			{
-				alDeleteBuffers(1, &buffer);
-				return;
-			}
-
-			alSourcei(source, AL_BUFFER, buffer);
-			checkALError("preloadEffect:alSourcei");
-
-			data->isLooped = false;
-			data->buffer = buffer;
-			data->source = source;
-
-			s_effects.insert(EffectsMap::value_type(fullPath, data));
-		}
-	}
-
-	void SimpleAudioEngine::unloadEffect(const char* pszFilePath)
-	{
-		// Changing file path to full path
-    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
-    	
-		EffectsMap::iterator iter = s_effects.find(fullPath);
-
-		if (iter != s_effects.end())
-	    {
-			checkALError("unloadEffect:init");
-
-	        alSourceStop(iter->second->source);
-	        checkALError("unloadEffect:alSourceStop");
-
-			alDeleteSources(1, &iter->second->source);
-			checkALError("unloadEffect:DeletSources");
-
-			alDeleteBuffers(1, &iter->second->buffer);
-			checkALError("unloadEffect:alDeleteBuffers");
-			delete iter->second;
-
-			s_effects.erase(iter);
-	    }
-	}
-
-	void SimpleAudioEngine::pauseEffect(unsigned int nSoundId)
-	{
-		ALint state;
-		alGetSourcei(nSoundId, AL_SOURCE_STATE, &state);
-		if (state == AL_PLAYING)
-			alSourcePause(nSoundId);
-		checkALError("pauseEffect:alSourcePause");
-	}
-
-	void SimpleAudioEngine::pauseAllEffects()
-	{
-		EffectsMap::iterator iter = s_effects.begin();
-		ALint state;
-		while (iter != s_effects.end())
-	    {
-			alGetSourcei(iter->second->source, AL_SOURCE_STATE, &state);
-			if (state == AL_PLAYING)
-				alSourcePause(iter->second->source);
-			checkALError("pauseAllEffects:alSourcePause");
-			++iter;
-	    }
-	}
-
-	void SimpleAudioEngine::resumeEffect(unsigned int nSoundId)
-	{
-		ALint state;
-		alGetSourcei(nSoundId, AL_SOURCE_STATE, &state);
-		if (state == AL_PAUSED)
-			alSourcePlay(nSoundId);
-		checkALError("resumeEffect:alSourcePlay");
-	}
-
-	void SimpleAudioEngine::resumeAllEffects()
-	{
-		EffectsMap::iterator iter = s_effects.begin();
-		ALint state;
-		while (iter != s_effects.end())
-	    {
-			alGetSourcei(iter->second->source, AL_SOURCE_STATE, &state);
-			if (state == AL_PAUSED)
-				alSourcePlay(iter->second->source);
-			checkALError("resumeAllEffects:alSourcePlay");
-			++iter;
-	    }
-	}
-
-    void SimpleAudioEngine::stopAllEffects()
-    {
-		EffectsMap::iterator iter = s_effects.begin();
-
-		if (iter != s_effects.end())
-	    {
-			checkALError("stopAllEffects:init");
-	        alSourceStop(iter->second->source);
-			checkALError("stopAllEffects:alSourceStop");
-	    }
-    }
-
-}
+/****************************************************************************
+Copyright (c) 2010 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include <map>
+#include <string>
+#include <stdio.h>
+#include <unistd.h>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+
+#include <AL/al.h>
+#include <AL/alc.h>
+#include <AL/alut.h>
+#include <sys/stat.h>
+
+#ifndef DISABLE_VORBIS
+#include <vorbis/vorbisfile.h>
+#endif
+
+#include "SimpleAudioEngine.h"
+#include "cocos2d.h"
+USING_NS_CC;
+
+using namespace std;
+
+// sources allocated for the effects, a new effect steals a voice when they are all playing
+#ifndef CC_OPENAL_EFFECT_VOICES
+#define CC_OPENAL_EFFECT_VOICES 24
+#endif
+
+// bytes of decoded effects kept in OpenAL buffers, the least recently played are unloaded first
+#ifndef CC_OPENAL_EFFECT_CACHE_SIZE
+#define CC_OPENAL_EFFECT_CACHE_SIZE (16 * 1024 * 1024)
+#endif
+
+// the OGG music is decoded into a queue of small buffers, 4 x 64KB hold about 1.5s of 44.1kHz stereo
+#define MUSIC_STREAM_BUFFERS 4
+#define MUSIC_STREAM_BUFFER_SIZE (64 * 1024)
+
+// interval of the streaming thread, well below the duration of a buffer
+#define MUSIC_STREAM_UPDATE_MS 20
+
+namespace CocosDenshion
+{
+	/*
+	 Effects are decoded once into an OpenAL buffer and played by a fixed pool of sources,
+	 the voices. When every voice is busy, the voice with the lowest priority, the oldest one
+	 among equals, is stolen. Looped effects have a higher priority than the others, so a new
+	 shot never cuts an engine or an ambience loop. The buffers form a cache with a byte budget,
+	 the least recently played effects not heard at the moment are unloaded when it is full.
+
+	 The OGG music is not decoded at once, a thread keeps a few small buffers queued on its
+	 source and decodes the next part of the file into each buffer the source is done with.
+	 Other formats are loaded whole by alut.
+	 */
+	struct soundData {
+		ALuint       buffer;
+		unsigned int size;      // bytes of PCM in the buffer
+		unsigned int lastUse;   // serial of the last play
+	};
+
+	typedef map<string, soundData *> EffectsMap;
+	EffectsMap s_effects;
+
+	struct effectVoice {
+		ALuint       source;
+		unsigned int soundId;   // returned by playEffect, 0 when the voice is free
+		soundData   *sound;
+		int          priority;
+		unsigned int started;   // serial of the play, the oldest voice is stolen first
+	};
+
+	static effectVoice  s_voices[CC_OPENAL_EFFECT_VOICES];
+	static bool         s_voicesCreated = false;
+	static unsigned int s_effectSerial = 0;
+	static unsigned int s_lastSoundId = 0;
+	static unsigned int s_effectCacheBytes = 0;
+
+	typedef enum {
+		PLAYING,
+		STOPPED,
+		PAUSED,
+	} playStatus;
+
+	static float s_volume 				   = 1.0f;
+	static float s_effectVolume			   = 1.0f;
+
+	struct backgroundMusicData {
+		ALuint buffer;          // the whole file, when the music is not streamed
+		ALuint source;
+		bool   isStreamed;
+		bool   isLooped;
+#ifndef DISABLE_VORBIS
+		OggVorbis_File ogg;
+		ALuint streamBuffers[MUSIC_STREAM_BUFFERS];
+		ALenum format;
+		ALsizei rate;
+		bool   isPrimed;        // the first buffers are queued, ready to play
+		bool   isEnded;         // decoded to the end of the file, the queue plays out
+#endif
+	};
+	typedef map<string, backgroundMusicData *> BackgroundMusicsMap;
+	BackgroundMusicsMap s_backgroundMusics;
+
+	// the streaming thread only touches the music played, it is changed with both mutexes
+	// below locked, so either one is enough to read it
+	static backgroundMusicData *s_backgroundMusic = NULL;
+	static playStatus           s_backgroundStatus = STOPPED;
+	// guards the decoders of the musics, always locked before s_alMutex. The streaming thread
+	// decodes with only this one locked, so the effects don't wait for a decode
+	static std::mutex           s_musicMutex;
+	// alGetError() reports the errors of the whole context, both threads call OpenAL with this locked
+	// so that an error is checked by the call that raised it
+	static std::mutex           s_alMutex;
+	static std::condition_variable s_musicCondition;   // waited on with s_musicMutex
+	static std::thread         *s_musicThread = NULL;   // a pointer, apps may exit without calling end()
+	static bool                 s_musicThreadQuit = false;
+
+	static SimpleAudioEngine  *s_engine = 0;
+
+	static int checkALError(const char *funcName)
+	{
+		int err = alGetError();
+
+		if (err != AL_NO_ERROR)
+		{
+			switch (err)
+			{
+				case AL_INVALID_NAME:
+					fprintf(stderr, "AL_INVALID_NAME in %s\n", funcName);
+					break;
+
+				case AL_INVALID_ENUM:
+					fprintf(stderr, "AL_INVALID_ENUM in %s\n", funcName);
+					break;
+
+				case AL_INVALID_VALUE:
+					fprintf(stderr, "AL_INVALID_VALUE in %s\n", funcName);
+					break;
+
+				case AL_INVALID_OPERATION:
+					fprintf(stderr, "AL_INVALID_OPERATION in %s\n", funcName);
+					break;
+
+				case AL_OUT_OF_MEMORY:
+					fprintf(stderr, "AL_OUT_OF_MEMORY in %s\n", funcName);
+					break;
+			}
+		}
+
+		return err;
+	}
+
+	//
+	// OGG support
+	//
+#ifndef DISABLE_VORBIS
+	static bool isOGGFile(const char *pszFilePath)
+	{
+		FILE			*file;
+		OggVorbis_File   ogg_file;
+		int				 result;
+
+		file = fopen(pszFilePath, "rb");
+		if (!file)
+			return false;
+
+		// the file belongs to ogg_file once the test succeeded
+		result = ov_test(file, &ogg_file, 0, 0);
+		if (result == 0)
+			ov_clear(&ogg_file);
+		else
+			fclose(file);
+
+		return (result == 0);
+	}
+
+	static ALuint createBufferFromOGG(const char *pszFilePath)
+	{
+		ALuint 			buffer = AL_NONE;
+		OggVorbis_File  ogg_file;
+		vorbis_info*    info;
+		ALenum 			format;
+		int 			result;
+		int 			section;
+		unsigned int 	size = 0;
+
+		if (ov_fopen(pszFilePath, &ogg_file) < 0)
+		{
+			fprintf(stderr, "Could not open OGG file %s\n", pszFilePath);
+			return AL_NONE;
+		}
+
+		info = ov_info(&ogg_file, -1);
+
+		if (info->channels == 1)
+			format = AL_FORMAT_MONO16;
+		else
+			format = AL_FORMAT_STEREO16;
+
+		// size = #samples * #channels * 2 (for 16 bit)
+		unsigned int data_size = ov_pcm_total(&ogg_file, -1) * info->channels * 2;
+		char* data = new char[data_size];
+
+		while (size < data_size)
+		{
+			result = ov_read(&ogg_file, data + size, data_size - size, 0, 2, 1, &section);
+			if (result > 0)
+			{
+				size += result;
+			}
+			else if (result < 0)
+			{
+				delete [] data;
+				ov_clear(&ogg_file);
+				fprintf(stderr, "OGG file problem %s\n", pszFilePath);
+				return AL_NONE;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (size == 0)
+		{
+			delete [] data;
+			ov_clear(&ogg_file);
+			fprintf(stderr, "Unable to read OGG data\n");
+			return AL_NONE;
+		}
+
+		std::lock_guard<std::mutex> lock(s_alMutex);
+
+		// clear al errors
+		checkALError("createBufferFromOGG:init");
+
+	    // Load audio data into a buffer.
+	    alGenBuffers(1, &buffer);
+
+	    if (checkALError("createBufferFromOGG:alGenBuffers") != AL_NO_ERROR)
+	    {
+	        fprintf(stderr, "Couldn't generate a buffer for OGG file\n");
+	        delete [] data;
+	        ov_clear(&ogg_file);
+	        return AL_NONE;
+	    }
+
+		alBufferData(buffer, format, data, size, info->rate);
+		checkALError("createBufferFromOGG:alBufferData");
+
+		delete [] data;
+		ov_clear(&ogg_file);
+
+		return buffer;
+	}
+
+	/** decodes the next part of the music into pcm, returns 0 at the end of a music not looped */
+	static int decodeMusic(backgroundMusicData *music, char *pcm)
+	{
+		int size = 0;
+		bool rewound = false;
+
+		while (size < MUSIC_STREAM_BUFFER_SIZE)
+		{
+			int section;
+			long result = ov_read(&music->ogg, pcm + size, MUSIC_STREAM_BUFFER_SIZE - size, 0, 2, 1, &section);
+			if (result > 0)
+			{
+				size += result;
+				rewound = false;
+			}
+			else if (result == 0 && music->isLooped && !rewound && ov_pcm_seek(&music->ogg, 0) == 0)
+			{
+				// an empty file would loop forever, rewind once without data in between
+				rewound = true;
+			}
+			else
+			{
+				if (result < 0)
+					fprintf(stderr, "OGG stream problem\n");
+				music->isEnded = true;
+				break;
+			}
+		}
+		return size;
+	}
+
+	/** decodes the next part of the music into buffer, false at the end of a music not looped */
+	static bool fillMusicBuffer(backgroundMusicData *music, ALuint buffer)
+	{
+		// only used by the main thread, with s_alMutex locked
+		static char pcm[MUSIC_STREAM_BUFFER_SIZE];
+		int size = decodeMusic(music, pcm);
+		if (size == 0)
+			return false;
+
+		alBufferData(buffer, music->format, pcm, size, music->rate);
+		return checkALError("fillMusicBuffer:alBufferData") == AL_NO_ERROR;
+	}
+
+	/** rewinds the music and queues its first buffers */
+	static void primeMusicStream(backgroundMusicData *music)
+	{
+		alSourceStop(music->source);
+		// unqueues all the buffers
+		alSourcei(music->source, AL_BUFFER, 0);
+		checkALError("primeMusicStream:unqueue");
+
+		ov_pcm_seek(&music->ogg, 0);
+		music->isEnded = false;
+
+		for (int i = 0; i < MUSIC_STREAM_BUFFERS && !music->isEnded; ++i)
+		{
+			if (!fillMusicBuffer(music, music->streamBuffers[i]))
+				break;
+			alSourceQueueBuffers(music->source, 1, &music->streamBuffers[i]);
+			checkALError("primeMusicStream:alSourceQueueBuffers");
+		}
+		music->isPrimed = true;
+	}
+
+	/** refills the buffers the source played, s_alMutex is only locked around the OpenAL calls */
+	static void updateMusicStream(backgroundMusicData *music)
+	{
+		// only used by the streaming thread
+		static char pcm[MUSIC_STREAM_BUFFER_SIZE];
+		ALuint buffers[MUSIC_STREAM_BUFFERS];
+		ALint processed = 0;
+		{
+			std::lock_guard<std::mutex> lock(s_alMutex);
+			checkALError("updateMusicStream:init");
+			alGetSourcei(music->source, AL_BUFFERS_PROCESSED, &processed);
+			if (processed > MUSIC_STREAM_BUFFERS)
+				processed = MUSIC_STREAM_BUFFERS;
+			if (processed > 0)
+				alSourceUnqueueBuffers(music->source, processed, buffers);
+			checkALError("updateMusicStream:unqueue");
+		}
+
+		for (ALint i = 0; i < processed && !music->isEnded; ++i)
+		{
+			int size = decodeMusic(music, pcm);
+			if (size == 0)
+				break;
+
+			std::lock_guard<std::mutex> lock(s_alMutex);
+			alBufferData(buffers[i], music->format, pcm, size, music->rate);
+			if (checkALError("updateMusicStream:alBufferData") == AL_NO_ERROR)
+			{
+				alSourceQueueBuffers(music->source, 1, &buffers[i]);
+				checkALError("updateMusicStream:alSourceQueueBuffers");
+			}
+		}
+	}
+#endif
+
+	/** called by the streaming thread with s_musicMutex locked */
+	static void updateBackgroundMusic()
+	{
+		backgroundMusicData *music = s_backgroundMusic;
+		if (!music || s_backgroundStatus != PLAYING)
+			return;
+
+#ifndef DISABLE_VORBIS
+		if (music->isStreamed)
+			updateMusicStream(music);
+#endif
+
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		checkALError("updateBackgroundMusic:init");
+		ALint queued = 0;
+#ifndef DISABLE_VORBIS
+		if (music->isStreamed)
+			alGetSourcei(music->source, AL_BUFFERS_QUEUED, &queued);
+#endif
+
+		ALint state;
+		alGetSourcei(music->source, AL_SOURCE_STATE, &state);
+		if (state != AL_PLAYING)
+		{
+			if (queued > 0)
+			{
+				// the decoding fell behind and the source ran dry
+				CCLOG("background music underrun");
+				alSourcePlay(music->source);
+			}
+			else
+			{
+				s_backgroundStatus = STOPPED;
+			}
+		}
+	}
+
+	static void musicStreamLoop()
+	{
+		std::unique_lock<std::mutex> lock(s_musicMutex);
+		while (!s_musicThreadQuit)
+		{
+			if (s_backgroundMusic && s_backgroundStatus == PLAYING)
+			{
+				updateBackgroundMusic();
+				s_musicCondition.wait_for(lock, std::chrono::milliseconds(MUSIC_STREAM_UPDATE_MS));
+			}
+			else
+			{
+				// woken when a music is played or resumed
+				s_musicCondition.wait(lock);
+			}
+		}
+	}
+
+	static void startMusicThread()
+	{
+		if (!s_musicThread)
+		{
+			s_musicThreadQuit = false;
+			s_musicThread = new std::thread(musicStreamLoop);
+		}
+	}
+
+	static void stopMusicThread()
+	{
+		if (s_musicThread)
+		{
+			{
+				std::lock_guard<std::mutex> lock(s_musicMutex);
+				s_musicThreadQuit = true;
+			}
+			s_musicCondition.notify_one();
+			s_musicThread->join();
+			delete s_musicThread;
+			s_musicThread = NULL;
+		}
+	}
+
+	// Joins the streaming thread when the app exits without calling end(),
+	// it is destroyed before the mutexes and the condition the thread waits on.
+	static struct MusicThreadGuard
+	{
+		~MusicThreadGuard()
+		{
+			stopMusicThread();
+		}
+	} s_musicThreadGuard;
+
+	static void deleteBackgroundMusic(backgroundMusicData *music)
+	{
+		alSourceStop(music->source);
+		checkALError("deleteBackgroundMusic:alSourceStop");
+		alDeleteSources(1, &music->source);
+		checkALError("deleteBackgroundMusic:alDeleteSources");
+#ifndef DISABLE_VORBIS
+		if (music->isStreamed)
+		{
+			alDeleteBuffers(MUSIC_STREAM_BUFFERS, music->streamBuffers);
+			checkALError("deleteBackgroundMusic:alDeleteBuffers");
+			ov_clear(&music->ogg);
+		}
+		else
+#endif
+		{
+			alDeleteBuffers(1, &music->buffer);
+			checkALError("deleteBackgroundMusic:alDeleteBuffers");
+		}
+		delete music;
+	}
+
+    static void stopBackground(bool bReleaseData)
+    {
+		std::lock_guard<std::mutex> musicLock(s_musicMutex);
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		if (!s_backgroundMusic)
+			return;
+
+		alSourceStop(s_backgroundMusic->source);
+#ifndef DISABLE_VORBIS
+		s_backgroundMusic->isPrimed = false;
+#endif
+
+		if (bReleaseData)
+		{
+			for (BackgroundMusicsMap::iterator it = s_backgroundMusics.begin(); it != s_backgroundMusics.end(); ++it)
+			{
+				if (it->second == s_backgroundMusic)
+				{
+					deleteBackgroundMusic(it->second);
+					s_backgroundMusics.erase(it);
+					break;
+				}
+			}
+		}
+
+		s_backgroundMusic = NULL;
+		s_backgroundStatus = STOPPED;
+    }
+
+	//
+	// effect voices and cache
+	//
+	static void createVoices()
+	{
+		if (s_voicesCreated)
+			return;
+
+		checkALError("createVoices:init");
+		for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+		{
+			effectVoice& voice = s_voices[i];
+			alGenSources(1, &voice.source);
+			if (checkALError("createVoices:alGenSources") != AL_NO_ERROR)
+				voice.source = AL_NONE;
+			voice.soundId = 0;
+			voice.sound = NULL;
+			voice.priority = 0;
+			voice.started = 0;
+		}
+		s_voicesCreated = true;
+	}
+
+	static void deleteVoices()
+	{
+		if (!s_voicesCreated)
+			return;
+
+		for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+		{
+			if (s_voices[i].source == AL_NONE)
+				continue;
+			alSourceStop(s_voices[i].source);
+			alDeleteSources(1, &s_voices[i].source);
+			checkALError("deleteVoices:alDeleteSources");
+		}
+		s_voicesCreated = false;
+	}
+
+	/** true while the voice is heard or paused, a finished voice is released */
+	static bool isVoiceActive(effectVoice& voice)
+	{
+		if (voice.soundId == 0)
+			return false;
+
+		ALint state;
+		alGetSourcei(voice.source, AL_SOURCE_STATE, &state);
+		if (state == AL_PLAYING || state == AL_PAUSED)
+			return true;
+
+		voice.soundId = 0;
+		voice.sound = NULL;
+		return false;
+	}
+
+	static effectVoice* findVoice(unsigned int nSoundId)
+	{
+		if (!s_voicesCreated || nSoundId == 0)
+			return NULL;
+
+		for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+		{
+			if (s_voices[i].soundId == nSoundId)
+				return &s_voices[i];
+		}
+		return NULL;
+	}
+
+	/** a free voice, or the one to steal for an effect of this priority, NULL when all the voices matter more */
+	static effectVoice* allocateVoice(int priority)
+	{
+		effectVoice *victim = NULL;
+		for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+		{
+			effectVoice& voice = s_voices[i];
+			if (voice.source == AL_NONE)
+				continue;
+			if (!isVoiceActive(voice))
+				return &voice;
+
+			if (!victim || voice.priority < victim->priority
+				|| (voice.priority == victim->priority && voice.started < victim->started))
+			{
+				victim = &voice;
+			}
+		}
+
+		if (victim && victim->priority <= priority)
+		{
+			CCLOG("effect voices exhausted, stealing sound %u", victim->soundId);
+			alSourceStop(victim->source);
+			victim->soundId = 0;
+			victim->sound = NULL;
+			return victim;
+		}
+		return NULL;
+	}
+
+	static bool isSoundPlaying(soundData *sound)
+	{
+		if (!s_voicesCreated)
+			return false;
+
+		for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+		{
+			if (s_voices[i].sound == sound && isVoiceActive(s_voices[i]))
+				return true;
+		}
+		return false;
+	}
+
+	/** stops the voices playing the effect and deletes its buffer */
+	static void deleteSound(soundData *sound)
+	{
+		if (s_voicesCreated)
+		{
+			for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+			{
+				effectVoice& voice = s_voices[i];
+				if (voice.source == AL_NONE)
+					continue;
+
+				ALint buffer = AL_NONE;
+				alGetSourcei(voice.source, AL_BUFFER, &buffer);
+				if (voice.sound == sound || (ALuint)buffer == sound->buffer)
+				{
+					// a buffer attached to a source can not be deleted
+					alSourceStop(voice.source);
+					alSourcei(voice.source, AL_BUFFER, 0);
+					voice.soundId = 0;
+					voice.sound = NULL;
+				}
+			}
+		}
+
+		alDeleteBuffers(1, &sound->buffer);
+		checkALError("deleteSound:alDeleteBuffers");
+		s_effectCacheBytes -= sound->size;
+		delete sound;
+	}
+
+	/** unloads the least recently played effects until the cache fits its budget */
+	static void trimEffectCache(soundData *keep)
+	{
+		while (s_effectCacheBytes > CC_OPENAL_EFFECT_CACHE_SIZE)
+		{
+			EffectsMap::iterator oldest = s_effects.end();
+			for (EffectsMap::iterator it = s_effects.begin(); it != s_effects.end(); ++it)
+			{
+				if (it->second == keep || isSoundPlaying(it->second))
+					continue;
+				if (oldest == s_effects.end() || it->second->lastUse < oldest->second->lastUse)
+					oldest = it;
+			}
+
+			// everything left is heard at the moment
+			if (oldest == s_effects.end())
+				break;
+
+			CCLOG("effect cache full, unloading %s", oldest->first.c_str());
+			deleteSound(oldest->second);
+			s_effects.erase(oldest);
+		}
+	}
+
+	SimpleAudioEngine::SimpleAudioEngine()
+	{
+		alutInit(0, 0);
+	  checkALError("SimpleAudioEngine:alutInit");
+	}
+
+	SimpleAudioEngine::~SimpleAudioEngine()
+	{
+		alutExit();
+	}
+
+	SimpleAudioEngine* SimpleAudioEngine::sharedEngine()
+	{
+		if (!s_engine)
+			s_engine = new SimpleAudioEngine();
+        
+		return s_engine;
+	}
+
+	void SimpleAudioEngine::end()
+	{
+		// the background first, the streaming thread stops with it
+		stopBackground(true);
+		stopMusicThread();
+
+		checkALError("end:init");
+
+		for (BackgroundMusicsMap::iterator it = s_backgroundMusics.begin(); it != s_backgroundMusics.end(); ++it)
+		{
+			deleteBackgroundMusic(it->second);
+		}
+		s_backgroundMusics.clear();
+
+		// clear all the sounds
+	    for (EffectsMap::iterator it = s_effects.begin(); it != s_effects.end(); it++)
+	    {
+			deleteSound(it->second);
+	    }
+	    s_effects.clear();
+		deleteVoices();
+	}
+
+	//
+	// background audio
+	//
+    void SimpleAudioEngine::preloadBackgroundMusic(const char* pszFilePath)
+	{
+		// Changing file path to full path
+    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
+
+    	BackgroundMusicsMap::const_iterator it = s_backgroundMusics.find(fullPath);
+		if (it != s_backgroundMusics.end())
+			return;
+
+		backgroundMusicData* data = new backgroundMusicData();
+		data->buffer = AL_NONE;
+		data->source = AL_NONE;
+		data->isStreamed = false;
+		data->isLooped = false;
+
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		checkALError("preloadBackgroundMusic:init");
+#ifndef DISABLE_VORBIS
+		if (isOGGFile(fullPath.data()))
+		{
+			if (ov_fopen(fullPath.data(), &data->ogg) < 0)
+			{
+				fprintf(stderr, "Could not open OGG file %s\n", fullPath.data());
+				delete data;
+				return;
+			}
+
+			vorbis_info *info = ov_info(&data->ogg, -1);
+			data->format = info->channels == 1 ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+			data->rate = info->rate;
+			data->isPrimed = false;
+			data->isEnded = false;
+			data->isStreamed = true;
+
+			alGenBuffers(MUSIC_STREAM_BUFFERS, data->streamBuffers);
+			if (checkALError("preloadBackgroundMusic:alGenBuffers") != AL_NO_ERROR)
+			{
+				ov_clear(&data->ogg);
+				delete data;
+				return;
+			}
+		}
+		else
+#endif
+		{
+			data->buffer = alutCreateBufferFromFile(fullPath.data());
+			checkALError("preloadBackgroundMusic:createBuffer");
+
+			if (data->buffer == AL_NONE)
+			{
+				fprintf(stderr, "Error loading file: '%s'\n", fullPath.data());
+				delete data;
+				return;
+			}
+		}
+
+		alGenSources(1, &data->source);
+		checkALError("preloadBackgroundMusic:alGenSources");
+		alSourcef(data->source, AL_GAIN, s_volume);
+
+#ifndef DISABLE_VORBIS
+		if (data->isStreamed)
+		{
+			// decode the first buffers now, so playing starts right away
+			primeMusicStream(data);
+		}
+		else
+#endif
+		{
+			alSourcei(data->source, AL_BUFFER, data->buffer);
+			checkALError("preloadBackgroundMusic:alSourcei");
+		}
+
+		s_backgroundMusics.insert(BackgroundMusicsMap::value_type(fullPath, data));
+	}
+
+	void SimpleAudioEngine::playBackgroundMusic(const char* pszFilePath, bool bLoop)
+	{
+		stopBackground(false);
+
+		// Changing file path to full path
+    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
+
+    	BackgroundMusicsMap::const_iterator it = s_backgroundMusics.find(fullPath);
+		if (it == s_backgroundMusics.end())
+		{
+			preloadBackgroundMusic(fullPath.c_str());
+			it = s_backgroundMusics.find(fullPath);
+		}
+
+		if (it != s_backgroundMusics.end())
+		{
+			startMusicThread();
+
+			std::lock_guard<std::mutex> musicLock(s_musicMutex);
+			std::lock_guard<std::mutex> lock(s_alMutex);
+			backgroundMusicData *music = it->second;
+			music->isLooped = bLoop;
+#ifndef DISABLE_VORBIS
+			if (music->isStreamed)
+			{
+				// the loop is made by the decoder, a short file may have been decoded to its end
+				alSourcei(music->source, AL_LOOPING, AL_FALSE);
+				if (!music->isPrimed || music->isEnded)
+					primeMusicStream(music);
+				music->isPrimed = false;
+			}
+			else
+#endif
+			{
+				alSourcei(music->source, AL_LOOPING, bLoop ? AL_TRUE : AL_FALSE);
+			}
+
+			alSourcef(music->source, AL_GAIN, s_volume);
+			alSourcePlay(music->source);
+			checkALError("playBackgroundMusic:alSourcePlay");
+			s_backgroundMusic = music;
+			s_backgroundStatus = PLAYING;
+			s_musicCondition.notify_one();
+		}
+	}
+
+	void SimpleAudioEngine::stopBackgroundMusic(bool bReleaseData)
+	{
+		stopBackground(bReleaseData);
+	}
+
+	void SimpleAudioEngine::pauseBackgroundMusic()
+	{
+		std::lock_guard<std::mutex> musicLock(s_musicMutex);
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		if (s_backgroundMusic && s_backgroundStatus == PLAYING)
+		{
+			alSourcePause(s_backgroundMusic->source);
+			checkALError("pauseBackgroundMusic:alSourcePause");
+			s_backgroundStatus = PAUSED;
+		}
+	}
+
+	void SimpleAudioEngine::resumeBackgroundMusic()
+	{
+		std::lock_guard<std::mutex> musicLock(s_musicMutex);
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		if (s_backgroundMusic && s_backgroundStatus == PAUSED)
+		{
+			alSourcePlay(s_backgroundMusic->source);
+			checkALError("resumeBackgroundMusic:alSourcePlay");
+			s_backgroundStatus = PLAYING;
+			s_musicCondition.notify_one();
+		}
+	} 
+
+	void SimpleAudioEngine::rewindBackgroundMusic()
+	{
+		std::lock_guard<std::mutex> musicLock(s_musicMutex);
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		if (!s_backgroundMusic)
+			return;
+
+#ifndef DISABLE_VORBIS
+		if (s_backgroundMusic->isStreamed)
+		{
+			primeMusicStream(s_backgroundMusic);
+			s_backgroundMusic->isPrimed = false;
+		}
+		else
+#endif
+		{
+			alSourceRewind(s_backgroundMusic->source);
+		}
+		checkALError("rewindBackgroundMusic:alSourceRewind");
+
+		alSourcePlay(s_backgroundMusic->source);
+		checkALError("rewindBackgroundMusic:alSourcePlay");
+		s_backgroundStatus = PLAYING;
+		s_musicCondition.notify_one();
+	}
+
+	bool SimpleAudioEngine::willPlayBackgroundMusic()
+	{
+		return true;
+	}
+
+	bool SimpleAudioEngine::isBackgroundMusicPlaying()
+	{
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		return s_backgroundMusic && s_backgroundStatus == PLAYING;
+	}
+
+	float SimpleAudioEngine::getBackgroundMusicVolume()
+	{
+		return s_volume;
+	}
+
+	void SimpleAudioEngine::setBackgroundMusicVolume(float volume)
+	{
+		if (s_volume != volume && volume >= -0.0001 && volume <= 1.0001)
+		{
+    		s_volume = volume;
+
+			std::lock_guard<std::mutex> lock(s_alMutex);
+			if (s_backgroundMusic)
+				alSourcef(s_backgroundMusic->source, AL_GAIN, volume);
+		}
+	}
+
+	//
+	// Effect audio (using OpenAL)
+	//
+	float SimpleAudioEngine::getEffectsVolume()
+	{
+		return s_effectVolume;
+	}
+
+	void SimpleAudioEngine::setEffectsVolume(float volume)
+	{
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		if (volume != s_effectVolume && s_voicesCreated)
+		{
+			for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+			{
+				if (s_voices[i].source != AL_NONE)
+					alSourcef(s_voices[i].source, AL_GAIN, volume);
+			}
+		}
+		s_effectVolume = volume;
+	}
+
+	unsigned int SimpleAudioEngine::playEffect(const char* pszFilePath, bool bLoop)
+	{
+		// Changing file path to full path
+    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
+
+		EffectsMap::iterator iter = s_effects.find(fullPath);
+
+		if (iter == s_effects.end())
+		{
+			preloadEffect(fullPath.c_str());
+
+			// let's try again
+			iter = s_effects.find(fullPath);
+			if (iter == s_effects.end())
+			{
+				fprintf(stderr, "could not find play sound %s\n", fullPath.c_str());
+				return -1;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		checkALError("playEffect:init");
+		createVoices();
+
+		int priority = bLoop ? 1 : 0;
+		effectVoice *voice = allocateVoice(priority);
+		if (!voice)
+		{
+			CCLOG("effect voices exhausted by looped effects, dropping %s", fullPath.c_str());
+			return -1;
+		}
+
+		soundData *sound = iter->second;
+		sound->lastUse = ++s_effectSerial;
+
+		alSourcei(voice->source, AL_BUFFER, sound->buffer);
+		alSourcei(voice->source, AL_LOOPING, bLoop ? AL_TRUE : AL_FALSE);
+		alSourcef(voice->source, AL_GAIN, s_effectVolume);
+		alSourcePlay(voice->source);
+		checkALError("playEffect:alSourcePlay");
+
+		// ids are never reused while a voice may still hold them, 0 and -1 are not valid
+		if (++s_lastSoundId == (unsigned int)-1)
+			s_lastSoundId = 1;
+		voice->soundId = s_lastSoundId;
+		voice->sound = sound;
+		voice->priority = priority;
+		voice->started = s_effectSerial;
+
+		return voice->soundId;
+	}
+
+	void SimpleAudioEngine::stopEffect(unsigned int nSoundId)
+	{
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		effectVoice *voice = findVoice(nSoundId);
+		if (voice)
+		{
+			alSourceStop(voice->source);
+			checkALError("stopEffect:alSourceStop");
+			voice->soundId = 0;
+			voice->sound = NULL;
+		}
+	}
+
+	void SimpleAudioEngine::preloadEffect(const char* pszFilePath)
+	{
+		// Changing file path to full path
+    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
+
+		EffectsMap::iterator iter = s_effects.find(fullPath);
+
+		// check if we have this already
+		if (iter == s_effects.end())
+		{
+			ALuint 		buffer;
+			string 	    path = fullPath;
+
+#ifndef DISABLE_VORBIS
+			if (isOGGFile(path.data()))
+			{
+				// decoded without the lock, the music keeps streaming meanwhile
+				buffer = createBufferFromOGG(path.data());
+			}
+			else
+#endif			
+			{
+				std::lock_guard<std::mutex> lock(s_alMutex);
+				checkALError("preloadEffect:init");
+				buffer = alutCreateBufferFromFile(path.data());
+				checkALError("preloadEffect:createBufferFromFile");
+			}
+
+			if (buffer == AL_NONE)
+			{
+				fprintf(stderr, "Error loading file: '%s'\n", path.data());
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(s_alMutex);
+			ALint size = 0;
+			alGetBufferi(buffer, AL_SIZE, &size);
+			checkALError("preloadEffect:alGetBufferi");
+
+			soundData *data = new soundData;
+			data->buffer = buffer;
+			data->size = size;
+			data->lastUse = ++s_effectSerial;
+
+			s_effects.insert(EffectsMap::value_type(fullPath, data));
+			s_effectCacheBytes += data->size;
+			trimEffectCache(data);
+		}
+	}
+
+	void SimpleAudioEngine::unloadEffect(const char* pszFilePath)
+	{
+		// Changing file path to full path
+    	std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFilePath);
+    	
+		EffectsMap::iterator iter = s_effects.find(fullPath);
+
+		if (iter != s_effects.end())
+	    {
+			std::lock_guard<std::mutex> lock(s_alMutex);
+			checkALError("unloadEffect:init");
+			deleteSound(iter->second);
+			s_effects.erase(iter);
+	    }
+	}
+
+	void SimpleAudioEngine::pauseEffect(unsigned int nSoundId)
+	{
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		effectVoice *voice = findVoice(nSoundId);
+		if (!voice)
+			return;
+
+		ALint state;
+		alGetSourcei(voice->source, AL_SOURCE_STATE, &state);
+		if (state == AL_PLAYING)
+			alSourcePause(voice->source);
+		checkALError("pauseEffect:alSourcePause");
+	}
+
+	void SimpleAudioEngine::pauseAllEffects()
+	{
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		if (!s_voicesCreated)
+			return;
+
+		ALint state;
+		for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+	    {
+			if (s_voices[i].soundId == 0)
+				continue;
+			alGetSourcei(s_voices[i].source, AL_SOURCE_STATE, &state);
+			if (state == AL_PLAYING)
+				alSourcePause(s_voices[i].source);
+			checkALError("pauseAllEffects:alSourcePause");
+	    }
+	}
+
+	void SimpleAudioEngine::resumeEffect(unsigned int nSoundId)
+	{
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		effectVoice *voice = findVoice(nSoundId);
+		if (!voice)
+			return;
+
+		ALint state;
+		alGetSourcei(voice->source, AL_SOURCE_STATE, &state);
+		if (state == AL_PAUSED)
+			alSourcePlay(voice->source);
+		checkALError("resumeEffect:alSourcePlay");
+	}
+
+	void SimpleAudioEngine::resumeAllEffects()
+	{
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		if (!s_voicesCreated)
+			return;
+
+		ALint state;
+		for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+	    {
+			if (s_voices[i].soundId == 0)
+				continue;
+			alGetSourcei(s_voices[i].source, AL_SOURCE_STATE, &state);
+			if (state == AL_PAUSED)
+				alSourcePlay(s_voices[i].source);
+			checkALError("resumeAllEffects:alSourcePlay");
+	    }
+	}
+
+    void SimpleAudioEngine::stopAllEffects()
+    {
+		std::lock_guard<std::mutex> lock(s_alMutex);
+		if (!s_voicesCreated)
+			return;
+
+		checkALError("stopAllEffects:init");
+		for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+	    {
+			if (s_voices[i].soundId == 0)
+				continue;
+	        alSourceStop(s_voices[i].source);
+			checkALError("stopAllEffects:alSourceStop");
+			s_voices[i].soundId = 0;
+			s_voices[i].sound = NULL;
+	    }
+    }
+
+}
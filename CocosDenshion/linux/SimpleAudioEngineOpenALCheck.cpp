@@ -0,0 +1,198 @@
+/****************************************************************************
+Copyright (c) 2010 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+/*
+ Checks of the effect voices and of the effect cache of the OpenAL backend, built by
+ "make OPENAL=1 check" in CocosDenshion/proj.linux and run on the null device of OpenAL Soft:
+
+     ALSOFT_DRIVERS=null ./openalcheck
+
+ The backend is compiled in with a small pool and cache, so that the checks can read its state.
+ The music streaming (underrun restart, looping, rewind) is not covered: the null device
+ plays nothing, its buffers are never processed.
+ */
+
+#define CC_OPENAL_EFFECT_VOICES 4
+#define CHECK_EFFECT_BYTES (2 * 22050 * 2)   // 2s of 22.05kHz mono, longer than the checks
+#define CC_OPENAL_EFFECT_CACHE_SIZE (3 * CHECK_EFFECT_BYTES)
+
+#include "SimpleAudioEngineOpenAL.cpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace CocosDenshion;
+
+static int s_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            s_failures++; \
+        } \
+    } while (0)
+
+/** writes a silent 16 bit mono wav of CHECK_EFFECT_BYTES bytes */
+static std::string writeEffect(const char *dir, char name)
+{
+    std::string path = std::string(dir) + "/" + name + ".wav";
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file)
+        return path;
+
+    unsigned int rate = 22050, byteRate = rate * 2, dataSize = CHECK_EFFECT_BYTES, riffSize = 36 + dataSize;
+    unsigned int fmtSize = 16;
+    unsigned short pcm = 1, channels = 1, blockAlign = 2, bits = 16;
+    fwrite("RIFF", 1, 4, file);
+    fwrite(&riffSize, 4, 1, file);
+    fwrite("WAVEfmt ", 1, 8, file);
+    fwrite(&fmtSize, 4, 1, file);
+    fwrite(&pcm, 2, 1, file);
+    fwrite(&channels, 2, 1, file);
+    fwrite(&rate, 4, 1, file);
+    fwrite(&byteRate, 4, 1, file);
+    fwrite(&blockAlign, 2, 1, file);
+    fwrite(&bits, 2, 1, file);
+    fwrite("data", 1, 4, file);
+    fwrite(&dataSize, 4, 1, file);
+
+    char silence[1024];
+    memset(silence, 0, sizeof(silence));
+    for (unsigned int left = dataSize; left > 0; )
+    {
+        unsigned int n = left < sizeof(silence) ? left : sizeof(silence);
+        fwrite(silence, 1, n, file);
+        left -= n;
+    }
+    fclose(file);
+    return path;
+}
+
+static bool isSourcePlaying(effectVoice *voice)
+{
+    ALint state = AL_STOPPED;
+    alGetSourcei(voice->source, AL_SOURCE_STATE, &state);
+    return state == AL_PLAYING;
+}
+
+/** a stolen voice no longer answers to the id of the effect it played */
+static void checkStealInvalidatesId(SimpleAudioEngine *engine, const std::string *effects)
+{
+    unsigned int ids[CC_OPENAL_EFFECT_VOICES];
+    for (int i = 0; i < CC_OPENAL_EFFECT_VOICES; ++i)
+    {
+        ids[i] = engine->playEffect(effects[0].c_str(), false);
+        CHECK(ids[i] != (unsigned int)-1);
+    }
+
+    unsigned int thief = engine->playEffect(effects[1].c_str(), false);
+    CHECK(thief != (unsigned int)-1);
+    CHECK(findVoice(ids[0]) == NULL);
+    CHECK(findVoice(thief) != NULL);
+
+    // the stale id must not stop the effect that took its voice
+    engine->stopEffect(ids[0]);
+    effectVoice *voice = findVoice(thief);
+    CHECK(voice && isSourcePlaying(voice));
+
+    engine->stopAllEffects();
+}
+
+/** a one-shot never cuts a loop, a loop takes the voice of a one-shot */
+static void checkLoopsOutrankShots(SimpleAudioEngine *engine, const std::string *effects)
+{
+    unsigned int shot = engine->playEffect(effects[0].c_str(), false);
+    unsigned int loops[CC_OPENAL_EFFECT_VOICES - 1];
+    for (int i = 0; i < CC_OPENAL_EFFECT_VOICES - 1; ++i)
+        loops[i] = engine->playEffect(effects[1].c_str(), true);
+
+    // no voice is free, the last loop steals the one-shot
+    unsigned int lastLoop = engine->playEffect(effects[1].c_str(), true);
+    CHECK(lastLoop != (unsigned int)-1);
+    CHECK(findVoice(shot) == NULL);
+
+    // every voice loops, a one-shot is dropped
+    CHECK(engine->playEffect(effects[0].c_str(), false) == (unsigned int)-1);
+    for (int i = 0; i < CC_OPENAL_EFFECT_VOICES - 1; ++i)
+        CHECK(findVoice(loops[i]) != NULL);
+    CHECK(findVoice(lastLoop) != NULL);
+
+    engine->stopAllEffects();
+}
+
+/** the least recently played effects are unloaded once the cache is over its budget */
+static void checkCacheTrim(SimpleAudioEngine *engine, const std::string *effects, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        engine->preloadEffect(effects[i].c_str());
+        CHECK(s_effectCacheBytes <= CC_OPENAL_EFFECT_CACHE_SIZE);
+    }
+    CHECK(s_effects.size() == CC_OPENAL_EFFECT_CACHE_SIZE / CHECK_EFFECT_BYTES);
+    CHECK(s_effects.find(effects[count - 1]) != s_effects.end());
+    CHECK(s_effects.find(effects[0]) == s_effects.end());
+
+    // a playing effect is never unloaded
+    unsigned int id = engine->playEffect(effects[0].c_str(), true);
+    for (int i = 1; i < count; ++i)
+        engine->preloadEffect(effects[i].c_str());
+    CHECK(findVoice(id) != NULL);
+    CHECK(s_effects.find(effects[0]) != s_effects.end());
+
+    engine->stopAllEffects();
+}
+
+int main()
+{
+    char dir[] = "/tmp/openalcheckXXXXXX";
+    if (!mkdtemp(dir))
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    const int count = 5;
+    std::string effects[count];
+    for (int i = 0; i < count; ++i)
+        effects[i] = writeEffect(dir, 'a' + i);
+
+    SimpleAudioEngine *engine = SimpleAudioEngine::sharedEngine();
+    checkStealInvalidatesId(engine, effects);
+    checkLoopsOutrankShots(engine, effects);
+    checkCacheTrim(engine, effects, count);
+    SimpleAudioEngine::end();
+
+    for (int i = 0; i < count; ++i)
+        remove(effects[i].c_str());
+    rmdir(dir);
+
+    if (s_failures)
+    {
+        fprintf(stderr, "%d checks failed\n", s_failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -47,6 +47,7 @@ kazmath/src/aabb.c \
 kazmath/src/mat3.c \
 kazmath/src/mat4.c \
 kazmath/src/neon_matrix_impl.c \
+kazmath/src/sse_matrix_impl.c \
 kazmath/src/plane.c \
 kazmath/src/quaternion.c \
 kazmath/src/ray2.c \
@@ -48,6 +48,7 @@ CCConfiguration::CCConfiguration(void)
 , m_bSupportsBGRA8888(false)
 , m_bSupportsDiscardFramebuffer(false)
 , m_bSupportsShareableVAO(false)
+, m_bSupportsPixelBufferObject(false)
 , m_nMaxSamplesAllowed(0)
 , m_nMaxTextureUnits(0)
 , m_pGlExtensions(NULL)
@@ -139,6 +140,11 @@ void CCConfiguration::gatherGPUInfo()
 
     m_bSupportsShareableVAO = checkForGLExtension("vertex_array_object");
 	m_pValueDict->setObject( CCBool::create(m_bSupportsShareableVAO), "gl.supports_vertex_array_object");
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+    m_bSupportsPixelBufferObject = checkForGLExtension("pixel_buffer_object");
+#endif
+	m_pValueDict->setObject( CCBool::create(m_bSupportsPixelBufferObject), "gl.supports_pixel_buffer_object");
     
     CHECK_GL_ERROR_DEBUG();
 }
@@ -217,6 +223,11 @@ bool CCConfiguration::supportsShareableVAO(void) const
 	return m_bSupportsShareableVAO;
 }
 
+bool CCConfiguration::supportsPixelBufferObject(void) const
+{
+	return m_bSupportsPixelBufferObject;
+}
+
 //
 // generic getters for properties
 //
@@ -104,6 +104,12 @@ public:
      */
 	bool supportsShareableVAO(void) const;
 
+    /** Whether or not pixel buffer objects can be used to read the framebuffer back asynchronously.
+     Only desktop OpenGL is checked, OpenGL ES 2.0 has no GL_PIXEL_PACK_BUFFER.
+     @since v2.2
+     */
+	bool supportsPixelBufferObject(void) const;
+
     /** returns whether or not an OpenGL is supported */
     bool checkForGLExtension(const std::string &searchName) const;
 
@@ -149,6 +155,7 @@ protected:
     bool            m_bSupportsBGRA8888;
     bool            m_bSupportsDiscardFramebuffer;
     bool            m_bSupportsShareableVAO;
+    bool            m_bSupportsPixelBufferObject;
     GLint           m_nMaxSamplesAllowed;
     GLint           m_nMaxTextureUnits;
     char *          m_pGlExtensions;
@@ -79,6 +79,8 @@ THE SOFTWARE.
 using namespace std;
 
 unsigned int g_uNumberOfDraws = 0;
+unsigned int g_uNumberOfStencilClips = 0;
+unsigned int g_uNumberOfScissorClips = 0;
 
 NS_CC_BEGIN
 // XXX it should be a Director ivar. Move it there once support for multiple directors is added
@@ -87,6 +89,8 @@ NS_CC_BEGIN
 static CCDisplayLinkDirector *s_SharedDirector = NULL;
 
 #define kDefaultFPS        60  // 60 frames per second
+// fixed timestep mode: steps dropped beyond this count, to avoid the spiral of death
+#define kMaxFixedStepsPerFrame 5
 extern const char* cocos2dVersion(void);
 
 CCDirector* CCDirector::sharedDirector(void)
@@ -128,9 +132,21 @@ bool CCDirector::init(void)
     m_pSPFLabel = NULL;
     m_pDrawsLabel = NULL;
     m_uTotalFrames = m_uFrames = 0;
-    m_pszFPS = new char[10];
-    m_pLastUpdate = new struct cc_timeval();
+    m_pszFPS = new char[32];
+    m_lLastUpdate = CCTime::getMonotonicTimeNs();
     m_fSecondsPerFrame = 0.0f;
+    m_uFrameTimeSamples = 0;
+    m_fFrameTimeAccum = 0.0f;
+    m_fFrameTimeMean = 0.0f;
+    m_fFrameTimeM2 = 0.0f;
+    m_fFrameTimeVariance = 0.0f;
+
+    // fixed timestep, disabled by default
+    m_fFixedTimestep = 0.0f;
+    m_fFixedTimeAccumulator = 0.0f;
+    m_fInterpolationAlpha = 1.0f;
+    m_bFrameProfilingEnabled = false;
+    memset(&m_tLastFrameProfile, 0, sizeof(m_tLastFrameProfile));
 
     // paused ?
     m_bPaused = false;
@@ -186,8 +202,6 @@ CCDirector::~CCDirector(void)
     CCPoolManager::sharedPoolManager()->pop();
     CCPoolManager::purgePoolManager();
 
-    // delete m_pLastUpdate
-    CC_SAFE_DELETE(m_pLastUpdate);
     // delete fps string
     delete []m_pszFPS;
 
@@ -246,15 +260,51 @@ void CCDirector::setGLDefaultValues(void)
 }
 
 // Draw the Scene
+static double profileTime()
+{
+    return CCTime::getMonotonicTimeNs() / 1000000000.0;
+}
+
 void CCDirector::drawScene(void)
 {
+    double tStart = 0, tUpdate = 0, tVisit = 0, tDraw = 0;
+    unsigned int uDrawsBefore = g_uNumberOfDraws;
+    unsigned int uStencilClipsBefore = g_uNumberOfStencilClips;
+    unsigned int uScissorClipsBefore = g_uNumberOfScissorClips;
+    if (m_bFrameProfilingEnabled)
+    {
+        tStart = profileTime();
+    }
+
     // calculate "global" dt
     calculateDeltaTime();
+    updateFrameTimeVariance();
 
     //tick before glClear: issue #533
     if (! m_bPaused)
     {
-        m_pScheduler->update(m_fDeltaTime);
+        if (m_fFixedTimestep > 0)
+        {
+            // run the simulation at a fixed rate, the remainder is carried to the next frame
+            m_fFixedTimeAccumulator += m_fDeltaTime;
+            unsigned int uSteps = 0;
+            while (m_fFixedTimeAccumulator >= m_fFixedTimestep && uSteps < kMaxFixedStepsPerFrame)
+            {
+                m_pScheduler->update(m_fFixedTimestep);
+                m_fFixedTimeAccumulator -= m_fFixedTimestep;
+                ++uSteps;
+            }
+            if (m_fFixedTimeAccumulator >= m_fFixedTimestep)
+            {
+                // too far behind, drop the whole steps that could not be simulated
+                m_fFixedTimeAccumulator = fmodf(m_fFixedTimeAccumulator, m_fFixedTimestep);
+            }
+            m_fInterpolationAlpha = m_fFixedTimeAccumulator / m_fFixedTimestep;
+        }
+        else
+        {
+            m_pScheduler->update(m_fDeltaTime);
+        }
     }
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -266,6 +316,11 @@ void CCDirector::drawScene(void)
         setNextScene();
     }
 
+    if (m_bFrameProfilingEnabled)
+    {
+        tUpdate = profileTime();
+    }
+
     kmGLPushMatrix();
 
     // draw the scene
@@ -279,6 +334,18 @@ void CCDirector::drawScene(void)
     {
         m_pNotificationNode->visit();
     }
+
+    // the last batched geometry of the frame
+    ccGLFlushDeferredDraw();
+
+    if (m_bFrameProfilingEnabled)
+    {
+        // the stats labels are not part of the measured frame
+        m_tLastFrameProfile.drawCalls = g_uNumberOfDraws - uDrawsBefore;
+        m_tLastFrameProfile.stencilClips = g_uNumberOfStencilClips - uStencilClipsBefore;
+        m_tLastFrameProfile.scissorClips = g_uNumberOfScissorClips - uScissorClipsBefore;
+        tVisit = profileTime();
+    }
     
     if (m_bDisplayStats)
     {
@@ -289,11 +356,28 @@ void CCDirector::drawScene(void)
 
     m_uTotalFrames++;
 
+    if (m_bFrameProfilingEnabled)
+    {
+        // wait for the GPU so the swap is not charged with the whole frame
+        glFinish();
+        tDraw = profileTime();
+    }
+
     // swap buffers
     if (m_pobOpenGLView)
     {
         m_pobOpenGLView->swapBuffers();
     }
+
+    if (m_bFrameProfilingEnabled)
+    {
+        double tEnd = profileTime();
+        m_tLastFrameProfile.update = tUpdate - tStart;
+        m_tLastFrameProfile.visit = tVisit - tUpdate;
+        m_tLastFrameProfile.draw = tDraw - tVisit;
+        m_tLastFrameProfile.swap = tEnd - tDraw;
+        m_tLastFrameProfile.total = tEnd - tStart;
+    }
     
     if (m_bDisplayStats)
     {
@@ -301,17 +385,48 @@ void CCDirector::drawScene(void)
     }
 }
 
-void CCDirector::calculateDeltaTime(void)
+void CCDirector::setFixedTimestep(float fTimestep)
 {
-    struct cc_timeval now;
+    m_fFixedTimestep = MAX(0.0f, fTimestep);
+    m_fFixedTimeAccumulator = 0.0f;
+    m_fInterpolationAlpha = 1.0f;
+}
 
-    if (CCTime::gettimeofdayCocos2d(&now, NULL) != 0)
+void CCDirector::updateFrameTimeVariance()
+{
+    // frames with a zero delta time (after a pause or a resume) would skew the variance
+    if (m_fDeltaTime <= 0)
     {
-        CCLOG("error in gettimeofday");
-        m_fDeltaTime = 0;
         return;
     }
 
+    // Welford's running variance, restarted every stats interval
+    ++m_uFrameTimeSamples;
+    float fDelta = m_fDeltaTime - m_fFrameTimeMean;
+    m_fFrameTimeMean += fDelta / m_uFrameTimeSamples;
+    m_fFrameTimeM2 += fDelta * (m_fDeltaTime - m_fFrameTimeMean);
+    m_fFrameTimeAccum += m_fDeltaTime;
+
+    if (m_fFrameTimeAccum > CC_DIRECTOR_STATS_INTERVAL)
+    {
+        m_fFrameTimeVariance = m_uFrameTimeSamples > 1 ? m_fFrameTimeM2 / (m_uFrameTimeSamples - 1) : 0.0f;
+        m_uFrameTimeSamples = 0;
+        m_fFrameTimeAccum = 0.0f;
+        m_fFrameTimeMean = 0.0f;
+        m_fFrameTimeM2 = 0.0f;
+    }
+}
+
+void CCDirector::setFrameProfilingEnabled(bool bEnabled)
+{
+    m_bFrameProfilingEnabled = bEnabled;
+    memset(&m_tLastFrameProfile, 0, sizeof(m_tLastFrameProfile));
+}
+
+void CCDirector::calculateDeltaTime(void)
+{
+    long long now = CCTime::getMonotonicTimeNs();
+
     // new delta time. Re-fixed issue #1277
     if (m_bNextDeltaTimeZero)
     {
@@ -320,7 +435,7 @@ void CCDirector::calculateDeltaTime(void)
     }
     else
     {
-        m_fDeltaTime = (now.tv_sec - m_pLastUpdate->tv_sec) + (now.tv_usec - m_pLastUpdate->tv_usec) / 1000000.0f;
+        m_fDeltaTime = (float)((now - m_lLastUpdate) / 1000000000.0);
         m_fDeltaTime = MAX(0, m_fDeltaTime);
     }
 
@@ -332,7 +447,7 @@ void CCDirector::calculateDeltaTime(void)
     }
 #endif
 
-    *m_pLastUpdate = now;
+    m_lLastUpdate = now;
 }
 float CCDirector::getDeltaTime()
 {
@@ -814,10 +929,7 @@ void CCDirector::resume(void)
 
     setAnimationInterval(m_dOldAnimationInterval);
 
-    if (CCTime::gettimeofdayCocos2d(m_pLastUpdate, NULL) != 0)
-    {
-        CCLOG("cocos2d: Director: Error in gettimeofday");
-    }
+    m_lLastUpdate = CCTime::getMonotonicTimeNs();
 
     m_bPaused = false;
     m_fDeltaTime = 0;
@@ -836,7 +948,8 @@ void CCDirector::showStats(void)
         {
             if (m_fAccumDt > CC_DIRECTOR_STATS_INTERVAL)
             {
-                sprintf(m_pszFPS, "%.3f", m_fSecondsPerFrame);
+                // seconds per frame / standard deviation of the frame time
+                sprintf(m_pszFPS, "%.3f/%.4f", m_fSecondsPerFrame, sqrtf(m_fFrameTimeVariance));
                 m_pSPFLabel->setString(m_pszFPS);
                 
                 m_fFrameRate = m_uFrames / m_fAccumDt;
@@ -846,7 +959,16 @@ void CCDirector::showStats(void)
                 sprintf(m_pszFPS, "%.1f", m_fFrameRate);
                 m_pFPSLabel->setString(m_pszFPS);
                 
-                sprintf(m_pszFPS, "%4lu", (unsigned long)g_uNumberOfDraws);
+                // draws, followed by the stencil and scissor clips when there are clipping nodes
+                if (g_uNumberOfStencilClips || g_uNumberOfScissorClips)
+                {
+                    sprintf(m_pszFPS, "%4lu/%lu/%lu", (unsigned long)g_uNumberOfDraws,
+                            (unsigned long)g_uNumberOfStencilClips, (unsigned long)g_uNumberOfScissorClips);
+                }
+                else
+                {
+                    sprintf(m_pszFPS, "%4lu", (unsigned long)g_uNumberOfDraws);
+                }
                 m_pDrawsLabel->setString(m_pszFPS);
             }
             
@@ -857,14 +979,15 @@ void CCDirector::showStats(void)
     }    
     
     g_uNumberOfDraws = 0;
+    g_uNumberOfStencilClips = 0;
+    g_uNumberOfScissorClips = 0;
 }
 
 void CCDirector::calculateMPF()
 {
-    struct cc_timeval now;
-    CCTime::gettimeofdayCocos2d(&now, NULL);
+    long long now = CCTime::getMonotonicTimeNs();
     
-    m_fSecondsPerFrame = (now.tv_sec - m_pLastUpdate->tv_sec) + (now.tv_usec - m_pLastUpdate->tv_usec) / 1000000.0f;
+    m_fSecondsPerFrame = (float)((now - m_lLastUpdate) / 1000000000.0);
 }
 
 // returns the FPS image data pointer and len
@@ -1058,10 +1181,7 @@ CCAccelerometer* CCDirector::getAccelerometer()
 // so we now only support DisplayLinkDirector
 void CCDisplayLinkDirector::startAnimation(void)
 {
-    if (CCTime::gettimeofdayCocos2d(m_pLastUpdate, NULL) != 0)
-    {
-        CCLOG("cocos2d: DisplayLinkDirector: Error on gettimeofday");
-    }
+    m_lLastUpdate = CCTime::getMonotonicTimeNs();
 
     m_bInvalid = false;
 #ifndef EMSCRIPTEN
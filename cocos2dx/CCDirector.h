@@ -62,6 +62,31 @@ typedef enum {
     kCCDirectorProjectionDefault = kCCDirectorProjection3D,
 } ccDirectorProjection;
 
+/** @struct ccDirectorFrameProfile
+ CPU time spent by the director in each phase of the last frame, in seconds.
+ Only filled while frame profiling is enabled, see CCDirector::setFrameProfilingEnabled.
+ @since v2.2
+ */
+typedef struct _ccDirectorFrameProfile
+{
+    /// scheduler update, including actions and scene switching
+    double update;
+    /// scene and notification node visit
+    double visit;
+    /// time spent waiting for the GPU to finish the frame (glFinish)
+    double draw;
+    /// buffer swap
+    double swap;
+    /// whole frame, from the start of the update to the end of the swap
+    double total;
+    /// number of draw calls issued by the frame
+    unsigned int drawCalls;
+    /// number of CCClippingNode clipping with the stencil buffer
+    unsigned int stencilClips;
+    /// number of CCClippingNode clipping with a scissor rectangle
+    unsigned int scissorClips;
+} ccDirectorFrameProfile;
+
 /* Forward declarations. */
 class CCLabelAtlas;
 class CCScene;
@@ -148,6 +173,40 @@ public:
 
     /** How many frames were called since the director started */
     inline unsigned int getTotalFrames(void) { return m_uTotalFrames; }
+
+    /** Whether the director measures the time spent in each phase of a frame.
+     Profiling adds a glFinish before the buffer swap, so it should only be
+     enabled by benchmarks.
+     @since v2.2
+     */
+    inline bool isFrameProfilingEnabled(void) { return m_bFrameProfilingEnabled; }
+    void setFrameProfilingEnabled(bool bEnabled);
+
+    /** Runs the scheduler at a fixed rate instead of once per frame with a variable delta time.
+     Every frame the elapsed time is accumulated and the scheduler is updated with
+     fTimestep as many times as it fits, the remainder being carried to the next frame.
+     Pass 0 to go back to one variable update per frame.
+     @since v2.2
+     */
+    void setFixedTimestep(float fTimestep);
+    inline float getFixedTimestep(void) { return m_fFixedTimestep; }
+
+    /** In fixed timestep mode, how far the rendered frame is between the last two
+     simulation steps, in [0, 1). Nodes may use it to interpolate their positions.
+     Always 1 when the fixed timestep is disabled.
+     @since v2.2
+     */
+    inline float getInterpolationAlpha(void) { return m_fInterpolationAlpha; }
+
+    /** Variance of the frame delta time over the last stats interval, in seconds squared.
+     @since v2.2
+     */
+    inline float getFrameTimeVariance(void) { return m_fFrameTimeVariance; }
+
+    /** Phase timings of the last drawn frame. Zeroed when profiling is disabled.
+     @since v2.2
+     */
+    inline const ccDirectorFrameProfile& getLastFrameProfile(void) { return m_tLastFrameProfile; }
     
     /** Sets an OpenGL projection
      @since v0.8.2
@@ -376,6 +435,8 @@ protected:
     
     /** calculates delta time since last time it was called */    
     void calculateDeltaTime();
+    /** accumulates the delta time into the frame time variance */
+    void updateFrameTimeVariance();
 protected:
     /* The CCEGLView, where everything is rendered */
     CCEGLView    *m_pobOpenGLView;
@@ -415,8 +476,20 @@ protected:
     /* scheduled scenes */
     CCArray* m_pobScenesStack;
     
-    /* last time the main loop was updated */
-    struct cc_timeval *m_pLastUpdate;
+    /* last time the main loop was updated, in nanoseconds of the monotonic clock */
+    long long m_lLastUpdate;
+
+    /* frame time variance, see updateFrameTimeVariance */
+    unsigned int m_uFrameTimeSamples;
+    float m_fFrameTimeAccum;
+    float m_fFrameTimeMean;
+    float m_fFrameTimeM2;
+    float m_fFrameTimeVariance;
+
+    /* fixed timestep mode */
+    float m_fFixedTimestep;
+    float m_fFixedTimeAccumulator;
+    float m_fInterpolationAlpha;
 
     /* whether or not the next delta time will be zero */
     bool m_bNextDeltaTimeZero;
@@ -438,6 +511,10 @@ protected:
 
     /* Projection protocol delegate */
     CCDirectorDelegate *m_pProjectionDelegate;
+
+    /* frame phase timings, see setFrameProfilingEnabled */
+    bool m_bFrameProfilingEnabled;
+    ccDirectorFrameProfile m_tLastFrameProfile;
     
     // CCEGLViewProtocol will recreate stats labels to fit visible rect
     friend class CCEGLViewProtocol;
@@ -102,7 +102,11 @@ CCDrawNode::CCDrawNode()
 , m_uBufferCapacity(0)
 , m_nBufferCount(0)
 , m_pBuffer(NULL)
+, m_uGLBufferCapacity(0)
+, m_nUploadedCount(0)
 , m_bDirty(false)
+, m_bStatic(false)
+, m_bSingleQuad(false)
 {
     m_sBlendFunc.src = CC_BLEND_SRC;
     m_sBlendFunc.dst = CC_BLEND_DST;
@@ -167,7 +171,9 @@ bool CCDrawNode::init()
     
     glGenBuffers(1, &m_uVbo);
     glBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)* m_uBufferCapacity, m_pBuffer, GL_STREAM_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)* m_uBufferCapacity, m_pBuffer, m_bStatic ? GL_STATIC_DRAW : GL_STREAM_DRAW);
+    m_uGLBufferCapacity = m_uBufferCapacity;
+    m_nUploadedCount = m_nBufferCount;
     
     glEnableVertexAttribArray(kCCVertexAttrib_Position);
     glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, vertices));
@@ -199,14 +205,42 @@ bool CCDrawNode::init()
     return true;
 }
 
+void CCDrawNode::uploadBuffer()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
+
+    // the vertex buffer is reallocated when the client buffer grew. A stream buffer is also
+    // reallocated when it is rewritten from the start (after clear), orphaning the old storage
+    // so the GPU can still read it while the new vertices are uploaded
+    if (m_uGLBufferCapacity != m_uBufferCapacity || (m_nUploadedCount == 0 && ! m_bStatic))
+    {
+        glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)*m_uBufferCapacity, NULL, m_bStatic ? GL_STATIC_DRAW : GL_STREAM_DRAW);
+        m_uGLBufferCapacity = m_uBufferCapacity;
+        m_nUploadedCount = 0;
+    }
+
+    // only the vertices added since the last upload
+    if (m_nBufferCount > m_nUploadedCount)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)*m_nUploadedCount,
+                        sizeof(ccV2F_C4B_T2F)*(m_nBufferCount - m_nUploadedCount), m_pBuffer + m_nUploadedCount);
+    }
+    m_nUploadedCount = m_nBufferCount;
+}
+
 void CCDrawNode::render()
 {
     if (m_bDirty)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)*m_uBufferCapacity, m_pBuffer, GL_STREAM_DRAW);
+        uploadBuffer();
         m_bDirty = false;
     }
+
+    if (m_nBufferCount == 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
 #if CC_TEXTURE_ATLAS_USE_VAO     
     ccGLBindVAO(m_uVao);
 #else
@@ -239,13 +273,15 @@ void CCDrawNode::draw()
 
 void CCDrawNode::drawDot(const CCPoint &pos, float radius, const ccColor4F &color)
 {
+    m_bSingleQuad = false;
     unsigned int vertex_count = 2*3;
     ensureCapacity(vertex_count);
+    ccColor4B col = ccc4BFromccc4F(color);
 	
-	ccV2F_C4B_T2F a = {{pos.x - radius, pos.y - radius}, ccc4BFromccc4F(color), {-1.0, -1.0} };
-	ccV2F_C4B_T2F b = {{pos.x - radius, pos.y + radius}, ccc4BFromccc4F(color), {-1.0,  1.0} };
-	ccV2F_C4B_T2F c = {{pos.x + radius, pos.y + radius}, ccc4BFromccc4F(color), { 1.0,  1.0} };
-	ccV2F_C4B_T2F d = {{pos.x + radius, pos.y - radius}, ccc4BFromccc4F(color), { 1.0, -1.0} };
+	ccV2F_C4B_T2F a = {{pos.x - radius, pos.y - radius}, col, {-1.0, -1.0} };
+	ccV2F_C4B_T2F b = {{pos.x - radius, pos.y + radius}, col, {-1.0,  1.0} };
+	ccV2F_C4B_T2F c = {{pos.x + radius, pos.y + radius}, col, { 1.0,  1.0} };
+	ccV2F_C4B_T2F d = {{pos.x + radius, pos.y - radius}, col, { 1.0, -1.0} };
 	
 	ccV2F_C4B_T2F_Triangle *triangles = (ccV2F_C4B_T2F_Triangle *)(m_pBuffer + m_nBufferCount);
     ccV2F_C4B_T2F_Triangle triangle0 = {a, b, c};
@@ -260,8 +296,10 @@ void CCDrawNode::drawDot(const CCPoint &pos, float radius, const ccColor4F &colo
 
 void CCDrawNode::drawSegment(const CCPoint &from, const CCPoint &to, float radius, const ccColor4F &color)
 {
+    m_bSingleQuad = false;
     unsigned int vertex_count = 6*3;
     ensureCapacity(vertex_count);
+    ccColor4B col = ccc4BFromccc4F(color);
 	
 	ccVertex2F a = __v2f(from);
 	ccVertex2F b = __v2f(to);
@@ -285,44 +323,44 @@ void CCDrawNode::drawSegment(const CCPoint &from, const CCPoint &to, float radiu
 	ccV2F_C4B_T2F_Triangle *triangles = (ccV2F_C4B_T2F_Triangle *)(m_pBuffer + m_nBufferCount);
 	
     ccV2F_C4B_T2F_Triangle triangles0 = {
-        {v0, ccc4BFromccc4F(color), __t(v2fneg(v2fadd(n, t)))},
-        {v1, ccc4BFromccc4F(color), __t(v2fsub(n, t))},
-        {v2, ccc4BFromccc4F(color), __t(v2fneg(n))},
+        {v0, col, __t(v2fneg(v2fadd(n, t)))},
+        {v1, col, __t(v2fsub(n, t))},
+        {v2, col, __t(v2fneg(n))},
     };
 	triangles[0] = triangles0;
 	
     ccV2F_C4B_T2F_Triangle triangles1 = {
-        {v3, ccc4BFromccc4F(color), __t(n)},
-        {v1, ccc4BFromccc4F(color), __t(v2fsub(n, t))},
-        {v2, ccc4BFromccc4F(color), __t(v2fneg(n))},
+        {v3, col, __t(n)},
+        {v1, col, __t(v2fsub(n, t))},
+        {v2, col, __t(v2fneg(n))},
     };
 	triangles[1] = triangles1;
 	
     ccV2F_C4B_T2F_Triangle triangles2 = {
-        {v3, ccc4BFromccc4F(color), __t(n)},
-        {v4, ccc4BFromccc4F(color), __t(v2fneg(n))},
-        {v2, ccc4BFromccc4F(color), __t(v2fneg(n))},
+        {v3, col, __t(n)},
+        {v4, col, __t(v2fneg(n))},
+        {v2, col, __t(v2fneg(n))},
     };
 	triangles[2] = triangles2;
 
     ccV2F_C4B_T2F_Triangle triangles3 = {
-        {v3, ccc4BFromccc4F(color), __t(n)},
-        {v4, ccc4BFromccc4F(color), __t(v2fneg(n))},
-        {v5, ccc4BFromccc4F(color), __t(n) },
+        {v3, col, __t(n)},
+        {v4, col, __t(v2fneg(n))},
+        {v5, col, __t(n) },
     };
     triangles[3] = triangles3;
 
     ccV2F_C4B_T2F_Triangle triangles4 = {
-        {v6, ccc4BFromccc4F(color), __t(v2fsub(t, n))},
-        {v4, ccc4BFromccc4F(color), __t(v2fneg(n)) },
-        {v5, ccc4BFromccc4F(color), __t(n)},
+        {v6, col, __t(v2fsub(t, n))},
+        {v4, col, __t(v2fneg(n)) },
+        {v5, col, __t(n)},
     };
 	triangles[4] = triangles4;
 
     ccV2F_C4B_T2F_Triangle triangles5 = {
-        {v6, ccc4BFromccc4F(color), __t(v2fsub(t, n))},
-        {v7, ccc4BFromccc4F(color), __t(v2fadd(n, t))},
-        {v5, ccc4BFromccc4F(color), __t(n)},
+        {v6, col, __t(v2fsub(t, n))},
+        {v7, col, __t(v2fadd(n, t))},
+        {v5, col, __t(n)},
     };
 	triangles[5] = triangles5;
 	
@@ -333,9 +371,12 @@ void CCDrawNode::drawSegment(const CCPoint &from, const CCPoint &to, float radiu
 
 void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor)
 {
+    m_bSingleQuad = (count == 4 && m_nBufferCount == 0);
+
     struct ExtrudeVerts {ccVertex2F offset, n;};
-	struct ExtrudeVerts* extrude = (struct ExtrudeVerts*)malloc(sizeof(struct ExtrudeVerts)*count);
-	memset(extrude, 0, sizeof(struct ExtrudeVerts)*count);
+    // small polygons, e.g. quads, don't need an allocation
+    struct ExtrudeVerts extrudeOnStack[16];
+	struct ExtrudeVerts* extrude = count <= 16 ? extrudeOnStack : (struct ExtrudeVerts*)malloc(sizeof(struct ExtrudeVerts)*count);
 	
 	for(unsigned int i = 0; i < count; i++)
     {
@@ -356,6 +397,8 @@ void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F
 	unsigned int triangle_count = 3*count - 2;
 	unsigned int vertex_count = 3*triangle_count;
     ensureCapacity(vertex_count);
+    ccColor4B fill = ccc4BFromccc4F(fillColor);
+    ccColor4B border = ccc4BFromccc4F(borderColor);
 	
 	ccV2F_C4B_T2F_Triangle *triangles = (ccV2F_C4B_T2F_Triangle *)(m_pBuffer + m_nBufferCount);
 	ccV2F_C4B_T2F_Triangle *cursor = triangles;
@@ -368,9 +411,9 @@ void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F
 		ccVertex2F v2 = v2fsub(__v2f(verts[i+2]), v2fmult(extrude[i+2].offset, inset));
 		
         ccV2F_C4B_T2F_Triangle tmp = {
-            {v0, ccc4BFromccc4F(fillColor), __t(v2fzero)},
-            {v1, ccc4BFromccc4F(fillColor), __t(v2fzero)},
-            {v2, ccc4BFromccc4F(fillColor), __t(v2fzero)},
+            {v0, fill, __t(v2fzero)},
+            {v1, fill, __t(v2fzero)},
+            {v2, fill, __t(v2fzero)},
         };
 
 		*cursor++ = tmp;
@@ -395,16 +438,16 @@ void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F
 			ccVertex2F outer1 = v2fadd(v1, v2fmult(offset1, borderWidth));
 			
             ccV2F_C4B_T2F_Triangle tmp1 = {
-                {inner0, ccc4BFromccc4F(borderColor), __t(v2fneg(n0))},
-                {inner1, ccc4BFromccc4F(borderColor), __t(v2fneg(n0))},
-                {outer1, ccc4BFromccc4F(borderColor), __t(n0)}
+                {inner0, border, __t(v2fneg(n0))},
+                {inner1, border, __t(v2fneg(n0))},
+                {outer1, border, __t(n0)}
             };
 			*cursor++ = tmp1;
 
             ccV2F_C4B_T2F_Triangle tmp2 = {
-                {inner0, ccc4BFromccc4F(borderColor), __t(v2fneg(n0))},
-                {outer0, ccc4BFromccc4F(borderColor), __t(n0)},
-                {outer1, ccc4BFromccc4F(borderColor), __t(n0)}
+                {inner0, border, __t(v2fneg(n0))},
+                {outer0, border, __t(n0)},
+                {outer1, border, __t(n0)}
             };
 			*cursor++ = tmp2;
 		}
@@ -415,16 +458,16 @@ void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F
 			ccVertex2F outer1 = v2fadd(v1, v2fmult(offset1, 0.5));
 			
             ccV2F_C4B_T2F_Triangle tmp1 = {
-                {inner0, ccc4BFromccc4F(fillColor), __t(v2fzero)},
-                {inner1, ccc4BFromccc4F(fillColor), __t(v2fzero)},
-                {outer1, ccc4BFromccc4F(fillColor), __t(n0)}
+                {inner0, fill, __t(v2fzero)},
+                {inner1, fill, __t(v2fzero)},
+                {outer1, fill, __t(n0)}
             };
 			*cursor++ = tmp1;
 
             ccV2F_C4B_T2F_Triangle tmp2 = {
-                {inner0, ccc4BFromccc4F(fillColor), __t(v2fzero)},
-                {outer0, ccc4BFromccc4F(fillColor), __t(n0)},
-                {outer1, ccc4BFromccc4F(fillColor), __t(n0)}
+                {inner0, fill, __t(v2fzero)},
+                {outer0, fill, __t(n0)},
+                {outer1, fill, __t(n0)}
             };
 			*cursor++ = tmp2;
 		}
@@ -434,13 +477,79 @@ void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F
 	
 	m_bDirty = true;
 
-    free(extrude);
+    if (extrude != extrudeOnStack)
+    {
+        free(extrude);
+    }
 }
 
 void CCDrawNode::clear()
 {
     m_nBufferCount = 0;
+    m_nUploadedCount = 0;
     m_bDirty = true;
+    m_bSingleQuad = false;
+}
+
+void CCDrawNode::setStatic(bool bStatic)
+{
+    if (m_bStatic != bStatic)
+    {
+        m_bStatic = bStatic;
+        // reallocate the vertex buffer with the new usage
+        m_uGLBufferCapacity = 0;
+        m_bDirty = true;
+    }
+}
+
+bool CCDrawNode::isStatic() const
+{
+    return m_bStatic;
+}
+
+bool CCDrawNode::isRectangle(CCRect *pRect) const
+{
+    if (!m_bSingleQuad)
+    {
+        return false;
+    }
+
+    // drawPolygon starts with the fill triangles (0, 1, 2) and (0, 2, 3) of the 4 corners
+    const ccVertex2F corners[4] = {
+        m_pBuffer[0].vertices, m_pBuffer[1].vertices, m_pBuffer[2].vertices, m_pBuffer[5].vertices
+    };
+
+    // the edges must be horizontal and vertical, one after the other
+    const float epsilon = 0.0001f;
+    bool horizontal[4], vertical[4];
+    for (int i = 0; i < 4; i++)
+    {
+        float dx = fabsf(corners[(i + 1) % 4].x - corners[i].x);
+        float dy = fabsf(corners[(i + 1) % 4].y - corners[i].y);
+        horizontal[i] = dy < epsilon && dx >= epsilon;
+        vertical[i] = dx < epsilon && dy >= epsilon;
+    }
+    if (!(horizontal[0] && vertical[1] && horizontal[2] && vertical[3])
+        && !(vertical[0] && horizontal[1] && vertical[2] && horizontal[3]))
+    {
+        return false;
+    }
+
+    if (pRect)
+    {
+        // the antialiased edges or the border lie outside the fill
+        float minX = m_pBuffer[0].vertices.x, maxX = minX;
+        float minY = m_pBuffer[0].vertices.y, maxY = minY;
+        for (GLsizei i = 1; i < m_nBufferCount; i++)
+        {
+            minX = MIN(minX, m_pBuffer[i].vertices.x);
+            maxX = MAX(maxX, m_pBuffer[i].vertices.x);
+            minY = MIN(minY, m_pBuffer[i].vertices.y);
+            maxY = MAX(maxY, m_pBuffer[i].vertices.y);
+        }
+        *pRect = CCRectMake(minX, minY, maxX - minX, maxY - minY);
+    }
+    return true;
 }
 
 ccBlendFunc CCDrawNode::getBlendFunc() const
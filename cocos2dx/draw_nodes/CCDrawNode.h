@@ -52,9 +52,14 @@ protected:
     GLsizei         m_nBufferCount;
     ccV2F_C4B_T2F   *m_pBuffer;
     
+    unsigned int    m_uGLBufferCapacity;    // vertices allocated in m_uVbo
+    GLsizei         m_nUploadedCount;       // vertices of m_pBuffer already in m_uVbo
+    
     ccBlendFunc     m_sBlendFunc;
     
     bool            m_bDirty;
+    bool            m_bStatic;
+    bool            m_bSingleQuad;  // the buffer holds a single polygon of 4 vertices, see isRectangle
     
 public:
     static CCDrawNode* create();
@@ -77,8 +82,25 @@ public:
      */
     void drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor);
     
-    /** Clear the geometry in the node's buffer. */
+    /** Clear the geometry in the node's buffer.
+     The buffers keep their capacity, redrawing after a clear doesn't reallocate them.
+     */
     void clear();
+
+    /** Static geometry is uploaded to a GL_STATIC_DRAW buffer, for shapes drawn once and rendered
+     for many frames. The default is false: a GL_STREAM_DRAW buffer, for shapes redrawn often.
+     In both modes only the vertices added since the last frame are uploaded.
+     @since v2.2
+     */
+    void setStatic(bool bStatic);
+    bool isStatic() const;
+
+    /** Returns true when the node holds a single axis aligned rectangle drawn with drawPolygon
+     and nothing else. The rectangle, antialiased edges and border included, is returned in pRect.
+     Used by CCClippingNode to clip with a scissor.
+     @since v2.2
+     */
+    bool isRectangle(CCRect *pRect) const;
     /**
      * @js NA
      */
@@ -99,6 +121,7 @@ public:
     void listenBackToForeground(CCObject *obj);
 private:
     void ensureCapacity(unsigned int count);
+    void uploadBuffer();
     void render();
 };
 
@@ -199,6 +199,9 @@ void CCGridBase::set2DProjection()
 
 void CCGridBase::beforeDraw(void)
 {
+    // draw the held back geometry with the projection it was batched for
+    ccGLFlushDeferredDraw();
+
     // save projection
     CCDirector *director = CCDirector::sharedDirector();
     m_directorProjection = director->getProjection();
@@ -211,6 +214,9 @@ void CCGridBase::beforeDraw(void)
 
 void CCGridBase::afterDraw(cocos2d::CCNode *pTarget)
 {
+    // the geometry batched inside the grid belongs to its FBO
+    ccGLFlushDeferredDraw();
+
     m_pGrabber->afterRender(m_pTexture);
 
     // restore projection
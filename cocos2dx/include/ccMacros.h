@@ -248,6 +248,20 @@ It should work same as apples CFSwapInt32LittleToHost(..)
 extern unsigned int CC_DLL g_uNumberOfDraws;
 #define CC_INCREMENT_GL_DRAWS(__n__) g_uNumberOfDraws += __n__
 
+/** @def CC_INCREMENT_STENCIL_CLIPS
+ Increments the number of CCClippingNode that clipped with the stencil buffer.
+ Shown after the GL Draws count when the CCDirector's stats are enabled.
+ */
+extern unsigned int CC_DLL g_uNumberOfStencilClips;
+#define CC_INCREMENT_STENCIL_CLIPS(__n__) g_uNumberOfStencilClips += __n__
+
+/** @def CC_INCREMENT_SCISSOR_CLIPS
+ Increments the number of CCClippingNode that clipped with a scissor rectangle.
+ Shown after the stencil clips count when the CCDirector's stats are enabled.
+ */
+extern unsigned int CC_DLL g_uNumberOfScissorClips;
+#define CC_INCREMENT_SCISSOR_CLIPS(__n__) g_uNumberOfScissorClips += __n__
+
 /*******************/
 /** Notifications **/
 /*******************/
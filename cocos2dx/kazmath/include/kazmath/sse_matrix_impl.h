@@ -0,0 +1,72 @@
+/*
+Copyright (c) 2013 cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef __SSE_MATRIX_IMPL_H__
+#define __SSE_MATRIX_IMPL_H__
+
+// SSE2 is available on every x86-64 CPU and is enabled at compile time, the
+// 256 bits AVX kernels are only selected after checking the CPU at runtime.
+// Define KM_NO_SIMD to build the scalar code only.
+#if !defined(KM_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define KM_USE_SSE2 1
+
+#if defined(__AVX__) || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#define KM_USE_AVX 1
+#elif defined(__clang__) && defined(__has_attribute)
+#if __has_attribute(target)
+#define KM_USE_AVX 1
+#endif
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define KM_USE_AVX 1
+#endif
+
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Matrices are assumed to be stored in column major format according to OpenGL
+// specification. The kernels pick the AVX version themselves when
+// kmSIMDFeatures() reports it, callers only check that SIMD is enabled at all.
+
+// Multiplies two 4x4 matrices (a,b) outputting a 4x4 matrix (output = a * b)
+void SSE_Matrix4Mul(const float* a, const float* b, float* output);
+
+// Inverts a 4x4 matrix (m), returns 0 and leaves output untouched when m is singular
+int SSE_Matrix4Inverse(const float* m, float* output);
+
+// Multiplies a 4x4 matrix (m) with a vector 4 (v), outputting a vector 4
+void SSE_Matrix4Vector4Mul(const float* m, const float* v, float* output);
+
+// Multiplies a 4x4 matrix (m) with a vector 3 (v, w = 1), outputting a vector 3
+void SSE_Matrix4Vector3Mul(const float* m, const float* v, float* output);
+
+// Multiplies count vector 4, the strides are in vector 4 units
+void SSE_Matrix4Vector4MulArray(const float* m, const float* v, unsigned int vStride,
+                                float* output, unsigned int outStride, unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __SSE_MATRIX_IMPL_H__
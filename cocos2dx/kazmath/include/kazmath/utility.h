@@ -54,6 +54,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define kmPIUnder180 57.295779f // 180 / PI
 #define kmEpsilon 1.0 / 64.0
 
+/* SIMD instruction sets used by the matrix and vector functions, see kmSIMDFeatures() */
+#define KM_SIMD_SSE2 0x1
+#define KM_SIMD_AVX 0x2
 
 
 #ifdef __cplusplus
@@ -68,6 +71,13 @@ CC_DLL kmScalar kmMin(kmScalar lhs, kmScalar rhs);
 CC_DLL kmScalar kmMax(kmScalar lhs, kmScalar rhs);
 CC_DLL kmBool kmAlmostEqual(kmScalar lhs, kmScalar rhs);
 
+/* Returns the KM_SIMD_* instruction sets used on this CPU, 0 when only the scalar code runs */
+CC_DLL int kmSIMDFeatures(void);
+/* Restricts the instruction sets to the ones in mask, e.g. 0 to run the scalar code for a
+   comparison. Returns the instruction sets used from now on. Not thread safe, call it
+   while no other thread uses kazmath. */
+CC_DLL int kmSetSIMDFeatures(int mask);
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,6 +38,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/plane.h"
 
 #include "kazmath/neon_matrix_impl.h"
+#include "kazmath/sse_matrix_impl.h"
 
 /**
  * Fills a kmMat4 structure with the values from a 16
@@ -169,6 +170,12 @@ kmMat4* const kmMat4Inverse(kmMat4* pOut, const kmMat4* pM)
     kmMat4 inv;
     kmMat4 tmp;
 
+#if defined(KM_USE_SSE2)
+    if (kmSIMDFeatures()) {
+        return SSE_Matrix4Inverse(pM->mat, pOut->mat) ? pOut : NULL;
+    }
+#endif
+
     kmMat4Assign(&inv, pM);
 
     kmMat4Identity(&tmp);
@@ -228,6 +235,13 @@ kmMat4* const kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
 
     const float *m1 = pM1->mat, *m2 = pM2->mat;
 
+#if defined(KM_USE_SSE2)
+    if (kmSIMDFeatures()) {
+        SSE_Matrix4Mul(m1, m2, pOut->mat);
+        return pOut;
+    }
+#endif
+
     mat[0] = m1[0] * m2[0] + m1[4] * m2[1] + m1[8] * m2[2] + m1[12] * m2[3];
     mat[1] = m1[1] * m2[0] + m1[5] * m2[1] + m1[9] * m2[2] + m1[13] * m2[3];
     mat[2] = m1[2] * m2[0] + m1[6] * m2[1] + m1[10] * m2[2] + m1[14] * m2[3];
@@ -0,0 +1,296 @@
+/*
+Copyright (c) 2013 cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "kazmath/utility.h"
+#include "kazmath/sse_matrix_impl.h"
+
+#if defined(KM_USE_SSE2)
+
+#include <emmintrin.h>
+#if defined(KM_USE_AVX)
+#include <immintrin.h>
+#endif
+
+#if defined(KM_USE_AVX) && !defined(__AVX__) && !defined(_MSC_VER)
+#define KM_AVX_FUNCTION __attribute__((target("avx")))
+#else
+#define KM_AVX_FUNCTION
+#endif
+
+#define KM_SPLAT(v, i) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(i, i, i, i))
+
+#if defined(KM_USE_AVX)
+
+KM_AVX_FUNCTION static void AVX_Matrix4Mul(const float* a, const float* b, float* output)
+{
+    // both 128 bits lanes hold the columns of a, each lane computes one column of the result
+    __m256 a0 = _mm256_broadcast_ps((const __m128*)(a));
+    __m256 a1 = _mm256_broadcast_ps((const __m128*)(a + 4));
+    __m256 a2 = _mm256_broadcast_ps((const __m128*)(a + 8));
+    __m256 a3 = _mm256_broadcast_ps((const __m128*)(a + 12));
+    __m256 b01 = _mm256_loadu_ps(b);
+    __m256 b23 = _mm256_loadu_ps(b + 8);
+    __m256 r01, r23;
+
+    r01 = _mm256_mul_ps(_mm256_shuffle_ps(b01, b01, 0x00), a0);
+    r23 = _mm256_mul_ps(_mm256_shuffle_ps(b23, b23, 0x00), a0);
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(b01, b01, 0x55), a1));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(b23, b23, 0x55), a1));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(b01, b01, 0xAA), a2));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(b23, b23, 0xAA), a2));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(b01, b01, 0xFF), a3));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(b23, b23, 0xFF), a3));
+
+    _mm256_storeu_ps(output, r01);
+    _mm256_storeu_ps(output + 8, r23);
+}
+
+KM_AVX_FUNCTION static void AVX_Matrix4Vector4MulArray(const float* m, const float* v, unsigned int vStride,
+                                                       float* output, unsigned int outStride, unsigned int count)
+{
+    __m256 c0 = _mm256_broadcast_ps((const __m128*)(m));
+    __m256 c1 = _mm256_broadcast_ps((const __m128*)(m + 4));
+    __m256 c2 = _mm256_broadcast_ps((const __m128*)(m + 8));
+    __m256 c3 = _mm256_broadcast_ps((const __m128*)(m + 12));
+    unsigned int i;
+
+    // two vectors per iteration, one in each 128 bits lane
+    for (i = 0; i + 1 < count; i += 2)
+    {
+        const float* v0 = v + i * vStride * 4;
+        const float* v1 = v0 + vStride * 4;
+        float* out0 = output + i * outStride * 4;
+        float* out1 = out0 + outStride * 4;
+        __m256 in = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(v0)), _mm_loadu_ps(v1), 1);
+        __m256 r;
+
+        r = _mm256_mul_ps(_mm256_shuffle_ps(in, in, 0x00), c0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(in, in, 0x55), c1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(in, in, 0xAA), c2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(in, in, 0xFF), c3));
+
+        _mm_storeu_ps(out0, _mm256_castps256_ps128(r));
+        _mm_storeu_ps(out1, _mm256_extractf128_ps(r, 1));
+    }
+
+    if (i < count)
+    {
+        __m128 in = _mm_loadu_ps(v + i * vStride * 4);
+        __m128 r;
+
+        r = _mm_mul_ps(KM_SPLAT(in, 0), _mm256_castps256_ps128(c0));
+        r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(in, 1), _mm256_castps256_ps128(c1)));
+        r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(in, 2), _mm256_castps256_ps128(c2)));
+        r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(in, 3), _mm256_castps256_ps128(c3)));
+        _mm_storeu_ps(output + i * outStride * 4, r);
+    }
+}
+
+#endif // KM_USE_AVX
+
+void SSE_Matrix4Mul(const float* a, const float* b, float* output)
+{
+    __m128 a0, a1, a2, a3, b0, b1, b2, b3, r;
+
+#if defined(KM_USE_AVX)
+    if (kmSIMDFeatures() & KM_SIMD_AVX)
+    {
+        AVX_Matrix4Mul(a, b, output);
+        return;
+    }
+#endif
+
+    // every input is loaded before the first store, output may alias a or b
+    a0 = _mm_loadu_ps(a);
+    a1 = _mm_loadu_ps(a + 4);
+    a2 = _mm_loadu_ps(a + 8);
+    a3 = _mm_loadu_ps(a + 12);
+    b0 = _mm_loadu_ps(b);
+    b1 = _mm_loadu_ps(b + 4);
+    b2 = _mm_loadu_ps(b + 8);
+    b3 = _mm_loadu_ps(b + 12);
+
+#define KM_MUL_COLUMN(col, out) \
+    r = _mm_mul_ps(KM_SPLAT(col, 0), a0); \
+    r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(col, 1), a1)); \
+    r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(col, 2), a2)); \
+    r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(col, 3), a3)); \
+    _mm_storeu_ps(out, r)
+
+    KM_MUL_COLUMN(b0, output);
+    KM_MUL_COLUMN(b1, output + 4);
+    KM_MUL_COLUMN(b2, output + 8);
+    KM_MUL_COLUMN(b3, output + 12);
+
+#undef KM_MUL_COLUMN
+}
+
+int SSE_Matrix4Inverse(const float* m, float* output)
+{
+    // Cramer's rule on the transposed matrix, after Intel's "Streaming SIMD
+    // Extensions - Inverse of 4x4 Matrix" (AP-928)
+    __m128 minor0, minor1, minor2, minor3;
+    __m128 row0, row1, row2, row3;
+    __m128 det, tmp;
+    float d;
+
+    tmp  = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(m)), (const __m64*)(m + 4));
+    row1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(m + 8)), (const __m64*)(m + 12));
+    row0 = _mm_shuffle_ps(tmp, row1, 0x88);
+    row1 = _mm_shuffle_ps(row1, tmp, 0xDD);
+    tmp  = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(m + 2)), (const __m64*)(m + 6));
+    row3 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(m + 10)), (const __m64*)(m + 14));
+    row2 = _mm_shuffle_ps(tmp, row3, 0x88);
+    row3 = _mm_shuffle_ps(row3, tmp, 0xDD);
+
+    tmp    = _mm_mul_ps(row2, row3);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0xB1);
+    minor0 = _mm_mul_ps(row1, tmp);
+    minor1 = _mm_mul_ps(row0, tmp);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0x4E);
+    minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp), minor0);
+    minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor1);
+    minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+    tmp    = _mm_mul_ps(row1, row2);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0xB1);
+    minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor0);
+    minor3 = _mm_mul_ps(row0, tmp);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0x4E);
+    minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp));
+    minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor3);
+    minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+    tmp    = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0xB1);
+    row2   = _mm_shuffle_ps(row2, row2, 0x4E);
+    minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp), minor0);
+    minor2 = _mm_mul_ps(row0, tmp);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0x4E);
+    minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp));
+    minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor2);
+    minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+    tmp    = _mm_mul_ps(row0, row1);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0xB1);
+    minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor2);
+    minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp), minor3);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0x4E);
+    minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp), minor2);
+    minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp));
+
+    tmp    = _mm_mul_ps(row0, row3);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0xB1);
+    minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp));
+    minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp), minor2);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0x4E);
+    minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp), minor1);
+    minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp));
+
+    tmp    = _mm_mul_ps(row0, row2);
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0xB1);
+    minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor1);
+    minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp));
+    tmp    = _mm_shuffle_ps(tmp, tmp, 0x4E);
+    minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp));
+    minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp), minor3);
+
+    det = _mm_mul_ps(row0, minor0);
+    det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+    det = _mm_add_ss(_mm_shuffle_ps(det, det, 0xB1), det);
+    d = _mm_cvtss_f32(det);
+    if (d == 0.0f)
+    {
+        return 0;
+    }
+
+    // a real division, the reciprocal estimate is not precise enough for kmMat4Inverse users
+    det = _mm_set1_ps(1.0f / d);
+    _mm_storeu_ps(output, _mm_mul_ps(det, minor0));
+    _mm_storeu_ps(output + 4, _mm_mul_ps(det, minor1));
+    _mm_storeu_ps(output + 8, _mm_mul_ps(det, minor2));
+    _mm_storeu_ps(output + 12, _mm_mul_ps(det, minor3));
+    return 1;
+}
+
+void SSE_Matrix4Vector4Mul(const float* m, const float* v, float* output)
+{
+    __m128 in = _mm_loadu_ps(v);
+    __m128 r;
+
+    r = _mm_mul_ps(KM_SPLAT(in, 0), _mm_loadu_ps(m));
+    r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(in, 1), _mm_loadu_ps(m + 4)));
+    r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(in, 2), _mm_loadu_ps(m + 8)));
+    r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(in, 3), _mm_loadu_ps(m + 12)));
+    _mm_storeu_ps(output, r);
+}
+
+void SSE_Matrix4Vector3Mul(const float* m, const float* v, float* output)
+{
+    // a kmVec3 is only 12 bytes, don't read or write past it
+    __m128 x = _mm_set1_ps(v[0]);
+    __m128 y = _mm_set1_ps(v[1]);
+    __m128 z = _mm_set1_ps(v[2]);
+    __m128 r;
+
+    r = _mm_mul_ps(x, _mm_loadu_ps(m));
+    r = _mm_add_ps(r, _mm_mul_ps(y, _mm_loadu_ps(m + 4)));
+    r = _mm_add_ps(r, _mm_mul_ps(z, _mm_loadu_ps(m + 8)));
+    r = _mm_add_ps(r, _mm_loadu_ps(m + 12));
+
+    _mm_storel_pi((__m64*)output, r);
+    _mm_store_ss(output + 2, _mm_movehl_ps(r, r));
+}
+
+void SSE_Matrix4Vector4MulArray(const float* m, const float* v, unsigned int vStride,
+                                float* output, unsigned int outStride, unsigned int count)
+{
+    __m128 c0, c1, c2, c3;
+    unsigned int i;
+
+#if defined(KM_USE_AVX)
+    if (kmSIMDFeatures() & KM_SIMD_AVX)
+    {
+        AVX_Matrix4Vector4MulArray(m, v, vStride, output, outStride, count);
+        return;
+    }
+#endif
+
+    c0 = _mm_loadu_ps(m);
+    c1 = _mm_loadu_ps(m + 4);
+    c2 = _mm_loadu_ps(m + 8);
+    c3 = _mm_loadu_ps(m + 12);
+
+    for (i = 0; i < count; ++i)
+    {
+        __m128 in = _mm_loadu_ps(v + i * vStride * 4);
+        __m128 r;
+
+        r = _mm_mul_ps(KM_SPLAT(in, 0), c0);
+        r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(in, 1), c1));
+        r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(in, 2), c2));
+        r = _mm_add_ps(r, _mm_mul_ps(KM_SPLAT(in, 3), c3));
+        _mm_storeu_ps(output + i * outStride * 4, r);
+    }
+}
+
+#endif // KM_USE_SSE2
@@ -57,3 +57,69 @@ kmScalar kmMax(kmScalar lhs, kmScalar rhs) {
 kmBool kmAlmostEqual(kmScalar lhs, kmScalar rhs) {
     return (lhs + kmEpsilon > rhs && lhs - kmEpsilon < rhs);
 }
+
+#include "kazmath/sse_matrix_impl.h"
+
+#if defined(KM_USE_SSE2)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+static int s_simdSupported = -1;
+static int s_simdFeatures = -1;
+
+static int kmDetectSIMDFeatures(void) {
+    int features = 0;
+#if defined(KM_USE_SSE2)
+    unsigned int ecx = 0;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    ecx = (unsigned int)info[2];
+#else
+    unsigned int eax, ebx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        ecx = 0;
+    }
+#endif
+
+    features |= KM_SIMD_SSE2;
+
+#if defined(KM_USE_AVX)
+    /* the CPU supports AVX (bit 28) and the OS saves the YMM registers (OSXSAVE, bit 27, then XCR0) */
+    if ((ecx & (1u << 27)) && (ecx & (1u << 28))) {
+        unsigned long long xcr0;
+#if defined(_MSC_VER)
+        xcr0 = _xgetbv(0);
+#else
+        unsigned int lo, hi;
+        __asm__ __volatile__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+        xcr0 = ((unsigned long long)hi << 32) | lo;
+#endif
+        if ((xcr0 & 6) == 6) {
+            features |= KM_SIMD_AVX;
+        }
+    }
+#else
+    (void)ecx;
+#endif
+#endif
+    return features;
+}
+
+int kmSIMDFeatures(void) {
+    if (s_simdFeatures < 0) {
+        s_simdSupported = kmDetectSIMDFeatures();
+        s_simdFeatures = s_simdSupported;
+    }
+    return s_simdFeatures;
+}
+
+int kmSetSIMDFeatures(int mask) {
+    kmSIMDFeatures();
+    s_simdFeatures = s_simdSupported & mask;
+    return s_simdFeatures;
+}
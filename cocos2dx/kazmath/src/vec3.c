@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/vec4.h"
 #include "kazmath/mat4.h"
 #include "kazmath/vec3.h"
+#include "kazmath/sse_matrix_impl.h"
 
 /**
  * Fill a kmVec3 structure using 3 floating point values
@@ -166,6 +167,13 @@ kmVec3* kmVec3Transform(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
 
     kmVec3 v;
 
+#if defined(KM_USE_SSE2)
+    if (kmSIMDFeatures()) {
+        SSE_Matrix4Vector3Mul(pM->mat, &pV->x, &pOut->x);
+        return pOut;
+    }
+#endif
+
     v.x = pV->x * pM->mat[0] + pV->y * pM->mat[4] + pV->z * pM->mat[8] + pM->mat[12];
     v.y = pV->x * pM->mat[1] + pV->y * pM->mat[5] + pV->z * pM->mat[9] + pM->mat[13];
     v.z = pV->x * pM->mat[2] + pV->y * pM->mat[6] + pV->z * pM->mat[10] + pM->mat[14];
@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/utility.h"
 #include "kazmath/vec4.h"
 #include "kazmath/mat4.h"
+#include "kazmath/sse_matrix_impl.h"
 
 
 kmVec4* kmVec4Fill(kmVec4* pOut, kmScalar x, kmScalar y, kmScalar z, kmScalar w)
@@ -113,6 +114,12 @@ kmVec4* kmVec4Subtract(kmVec4* pOut, const kmVec4* pV1, const kmVec4* pV2) {
 
 /// Transforms a 4D vector by a matrix, the result is stored in pOut, and pOut is returned.
 kmVec4* kmVec4Transform(kmVec4* pOut, const kmVec4* pV, const kmMat4* pM) {
+#if defined(KM_USE_SSE2)
+    if (kmSIMDFeatures()) {
+        SSE_Matrix4Vector4Mul(pM->mat, &pV->x, &pOut->x);
+        return pOut;
+    }
+#endif
     pOut->x = pV->x * pM->mat[0] + pV->y * pM->mat[4] + pV->z * pM->mat[8] + pV->w * pM->mat[12];
     pOut->y = pV->x * pM->mat[1] + pV->y * pM->mat[5] + pV->z * pM->mat[9] + pV->w * pM->mat[13];
     pOut->z = pV->x * pM->mat[2] + pV->y * pM->mat[6] + pV->z * pM->mat[10] + pV->w * pM->mat[14];
@@ -124,6 +131,12 @@ kmVec4* kmVec4Transform(kmVec4* pOut, const kmVec4* pV, const kmMat4* pM) {
 kmVec4* kmVec4TransformArray(kmVec4* pOut, unsigned int outStride,
             const kmVec4* pV, unsigned int vStride, const kmMat4* pM, unsigned int count) {
     unsigned int i = 0;
+#if defined(KM_USE_SSE2)
+    if (kmSIMDFeatures()) {
+        SSE_Matrix4Vector4MulArray(pM->mat, &pV->x, vStride, &pOut->x, outStride, count);
+        return pOut;
+    }
+#endif
     //Go through all of the vectors
     while (i < count) {
         const kmVec4* in = pV + (i * vStride); //Get a pointer to the current input
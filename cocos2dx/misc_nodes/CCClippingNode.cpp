@@ -29,9 +29,15 @@
 #include "kazmath/GL/matrix.h"
 #include "shaders/CCGLProgram.h"
 #include "shaders/CCShaderCache.h"
+#include "shaders/ccGLStateCache.h"
 #include "CCDirector.h"
 #include "support/CCPointExtension.h"
 #include "draw_nodes/CCDrawingPrimitives.h"
+#include "draw_nodes/CCDrawNode.h"
+#include "layers_scenes_transitions_nodes/CCLayer.h"
+#include "sprite_nodes/CCSprite.h"
+#include "effects/CCGrid.h"
+#include <typeinfo>
 
 NS_CC_BEGIN
 
@@ -142,8 +148,165 @@ void CCClippingNode::onExit()
     CCNode::onExit();
 }
 
+bool CCClippingNode::getStencilScissorBox(GLint *pBox)
+{
+    // with an alpha test or inverted, the clipped area is not the stencil's rectangle
+    if (m_bInverted || m_fAlphaThreshold < 1)
+    {
+        return false;
+    }
+
+    if (m_pStencil->getChildrenCount() > 0 || (m_pStencil->getGrid() && m_pStencil->getGrid()->isActive()))
+    {
+        return false;
+    }
+
+    // only the nodes known to fill their rectangle, a subclass could draw anything
+    CCShaderCache *pShaderCache = CCShaderCache::sharedShaderCache();
+    CCGLProgram *pProgram = m_pStencil->getShaderProgram();
+    const std::type_info &type = typeid(*m_pStencil);
+    CCRect rect;
+    if (type == typeid(CCDrawNode))
+    {
+        if (pProgram != pShaderCache->programForKey(kCCShader_PositionLengthTexureColor)
+            || ! static_cast<CCDrawNode*>(m_pStencil)->isRectangle(&rect))
+        {
+            return false;
+        }
+    }
+    else if (type == typeid(CCLayerColor) || type == typeid(CCLayerGradient))
+    {
+        if (pProgram != pShaderCache->programForKey(kCCShader_PositionColor))
+        {
+            return false;
+        }
+        rect = CCRectMake(0, 0, m_pStencil->getContentSize().width, m_pStencil->getContentSize().height);
+    }
+    else if (type == typeid(CCSprite))
+    {
+        CCSprite *pSprite = static_cast<CCSprite*>(m_pStencil);
+        if (pSprite->getBatchNode() || pProgram != pShaderCache->programForKey(kCCShader_PositionTextureColor))
+        {
+            return false;
+        }
+        // the quad of a sprite is always axis aligned in its own space
+        ccV3F_C4B_T2F_Quad quad = pSprite->getQuad();
+        float minX = MIN(quad.bl.vertices.x, quad.tr.vertices.x);
+        float minY = MIN(quad.bl.vertices.y, quad.tr.vertices.y);
+        rect = CCRectMake(minX, minY, fabsf(quad.tr.vertices.x - quad.bl.vertices.x), fabsf(quad.tr.vertices.y - quad.bl.vertices.y));
+    }
+    else
+    {
+        return false;
+    }
+
+    // the matrices the stencil would be drawn with
+    kmMat4 modelview, projection, mvp;
+    kmGLPushMatrix();
+    transform();
+    m_pStencil->transform();
+    kmGLGetMatrix(KM_GL_MODELVIEW, &modelview);
+    kmGLPopMatrix();
+    kmGLGetMatrix(KM_GL_PROJECTION, &projection);
+    kmMat4Multiply(&mvp, &projection, &modelview);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    // corners of the rectangle in window coordinates
+    const float x[4] = { rect.getMinX(), rect.getMaxX(), rect.getMaxX(), rect.getMinX() };
+    const float y[4] = { rect.getMinY(), rect.getMinY(), rect.getMaxY(), rect.getMaxY() };
+    CCPoint corners[4];
+    const float *m = mvp.mat;
+    for (int i = 0; i < 4; i++)
+    {
+        float clipX = m[0] * x[i] + m[4] * y[i] + m[12];
+        float clipY = m[1] * x[i] + m[5] * y[i] + m[13];
+        float clipW = m[3] * x[i] + m[7] * y[i] + m[15];
+        if (clipW <= 0)
+        {
+            return false;
+        }
+        corners[i].x = viewport[0] + (clipX / clipW + 1) * 0.5f * viewport[2];
+        corners[i].y = viewport[1] + (clipY / clipW + 1) * 0.5f * viewport[3];
+    }
+
+    // the edges must be horizontal and vertical, in either order (e.g. rotated by 90 degrees)
+    const float epsilon = 0.01f;
+    bool bAligned = (fabsf(corners[0].y - corners[1].y) < epsilon && fabsf(corners[1].x - corners[2].x) < epsilon
+                  && fabsf(corners[2].y - corners[3].y) < epsilon && fabsf(corners[3].x - corners[0].x) < epsilon)
+                 || (fabsf(corners[0].x - corners[1].x) < epsilon && fabsf(corners[1].y - corners[2].y) < epsilon
+                  && fabsf(corners[2].x - corners[3].x) < epsilon && fabsf(corners[3].y - corners[0].y) < epsilon);
+    if (! bAligned)
+    {
+        return false;
+    }
+
+    // keep the pixels whose center is inside, like the rasterization of the stencil
+    float minX = MIN(corners[0].x, corners[2].x), maxX = MAX(corners[0].x, corners[2].x);
+    float minY = MIN(corners[0].y, corners[2].y), maxY = MAX(corners[0].y, corners[2].y);
+    pBox[0] = (GLint)floorf(minX + 0.5f);
+    pBox[1] = (GLint)floorf(minY + 0.5f);
+    pBox[2] = (GLint)floorf(maxX + 0.5f) - pBox[0];
+    pBox[3] = (GLint)floorf(maxY + 0.5f) - pBox[1];
+    return true;
+}
+
+void CCClippingNode::visitWithScissor(const GLint *pBox)
+{
+    CC_INCREMENT_SCISSOR_CLIPS(1);
+
+    // the scissor set by the enclosing nodes, restored afterwards: this is the nested scissor stack
+    // read from the GL state cache, a nested clipping node doesn't stall on a glGet
+    bool currentScissorEnabled = ccGLIsScissorTestEnabled();
+    GLint currentScissorBox[4] = {0};
+
+    GLint x0 = pBox[0], y0 = pBox[1];
+    GLint x1 = pBox[0] + pBox[2], y1 = pBox[1] + pBox[3];
+    if (currentScissorEnabled)
+    {
+        ccGLGetScissorBox(currentScissorBox);
+        x0 = MAX(x0, currentScissorBox[0]);
+        y0 = MAX(y0, currentScissorBox[1]);
+        x1 = MIN(x1, currentScissorBox[0] + currentScissorBox[2]);
+        y1 = MIN(y1, currentScissorBox[1] + currentScissorBox[3]);
+    }
+
+    // nothing is visible
+    if (x1 <= x0 || y1 <= y0)
+    {
+        return;
+    }
+
+    ccGLEnableScissorTest(true);
+    ccGLScissor(x0, y0, x1 - x0, y1 - y0);
+
+    CCNode::visit();
+
+    ccGLFlushDeferredDraw();
+    if (currentScissorEnabled)
+    {
+        ccGLScissor(currentScissorBox[0], currentScissorBox[1], currentScissorBox[2], currentScissorBox[3]);
+    }
+    else
+    {
+        ccGLEnableScissorTest(false);
+    }
+}
+
 void CCClippingNode::visit()
 {
+    // batched geometry drawn before this node must not be clipped
+    ccGLFlushDeferredDraw();
+
+    // an unrotated rectangle is clipped with a scissor, it doesn't need the stencil buffer
+    GLint scissorBox[4];
+    if (m_bVisible && m_pStencil && m_pStencil->isVisible() && getStencilScissorBox(scissorBox))
+    {
+        visitWithScissor(scissorBox);
+        return;
+    }
+
     // if stencil buffer disabled
     if (g_sStencilBits < 1)
     {
@@ -193,6 +356,7 @@ void CCClippingNode::visit()
     
     // increment the current layer
     layer++;
+    CC_INCREMENT_STENCIL_CLIPS(1);
     
     // mask of the current layer (ie: for layer 3: 00000100)
     GLint mask_layer = 0x1 << layer;
@@ -350,6 +514,9 @@ void CCClippingNode::visit()
     ///////////////////////////////////
     // CLEANUP
     
+    // batched children are still clipped
+    ccGLFlushDeferredDraw();
+
     // manually restore the stencil state
     glStencilFunc(currentStencilFunc, currentStencilRef, currentStencilValueMask);
     glStencilOp(currentStencilFail, currentStencilPassDepthFail, currentStencilPassDepthPass);
@@ -37,6 +37,11 @@ NS_CC_BEGIN
  It draws its content (childs) clipped using a stencil.
  The stencil is an other CCNode that will not be drawn.
  The clipping is done using the alpha part of the stencil (adjusted with an alphaThreshold).
+
+ When the stencil is an unrotated rectangle (a CCDrawNode holding a rectangle, a CCLayerColor,
+ a CCLayerGradient or a CCSprite without children and with their default shader), the alpha
+ threshold is 1 and the node is not inverted, the content is clipped with glScissor instead:
+ no stencil layer is used, nested scissors are intersected.
  */
 class CC_DLL CCClippingNode : public CCNode
 {
@@ -114,6 +119,12 @@ public:
     
 protected:
     CCClippingNode();
+
+    /** Returns true when the stencil covers an unrotated rectangle on the screen,
+     its box in window pixels (x, y, width, height) is returned in pBox.
+     */
+    bool getStencilScissorBox(GLint *pBox);
+    void visitWithScissor(const GLint *pBox);
 };
 
 NS_CC_END
@@ -41,9 +41,171 @@ THE SOFTWARE.
 // extern
 #include "kazmath/GL/matrix.h"
 #include "CCEGLView.h"
+#include "CCScheduler.h"
+#include <deque>
+
+#ifndef EMSCRIPTEN
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+// pixel buffer objects are part of desktop OpenGL, OpenGL ES 2.0 has no GL_PIXEL_PACK_BUFFER
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+#define CC_RENDER_TEXTURE_USE_PBO 1
+#else
+#define CC_RENDER_TEXTURE_USE_PBO 0
+#endif
 
 NS_CC_BEGIN
 
+struct _ccRenderTextureCapture
+{
+    int             nWidth;
+    int             nHeight;
+    bool            bFlipImage;
+    std::string     strPath;        // empty when the image isn't saved
+    GLubyte         *pData;         // NULL when the readback failed
+    unsigned int    uBuffer;        // pixel buffer of the readback
+    unsigned int    uFrame;         // frame of the readback
+    CCObject        *pTarget;
+    SEL_CallFuncO   pSelector;
+    CCScheduler     *pScheduler;
+};
+
+/** flips the rows, creates the image and saves it, then calls the selector on the main thread */
+static void processCapture(_ccRenderTextureCapture *pCapture, bool bNotify)
+{
+    CCImage *pImage = NULL;
+    bool bSaved = false;
+
+    if (pCapture->pData)
+    {
+        int nRowSize = pCapture->nWidth * 4;
+        if (pCapture->bFlipImage)
+        {
+            GLubyte *pRow = new GLubyte[nRowSize];
+            for (int i = 0; i < pCapture->nHeight / 2; ++i)
+            {
+                GLubyte *pTop = pCapture->pData + i * nRowSize;
+                GLubyte *pBottom = pCapture->pData + (pCapture->nHeight - i - 1) * nRowSize;
+                memcpy(pRow, pTop, nRowSize);
+                memcpy(pTop, pBottom, nRowSize);
+                memcpy(pBottom, pRow, nRowSize);
+            }
+            CC_SAFE_DELETE_ARRAY(pRow);
+        }
+
+        pImage = new CCImage();
+        if (! pImage->initWithImageData(pCapture->pData, nRowSize * pCapture->nHeight, CCImage::kFmtRawData, pCapture->nWidth, pCapture->nHeight, 8))
+        {
+            CC_SAFE_RELEASE_NULL(pImage);
+        }
+        CC_SAFE_DELETE_ARRAY(pCapture->pData);
+    }
+
+    if (pImage && ! pCapture->strPath.empty())
+    {
+        bSaved = pImage->saveToFile(pCapture->strPath.c_str(), true);
+    }
+
+    if (! bNotify)
+    {
+        // the application is exiting, nobody is waiting for the result
+        CC_SAFE_RELEASE(pImage);
+        delete pCapture;
+        return;
+    }
+
+    pCapture->pScheduler->performFunctionInCocosThread([pCapture, pImage, bSaved]() {
+        if (pCapture->pTarget && pCapture->pSelector)
+        {
+            if (pCapture->strPath.empty())
+            {
+                (pCapture->pTarget->*pCapture->pSelector)(pImage);
+            }
+            else
+            {
+                (pCapture->pTarget->*pCapture->pSelector)(bSaved ? CCString::create(pCapture->strPath) : NULL);
+            }
+        }
+        CC_SAFE_RELEASE(pCapture->pTarget);
+        CC_SAFE_RELEASE(pImage);
+        delete pCapture;
+    });
+}
+
+#ifndef EMSCRIPTEN
+
+// one worker thread encodes the captures of all the render textures
+static std::mutex s_captureMutex;
+static std::condition_variable s_captureCondition;
+static std::deque<_ccRenderTextureCapture*> s_captureQueue;
+static bool s_bCaptureQuit = false;
+static std::thread s_captureThread;
+
+static void captureThreadLoop()
+{
+    std::unique_lock<std::mutex> lock(s_captureMutex);
+    while (true)
+    {
+        if (s_captureQueue.empty())
+        {
+            if (s_bCaptureQuit)
+            {
+                break;
+            }
+            s_captureCondition.wait(lock);
+            continue;
+        }
+
+        _ccRenderTextureCapture *pCapture = s_captureQueue.front();
+        s_captureQueue.pop_front();
+        bool bNotify = ! s_bCaptureQuit;
+        lock.unlock();
+
+        processCapture(pCapture, bNotify);
+
+        lock.lock();
+    }
+}
+
+// finishes the queued captures, e.g. the files being saved, when the application exits
+static struct CaptureThreadGuard
+{
+    ~CaptureThreadGuard()
+    {
+        if (s_captureThread.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(s_captureMutex);
+                s_bCaptureQuit = true;
+            }
+            s_captureCondition.notify_one();
+            s_captureThread.join();
+        }
+    }
+} s_captureThreadGuard;
+
+#endif // EMSCRIPTEN
+
+static void queueCapture(_ccRenderTextureCapture *pCapture)
+{
+#ifdef EMSCRIPTEN
+    processCapture(pCapture, true);
+#else
+    {
+        std::lock_guard<std::mutex> lock(s_captureMutex);
+        if (! s_captureThread.joinable())
+        {
+            s_captureThread = std::thread(captureThreadLoop);
+        }
+        s_captureQueue.push_back(pCapture);
+    }
+    s_captureCondition.notify_one();
+#endif
+}
+
 // implementation CCRenderTexture
 CCRenderTexture::CCRenderTexture()
 : m_pSprite(NULL)
@@ -59,7 +221,10 @@ CCRenderTexture::CCRenderTexture()
 , m_fClearDepth(0.0f)
 , m_nClearStencil(0)
 , m_bAutoDraw(false)
+, m_uNextCaptureBuffer(0)
 {
+    memset(m_uCaptureBuffers, 0, sizeof(m_uCaptureBuffers));
+
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     // Listen this event to save render texture before come to background.
     // Then it can be restored after coming to foreground on Android.
@@ -87,6 +252,23 @@ CCRenderTexture::~CCRenderTexture()
     }
     CC_SAFE_DELETE(m_pUITextureImage);
 
+    // the scheduler keeps the render texture alive while captures are pending,
+    // they are only left when the director is purged
+    for (unsigned int i = 0; i < m_vPendingCaptures.size(); ++i)
+    {
+        CC_SAFE_RELEASE(m_vPendingCaptures[i]->pTarget);
+        delete m_vPendingCaptures[i];
+    }
+#if CC_RENDER_TEXTURE_USE_PBO
+    for (int i = 0; i < kCCRenderTextureCaptureBuffers; ++i)
+    {
+        if (m_uCaptureBuffers[i])
+        {
+            glDeleteBuffers(1, &m_uCaptureBuffers[i]);
+        }
+    }
+#endif
+
 #if CC_ENABLE_CACHE_TEXTURE_DATA
     CCNotificationCenter::sharedNotificationCenter()->removeObserver(this, EVENT_COME_TO_BACKGROUND);
     CCNotificationCenter::sharedNotificationCenter()->removeObserver(this, EVENT_COME_TO_FOREGROUND);
@@ -362,6 +544,9 @@ bool CCRenderTexture::initWithWidthAndHeight(int w, int h, CCTexture2DPixelForma
 
 void CCRenderTexture::begin()
 {
+    // batched geometry belongs to the previous render target
+    ccGLFlushDeferredDraw();
+
     kmGLMatrixMode(KM_GL_PROJECTION);
 	kmGLPushMatrix();
 	kmGLMatrixMode(KM_GL_MODELVIEW);
@@ -473,6 +658,7 @@ void CCRenderTexture::end()
 {
     CCDirector *director = CCDirector::sharedDirector();
     
+    ccGLFlushDeferredDraw();
     glBindFramebuffer(GL_FRAMEBUFFER, m_nOldFBO);
 
     // restore viewport
@@ -648,6 +834,158 @@ bool CCRenderTexture::saveToFile(const char *fileName, tCCImageFormat format)
     return bRet;
 }
 
+void CCRenderTexture::newCCImageAsync(CCObject *pTarget, SEL_CallFuncO pSelector, bool flipImage)
+{
+    CCAssert(m_ePixelFormat == kCCTexture2DPixelFormat_RGBA8888, "only RGBA8888 can be saved as image");
+
+    _ccRenderTextureCapture *pCapture = new _ccRenderTextureCapture();
+    pCapture->bFlipImage = flipImage;
+    pCapture->pTarget = pTarget;
+    pCapture->pSelector = pSelector;
+    CC_SAFE_RETAIN(pTarget);
+
+    startCapture(pCapture);
+}
+
+void CCRenderTexture::saveToFileAsync(const char *fileName, tCCImageFormat format, CCObject *pTarget, SEL_CallFuncO pSelector)
+{
+    CCAssert(format == kCCImageFormatJPEG || format == kCCImageFormatPNG,
+             "the image can only be saved as JPG or PNG format");
+    CCAssert(m_ePixelFormat == kCCTexture2DPixelFormat_RGBA8888, "only RGBA8888 can be saved as image");
+
+    _ccRenderTextureCapture *pCapture = new _ccRenderTextureCapture();
+    pCapture->bFlipImage = true;
+    pCapture->strPath = CCFileUtils::sharedFileUtils()->getWritablePath() + fileName;
+    pCapture->pTarget = pTarget;
+    pCapture->pSelector = pSelector;
+    CC_SAFE_RETAIN(pTarget);
+
+    startCapture(pCapture);
+}
+
+void CCRenderTexture::startCapture(_ccRenderTextureCapture *pCapture)
+{
+    CCDirector *pDirector = CCDirector::sharedDirector();
+    pCapture->pScheduler = pDirector->getScheduler();
+    pCapture->pData = NULL;
+    pCapture->uBuffer = 0;
+    pCapture->uFrame = pDirector->getTotalFrames();
+
+    if (NULL == m_pTexture)
+    {
+        pCapture->nWidth = pCapture->nHeight = 0;
+        queueCapture(pCapture);
+        return;
+    }
+
+    const CCSize& s = m_pTexture->getContentSizeInPixels();
+    pCapture->nWidth = (int)s.width;
+    pCapture->nHeight = (int)s.height;
+    int nSize = pCapture->nWidth * pCapture->nHeight * 4;
+
+    ccGLFlushDeferredDraw();
+
+    GLint nOldFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &nOldFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_uFBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+#if CC_RENDER_TEXTURE_USE_PBO
+    if (CCConfiguration::sharedConfiguration()->supportsPixelBufferObject())
+    {
+        bool bWasPending = ! m_vPendingCaptures.empty();
+
+        pCapture->uBuffer = m_uNextCaptureBuffer;
+        m_uNextCaptureBuffer = (m_uNextCaptureBuffer + 1) % kCCRenderTextureCaptureBuffers;
+
+        // all the buffers are in use, the oldest capture is read back now
+        for (std::vector<_ccRenderTextureCapture*>::iterator it = m_vPendingCaptures.begin(); it != m_vPendingCaptures.end(); ++it)
+        {
+            if ((*it)->uBuffer == pCapture->uBuffer)
+            {
+                finishCapture(*it);
+                m_vPendingCaptures.erase(it);
+                break;
+            }
+        }
+
+        if (! m_uCaptureBuffers[pCapture->uBuffer])
+        {
+            glGenBuffers(1, &m_uCaptureBuffers[pCapture->uBuffer]);
+        }
+
+        // the copy into the buffer is queued by the GPU, glReadPixels returns right away
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_uCaptureBuffers[pCapture->uBuffer]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, nSize, NULL, GL_STREAM_READ);
+        glReadPixels(0, 0, pCapture->nWidth, pCapture->nHeight, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, nOldFBO);
+        CHECK_GL_ERROR_DEBUG();
+
+        m_vPendingCaptures.push_back(pCapture);
+        if (! bWasPending)
+        {
+            pCapture->pScheduler->scheduleSelector(schedule_selector(CCRenderTexture::updateCaptures), this, 0, false);
+        }
+        return;
+    }
+#endif
+
+    // synchronous readback, only the flip and the encoding are moved to the worker thread
+    pCapture->pData = new GLubyte[nSize];
+    glReadPixels(0, 0, pCapture->nWidth, pCapture->nHeight, GL_RGBA, GL_UNSIGNED_BYTE, pCapture->pData);
+    glBindFramebuffer(GL_FRAMEBUFFER, nOldFBO);
+
+    queueCapture(pCapture);
+}
+
+void CCRenderTexture::finishCapture(_ccRenderTextureCapture *pCapture)
+{
+#if CC_RENDER_TEXTURE_USE_PBO
+    int nSize = pCapture->nWidth * pCapture->nHeight * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_uCaptureBuffers[pCapture->uBuffer]);
+    GLvoid *pPixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (pPixels)
+    {
+        pCapture->pData = new GLubyte[nSize];
+        memcpy(pCapture->pData, pPixels, nSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+    {
+        CCLOG("cocos2d: CCRenderTexture: failed to map the capture buffer");
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+#endif
+
+    queueCapture(pCapture);
+}
+
+void CCRenderTexture::updateCaptures(float dt)
+{
+    unsigned int uFrame = CCDirector::sharedDirector()->getTotalFrames();
+
+    std::vector<_ccRenderTextureCapture*>::iterator it = m_vPendingCaptures.begin();
+    while (it != m_vPendingCaptures.end())
+    {
+        if (uFrame - (*it)->uFrame >= kCCRenderTextureCaptureDelay)
+        {
+            finishCapture(*it);
+            it = m_vPendingCaptures.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (m_vPendingCaptures.empty())
+    {
+        CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCRenderTexture::updateCaptures), this);
+    }
+}
+
 /* get buffer as CCImage */
 CCImage* CCRenderTexture::newCCImage(bool flipImage)
 {
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "base_nodes/CCNode.h"
 #include "sprite_nodes/CCSprite.h"
 #include "kazmath/mat4.h"
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -41,6 +42,13 @@ typedef enum eImageFormat
     kCCImageFormatJPEG      = 0,
     kCCImageFormatPNG       = 1,
 } tCCImageFormat;
+
+/** number of pixel buffers used by the asynchronous captures of a render texture */
+#define kCCRenderTextureCaptureBuffers 3
+/** frames waited before mapping a pixel buffer, the GPU has finished the copy by then */
+#define kCCRenderTextureCaptureDelay   2
+
+struct _ccRenderTextureCapture;
 /**
 @brief CCRenderTexture is a generic rendering target. To render things into it,
 simply construct a render target, call begin on it, call visit on any cocos
@@ -131,6 +139,24 @@ public:
         Returns YES if the operation is successful.
      */
     bool saveToFile(const char *name, tCCImageFormat format);
+
+    /** Captures the texture without stalling the main thread.
+     Where pixel buffer objects are supported the pixels are read back a few frames later,
+     otherwise they are read right away. Flipping the rows is done on a worker thread.
+     The selector is called on the main thread with the CCImage, or NULL if the capture failed.
+     The image is released after the call, retain it to keep it.
+     @since v2.2
+     */
+    void newCCImageAsync(CCObject *pTarget, SEL_CallFuncO pSelector, bool flipImage = true);
+
+    /** saves the texture into a file like saveToFile(), the image is encoded on a worker thread.
+     The selector, if any, is called on the main thread with a CCString of the full path, or NULL if saving failed.
+     @since v2.2
+     */
+    void saveToFileAsync(const char *name, tCCImageFormat format, CCObject *pTarget = NULL, SEL_CallFuncO pSelector = NULL);
+
+    /** reads back the pixels of the finished asynchronous captures, scheduled while captures are pending */
+    void updateCaptures(float dt);
     
     /** Listen "come to background" message, and save render texture.
      It only has effect on Android.
@@ -166,6 +192,8 @@ public:
 
 private:
     void beginWithClear(float r, float g, float b, float a, float depthValue, int stencilValue, GLbitfield flags);
+    void startCapture(struct _ccRenderTextureCapture *pCapture);
+    void finishCapture(struct _ccRenderTextureCapture *pCapture);
 
 protected:
     GLuint       m_uFBO;
@@ -182,6 +210,11 @@ protected:
     GLclampf     m_fClearDepth;
     GLint        m_nClearStencil;
     bool         m_bAutoDraw;
+
+    // asynchronous captures
+    GLuint       m_uCaptureBuffers[kCCRenderTextureCaptureBuffers];
+    unsigned int m_uNextCaptureBuffer;
+    std::vector<struct _ccRenderTextureCapture*> m_vPendingCaptures;
 };
 
 // end of textures group
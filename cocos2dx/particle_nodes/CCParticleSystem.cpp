@@ -753,12 +753,14 @@ void CCParticleSystem::update(float dt)
 
                 if( m_uParticleCount == 0 && m_bIsAutoRemoveOnFinish )
                 {
+                    finishQuadUpdates();
                     this->unscheduleUpdate();
                     m_pParent->removeChild(this, true);
                     return;
                 }
             }
         } //while
+        finishQuadUpdates();
         m_bTransformSystemDirty = false;
     }
     if (! m_pBatchNode)
@@ -786,6 +788,11 @@ void CCParticleSystem::postStep()
     // should be overridden
 }
 
+void CCParticleSystem::finishQuadUpdates()
+{
+    // should be overridden
+}
+
 // ParticleSystem - CCTexture protocol
 void CCParticleSystem::setTexture(CCTexture2D* var)
 {
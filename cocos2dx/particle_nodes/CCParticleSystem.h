@@ -425,6 +425,11 @@ public:
     virtual void updateQuadWithParticle(tCCParticle* particle, const CCPoint& newPosition);
     //! should be overridden by subclasses
     virtual void postStep();
+    /** called once the quads of all the particles were updated, subclasses that defer the
+     work of updateQuadWithParticle complete it here
+     @since v2.2
+     */
+    virtual void finishQuadUpdates();
 
     virtual void update(float dt);
     virtual void updateWithNoTime(void);
@@ -85,6 +85,7 @@ CCParticleSystemQuad::CCParticleSystemQuad()
 #if CC_TEXTURE_ATLAS_USE_VAO
 ,m_uVAOname(0)
 #endif
+,m_uQuadTransformCount(0)
 {
     memset(m_pBuffersVBO, 0, sizeof(m_pBuffersVBO));
 }
@@ -268,41 +269,24 @@ void CCParticleSystemQuad::updateQuadWithParticle(tCCParticle* particle, const C
     GLfloat size_2 = particle->size/2;
     if (particle->rotation) 
     {
-        GLfloat x1 = -size_2;
-        GLfloat y1 = -size_2;
-
-        GLfloat x2 = size_2;
-        GLfloat y2 = size_2;
-        GLfloat x = newPosition.x;
-        GLfloat y = newPosition.y;
-
+        // the vertices are computed in batches, see finishQuadUpdates()
         GLfloat r = (GLfloat)-CC_DEGREES_TO_RADIANS(particle->rotation);
         GLfloat cr = cosf(r);
         GLfloat sr = sinf(r);
-        GLfloat ax = x1 * cr - y1 * sr + x;
-        GLfloat ay = x1 * sr + y1 * cr + y;
-        GLfloat bx = x2 * cr - y1 * sr + x;
-        GLfloat by = x2 * sr + y1 * cr + y;
-        GLfloat cx = x2 * cr - y2 * sr + x;
-        GLfloat cy = x2 * sr + y2 * cr + y;
-        GLfloat dx = x1 * cr - y2 * sr + x;
-        GLfloat dy = x1 * sr + y2 * cr + y;
-
-        // bottom-left
-        quad->bl.vertices.x = ax;
-        quad->bl.vertices.y = ay;
 
-        // bottom-right vertex:
-        quad->br.vertices.x = bx;
-        quad->br.vertices.y = by;
+        ccQuadTransform& item = m_pQuadTransforms[m_uQuadTransformCount++];
+        item.transform = CCAffineTransformMake(cr, sr, -sr, cr, newPosition.x, newPosition.y);
+        item.x1 = -size_2;
+        item.y1 = -size_2;
+        item.x2 = size_2;
+        item.y2 = size_2;
+        item.z = quad->bl.vertices.z;
+        item.quad = quad;
 
-        // top-left vertex:
-        quad->tl.vertices.x = dx;
-        quad->tl.vertices.y = dy;
-
-        // top-right vertex:
-        quad->tr.vertices.x = cx;
-        quad->tr.vertices.y = cy;
+        if (m_uQuadTransformCount == kCCParticleQuadTransformBatch)
+        {
+            finishQuadUpdates();
+        }
     } 
     else 
     {
@@ -323,8 +307,20 @@ void CCParticleSystemQuad::updateQuadWithParticle(tCCParticle* particle, const C
         quad->tr.vertices.y = newPosition.y + size_2;                
     }
 }
+void CCParticleSystemQuad::finishQuadUpdates()
+{
+    if (m_uQuadTransformCount)
+    {
+        ccTransformQuads(m_pQuadTransforms, m_uQuadTransformCount);
+        m_uQuadTransformCount = 0;
+    }
+}
+
 void CCParticleSystemQuad::postStep()
 {
+    // in case updateQuadWithParticle was called outside of update()
+    finishQuadUpdates();
+
     glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
 	
 	// Option 1: Sub Data
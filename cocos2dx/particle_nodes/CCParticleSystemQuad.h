@@ -28,11 +28,15 @@ THE SOFTWARE.
 #define __CC_PARTICLE_SYSTEM_QUAD_H__
 
 #include  "CCParticleSystem.h"
+#include "support/TransformUtils.h"
 
 NS_CC_BEGIN
 
 class CCSpriteFrame;
 
+/** number of rotated particles whose vertices are computed by a single ccTransformQuads call */
+#define kCCParticleQuadTransformBatch 32
+
 /**
  * @addtogroup particle_nodes
  * @{
@@ -62,6 +66,9 @@ protected:
 
     GLuint                m_pBuffersVBO[2]; //0: vertex  1: indices
 
+    ccQuadTransform       m_pQuadTransforms[kCCParticleQuadTransformBatch];
+    unsigned int          m_uQuadTransformCount;
+
 public:
     /**
      * @js ctor
@@ -111,6 +118,10 @@ public:
      * @js NA
      */
     virtual void postStep();
+    /**
+     * @js NA
+     */
+    virtual void finishQuadUpdates();
     /**
      * @js NA
      * @lua NA
@@ -2,6 +2,7 @@
 #include "touch_dispatcher/CCTouchDispatcher.h"
 #include "touch_dispatcher/CCTouch.h"
 #include "CCDirector.h"
+#include "shaders/ccGLStateCache.h"
 #include "cocoa/CCSet.h"
 #include "cocoa/CCDictionary.h"
 #include "cocoa/CCInteger.h"
@@ -159,21 +160,21 @@ void CCEGLViewProtocol::setViewPortInPoints(float x , float y , float w , float
 
 void CCEGLViewProtocol::setScissorInPoints(float x , float y , float w , float h)
 {
-    glScissor((GLint)(x * m_fScaleX + m_obViewPortRect.origin.x),
-              (GLint)(y * m_fScaleY + m_obViewPortRect.origin.y),
-              (GLsizei)(w * m_fScaleX),
-              (GLsizei)(h * m_fScaleY));
+    ccGLScissor((GLint)(x * m_fScaleX + m_obViewPortRect.origin.x),
+                (GLint)(y * m_fScaleY + m_obViewPortRect.origin.y),
+                (GLsizei)(w * m_fScaleX),
+                (GLsizei)(h * m_fScaleY));
 }
 
 bool CCEGLViewProtocol::isScissorEnabled()
 {
-	return (GL_FALSE == glIsEnabled(GL_SCISSOR_TEST)) ? false : true;
+	return ccGLIsScissorTestEnabled();
 }
 
 CCRect CCEGLViewProtocol::getScissorRect()
 {
-	GLfloat params[4];
-	glGetFloatv(GL_SCISSOR_BOX, params);
+	GLint params[4];
+	ccGLGetScissorBox(params);
 	float x = (params[0] - m_obViewPortRect.origin.x) / m_fScaleX;
 	float y = (params[1] - m_obViewPortRect.origin.y) / m_fScaleY;
 	float w = params[2] / m_fScaleX;
@@ -29,6 +29,7 @@ THE SOFTWARE.
 #include "CCSAXParser.h"
 #include "support/tinyxml2/tinyxml2.h"
 #include "support/zip_support/unzip.h"
+#include "support/zip_support/ZipUtils.h"
 #include <stack>
 #include <algorithm>
 
@@ -492,8 +493,18 @@ unsigned char* CCFileUtils::getFileData(const char* pszFileName, const char* psz
     *pSize = 0;
     do
     {
-        // read the file from hardware
         std::string fullPath = fullPathForFilename(pszFileName);
+
+        // read the file from a search pack
+        std::string entryName;
+        std::shared_ptr<ZipFile> pPack = getSearchPackForPath(fullPath, entryName);
+        if (pPack)
+        {
+            pBuffer = pPack->getFileData(entryName, pSize);
+            break;
+        }
+
+        // read the file from hardware
         FILE *fp = fopen(fullPath.c_str(), pszMode);
         CC_BREAK_IF(!fp);
         
@@ -582,6 +593,22 @@ std::string CCFileUtils::getPathForFilename(const std::string& filename, const s
         file = filename.substr(pos+1);
     }
     
+    // the file lives in an archive, check its index instead of the file system
+    std::shared_ptr<ZipFile> pPack;
+    {
+        std::lock_guard<std::mutex> lock(m_searchPackMutex);
+        std::map<std::string, std::shared_ptr<ZipFile> >::iterator packIter = m_searchPackMap.find(searchPath);
+        if (packIter != m_searchPackMap.end())
+        {
+            pPack = packIter->second;
+        }
+    }
+    if (pPack)
+    {
+        std::string entryName = file_path + resolutionDirectory + file;
+        return pPack->fileExists(entryName) ? searchPath + entryName : "";
+    }
+    
     // searchPath + file_path + resourceDirectory
     std::string path = searchPath;
     path += file_path;
@@ -724,6 +751,8 @@ void CCFileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
         //CCLOG("Default root path doesn't exist, adding it.");
         m_searchPathArray.push_back(m_strDefaultResRootPath);
     }
+
+    updateSearchPacks();
 }
 
 void CCFileUtils::addSearchPath(const char* path_)
@@ -740,6 +769,7 @@ void CCFileUtils::addSearchPath(const char* path_)
         path += "/";
     }
     m_searchPathArray.push_back(path);
+    updateSearchPacks();
 }
 
 void CCFileUtils::removeSearchPath(const char *path_)
@@ -757,11 +787,77 @@ void CCFileUtils::removeSearchPath(const char *path_)
 	}
 	std::vector<std::string>::iterator iter = std::find(m_searchPathArray.begin(), m_searchPathArray.end(), path);
 	m_searchPathArray.erase(iter);
+	updateSearchPacks();
 }
 
 void CCFileUtils::removeAllPaths()
 {
 	m_searchPathArray.clear();
+	updateSearchPacks();
+}
+
+static bool isSearchPackPath(const std::string& path)
+{
+    static const char* s_packExtensions[] = { ".zip/", ".obb/", ".apk/", ".pak/" };
+    for (unsigned int i = 0; i < sizeof(s_packExtensions) / sizeof(s_packExtensions[0]); ++i)
+    {
+        size_t len = strlen(s_packExtensions[i]);
+        if (path.length() > len && path.compare(path.length() - len, len, s_packExtensions[i]) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CCFileUtils::updateSearchPacks()
+{
+    std::lock_guard<std::mutex> lock(m_searchPackMutex);
+
+    // close the packs which are no longer searched, once the readers holding them are done
+    std::map<std::string, std::shared_ptr<ZipFile> >::iterator iter = m_searchPackMap.begin();
+    while (iter != m_searchPackMap.end())
+    {
+        if (std::find(m_searchPathArray.begin(), m_searchPathArray.end(), iter->first) == m_searchPathArray.end())
+        {
+            m_searchPackMap.erase(iter++);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    for (std::vector<std::string>::iterator pathIter = m_searchPathArray.begin(); pathIter != m_searchPathArray.end(); ++pathIter)
+    {
+        if (!isSearchPackPath(*pathIter) || m_searchPackMap.find(*pathIter) != m_searchPackMap.end())
+        {
+            continue;
+        }
+
+        // drop the trailing '/' which was appended to the search path
+        std::shared_ptr<ZipFile> pPack(new ZipFile(pathIter->substr(0, pathIter->length() - 1)));
+        if (!pPack->isOpen())
+        {
+            CCLOG("cocos2d: CCFileUtils: can't open search pack %s", pathIter->c_str());
+            continue;
+        }
+        m_searchPackMap[*pathIter] = pPack;
+    }
+}
+
+std::shared_ptr<ZipFile> CCFileUtils::getSearchPackForPath(const std::string& fullPath, std::string& entryName)
+{
+    std::lock_guard<std::mutex> lock(m_searchPackMutex);
+    for (std::map<std::string, std::shared_ptr<ZipFile> >::iterator iter = m_searchPackMap.begin(); iter != m_searchPackMap.end(); ++iter)
+    {
+        if (fullPath.compare(0, iter->first.length(), iter->first) == 0)
+        {
+            entryName = fullPath.substr(iter->first.length());
+            return iter->second;
+        }
+    }
+    return NULL;
 }
 void CCFileUtils::setFilenameLookupDictionary(CCDictionary* pFilenameLookupDict)
 {
@@ -27,6 +27,8 @@ THE SOFTWARE.
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
 #include "CCPlatformMacros.h"
 #include "ccTypes.h"
 #include "ccTypeInfo.h"
@@ -35,6 +37,7 @@ NS_CC_BEGIN
 
 class CCDictionary;
 class CCArray;
+class ZipFile;
 /**
  * @addtogroup platform
  * @{
@@ -253,6 +256,11 @@ public:
      *        	If "/mnt/sdcard/" and "resources-large" were set to the search paths vector,
      *        	"resources-large" will be converted to "assets/resources-large" since it was a relative path.
      *
+     *  @note A search path which names a zip archive (".zip", ".obb", ".apk" or ".pak") is opened as a search pack.
+     *        Files are then looked up in the archive index instead of the file system, e.g. "/mnt/sdcard/main.obb"
+     *        resolves "sprite.png" to "/mnt/sdcard/main.obb/sprite.png", which getFileData reads from the archive.
+     *        The archive has to be a plain file on disk, it can't be nested in the apk on Android.
+     *
      *  @param searchPaths The array contains search paths.
      *  @see fullPathForFilename(const char*)
      *  @since v2.1
@@ -393,6 +401,21 @@ protected:
      *  @note This method is used internally.
      */
     virtual CCArray* createCCArrayWithContentsOfFile(const std::string& filename);
+
+    /**
+     *  Gets the search pack containing a full path.
+     *  @param fullPath The full path returned by fullPathForFilename.
+     *  @param[out] entryName The name of the file inside the archive.
+     *  @return The search pack, or NULL if the path doesn't point into one. It stays open while
+     *          it is referenced, even if its search path is removed meanwhile on another thread.
+     */
+    std::shared_ptr<ZipFile> getSearchPackForPath(const std::string& fullPath, std::string& entryName);
+
+    /**
+     *  Opens the archives in the search paths and closes those which were removed.
+     *  @note This method is used internally.
+     */
+    void updateSearchPacks();
     
     /** Dictionary used to lookup filenames based on a key.
      *  It is used internally by the following methods:
@@ -414,6 +437,14 @@ protected:
      * The lower index of the element in this vector, the higher priority for this search path.
      */
     std::vector<std::string> m_searchPathArray;
+
+    /**
+     *  The opened search packs, keyed by their entry in m_searchPathArray.
+     *  The packs are shared by all threads, they are only opened and closed while the search paths change.
+     *  The map is guarded by m_searchPackMutex, the async loaders look it up while the main thread changes it.
+     */
+    std::map<std::string, std::shared_ptr<ZipFile> > m_searchPackMap;
+    std::mutex m_searchPackMutex;
     
     /**
      *  The default root path of resources.
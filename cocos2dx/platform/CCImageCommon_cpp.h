@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "CCCommon.h"
 #include "CCStdC.h"
 #include "CCFileUtils.h"
+#include "support/zip_support/ZipUtils.h"
 #include "png.h"
 #include "jpeglib.h"
 #include "tiffio.h"
@@ -177,6 +178,28 @@ bool CCImage::initWithImageData(void * pData,
     {
         CC_BREAK_IF(! pData || nDataLen <= 0);
 
+        // images wrapped in a .ccz container (zlib or lz4) are inflated first
+        if (kFmtRawData != eFmt && ZipUtils::ccIsCCZBuffer((unsigned char*)pData, nDataLen))
+        {
+            // encrypted containers are decrypted in place, so work on a copy of the caller's data
+            unsigned char* pSource = (unsigned char*)pData;
+            unsigned char* pCopy = NULL;
+            if (pSource[3] == 'p')
+            {
+                pCopy = (unsigned char*)malloc(nDataLen);
+                CC_BREAK_IF(! pCopy);
+                memcpy(pCopy, pData, nDataLen);
+                pSource = pCopy;
+            }
+
+            unsigned char* pInflated = NULL;
+            int nInflatedLen = ZipUtils::ccInflateCCZBuffer(pSource, nDataLen, &pInflated);
+            free(pCopy);
+            bRet = nInflatedLen > 0 && initWithImageData(pInflated, nInflatedLen, eFmt, nWidth, nHeight, nBitsPerComponent);
+            free(pInflated);
+            break;
+        }
+
         if (kFmtPng == eFmt)
         {
             bRet = _initWithPngData(pData, nDataLen);
@@ -130,18 +130,16 @@ unsigned char* CCFileUtilsAndroid::doGetFileData(const char* pszFileName, const
     
     string fullPath = fullPathForFilename(pszFileName);
     
-    
-    
-    if (fullPath[0] != '/')
+    std::string entryName;
+    std::shared_ptr<ZipFile> pPack = getSearchPackForPath(fullPath, entryName);
+    if (pPack)
     {
-        if (forAsync)
-        {
-            pData = s_pZipFile->getFileData(fullPath.c_str(), pSize, s_pZipFile->_dataThread);
-        }
-        else
-        {
-            pData = s_pZipFile->getFileData(fullPath.c_str(), pSize);
-        }
+        pData = pPack->getFileData(entryName, pSize);
+    }
+    else if (fullPath[0] != '/')
+    {
+        // ZipFile reads are thread safe, the async loader shares the same archive
+        pData = s_pZipFile->getFileData(fullPath.c_str(), pSize);
     }
     else
     {
@@ -6,10 +6,11 @@
  */
 #include "CCApplication.h"
 #include <unistd.h>
-#include <sys/time.h>
+#include <time.h>
 #include <string>
 #include "CCDirector.h"
 #include "platform/CCFileUtils.h"
+#include "platform/platform.h"
 
 NS_CC_BEGIN
 
@@ -17,26 +18,39 @@ NS_CC_BEGIN
 // sharedApplication pointer
 CCApplication * CCApplication::sm_pSharedApplication = 0;
 
-static long getCurrentMillSecond() {
-	long lLastTime;
-	struct timeval stCurrentTime;
+// the pacing loop sleeps until this much time is left before the next frame, then spins
+#define kSpinThresholdNs 1000000LL
 
-	gettimeofday(&stCurrentTime,NULL);
-	lLastTime = stCurrentTime.tv_sec*1000+stCurrentTime.tv_usec*0.001; //millseconds
-	return lLastTime;
+static void waitUntil(long long deadline)
+{
+	long long remaining = deadline - CCTime::getMonotonicTimeNs();
+	if (remaining > kSpinThresholdNs)
+	{
+		// the sleep is coarse and may oversleep, so stop short of the deadline
+		struct timespec sleepTime;
+		remaining -= kSpinThresholdNs;
+		sleepTime.tv_sec = remaining / 1000000000LL;
+		sleepTime.tv_nsec = remaining % 1000000000LL;
+		nanosleep(&sleepTime, NULL);
+	}
+
+	while (CCTime::getMonotonicTimeNs() < deadline)
+	{
+	}
 }
 
 CCApplication::CCApplication()
 {
 	CC_ASSERT(! sm_pSharedApplication);
 	sm_pSharedApplication = this;
+	m_nAnimationInterval = 1000000000LL / 60;
 }
 
 CCApplication::~CCApplication()
 {
 	CC_ASSERT(this == sm_pSharedApplication);
 	sm_pSharedApplication = NULL;
-	m_nAnimationInterval = 1.0f/60.0f*1000.0f;
+	m_nAnimationInterval = 1000000000LL / 60;
 }
 
 int CCApplication::run()
@@ -48,22 +62,26 @@ int CCApplication::run()
 	}
 
 
+	long long nextFrame = CCTime::getMonotonicTimeNs();
 	for (;;) {
-		long iLastTime = getCurrentMillSecond();
 		CCDirector::sharedDirector()->mainLoop();
-		long iCurTime = getCurrentMillSecond();
-		if (iCurTime-iLastTime<m_nAnimationInterval){
-			usleep((m_nAnimationInterval - iCurTime+iLastTime)*1000);
-		}
 
+		nextFrame += m_nAnimationInterval;
+		long long now = CCTime::getMonotonicTimeNs();
+		if (now - nextFrame > m_nAnimationInterval)
+		{
+			// more than a frame late, don't try to catch up
+			nextFrame = now;
+			continue;
+		}
+		waitUntil(nextFrame);
 	}
 	return -1;
 }
 
 void CCApplication::setAnimationInterval(double interval)
 {
-	//TODO do something else
-	m_nAnimationInterval = interval*1000.0f;
+	m_nAnimationInterval = (long long)(interval * 1000000000.0);
 }
 
 void CCApplication::setResourceRootPath(const std::string& rootResDir)
@@ -58,7 +58,7 @@ public:
      */
     virtual TargetPlatform getTargetPlatform();
 protected:
-    long       m_nAnimationInterval;  //micro second
+    long long  m_nAnimationInterval;  // nanoseconds
     std::string m_resourceRootPath;
     
 	static CCApplication * sm_pSharedApplication;
@@ -10,9 +10,15 @@
 #include "GL/glfw.h"
 #include "ccMacros.h"
 #include "CCDirector.h"
+#include "shaders/ccGLStateCache.h"
 #include "touch_dispatcher/CCTouch.h"
 #include "touch_dispatcher/CCTouchDispatcher.h"
 #include "text_input_node/CCIMEDispatcher.h"
+#include "platform/CCImage.h"
+
+#if CC_ENABLE_HEADLESS
+#include <EGL/egl.h>
+#endif
 
 PFNGLGENFRAMEBUFFERSEXTPROC glGenFramebuffersEXT = NULL;
 PFNGLDELETEFRAMEBUFFERSEXTPROC glDeleteFramebuffersEXT = NULL;
@@ -27,8 +33,30 @@ PFNGLBUFFERDATAARBPROC glBufferDataARB = NULL;
 PFNGLBUFFERSUBDATAARBPROC glBufferSubDataARB = NULL;
 PFNGLDELETEBUFFERSARBPROC glDeleteBuffersARB = NULL;
 
+// true when rendering into an offscreen pbuffer, there is no glfw window then
+static bool s_bHeadless = false;
+
+static void* getGLProcAddress(const char* pszName)
+{
+#if CC_ENABLE_HEADLESS
+	if (s_bHeadless) {
+		return (void*)eglGetProcAddress(pszName);
+	}
+#endif
+	return glfwGetProcAddress(pszName);
+}
+
+static bool isGLExtensionSupported(const char* pszName)
+{
+	if (s_bHeadless) {
+		const char* pszExtensions = (const char*)glGetString(GL_EXTENSIONS);
+		return pszExtensions && strstr(pszExtensions, pszName) != NULL;
+	}
+	return glfwExtensionSupported(pszName) != GL_FALSE;
+}
+
 bool initExtensions() {
-#define LOAD_EXTENSION_FUNCTION(TYPE, FN)  FN = (TYPE)glfwGetProcAddress(#FN);
+#define LOAD_EXTENSION_FUNCTION(TYPE, FN)  FN = (TYPE)getGLProcAddress(#FN);
 	bool bRet = false;
 	do {
 
@@ -36,7 +64,7 @@ bool initExtensions() {
 //		printf(p);
 
 		/* Supports frame buffer? */
-		if (glfwExtensionSupported("GL_EXT_framebuffer_object") != GL_FALSE)
+		if (isGLExtensionSupported("GL_EXT_framebuffer_object"))
 		{
 
 			/* Loads frame buffer extension functions */
@@ -57,7 +85,7 @@ bool initExtensions() {
 			break;
 		}
 
-		if (glfwExtensionSupported("GL_ARB_vertex_buffer_object") != GL_FALSE) {
+		if (isGLExtensionSupported("GL_ARB_vertex_buffer_object")) {
 			LOAD_EXTENSION_FUNCTION(PFNGLGENBUFFERSARBPROC, glGenBuffersARB);
 			LOAD_EXTENSION_FUNCTION(PFNGLBINDBUFFERARBPROC, glBindBufferARB);
 			LOAD_EXTENSION_FUNCTION(PFNGLBUFFERDATAARBPROC, glBufferDataARB);
@@ -78,7 +106,19 @@ NS_CC_BEGIN
 CCEGLView::CCEGLView()
 : bIsInit(false)
 , m_fFrameZoomFactor(1.0f)
+, m_bHeadless(false)
+, m_uFrameDumpInterval(1)
+, m_uFrameCount(0)
+, m_pEGLDisplay(NULL)
+, m_pEGLSurface(NULL)
+, m_pEGLContext(NULL)
 {
+	// benchmark and CI hosts select the offscreen backend without rebuilding the app
+	const char* pszHeadless = getenv("COCOS2D_HEADLESS");
+	if (pszHeadless && strcmp(pszHeadless, "0") != 0) {
+		const char* pszInterval = getenv("COCOS2D_HEADLESS_DUMP_INTERVAL");
+		setHeadless(true, getenv("COCOS2D_HEADLESS_DUMP"), pszInterval ? atoi(pszInterval) : 1);
+	}
 }
 
 CCEGLView::~CCEGLView()
@@ -163,6 +203,23 @@ void CCEGLView::setFrameSize(float width, float height)
 	//check
 	CCAssert(width!=0&&height!=0, "invalid window's size equal 0");
 
+	if (m_bHeadless) {
+		if (!initHeadless(width, height)) {
+			CCAssert(0, "fail to create the offscreen context");
+			return;
+		}
+		// there is no window to fall back to, a context without GL entry points is unusable
+		if (!initExtensions() || !initGL()) {
+			CCLog("cocos2d: can't load the GL entry points in the offscreen context");
+			destroyHeadless();
+			CCAssert(0, "fail to init opengl in the offscreen context");
+			return;
+		}
+		CCEGLViewProtocol::setFrameSize(width, height);
+		bIsInit = true;
+		return;
+	}
+
 	//Inits GLFW
 	eResult = glfwInit() != GL_FALSE;
 
@@ -243,6 +300,11 @@ void CCEGLView::setFrameSize(float width, float height)
 
 void CCEGLView::setFrameZoomFactor(float fZoomFactor)
 {
+    if (m_bHeadless)
+    {
+        // the pbuffer has a fixed size
+        return;
+    }
     m_fFrameZoomFactor = fZoomFactor;
     glfwSetWindowSize(m_obScreenSize.width * fZoomFactor, m_obScreenSize.height * fZoomFactor);
     CCDirector::sharedDirector()->setProjection(CCDirector::sharedDirector()->getProjection());
@@ -263,10 +325,10 @@ void CCEGLView::setViewPortInPoints(float x , float y , float w , float h)
 
 void CCEGLView::setScissorInPoints(float x , float y , float w , float h)
 {
-    glScissor((GLint)(x * m_fScaleX * m_fFrameZoomFactor + m_obViewPortRect.origin.x * m_fFrameZoomFactor),
-              (GLint)(y * m_fScaleY * m_fFrameZoomFactor + m_obViewPortRect.origin.y * m_fFrameZoomFactor),
-              (GLsizei)(w * m_fScaleX * m_fFrameZoomFactor),
-              (GLsizei)(h * m_fScaleY * m_fFrameZoomFactor));
+    ccGLScissor((GLint)(x * m_fScaleX * m_fFrameZoomFactor + m_obViewPortRect.origin.x * m_fFrameZoomFactor),
+                (GLint)(y * m_fScaleY * m_fFrameZoomFactor + m_obViewPortRect.origin.y * m_fFrameZoomFactor),
+                (GLsizei)(w * m_fScaleX * m_fFrameZoomFactor),
+                (GLsizei)(h * m_fScaleY * m_fFrameZoomFactor));
 }
 
 
@@ -277,19 +339,167 @@ bool CCEGLView::isOpenGLReady()
 
 void CCEGLView::end()
 {
-	/* Exits from GLFW */
-	glfwTerminate();
+	if (m_bHeadless) {
+		destroyHeadless();
+	} else {
+		/* Exits from GLFW */
+		glfwTerminate();
+	}
 	delete this;
 	exit(0);
 }
 
 void CCEGLView::swapBuffers() {
 	if (bIsInit) {
+		if (m_bHeadless) {
+			/* Nothing to present, just finish the frame so frame times stay honest */
+			if (!m_strFrameDumpPath.empty() && m_uFrameCount % m_uFrameDumpInterval == 0) {
+				dumpFrame();
+			} else {
+				glFinish();
+			}
+			++m_uFrameCount;
+			return;
+		}
 		/* Swap buffers */
 		glfwSwapBuffers();
 	}
 }
 
+void CCEGLView::setHeadless(bool bHeadless, const char* pszFrameDumpPath, unsigned int uFrameDumpInterval)
+{
+	CCAssert(!bIsInit, "setHeadless must be called before setFrameSize");
+#if CC_ENABLE_HEADLESS
+	m_bHeadless = bHeadless;
+#else
+	if (bHeadless) {
+		CCLog("cocos2d: headless rendering isn't available, build with HEADLESS=1");
+	}
+#endif
+	s_bHeadless = m_bHeadless;
+	m_strFrameDumpPath = pszFrameDumpPath ? pszFrameDumpPath : "";
+	if (!m_strFrameDumpPath.empty() && m_strFrameDumpPath[m_strFrameDumpPath.length() - 1] != '/') {
+		m_strFrameDumpPath += '/';
+	}
+	m_uFrameDumpInterval = uFrameDumpInterval > 0 ? uFrameDumpInterval : 1;
+}
+
+bool CCEGLView::isHeadless()
+{
+	return m_bHeadless;
+}
+
+bool CCEGLView::initHeadless(float width, float height)
+{
+#if CC_ENABLE_HEADLESS
+	// With Mesa, EGL_PLATFORM=surfaceless and LIBGL_ALWAYS_SOFTWARE=1 give a display
+	// without any X server, rendered by the llvmpipe/softpipe rasterizer.
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	EGLint major, minor;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		CCLog("cocos2d: can't initialize the EGL display");
+		return false;
+	}
+
+	static const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 16,
+		EGL_STENCIL_SIZE, 8,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+		CCLog("cocos2d: no EGL config for an RGBA8888 pbuffer");
+		eglTerminate(display);
+		return false;
+	}
+
+	const EGLint pbufferAttribs[] = {
+		EGL_WIDTH, (EGLint)width,
+		EGL_HEIGHT, (EGLint)height,
+		EGL_NONE
+	};
+	EGLSurface surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+	if (surface == EGL_NO_SURFACE) {
+		CCLog("cocos2d: can't create a %dx%d pbuffer", (int)width, (int)height);
+		eglTerminate(display);
+		return false;
+	}
+
+	eglBindAPI(EGL_OPENGL_API);
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+	if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+		CCLog("cocos2d: can't create the offscreen GL context");
+		eglDestroySurface(display, surface);
+		eglTerminate(display);
+		return false;
+	}
+
+	m_pEGLDisplay = display;
+	m_pEGLSurface = surface;
+	m_pEGLContext = context;
+	CCLog("cocos2d: offscreen rendering %dx%d with EGL %d.%d, %s", (int)width, (int)height, major, minor, glGetString(GL_RENDERER));
+	return true;
+#else
+	CC_UNUSED_PARAM(width);
+	CC_UNUSED_PARAM(height);
+	return false;
+#endif
+}
+
+void CCEGLView::destroyHeadless()
+{
+#if CC_ENABLE_HEADLESS
+	if (m_pEGLDisplay) {
+		eglMakeCurrent(m_pEGLDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(m_pEGLDisplay, m_pEGLContext);
+		eglDestroySurface(m_pEGLDisplay, m_pEGLSurface);
+		eglTerminate(m_pEGLDisplay);
+	}
+#endif
+	m_pEGLDisplay = NULL;
+	m_pEGLSurface = NULL;
+	m_pEGLContext = NULL;
+}
+
+void CCEGLView::dumpFrame()
+{
+	int nWidth = (int)m_obScreenSize.width;
+	int nHeight = (int)m_obScreenSize.height;
+	int nRowSize = nWidth * 4;
+
+	GLubyte *pTempData = new GLubyte[nRowSize * nHeight];
+	GLubyte *pBuffer = new GLubyte[nRowSize * nHeight];
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, nWidth, nHeight, GL_RGBA, GL_UNSIGNED_BYTE, pTempData);
+
+	// gl rows are bottom up
+	for (int i = 0; i < nHeight; ++i) {
+		memcpy(&pBuffer[i * nRowSize], &pTempData[(nHeight - i - 1) * nRowSize], nRowSize);
+	}
+
+	char szFileName[32];
+	snprintf(szFileName, sizeof(szFileName), "frame_%06u.png", m_uFrameCount);
+	std::string strPath = m_strFrameDumpPath + szFileName;
+
+	CCImage *pImage = new CCImage();
+	if (!pImage->initWithImageData(pBuffer, nRowSize * nHeight, CCImage::kFmtRawData, nWidth, nHeight, 8)
+		|| !pImage->saveToFile(strPath.c_str(), false)) {
+		CCLog("cocos2d: can't dump frame to %s", strPath.c_str());
+	}
+
+	CC_SAFE_DELETE(pImage);
+	CC_SAFE_DELETE_ARRAY(pBuffer);
+	CC_SAFE_DELETE_ARRAY(pTempData);
+}
+
 void CCEGLView::setIMEKeyboardState(bool bOpen) {
 
 }
@@ -297,7 +507,15 @@ void CCEGLView::setIMEKeyboardState(bool bOpen) {
 bool CCEGLView::initGL()
 {
     GLenum GlewInitResult = glewInit();
-    if (GLEW_OK != GlewInitResult) 
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // A GLX build of GLEW (>= 2.1) loads the GL entry points first, then fails on the
+    // missing X display of the EGL offscreen context. Only the GLX extensions are missing.
+    if (m_bHeadless && GLEW_ERROR_NO_GLX_DISPLAY == GlewInitResult)
+    {
+        GlewInitResult = GLEW_OK;
+    }
+#endif
+    if (GLEW_OK != GlewInitResult)
     {
         fprintf(stderr,"ERROR: %s\n",glewGetErrorString(GlewInitResult));
         return false;
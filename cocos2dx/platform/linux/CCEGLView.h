@@ -45,6 +45,19 @@ public:
 	virtual void swapBuffers();
 	virtual void setIMEKeyboardState(bool bOpen);
 
+	/**
+	 * Render into an offscreen EGL pbuffer of the frame size instead of a glfw window,
+	 * so performance scenes and pixel checks can run on hosts without a display.
+	 * It must be called before setFrameSize, and is only available when built with HEADLESS=1.
+	 * The COCOS2D_HEADLESS, COCOS2D_HEADLESS_DUMP and COCOS2D_HEADLESS_DUMP_INTERVAL
+	 * environment variables select it at runtime as well.
+	 *
+	 * @param pszFrameDumpPath if set, swapBuffers saves frames as frame_NNNNNN.png into this directory.
+	 * @param uFrameDumpInterval save every n-th frame only.
+	 */
+	void setHeadless(bool bHeadless, const char* pszFrameDumpPath = NULL, unsigned int uFrameDumpInterval = 1);
+	bool isHeadless();
+
 	/**
 	 @brief	get the shared main open gl window
 	 */
@@ -52,11 +65,23 @@ public:
 private:
 	bool initGL();
 	void destroyGL();
+	bool initHeadless(float width, float height);
+	void destroyHeadless();
+	void dumpFrame();
 private:
 	//store current mouse point for moving, valid if and only if the mouse pressed
 	CCPoint m_mousePoint;
 	bool bIsInit;
 	float m_fFrameZoomFactor;
+
+	bool m_bHeadless;
+	std::string m_strFrameDumpPath;
+	unsigned int m_uFrameDumpInterval;
+	unsigned int m_uFrameCount;
+	// EGLDisplay, EGLSurface and EGLContext, kept opaque to avoid the EGL headers here
+	void* m_pEGLDisplay;
+	void* m_pEGLSurface;
+	void* m_pEGLContext;
 };
 
 NS_CC_END
@@ -9,6 +9,7 @@
 #include "ccMacros.h"
 #include "CCApplication.h"
 #include "cocoa/CCString.h"
+#include "support/zip_support/ZipUtils.h"
 #include <unistd.h>
 #include <sys/stat.h>
 #include <stdio.h>
@@ -85,6 +86,13 @@ bool CCFileUtilsLinux::isFileExist(const std::string& strFilePath)
     { // Not absolute path, add the default root path at the beginning.
         strPath.insert(0, m_strDefaultResRootPath);
     }
+
+    std::string entryName;
+    std::shared_ptr<ZipFile> pPack = getSearchPackForPath(strPath, entryName);
+    if (pPack)
+    {
+        return pPack->fileExists(entryName);
+    }
     
     struct stat sts;
     return (stat(strPath.c_str(), &sts) != -1) ? true : false;
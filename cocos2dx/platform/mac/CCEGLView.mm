@@ -27,6 +27,7 @@
 #include "CCSet.h"
 #include "CCTouch.h"
 #include "CCTouchDispatcher.h"
+#include "ccGLStateCache.h"
 
 NS_CC_BEGIN
 
@@ -102,10 +103,10 @@ void CCEGLView::setScissorInPoints(float x , float y , float w , float h)
 {
     float frameZoomFactor = [[EAGLView sharedEGLView] frameZoomFactor];
     
-    glScissor((GLint)(x * m_fScaleX * frameZoomFactor + m_obViewPortRect.origin.x * frameZoomFactor),
-              (GLint)(y * m_fScaleY * frameZoomFactor + m_obViewPortRect.origin.y * frameZoomFactor),
-              (GLsizei)(w * m_fScaleX * frameZoomFactor),
-              (GLsizei)(h * m_fScaleY * frameZoomFactor));
+    ccGLScissor((GLint)(x * m_fScaleX * frameZoomFactor + m_obViewPortRect.origin.x * frameZoomFactor),
+                (GLint)(y * m_fScaleY * frameZoomFactor + m_obViewPortRect.origin.y * frameZoomFactor),
+                (GLsizei)(w * m_fScaleX * frameZoomFactor),
+                (GLsizei)(h * m_fScaleY * frameZoomFactor));
 }
 
 void CCEGLView::setMultiTouchMask(bool mask)
@@ -26,6 +26,12 @@ THE SOFTWARE.
 
 #include "CCStdC.h"
 
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+#include <mach/mach_time.h>
+#elif (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32) && (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8) && (CC_TARGET_PLATFORM != CC_PLATFORM_MARMALADE)
+#include <time.h>
+#endif
+
 NS_CC_BEGIN
 
 int CCTime::gettimeofdayCocos2d(struct cc_timeval *tp, void *tzp)
@@ -48,4 +54,36 @@ double CCTime::timersubCocos2d(struct cc_timeval *start, struct cc_timeval *end)
     return ((end->tv_sec*1000.0+end->tv_usec/1000.0) - (start->tv_sec*1000.0+start->tv_usec/1000.0));
 }
 
+long long CCTime::getMonotonicTimeNs()
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+    static LARGE_INTEGER s_freq = { 0 };
+    if (s_freq.QuadPart == 0)
+    {
+        QueryPerformanceFrequency(&s_freq);
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    // split the conversion so that the multiplication can not overflow
+    long long seconds = now.QuadPart / s_freq.QuadPart;
+    long long remainder = now.QuadPart % s_freq.QuadPart;
+    return seconds * 1000000000LL + remainder * 1000000000LL / s_freq.QuadPart;
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_IOS) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+    static mach_timebase_info_data_t s_timebase = { 0, 0 };
+    if (s_timebase.denom == 0)
+    {
+        mach_timebase_info(&s_timebase);
+    }
+    return (long long)(mach_absolute_time() * s_timebase.numer / s_timebase.denom);
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_MARMALADE)
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec * 1000000000LL + now.tv_usec * 1000LL;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+#endif
+}
+
 NS_CC_END
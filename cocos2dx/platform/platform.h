@@ -50,6 +50,12 @@ class CC_DLL CCTime
 public:
     static int gettimeofdayCocos2d(struct cc_timeval *tp, void *tzp);
     static double timersubCocos2d(struct cc_timeval *start, struct cc_timeval *end);
+
+    /** Nanoseconds elapsed since an arbitrary origin. Unlike gettimeofdayCocos2d
+     the clock is monotonic: it is not affected by changes of the system time.
+     @since v2.2
+     */
+    static long long getMonotonicTimeNs();
 };
 
 // end of platform group
@@ -27,6 +27,7 @@ THE SOFTWARE.
 #include "cocoa/CCSet.h"
 #include "ccMacros.h"
 #include "CCDirector.h"
+#include "shaders/ccGLStateCache.h"
 #include "touch_dispatcher/CCTouch.h"
 #include "touch_dispatcher/CCTouchDispatcher.h"
 #include "text_input_node/CCIMEDispatcher.h"
@@ -583,17 +584,17 @@ void CCEGLView::setScissorInPoints(float x , float y , float w , float h)
 	{
 		case DisplayOrientations::Landscape:
 		case DisplayOrientations::LandscapeFlipped:
-            glScissor((GLint)(y * m_fScaleY + m_obViewPortRect.origin.y),
-                       (GLint)((m_obViewPortRect.size.width - ((x + w) * m_fScaleX)) + m_obViewPortRect.origin.x),
-                       (GLsizei)(h * m_fScaleY),
-                       (GLsizei)(w * m_fScaleX));
+            ccGLScissor((GLint)(y * m_fScaleY + m_obViewPortRect.origin.y),
+                         (GLint)((m_obViewPortRect.size.width - ((x + w) * m_fScaleX)) + m_obViewPortRect.origin.x),
+                         (GLsizei)(h * m_fScaleY),
+                         (GLsizei)(w * m_fScaleX));
 			break;
 
         default:
-            glScissor((GLint)(x * m_fScaleX + m_obViewPortRect.origin.x),
-                       (GLint)(y * m_fScaleY + m_obViewPortRect.origin.y),
-                       (GLsizei)(w * m_fScaleX),
-                       (GLsizei)(h * m_fScaleY));
+            ccGLScissor((GLint)(x * m_fScaleX + m_obViewPortRect.origin.x),
+                         (GLint)(y * m_fScaleY + m_obViewPortRect.origin.y),
+                         (GLsizei)(w * m_fScaleX),
+                         (GLsizei)(h * m_fScaleY));
 	}
 }
 
@@ -96,6 +96,12 @@ endif
 endif
 
 SHAREDLIBS += -lglfw -lGLEW -lfontconfig -lpthread -lGL
+
+# offscreen rendering through an EGL pbuffer, see CCEGLView::setHeadless
+ifeq ($(HEADLESS),1)
+DEFINES += -DCC_ENABLE_HEADLESS=1
+SHAREDLIBS += -lEGL
+endif
 SHAREDLIBS += -L$(FMOD_LIBDIR) -Wl,-rpath,$(abspath $(FMOD_LIBDIR))
 SHAREDLIBS += -L$(LIB_DIR) -Wl,-rpath,$(abspath $(LIB_DIR))
 
@@ -39,6 +39,7 @@ static GLuint      s_uCurrentProjectionMatrix = -1;
 static bool        s_bVertexAttribPosition = false;
 static bool        s_bVertexAttribColor = false;
 static bool        s_bVertexAttribTexCoords = false;
+static void      (*s_pDeferredDraw)(void) = NULL;
 
 
 #if CC_ENABLE_GL_STATE_CACHE
@@ -50,6 +51,9 @@ static GLuint    s_uCurrentBoundTexture[kCCMaxActiveTexture] =  {(GLuint)-1,(GLu
 static GLenum    s_eBlendingSource = -1;
 static GLenum    s_eBlendingDest = -1;
 static int       s_eGLServerState = 0;
+static bool      s_bScissorKnown = false;    // the scissor state below was queried or set since the last invalidation
+static bool      s_bScissorTestEnabled = false;
+static GLint     s_pScissorBox[4] = {0, 0, 0, 0};
 #if CC_TEXTURE_ATLAS_USE_VAO
 static GLuint    s_uVAO = 0;
 #endif
@@ -76,6 +80,7 @@ void ccGLInvalidateStateCache( void )
     s_eBlendingSource = -1;
     s_eBlendingDest = -1;
     s_eGLServerState = 0;
+    s_bScissorKnown = false;
 
 #if CC_TEXTURE_ATLAS_USE_VAO
     s_uVAO = 0;
@@ -96,8 +101,106 @@ void ccGLDeleteProgram( GLuint program )
     glDeleteProgram( program );
 }
 
+#if CC_ENABLE_GL_STATE_CACHE
+static void ReadScissorState(void)
+{
+    if (!s_bScissorKnown)
+    {
+        s_bScissorTestEnabled = glIsEnabled(GL_SCISSOR_TEST) != GL_FALSE;
+        glGetIntegerv(GL_SCISSOR_BOX, s_pScissorBox);
+        s_bScissorKnown = true;
+    }
+}
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+void ccGLEnableScissorTest(bool enabled)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    ReadScissorState();
+    if (enabled == s_bScissorTestEnabled)
+    {
+        return;
+    }
+    s_bScissorTestEnabled = enabled;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    if (enabled)
+    {
+        glEnable(GL_SCISSOR_TEST);
+    }
+    else
+    {
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+bool ccGLIsScissorTestEnabled(void)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    ReadScissorState();
+    return s_bScissorTestEnabled;
+#else
+    return glIsEnabled(GL_SCISSOR_TEST) != GL_FALSE;
+#endif // CC_ENABLE_GL_STATE_CACHE
+}
+
+void ccGLScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    ReadScissorState();
+    if (x == s_pScissorBox[0] && y == s_pScissorBox[1] && width == s_pScissorBox[2] && height == s_pScissorBox[3])
+    {
+        return;
+    }
+    s_pScissorBox[0] = x;
+    s_pScissorBox[1] = y;
+    s_pScissorBox[2] = width;
+    s_pScissorBox[3] = height;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glScissor(x, y, width, height);
+}
+
+void ccGLGetScissorBox(GLint *pBox)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    ReadScissorState();
+    for (int i = 0; i < 4; i++)
+    {
+        pBox[i] = s_pScissorBox[i];
+    }
+#else
+    glGetIntegerv(GL_SCISSOR_BOX, pBox);
+#endif // CC_ENABLE_GL_STATE_CACHE
+}
+
+void ccGLSetDeferredDraw(void (*func)(void))
+{
+    if (s_pDeferredDraw != func)
+    {
+        ccGLFlushDeferredDraw();
+        s_pDeferredDraw = func;
+    }
+}
+
+void ccGLFlushDeferredDraw(void)
+{
+    if (s_pDeferredDraw)
+    {
+        // the function uses a program itself
+        void (*func)(void) = s_pDeferredDraw;
+        s_pDeferredDraw = NULL;
+        func();
+    }
+}
+
 void ccGLUseProgram( GLuint program )
 {
+    if (s_pDeferredDraw)
+    {
+        ccGLFlushDeferredDraw();
+    }
+
 #if CC_ENABLE_GL_STATE_CACHE
     if( program != s_uCurrentShaderProgram ) {
         s_uCurrentShaderProgram = program;
@@ -79,6 +79,43 @@ void CC_DLL ccGLInvalidateStateCache(void);
  */
 void CC_DLL ccGLUseProgram(GLuint program);
 
+/** Registers a function drawing geometry that was held back to be batched with the following draws.
+ It is called once, before the next program is used or when ccGLFlushDeferredDraw() is called,
+ so that the held back geometry is drawn before anything else. Registering another function flushes the previous one.
+ @since v2.2
+ */
+void CC_DLL ccGLSetDeferredDraw(void (*func)(void));
+
+/** Draws the geometry held back with ccGLSetDeferredDraw().
+ Call it before changing the render target, the scissor or the stencil state.
+ @since v2.2
+ */
+void CC_DLL ccGLFlushDeferredDraw(void);
+
+/** Enables or disables GL_SCISSOR_TEST in case it is not already in that state.
+ Code changing the scissor must use it and ccGLScissor() instead of glEnable(GL_SCISSOR_TEST) and glScissor(),
+ or the cached state goes stale.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glEnable() or glDisable() directly.
+ @since v2.2
+ */
+void CC_DLL ccGLEnableScissorTest(bool enabled);
+
+/** Returns whether GL_SCISSOR_TEST is enabled, read from the cache after the first query.
+ @since v2.2
+ */
+bool CC_DLL ccGLIsScissorTestEnabled(void);
+
+/** Sets the scissor box in case it is not already the current one.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glScissor() directly.
+ @since v2.2
+ */
+void CC_DLL ccGLScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+/** Returns the scissor box (x, y, width, height) in pBox, read from the cache after the first query.
+ @since v2.2
+ */
+void CC_DLL ccGLGetScissorBox(GLint *pBox);
+
 /** Deletes the GL program. If it is the one that is being used, it invalidates it.
  If CC_ENABLE_GL_STATE_CACHE is disabled, it will the glDeleteProgram() directly.
  @since v2.0.0
@@ -299,6 +299,7 @@ CCSprite* CCSprite::initWithCGImage(CGImageRef pImage, const char *pszKey)
 
 CCSprite::CCSprite(void)
 : m_bShouldBeHidden(false),
+m_bInDirtyList(false),
 m_pobTexture(NULL),
 preferenceRootParent(NULL),
 userObject(NULL)
@@ -307,6 +308,10 @@ userObject(NULL)
 
 CCSprite::~CCSprite(void)
 {
+    if (m_bInDirtyList && m_pobBatchNode)
+    {
+        m_pobBatchNode->removeDirtySprite(this);
+    }
     CC_SAFE_RELEASE(m_pobTexture);
 }
 
@@ -452,67 +457,89 @@ void CCSprite::setTextureCoords(CCRect rect)
     }
 }
 
-void CCSprite::updateTransform(void)
+bool CCSprite::updateQuadTransform(ccQuadTransform *pQuadTransform)
 {
-    CCAssert(m_pobBatchNode, "updateTransform is only valid when CCSprite is being rendered using an CCSpriteBatchNode");
+    // If it is not visible, or one of its ancestors is not visible, then do nothing:
+    if( !m_bVisible || ( m_pParent && m_pParent != m_pobBatchNode && ((CCSprite*)m_pParent)->m_bShouldBeHidden) )
+    {
+        m_sQuad.br.vertices = m_sQuad.tl.vertices = m_sQuad.tr.vertices = m_sQuad.bl.vertices = vertex3(0,0,0);
+        m_bShouldBeHidden = true;
+        return false;
+    }
 
-    // recalculate matrix only if it is dirty
-    if( isDirty() ) {
+    m_bShouldBeHidden = false;
 
-        // If it is not visible, or one of its ancestors is not visible, then do nothing:
-        if( !m_bVisible || ( m_pParent && m_pParent != m_pobBatchNode && ((CCSprite*)m_pParent)->m_bShouldBeHidden) )
-        {
-            m_sQuad.br.vertices = m_sQuad.tl.vertices = m_sQuad.tr.vertices = m_sQuad.bl.vertices = vertex3(0,0,0);
-            m_bShouldBeHidden = true;
-        }
-        else 
-        {
-            m_bShouldBeHidden = false;
+    if( ! m_pParent || m_pParent == m_pobBatchNode )
+    {
+        m_transformToBatch = nodeToParentTransform();
+    }
+    else 
+    {
+        CCAssert( dynamic_cast<CCSprite*>(m_pParent), "Logic error in CCSprite. Parent must be a CCSprite");
+        m_transformToBatch = CCAffineTransformConcat( nodeToParentTransform() , ((CCSprite*)m_pParent)->m_transformToBatch );
+    }
 
-            if( ! m_pParent || m_pParent == m_pobBatchNode )
-            {
-                m_transformToBatch = nodeToParentTransform();
-            }
-            else 
-            {
-                CCAssert( dynamic_cast<CCSprite*>(m_pParent), "Logic error in CCSprite. Parent must be a CCSprite");
-                m_transformToBatch = CCAffineTransformConcat( nodeToParentTransform() , ((CCSprite*)m_pParent)->m_transformToBatch );
-            }
+    //
+    // calculate the Quad based on the Affine Matrix
+    //
+
+    CCSize size = m_obRect.size;
+
+#if CC_SPRITEBATCHNODE_RENDER_SUBPIXEL
+    pQuadTransform->transform = m_transformToBatch;
+    pQuadTransform->x1 = m_obOffsetPosition.x;
+    pQuadTransform->y1 = m_obOffsetPosition.y;
+    pQuadTransform->x2 = pQuadTransform->x1 + size.width;
+    pQuadTransform->y2 = pQuadTransform->y1 + size.height;
+    pQuadTransform->z = m_fVertexZ;
+    pQuadTransform->quad = &m_sQuad;
+    return true;
+#else
+    CC_UNUSED_PARAM(pQuadTransform);
+
+    float x1 = m_obOffsetPosition.x;
+    float y1 = m_obOffsetPosition.y;
 
-            //
-            // calculate the Quad based on the Affine Matrix
-            //
+    float x2 = x1 + size.width;
+    float y2 = y1 + size.height;
+    float x = m_transformToBatch.tx;
+    float y = m_transformToBatch.ty;
 
-            CCSize size = m_obRect.size;
+    float cr = m_transformToBatch.a;
+    float sr = m_transformToBatch.b;
+    float cr2 = m_transformToBatch.d;
+    float sr2 = -m_transformToBatch.c;
+    float ax = x1 * cr - y1 * sr2 + x;
+    float ay = x1 * sr + y1 * cr2 + y;
 
-            float x1 = m_obOffsetPosition.x;
-            float y1 = m_obOffsetPosition.y;
+    float bx = x2 * cr - y1 * sr2 + x;
+    float by = x2 * sr + y1 * cr2 + y;
 
-            float x2 = x1 + size.width;
-            float y2 = y1 + size.height;
-            float x = m_transformToBatch.tx;
-            float y = m_transformToBatch.ty;
+    float cx = x2 * cr - y2 * sr2 + x;
+    float cy = x2 * sr + y2 * cr2 + y;
 
-            float cr = m_transformToBatch.a;
-            float sr = m_transformToBatch.b;
-            float cr2 = m_transformToBatch.d;
-            float sr2 = -m_transformToBatch.c;
-            float ax = x1 * cr - y1 * sr2 + x;
-            float ay = x1 * sr + y1 * cr2 + y;
+    float dx = x1 * cr - y2 * sr2 + x;
+    float dy = x1 * sr + y2 * cr2 + y;
 
-            float bx = x2 * cr - y1 * sr2 + x;
-            float by = x2 * sr + y1 * cr2 + y;
+    m_sQuad.bl.vertices = vertex3( RENDER_IN_SUBPIXEL(ax), RENDER_IN_SUBPIXEL(ay), m_fVertexZ );
+    m_sQuad.br.vertices = vertex3( RENDER_IN_SUBPIXEL(bx), RENDER_IN_SUBPIXEL(by), m_fVertexZ );
+    m_sQuad.tl.vertices = vertex3( RENDER_IN_SUBPIXEL(dx), RENDER_IN_SUBPIXEL(dy), m_fVertexZ );
+    m_sQuad.tr.vertices = vertex3( RENDER_IN_SUBPIXEL(cx), RENDER_IN_SUBPIXEL(cy), m_fVertexZ );
+    return false;
+#endif
+}
 
-            float cx = x2 * cr - y2 * sr2 + x;
-            float cy = x2 * sr + y2 * cr2 + y;
+void CCSprite::updateTransform(void)
+{
+    CCAssert(m_pobBatchNode, "updateTransform is only valid when CCSprite is being rendered using an CCSpriteBatchNode");
 
-            float dx = x1 * cr - y2 * sr2 + x;
-            float dy = x1 * sr + y2 * cr2 + y;
+    // recalculate matrix only if it is dirty
+    if( isDirty() ) {
 
-            m_sQuad.bl.vertices = vertex3( RENDER_IN_SUBPIXEL(ax), RENDER_IN_SUBPIXEL(ay), m_fVertexZ );
-            m_sQuad.br.vertices = vertex3( RENDER_IN_SUBPIXEL(bx), RENDER_IN_SUBPIXEL(by), m_fVertexZ );
-            m_sQuad.tl.vertices = vertex3( RENDER_IN_SUBPIXEL(dx), RENDER_IN_SUBPIXEL(dy), m_fVertexZ );
-            m_sQuad.tr.vertices = vertex3( RENDER_IN_SUBPIXEL(cx), RENDER_IN_SUBPIXEL(cy), m_fVertexZ );
+        ccQuadTransform quadTransform;
+        if (updateQuadTransform(&quadTransform))
+        {
+            ccTransformQuads(&quadTransform, 1);
         }
 
         // MARMALADE CHANGE: ADDED CHECK FOR NULL, TO PERMIT SPRITES WITH NO BATCH NODE / TEXTURE ATLAS
@@ -802,6 +829,17 @@ void CCSprite::setReorderChildDirtyRecursively(void)
 }
 
 
+void CCSprite::setDirty(bool bDirty)
+{
+    m_bDirty = bDirty;
+
+    // the batch node only updates the quads of the sprites it was told about
+    if (bDirty && m_pobBatchNode && ! m_bInDirtyList)
+    {
+        m_pobBatchNode->addDirtySprite(this);
+    }
+}
+
 void CCSprite::setDirtyRecursively(bool bValue)
 {
     m_bRecursiveDirty = bValue;
@@ -1077,6 +1115,11 @@ CCSpriteBatchNode* CCSprite::getBatchNode(void)
 
 void CCSprite::setBatchNode(CCSpriteBatchNode *pobSpriteBatchNode)
 {
+    if (m_bInDirtyList && m_pobBatchNode)
+    {
+        m_pobBatchNode->removeDirtySprite(this);
+    }
+
     m_pobBatchNode = pobSpriteBatchNode; // weak reference
 
     // self render
@@ -1100,6 +1143,11 @@ void CCSprite::setBatchNode(CCSpriteBatchNode *pobSpriteBatchNode)
         // using batch
         m_transformToBatch = CCAffineTransformIdentity;
         setTextureAtlas(m_pobBatchNode->getTextureAtlas()); // weak ref
+
+        if (m_bDirty)
+        {
+            m_pobBatchNode->addDirtySprite(this);
+        }
     }
 }
 
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "textures/CCTextureAtlas.h"
 #include "ccTypes.h"
 #include "cocoa/CCDictionary.h"
+#include "support/TransformUtils.h"
 #include <string>
 #ifdef EMSCRIPTEN
 #include "base_nodes/CCGLBufferedNode.h"
@@ -421,8 +422,9 @@ public:
     
     /** 
      * Makes the Sprite to be updated in the Atlas.
+     * A dirty sprite is queued on its CCSpriteBatchNode, which only updates the queued quads.
      */
-    inline virtual void setDirty(bool bDirty) { m_bDirty = bDirty; }
+    virtual void setDirty(bool bDirty);
     
     /**
      * Returns the quad (tex coords, vertex coords and color) information.
@@ -517,6 +519,11 @@ protected:
     virtual void setReorderChildDirtyRecursively(void);
     virtual void setDirtyRecursively(bool bValue);
 
+    /** Updates m_transformToBatch and prepares the quad vertices of a dirty batched sprite, without its children.
+     Returns false when the vertices are already set (hidden sprite), otherwise they are computed by ccTransformQuads.
+     */
+    bool updateQuadTransform(ccQuadTransform *pQuadTransform);
+
     //
     // Data used when the sprite is rendered using a CCSpriteSheet
     //
@@ -528,6 +535,7 @@ protected:
     bool                m_bRecursiveDirty;      /// Whether all of the sprite's children needs to be updated
     bool                m_bHasChildren;         /// Whether the sprite contains children
     bool                m_bShouldBeHidden;      /// should not be drawn because one of the ancestors is not visible
+    bool                m_bInDirtyList;         /// Whether the sprite is queued on the batch node dirty list
     CCAffineTransform   m_transformToBatch;
     
     //
@@ -560,6 +568,8 @@ protected:
     
     // @PlusPingya
     bool m_visible = true;
+
+    friend class CCSpriteBatchNode;
 };
 
 
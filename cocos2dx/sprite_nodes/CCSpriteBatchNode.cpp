@@ -39,9 +39,146 @@ THE SOFTWARE.
 #include "support/CCProfiling.h"
 // external
 #include "kazmath/GL/matrix.h"
+#include <algorithm>
+#ifndef EMSCRIPTEN
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#endif
 
 NS_CC_BEGIN
 
+// dirty quads transformed at a time by one thread
+#define kCCSpriteBatchParallelChunk 256
+
+static unsigned int s_uParallelUpdateThreads = 0;
+static unsigned int s_uParallelUpdateThreshold = 2048;
+
+#ifndef EMSCRIPTEN
+// Threads sharing ccTransformQuads with the drawing thread. Chunks are handed
+// out through an atomic counter, and run() only returns once every thread that
+// picked up the job has left it.
+class CCQuadTransformPool
+{
+public:
+    CCQuadTransformPool(unsigned int threads)
+    : m_pTransforms(NULL)
+    , m_uCount(0)
+    , m_uNext(0)
+    , m_uGeneration(0)
+    , m_uActive(0)
+    , m_bQuit(false)
+    {
+        for (unsigned int i = 0; i < threads; ++i)
+        {
+            m_threads.push_back(std::thread(&CCQuadTransformPool::threadLoop, this));
+        }
+    }
+
+    ~CCQuadTransformPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bQuit = true;
+        }
+        m_wake.notify_all();
+        for (size_t i = 0; i < m_threads.size(); ++i)
+        {
+            m_threads[i].join();
+        }
+    }
+
+    void run(const ccQuadTransform *transforms, unsigned int count)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [this] { return m_uActive == 0; });
+            m_pTransforms = transforms;
+            m_uCount = count;
+            m_uNext = 0;
+            ++m_uGeneration;
+        }
+        m_wake.notify_all();
+
+        transformChunks(transforms, count);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_uActive == 0; });
+    }
+
+private:
+    void transformChunks(const ccQuadTransform *transforms, unsigned int count)
+    {
+        for (;;)
+        {
+            unsigned int first = m_uNext.fetch_add(kCCSpriteBatchParallelChunk);
+            if (first >= count)
+            {
+                break;
+            }
+            ccTransformQuads(transforms + first, MIN(kCCSpriteBatchParallelChunk, count - first));
+        }
+    }
+
+    void threadLoop()
+    {
+        unsigned int generation = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_wake.wait(lock, [&] { return m_bQuit || m_uGeneration != generation; });
+            if (m_bQuit)
+            {
+                break;
+            }
+            generation = m_uGeneration;
+            const ccQuadTransform *transforms = m_pTransforms;
+            unsigned int count = m_uCount;
+            ++m_uActive;
+            lock.unlock();
+
+            transformChunks(transforms, count);
+
+            lock.lock();
+            if (--m_uActive == 0)
+            {
+                m_done.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const ccQuadTransform *m_pTransforms;
+    unsigned int m_uCount;
+    std::atomic<unsigned int> m_uNext;
+    unsigned int m_uGeneration;
+    unsigned int m_uActive;
+    bool m_bQuit;
+};
+
+static CCQuadTransformPool *s_pQuadTransformPool = NULL;
+#endif // EMSCRIPTEN
+
+void CCSpriteBatchNode::setParallelUpdateThreads(unsigned int threads)
+{
+#ifndef EMSCRIPTEN
+    if (threads != s_uParallelUpdateThreads)
+    {
+        CC_SAFE_DELETE(s_pQuadTransformPool);
+    }
+#endif
+    s_uParallelUpdateThreads = threads;
+}
+
+void CCSpriteBatchNode::setParallelUpdateThreshold(unsigned int count)
+{
+    s_uParallelUpdateThreshold = count;
+}
+
 /*
 * creation with CCTexture2D
 */
@@ -124,6 +261,12 @@ CCSpriteBatchNode::CCSpriteBatchNode()
 
 CCSpriteBatchNode::~CCSpriteBatchNode()
 {
+    // the sprites may outlive the batch node, forget about them
+    for (size_t i = 0; i < m_obDirtySprites.size(); ++i)
+    {
+        m_obDirtySprites[i]->m_bInDirtyList = false;
+    }
+
     unschedule(schedule_selector(CCSprite::checkCoolingOffscreen));
     CC_SAFE_RELEASE(m_pobTextureAtlas);
     CC_SAFE_RELEASE(m_pobDescendants);
@@ -236,6 +379,13 @@ void CCSpriteBatchNode::removeChildAtIndex(unsigned int uIndex, bool bDoCleanup)
 
 void CCSpriteBatchNode::removeAllChildrenWithCleanup(bool bCleanup)
 {
+    // all the queued sprites are leaving, don't look them up one by one
+    for (size_t i = 0; i < m_obDirtySprites.size(); ++i)
+    {
+        m_obDirtySprites[i]->m_bInDirtyList = false;
+    }
+    m_obDirtySprites.clear();
+
     // Invalidate atlas index. issue #569
     // useSelfRender should be performed on all descendants. issue #1216
     arrayMakeObjectsPerformSelectorWithObject(m_pobDescendants, setBatchNode, NULL, CCSprite*);
@@ -401,7 +551,24 @@ void CCSpriteBatchNode::draw(void)
 
     CC_NODE_DRAW_SETUP();
 
-    arrayMakeObjectsPerformSelector(m_pChildren, updateTransform, CCSprite*);
+    updateDirtySprites();
+
+#if CC_SPRITE_DEBUG_DRAW
+    // draw the bounding boxes, the clean sprites aren't visited any more
+    CCObject* pObj = NULL;
+    CCARRAY_FOREACH(m_pobDescendants, pObj)
+    {
+        ccV3F_C4B_T2F_Quad quad = ((CCSprite*)pObj)->getQuad();
+        CCPoint vertices[4] = {
+            ccp( quad.bl.vertices.x, quad.bl.vertices.y ),
+            ccp( quad.br.vertices.x, quad.br.vertices.y ),
+            ccp( quad.tr.vertices.x, quad.tr.vertices.y ),
+            ccp( quad.tl.vertices.x, quad.tl.vertices.y ),
+        };
+        ccDrawPoly(vertices, 4, true);
+    }
+    getShaderProgram()->use();
+#endif // CC_SPRITE_DEBUG_DRAW
 
     ccGLBlendFunc( m_blendFunc.src, m_blendFunc.dst );
 
@@ -410,6 +577,108 @@ void CCSpriteBatchNode::draw(void)
     CC_PROFILER_STOP("CCSpriteBatchNode - draw");
 }
 
+void CCSpriteBatchNode::addDirtySprite(CCSprite *sprite)
+{
+    sprite->m_bInDirtyList = true;
+    m_obDirtySprites.push_back(sprite);
+}
+
+void CCSpriteBatchNode::removeDirtySprite(CCSprite *sprite)
+{
+    std::vector<CCSprite*>::iterator it = std::find(m_obDirtySprites.begin(), m_obDirtySprites.end(), sprite);
+    if (it != m_obDirtySprites.end())
+    {
+        m_obDirtySprites.erase(it);
+    }
+    sprite->m_bInDirtyList = false;
+}
+
+void CCSpriteBatchNode::prepareDirtySprite(CCSprite* sprite)
+{
+    // cleared once per draw, so that every sprite is prepared once
+    if (! sprite->m_bInDirtyList)
+    {
+        return;
+    }
+    sprite->m_bInDirtyList = false;
+
+    // quads inserted without a sprite in the scene graph (tile maps) are updated by their owner
+    CCNode* pParent = sprite->getParent();
+    if (! pParent || ! sprite->isDirty())
+    {
+        return;
+    }
+
+    // children are transformed relative to their parent
+    if (pParent != this)
+    {
+        prepareDirtySprite((CCSprite*)pParent);
+    }
+
+    ccQuadTransform quadTransform;
+    if (sprite->updateQuadTransform(&quadTransform))
+    {
+        m_obQuadTransforms.push_back(quadTransform);
+    }
+    m_obUpdatedSprites.push_back(sprite);
+
+    sprite->m_bRecursiveDirty = false;
+    sprite->setDirty(false);
+}
+
+void CCSpriteBatchNode::updateDirtySprites()
+{
+    if (m_obDirtySprites.empty())
+    {
+        return;
+    }
+
+    CC_PROFILER_START("CCSpriteBatchNode - updateDirtySprites");
+
+    m_obPendingSprites.swap(m_obDirtySprites);
+
+    for (size_t i = 0; i < m_obPendingSprites.size(); ++i)
+    {
+        prepareDirtySprite(m_obPendingSprites[i]);
+    }
+    m_obPendingSprites.clear();
+
+    unsigned int count = (unsigned int)m_obQuadTransforms.size();
+    if (count > 0)
+    {
+#ifndef EMSCRIPTEN
+        if (s_uParallelUpdateThreads > 0 && count >= s_uParallelUpdateThreshold)
+        {
+            if (! s_pQuadTransformPool)
+            {
+                s_pQuadTransformPool = new CCQuadTransformPool(s_uParallelUpdateThreads);
+            }
+            s_pQuadTransformPool->run(&m_obQuadTransforms[0], count);
+        }
+        else
+#endif
+        {
+            ccTransformQuads(&m_obQuadTransforms[0], count);
+        }
+        m_obQuadTransforms.clear();
+    }
+
+    for (size_t i = 0; i < m_obUpdatedSprites.size(); ++i)
+    {
+        CCSprite* sprite = m_obUpdatedSprites[i];
+        m_pobTextureAtlas->updateQuad(&sprite->m_sQuad, sprite->m_uAtlasIndex);
+
+        // sprites that are always dirty (eg: CCPhysicsSprite) are updated again next frame
+        if (sprite->isDirty() && ! sprite->m_bInDirtyList)
+        {
+            addDirtySprite(sprite);
+        }
+    }
+    m_obUpdatedSprites.clear();
+
+    CC_PROFILER_STOP("CCSpriteBatchNode - updateDirtySprites");
+}
+
 void CCSpriteBatchNode::checkCoolingOffscreen() {
     
     //@PlusPingya - Don't render when offscreen
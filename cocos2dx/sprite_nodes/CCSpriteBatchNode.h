@@ -33,6 +33,8 @@ THE SOFTWARE.
 #include "textures/CCTextureAtlas.h"
 #include "ccMacros.h"
 #include "cocoa/CCArray.h"
+#include "support/TransformUtils.h"
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -134,6 +136,20 @@ public:
     void appendChild(CCSprite* sprite);
     void removeSpriteFromAtlas(CCSprite *sprite);
 
+    /* Sprites use this to queue their quad for the next draw, don't call this manually */
+    void addDirtySprite(CCSprite *sprite);
+    void removeDirtySprite(CCSprite *sprite);
+
+    /** Number of worker threads that transform the dirty quads together with the drawing thread.
+    0, the default, transforms them on the drawing thread only.
+    @since v2.2
+    */
+    static void setParallelUpdateThreads(unsigned int threads);
+    /** Minimum number of dirty quads in one batch node for the worker threads to be used.
+    @since v2.2
+    */
+    static void setParallelUpdateThreshold(unsigned int count);
+
     unsigned int rebuildIndexInOrder(CCSprite *parent, unsigned int index);
     unsigned int highestAtlasIndexInChild(CCSprite *sprite);
     unsigned int lowestAtlasIndexInChild(CCSprite *sprite);
@@ -180,7 +196,11 @@ protected:
     */
     void updateQuadFromSprite(CCSprite *sprite, unsigned int index);
 
+    /** Updates the quads of the sprites that became dirty since the last draw, parents before their children */
+    void updateDirtySprites();
+
 private:
+    void prepareDirtySprite(CCSprite* sprite);
     void updateAtlasIndex(CCSprite* sprite, int* curIndex);
     void swap(int oldIndex, int newIndex);
     void updateBlendFunc();
@@ -191,6 +211,12 @@ protected:
 
     // all descendants: children, gran children, etc...
     CCArray* m_pobDescendants;
+
+    // sprites whose quad must be updated on the next draw, and the scratch arrays used to update them
+    std::vector<CCSprite*> m_obDirtySprites;
+    std::vector<CCSprite*> m_obPendingSprites;
+    std::vector<CCSprite*> m_obUpdatedSprites;
+    std::vector<ccQuadTransform> m_obQuadTransforms;
 };
 
 // end of sprite_nodes group
@@ -47,5 +47,23 @@ void GLToCGAffine(const GLfloat *m, CCAffineTransform *t)
     t->b = m[1]; t->d = m[5]; t->ty = m[13];
 }
 
+void ccTransformQuads(const ccQuadTransform *pTransforms, unsigned int uCount)
+{
+    // The loop is left to the compiler: SSE2 versions computing the four corners in one
+    // register were slower than this code, the 24 bytes vertex stride makes the stores,
+    // not the math, the bottleneck. What pays off is transforming many quads per call.
+    for (unsigned int i = 0; i < uCount; ++i)
+    {
+        const ccQuadTransform& item = pTransforms[i];
+        const CCAffineTransform& t = item.transform;
+        ccV3F_C4B_T2F_Quad *quad = item.quad;
+
+        quad->bl.vertices = vertex3(item.x1 * t.a + item.y1 * t.c + t.tx, item.x1 * t.b + item.y1 * t.d + t.ty, item.z);
+        quad->br.vertices = vertex3(item.x2 * t.a + item.y1 * t.c + t.tx, item.x2 * t.b + item.y1 * t.d + t.ty, item.z);
+        quad->tl.vertices = vertex3(item.x1 * t.a + item.y2 * t.c + t.tx, item.x1 * t.b + item.y2 * t.d + t.ty, item.z);
+        quad->tr.vertices = vertex3(item.x2 * t.a + item.y2 * t.c + t.tx, item.x2 * t.b + item.y2 * t.d + t.ty, item.z);
+    }
+}
+
 }//namespace   cocos2d 
 
@@ -29,13 +29,33 @@ THE SOFTWARE.
 // todo:
 // when in MAC or windows, it includes <OpenGL/gl.h>
 #include "CCGL.h"
+#include "ccTypes.h"
+#include "cocoa/CCAffineTransform.h"
 
 namespace   cocos2d {
 
-struct CCAffineTransform;
-
 void CGAffineToGL(const CCAffineTransform *t, GLfloat *m);
 void GLToCGAffine(const GLfloat *m, CCAffineTransform *t);
+
+/** A rectangle to turn into the vertices of a quad with ccTransformQuads().
+ (x1, y1) is the bottom left corner and (x2, y2) the top right corner before the transform.
+ @since v2.2
+ */
+typedef struct _ccQuadTransform
+{
+    CCAffineTransform   transform;
+    GLfloat             x1, y1, x2, y2;
+    GLfloat             z;
+    ccV3F_C4B_T2F_Quad  *quad;
+} ccQuadTransform;
+
+/** Transforms uCount rectangles by their affine transforms and writes the resulting
+ positions, and z, into their quads. Colors and texture coordinates are left untouched.
+ Transforming all the quads of a node in one call is about twice as fast as one call per quad.
+ @since v2.2
+ */
+void CC_DLL ccTransformQuads(const ccQuadTransform *pTransforms, unsigned int uCount);
+
 }//namespace   cocos2d 
 
 #endif // __SUPPORT_TRANSFORM_UTILS_H__
@@ -28,111 +28,305 @@ THE SOFTWARE.
 
 #if (CC_TARGET_PLATFORM != CC_PLATFORM_IOS && CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID)
 
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#ifndef EMSCRIPTEN
+#include <thread>
+#endif
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+#include <windows.h>
+#elif (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
+#include <unistd.h>
+#endif
+
 // root name of xml
 #define USERDEFAULT_ROOT_NAME    "userDefaultRoot"
 
 #define XML_FILE_NAME "UserDefault.xml"
 
+// the new content is written there first, then renamed over the xml file
+#define XML_TEMP_FILE_SUFFIX ".tmp"
+
+// default delay between the first unsaved change and its write, in seconds
+#define DEFAULT_AUTO_FLUSH_DELAY 1.0f
+
 using namespace std;
 
 NS_CC_BEGIN
 
 /**
- * define the functions here because we don't want to
+ * define the types and functions here because we don't want to
  * export xmlNodePtr and other types in "CCUserDefault.h"
  */
 
-static tinyxml2::XMLElement* getXMLNodeForKey(const char* pKey, tinyxml2::XMLElement** rootNode, tinyxml2::XMLDocument **doc)
+/**
+ * A value of the store. The values read from the xml file are kept as text
+ * and converted when they are read, the values set by the game keep their type.
+ */
+struct UserDefaultValue
 {
-    tinyxml2::XMLElement* curNode = NULL;
+    enum Type
+    {
+        kTypeString,
+        kTypeBool,
+        kTypeInteger,
+        kTypeDouble
+    };
+
+    Type        type;
+    union
+    {
+        bool    boolValue;
+        int     intValue;
+        double  doubleValue;
+    };
+    string      stringValue;
+
+    // the text written in the xml file, read back the same way as before the store existed
+    string toString() const
+    {
+        char tmp[50];
+        switch (type)
+        {
+            case kTypeBool:
+                return boolValue ? "true" : "false";
+            case kTypeInteger:
+                sprintf(tmp, "%d", intValue);
+                return tmp;
+            case kTypeDouble:
+                // enough digits to read back the same double
+                sprintf(tmp, "%.17g", doubleValue);
+                return tmp;
+            default:
+                return stringValue;
+        }
+    }
+};
+
+typedef map<string, UserDefaultValue> UserDefaultValues;
+
+static UserDefaultValues s_values;
+// guards s_values and the write state below, the writer thread reads the values
+static std::mutex s_valuesMutex;
+
+// write state
+static bool s_dirty = false;                 // values changed since the last write
+static bool s_writeRequested = false;        // flush() was called
+static bool s_writerQuit = false;
+static float s_autoFlushDelay = DEFAULT_AUTO_FLUSH_DELAY;
+static std::chrono::steady_clock::time_point s_dirtySince;
+static std::condition_variable s_writerCondition;
+#ifndef EMSCRIPTEN
+static std::thread s_writerThread;
+#endif
+
+// Reads the values of the xml file, the temporary file is used when a write was interrupted before its rename
+static void loadXMLFile(const string& path)
+{
+    unsigned long nSize = 0;
+    unsigned char* pXmlBuffer = CCFileUtils::sharedFileUtils()->getFileData(path.c_str(), "rb", &nSize);
+    if (NULL == pXmlBuffer)
+    {
+        string tempPath = path + XML_TEMP_FILE_SUFFIX;
+        pXmlBuffer = CCFileUtils::sharedFileUtils()->getFileData(tempPath.c_str(), "rb", &nSize);
+    }
+    if (NULL == pXmlBuffer)
+    {
+        CCLOG("can not read xml file");
+        return;
+    }
 
-    // check the key value
-    if (! pKey)
+    tinyxml2::XMLDocument xmlDoc;
+    xmlDoc.Parse((const char*)pXmlBuffer, nSize);
+    delete[] pXmlBuffer;
+
+    tinyxml2::XMLElement* rootNode = xmlDoc.RootElement();
+    if (NULL == rootNode)
     {
-        return NULL;
+        CCLOG("read root node error");
+        return;
     }
 
-    do 
-    {
- 		tinyxml2::XMLDocument* xmlDoc = new tinyxml2::XMLDocument();
-		*doc = xmlDoc;
-		//CCFileData data(CCUserDefault::sharedUserDefault()->getXMLFilePath().c_str(),"rt");
-		unsigned long nSize;
-		const char* pXmlBuffer = (const char*)CCFileUtils::sharedFileUtils()->getFileData(CCUserDefault::sharedUserDefault()->getXMLFilePath().c_str(), "rb", &nSize);
-		//const char* pXmlBuffer = (const char*)data.getBuffer();
-		if(NULL == pXmlBuffer)
-		{
-			CCLOG("can not read xml file");
-			break;
-		}
-		xmlDoc->Parse(pXmlBuffer, nSize);
-        delete[] pXmlBuffer;
-		// get root node
-		*rootNode = xmlDoc->RootElement();
-		if (NULL == *rootNode)
-		{
-			CCLOG("read root node error");
-			break;
-		}
-		// find the node
-		curNode = (*rootNode)->FirstChildElement();
-		while (NULL != curNode)
-		{
-			const char* nodeName = curNode->Value();
-			if (!strcmp(nodeName, pKey))
-			{
-				break;
-			}
-
-			curNode = curNode->NextSiblingElement();
-		}
-	} while (0);
-
-	return curNode;
-}
-
-static void setValueForKey(const char* pKey, const char* pValue)
-{
- 	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	// check the params
-	if (! pKey || ! pValue)
-	{
-		return;
-	}
-	// find the node
-	node = getXMLNodeForKey(pKey, &rootNode, &doc);
-	// if node exist, change the content
-	if (node)
-	{
-        if (node->FirstChild())
+    for (tinyxml2::XMLElement* curNode = rootNode->FirstChildElement(); curNode; curNode = curNode->NextSiblingElement())
+    {
+        // a node without content used to read as a missing key
+        if (curNode->FirstChild())
+        {
+            UserDefaultValue& value = s_values[curNode->Value()];
+            value.type = UserDefaultValue::kTypeString;
+            value.stringValue = curNode->FirstChild()->Value();
+        }
+    }
+}
+
+// Writes the values next to the xml file, then replaces it, so it is never left half written
+static bool writeXMLFile(const UserDefaultValues& values, const string& path)
+{
+    tinyxml2::XMLDocument doc;
+    doc.LinkEndChild(doc.NewDeclaration(NULL));
+    tinyxml2::XMLElement* rootNode = doc.NewElement(USERDEFAULT_ROOT_NAME);
+    doc.LinkEndChild(rootNode);
+    for (UserDefaultValues::const_iterator it = values.begin(); it != values.end(); ++it)
+    {
+        tinyxml2::XMLElement* node = doc.NewElement(it->first.c_str());
+        node->LinkEndChild(doc.NewText(it->second.toString().c_str()));
+        rootNode->LinkEndChild(node);
+    }
+
+    string tempPath = path + XML_TEMP_FILE_SUFFIX;
+    FILE* fp = fopen(tempPath.c_str(), "wb");
+    if (NULL == fp)
+    {
+        CCLOG("can not write %s", tempPath.c_str());
+        return false;
+    }
+    bool written = (tinyxml2::XML_SUCCESS == doc.SaveFile(fp)) && (0 == fflush(fp));
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32) && (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8)
+    // the data must reach the disk before the rename does
+    written = written && (0 == fsync(fileno(fp)));
+#endif
+    written = (0 == fclose(fp)) && written;
+    if (!written)
+    {
+        CCLOG("can not write %s", tempPath.c_str());
+        remove(tempPath.c_str());
+        return false;
+    }
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    bool renamed = (0 != MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH));
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+    // rename doesn't replace an existing file here, loadXMLFile falls back to the temporary file
+    remove(path.c_str());
+    bool renamed = (0 == rename(tempPath.c_str(), path.c_str()));
+#else
+    bool renamed = (0 == rename(tempPath.c_str(), path.c_str()));
+#endif
+    if (!renamed)
+    {
+        CCLOG("can not replace %s", path.c_str());
+    }
+    return renamed;
+}
+
+// Writes a snapshot of the values, the lock is released while writing
+static void writeValues(std::unique_lock<std::mutex>& lock)
+{
+    UserDefaultValues snapshot(s_values);
+    s_dirty = false;
+    s_writeRequested = false;
+
+    lock.unlock();
+    bool written = writeXMLFile(snapshot, CCUserDefault::getXMLFilePath());
+    lock.lock();
+
+    if (!written && !s_dirty)
+    {
+        // try again with the next change or flush
+        s_dirty = true;
+        s_dirtySince = std::chrono::steady_clock::now();
+    }
+}
+
+#ifndef EMSCRIPTEN
+// Writes the values when flush() is called or when the auto flush delay of a change expires
+static void writerThreadLoop()
+{
+    std::unique_lock<std::mutex> lock(s_valuesMutex);
+    while (true)
+    {
+        std::chrono::steady_clock::time_point deadline;
+        bool timed = s_dirty && s_autoFlushDelay > 0;
+        if (timed)
+        {
+            deadline = s_dirtySince + std::chrono::microseconds((long long)(s_autoFlushDelay * 1000000));
+        }
+
+        if (s_writeRequested || (s_dirty && s_writerQuit)
+            || (timed && std::chrono::steady_clock::now() >= deadline))
         {
-            node->FirstChild()->SetValue(pValue);
+            writeValues(lock);
+            continue;
+        }
+        if (s_writerQuit)
+        {
+            break;
+        }
+
+        if (timed)
+        {
+            s_writerCondition.wait_until(lock, deadline);
         }
         else
         {
-            tinyxml2::XMLText* content = doc->NewText(pValue);
-            node->LinkEndChild(content);
+            s_writerCondition.wait(lock);
         }
-	}
-	else
-	{
-		if (rootNode)
-		{
-			tinyxml2::XMLElement* tmpNode = doc->NewElement(pKey);//new tinyxml2::XMLElement(pKey);
-			rootNode->LinkEndChild(tmpNode);
-			tinyxml2::XMLText* content = doc->NewText(pValue);//new tinyxml2::XMLText(pValue);
-			tmpNode->LinkEndChild(content);
-		}	
-	}
+    }
+}
+#endif
 
-    // save file and free doc
-	if (doc)
-	{
-		doc->SaveFile(CCUserDefault::sharedUserDefault()->getXMLFilePath().c_str());
-		delete doc;
-	}
+// Stops the writer thread, the pending changes are written first
+static void stopWriterThread()
+{
+#ifndef EMSCRIPTEN
+    if (s_writerThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_valuesMutex);
+            s_writerQuit = true;
+        }
+        s_writerCondition.notify_one();
+        s_writerThread.join();
+        s_writerQuit = false;
+    }
+#else
+    std::unique_lock<std::mutex> lock(s_valuesMutex);
+    if (s_dirty)
+    {
+        writeValues(lock);
+    }
+#endif
+}
+
+// Finds the value of a key, the values mutex must be locked
+static const UserDefaultValue* findValue(const char* pKey)
+{
+    if (! pKey)
+    {
+        return NULL;
+    }
+    UserDefaultValues::const_iterator it = s_values.find(pKey);
+    return it != s_values.end() ? &it->second : NULL;
+}
+
+static void setValueForKey(const char* pKey, const UserDefaultValue& value)
+{
+    // check the params
+    if (! pKey)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_valuesMutex);
+        s_values[pKey] = value;
+        if (!s_dirty)
+        {
+            s_dirty = true;
+            s_dirtySince = std::chrono::steady_clock::now();
+        }
+
+#ifndef EMSCRIPTEN
+        // the writer thread is only needed once something changed
+        if (!s_writerThread.joinable())
+        {
+            s_writerThread = std::thread(writerThreadLoop);
+        }
+#endif
+    }
+    s_writerCondition.notify_one();
 }
 
 /**
@@ -143,14 +337,33 @@ CCUserDefault* CCUserDefault::m_spUserDefault = 0;
 string CCUserDefault::m_sFilePath = string("");
 bool CCUserDefault::m_sbIsFilePathInitialized = false;
 
+// Writes the pending changes when the program exits without purging the instance,
+// it is destroyed before the file path and the values above.
+static struct UserDefaultWriterGuard
+{
+    ~UserDefaultWriterGuard()
+    {
+        stopWriterThread();
+    }
+} s_writerGuard;
+
 /**
  * If the user invoke delete CCUserDefault::sharedUserDefault(), should set m_spUserDefault
  * to null to avoid error when he invoke CCUserDefault::sharedUserDefault() later.
  */
 CCUserDefault::~CCUserDefault()
 {
-	CC_SAFE_DELETE(m_spUserDefault);
-    m_spUserDefault = NULL;
+    stopWriterThread();
+
+    std::lock_guard<std::mutex> lock(s_valuesMutex);
+    s_values.clear();
+    s_dirty = false;
+    s_writeRequested = false;
+
+    if (m_spUserDefault == this)
+    {
+        m_spUserDefault = NULL;
+    }
 }
 
 CCUserDefault::CCUserDefault()
@@ -160,7 +373,8 @@ CCUserDefault::CCUserDefault()
 
 void CCUserDefault::purgeSharedUserDefault()
 {
-    m_spUserDefault = NULL;
+    // the pending changes are written before the instance goes away
+    CC_SAFE_DELETE(m_spUserDefault);
 }
 
  bool CCUserDefault::getBoolForKey(const char* pKey)
@@ -170,27 +384,17 @@ void CCUserDefault::purgeSharedUserDefault()
 
 bool CCUserDefault::getBoolForKey(const char* pKey, bool defaultValue)
 {
-    const char* value = NULL;
-	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-	// find the node
-	if (node && node->FirstChild())
-	{
-        value = (const char*)(node->FirstChild()->Value());
-	}
-
-	bool ret = defaultValue;
-
-	if (value)
-	{
-		ret = (! strcmp(value, "true"));
-	}
-
-    if (doc) delete doc;
-
-	return ret;
+    std::lock_guard<std::mutex> lock(s_valuesMutex);
+    const UserDefaultValue* value = findValue(pKey);
+    if (! value)
+    {
+        return defaultValue;
+    }
+    if (UserDefaultValue::kTypeBool == value->type)
+    {
+        return value->boolValue;
+    }
+    return value->toString() == "true";
 }
 
 int CCUserDefault::getIntegerForKey(const char* pKey)
@@ -200,31 +404,17 @@ int CCUserDefault::getIntegerForKey(const char* pKey)
 
 int CCUserDefault::getIntegerForKey(const char* pKey, int defaultValue)
 {
-	const char* value = NULL;
-	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-	// find the node
-	if (node && node->FirstChild())
-	{
-        value = (const char*)(node->FirstChild()->Value());
-	}
-
-	int ret = defaultValue;
-
-	if (value)
-	{
-		ret = atoi(value);
-	}
-
-	if(doc)
-	{
-		delete doc;
-	}
-
-
-	return ret;
+    std::lock_guard<std::mutex> lock(s_valuesMutex);
+    const UserDefaultValue* value = findValue(pKey);
+    if (! value)
+    {
+        return defaultValue;
+    }
+    if (UserDefaultValue::kTypeInteger == value->type)
+    {
+        return value->intValue;
+    }
+    return atoi(value->toString().c_str());
 }
 
 float CCUserDefault::getFloatForKey(const char* pKey)
@@ -246,27 +436,21 @@ double  CCUserDefault::getDoubleForKey(const char* pKey)
 
 double CCUserDefault::getDoubleForKey(const char* pKey, double defaultValue)
 {
-	const char* value = NULL;
-	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-	// find the node
-	if (node && node->FirstChild())
-	{
-        value = (const char*)(node->FirstChild()->Value());
-	}
-
-	double ret = defaultValue;
-
-	if (value)
-	{
-		ret = atof(value);
-	}
-
-    if (doc) delete doc;
-
-	return ret;
+    std::lock_guard<std::mutex> lock(s_valuesMutex);
+    const UserDefaultValue* value = findValue(pKey);
+    if (! value)
+    {
+        return defaultValue;
+    }
+    if (UserDefaultValue::kTypeDouble == value->type)
+    {
+        return value->doubleValue;
+    }
+    if (UserDefaultValue::kTypeInteger == value->type)
+    {
+        return value->intValue;
+    }
+    return atof(value->toString().c_str());
 }
 
 std::string CCUserDefault::getStringForKey(const char* pKey)
@@ -276,57 +460,29 @@ std::string CCUserDefault::getStringForKey(const char* pKey)
 
 string CCUserDefault::getStringForKey(const char* pKey, const std::string & defaultValue)
 {
-    const char* value = NULL;
-	tinyxml2::XMLElement* rootNode;
-	tinyxml2::XMLDocument* doc;
-	tinyxml2::XMLElement* node;
-	node =  getXMLNodeForKey(pKey, &rootNode, &doc);
-	// find the node
-	if (node && node->FirstChild())
-	{
-        value = (const char*)(node->FirstChild()->Value());
-	}
-
-	string ret = defaultValue;
-
-	if (value)
-	{
-		ret = string(value);
-	}
-
-    if (doc) delete doc;
-
-	return ret;
+    std::lock_guard<std::mutex> lock(s_valuesMutex);
+    const UserDefaultValue* value = findValue(pKey);
+    if (! value)
+    {
+        return defaultValue;
+    }
+    return value->toString();
 }
 
 void CCUserDefault::setBoolForKey(const char* pKey, bool value)
 {
-    // save bool value as string
-
-    if (true == value)
-    {
-        setStringForKey(pKey, "true");
-    }
-    else
-    {
-        setStringForKey(pKey, "false");
-    }
+    UserDefaultValue newValue;
+    newValue.type = UserDefaultValue::kTypeBool;
+    newValue.boolValue = value;
+    setValueForKey(pKey, newValue);
 }
 
 void CCUserDefault::setIntegerForKey(const char* pKey, int value)
 {
-    // check key
-    if (! pKey)
-    {
-        return;
-    }
-
-    // format the value
-    char tmp[50];
-    memset(tmp, 0, 50);
-    sprintf(tmp, "%d", value);
-
-    setValueForKey(pKey, tmp);
+    UserDefaultValue newValue;
+    newValue.type = UserDefaultValue::kTypeInteger;
+    newValue.intValue = value;
+    setValueForKey(pKey, newValue);
 }
 
 void CCUserDefault::setFloatForKey(const char* pKey, float value)
@@ -336,45 +492,38 @@ void CCUserDefault::setFloatForKey(const char* pKey, float value)
 
 void CCUserDefault::setDoubleForKey(const char* pKey, double value)
 {
-    // check key
-    if (! pKey)
-    {
-        return;
-    }
-
-    // format the value
-    char tmp[50];
-    memset(tmp, 0, 50);
-    sprintf(tmp, "%f", value);
-
-    setValueForKey(pKey, tmp);
+    UserDefaultValue newValue;
+    newValue.type = UserDefaultValue::kTypeDouble;
+    newValue.doubleValue = value;
+    setValueForKey(pKey, newValue);
 }
 
 void CCUserDefault::setStringForKey(const char* pKey, const std::string & value)
 {
-    // check key
-    if (! pKey)
-    {
-        return;
-    }
-
-    setValueForKey(pKey, value.c_str());
+    UserDefaultValue newValue;
+    newValue.type = UserDefaultValue::kTypeString;
+    newValue.stringValue = value;
+    setValueForKey(pKey, newValue);
 }
 
 CCUserDefault* CCUserDefault::sharedUserDefault()
 {
-    initXMLFilePath();
-
-    // only create xml file one time
-    // the file exists after the program exit
-    if ((! isXMLFileExist()) && (! createXMLFile()))
-    {
-        return NULL;
-    }
-
     if (! m_spUserDefault)
     {
+        initXMLFilePath();
+
+        // only create xml file one time
+        // the file exists after the program exit
+        if ((! isXMLFileExist()) && (! createXMLFile()))
+        {
+            return NULL;
+        }
+
         m_spUserDefault = new CCUserDefault();
+
+        // the file is only read once, the values are then kept in memory
+        std::lock_guard<std::mutex> lock(s_valuesMutex);
+        loadXMLFile(m_sFilePath);
     }
 
     return m_spUserDefault;
@@ -406,6 +555,15 @@ void CCUserDefault::initXMLFilePath()
 // create new xml file
 bool CCUserDefault::createXMLFile()
 {
+    // a write interrupted before its rename left the values in the temporary file
+    string tempPath = m_sFilePath + XML_TEMP_FILE_SUFFIX;
+    FILE *fp = fopen(tempPath.c_str(), "r");
+    if (fp)
+    {
+        fclose(fp);
+        return true;
+    }
+
 	bool bRet = false;  
     tinyxml2::XMLDocument *pDoc = new tinyxml2::XMLDocument(); 
     if (NULL==pDoc)  
@@ -441,6 +599,39 @@ const string& CCUserDefault::getXMLFilePath()
 
 void CCUserDefault::flush()
 {
+#ifndef EMSCRIPTEN
+    {
+        std::lock_guard<std::mutex> lock(s_valuesMutex);
+        if (! s_dirty)
+        {
+            return;
+        }
+        s_writeRequested = true;
+    }
+    s_writerCondition.notify_one();
+#else
+    // no thread to write in the background
+    std::unique_lock<std::mutex> lock(s_valuesMutex);
+    if (s_dirty)
+    {
+        writeValues(lock);
+    }
+#endif
+}
+
+void CCUserDefault::setAutoFlushDelay(float seconds)
+{
+    {
+        std::lock_guard<std::mutex> lock(s_valuesMutex);
+        s_autoFlushDelay = seconds > 0 ? seconds : 0;
+    }
+    s_writerCondition.notify_one();
+}
+
+float CCUserDefault::getAutoFlushDelay()
+{
+    std::lock_guard<std::mutex> lock(s_valuesMutex);
+    return s_autoFlushDelay;
 }
 
 NS_CC_END
@@ -103,9 +103,18 @@ public:
     */
     void    setStringForKey(const char* pKey, const std::string & value);
     /**
-     @brief Save content to xml file
+     @brief Save content to xml file.
+     On the platforms using an xml file, the values are kept in memory and this only starts
+     the write on a background thread. purgeSharedUserDefault() waits for the pending writes.
      */
     void    flush();
+    /**
+     @brief Changes are also saved this many seconds after the first unsaved one, 1 by default.
+     0 saves them only in flush(). Only used by the platforms using an xml file, except emscripten
+     which has no background thread and saves in flush() and purgeSharedUserDefault().
+     */
+    void    setAutoFlushDelay(float seconds);
+    float   getAutoFlushDelay();
 
     static CCUserDefault* sharedUserDefault();
     static void purgeSharedUserDefault();
@@ -480,6 +480,15 @@ void CCUserDefault::flush()
     [[NSUserDefaults standardUserDefaults] synchronize];
 }
 
+void CCUserDefault::setAutoFlushDelay(float seconds)
+{
+}
+
+float CCUserDefault::getAutoFlushDelay()
+{
+    return 0;
+}
+
 
 NS_CC_END
 
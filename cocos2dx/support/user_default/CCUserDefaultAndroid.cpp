@@ -435,6 +435,15 @@ void CCUserDefault::flush()
 {
 }
 
+void CCUserDefault::setAutoFlushDelay(float seconds)
+{
+}
+
+float CCUserDefault::getAutoFlushDelay()
+{
+    return 0;
+}
+
 NS_CC_END
 
 #endif // (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
@@ -28,8 +28,20 @@
 #include "ZipUtils.h"
 #include "ccMacros.h"
 #include "platform/CCFileUtils.h"
-#include "unzip.h"
-#include <map>
+#include <string.h>
+#include <unordered_map>
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_BLACKBERRY || CC_TARGET_PLATFORM == CC_PLATFORM_TIZEN)
+#define CC_ZIP_USE_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8) && !defined(EMSCRIPTEN)
+#include <pthread.h>
+#endif
 
 NS_CC_BEGIN
 
@@ -316,53 +328,70 @@ int ZipUtils::ccInflateCCZFile(const char *path, unsigned char **out)
         return -1;
     }
     
-    struct CCZHeader *header = (struct CCZHeader*) compressed;
+    int len = ccInflateCCZBuffer(compressed, fileLen, out);
+    delete [] compressed;
+    
+    return len;
+}
+
+bool ZipUtils::ccIsCCZBuffer(const unsigned char *buffer, unsigned long len)
+{
+    if (len < sizeof(struct CCZHeader))
+    {
+        return false;
+    }
+    
+    const struct CCZHeader *header = (const struct CCZHeader*) buffer;
+    return header->sig[0] == 'C' && header->sig[1] == 'C' && header->sig[2] == 'Z' && (header->sig[3] == '!' || header->sig[3] == 'p');
+}
+
+int ZipUtils::ccInflateCCZBuffer(unsigned char *buffer, unsigned long bufferLen, unsigned char **out)
+{
+    CCAssert(out, "");
+    CCAssert(&*out, "");
+    
+    *out = NULL;
+    if (!ccIsCCZBuffer(buffer, bufferLen))
+    {
+        CCLOG("cocos2d: Invalid CCZ file");
+        return -1;
+    }
+    
+    struct CCZHeader *header = (struct CCZHeader*) buffer;
+    unsigned int compressionType = CC_SWAP_INT16_BIG_TO_HOST(header->compression_type);
     
-    // verify header
-    if( header->sig[0] == 'C' && header->sig[1] == 'C' && header->sig[2] == 'Z' && header->sig[3] == '!' )
+    // verify compression format
+    if (compressionType != CCZ_COMPRESSION_ZLIB && compressionType != CCZ_COMPRESSION_LZ4)
+    {
+        CCLOG("cocos2d: CCZ Unsupported compression method");
+        return -1;
+    }
+    
+    if( header->sig[3] == '!' )
     {
         // verify header version
         unsigned int version = CC_SWAP_INT16_BIG_TO_HOST( header->version );
         if( version > 2 )
         {
             CCLOG("cocos2d: Unsupported CCZ header format");
-            delete [] compressed;
-            return -1;
-        }
-        
-        // verify compression format
-        if( CC_SWAP_INT16_BIG_TO_HOST(header->compression_type) != CCZ_COMPRESSION_ZLIB )
-        {
-            CCLOG("cocos2d: CCZ Unsupported compression method");
-            delete [] compressed;
             return -1;
         }
     }
-    else if( header->sig[0] == 'C' && header->sig[1] == 'C' && header->sig[2] == 'Z' && header->sig[3] == 'p' )
+    else
     {
         // encrypted ccz file
-        header = (struct CCZHeader*) compressed;
         
         // verify header version
         unsigned int version = CC_SWAP_INT16_BIG_TO_HOST( header->version );
         if( version > 0 )
         {
             CCLOG("cocos2d: Unsupported CCZ header format");
-            delete [] compressed;
-            return -1;
-        }
-        
-        // verify compression format
-        if( CC_SWAP_INT16_BIG_TO_HOST(header->compression_type) != CCZ_COMPRESSION_ZLIB )
-        {
-            CCLOG("cocos2d: CCZ Unsupported compression method");
-            delete [] compressed;
             return -1;
         }
         
         // decrypt
-        unsigned int* ints = (unsigned int*)(compressed+12);
-        int enclen = (fileLen-12)/4;
+        unsigned int* ints = (unsigned int*)(buffer+12);
+        int enclen = (bufferLen-12)/4;
         
         ccDecodeEncodedPvr(ints, enclen);
                 
@@ -374,17 +403,10 @@ int ZipUtils::ccInflateCCZFile(const char *path, unsigned char **out)
         if(calculated != required)
         {
             CCLOG("cocos2d: Can't decrypt image file. Is the decryption key valid?");
-            delete [] compressed;
             return -1;
         }
 #endif
     }
-    else
-    {
-        CCLOG("cocos2d: Invalid CCZ file");
-        delete [] compressed;
-        return -1;
-    }
     
     unsigned int len = CC_SWAP_INT32_BIG_TO_HOST( header->len );
     
@@ -392,17 +414,24 @@ int ZipUtils::ccInflateCCZFile(const char *path, unsigned char **out)
     if(! *out )
     {
         CCLOG("cocos2d: CCZ: Failed to allocate memory for texture");
-        delete [] compressed;
         return -1;
     }
     
-    unsigned long destlen = len;
-    unsigned long source = (unsigned long) compressed + sizeof(*header);
-    int ret = uncompress(*out, &destlen, (Bytef*)source, fileLen - sizeof(*header) );
+    const unsigned char *source = buffer + sizeof(*header);
+    unsigned long sourceLen = bufferLen - sizeof(*header);
     
-    delete [] compressed;
+    bool decoded;
+    if (compressionType == CCZ_COMPRESSION_LZ4)
+    {
+        decoded = ccInflateLZ4Blocks(source, sourceLen, *out, len);
+    }
+    else
+    {
+        unsigned long destlen = len;
+        decoded = (uncompress(*out, &destlen, (Bytef*)source, sourceLen) == Z_OK);
+    }
     
-    if( ret != Z_OK )
+    if( ! decoded )
     {
         CCLOG("cocos2d: CCZ: Failed to uncompress data");
         free( *out );
@@ -413,6 +442,254 @@ int ZipUtils::ccInflateCCZFile(const char *path, unsigned char **out)
     return len;
 }
 
+// --------------------- LZ4 ---------------------
+
+int ZipUtils::ccDecompressLZ4Block(const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outLength)
+{
+    const unsigned char *ip = in;
+    const unsigned char *const ipEnd = in + inLength;
+    unsigned char *op = out;
+    unsigned char *const opEnd = out + outLength;
+    
+    for (;;)
+    {
+        if (ip >= ipEnd)
+        {
+            return -1;
+        }
+        
+        unsigned int token = *ip++;
+        
+        // literals
+        size_t length = token >> 4;
+        if (length == 15)
+        {
+            unsigned int s;
+            do
+            {
+                if (ip >= ipEnd)
+                {
+                    return -1;
+                }
+                s = *ip++;
+                length += s;
+            } while (s == 255);
+        }
+        if (length > (size_t)(ipEnd - ip) || length > (size_t)(opEnd - op))
+        {
+            return -1;
+        }
+        memcpy(op, ip, length);
+        ip += length;
+        op += length;
+        
+        // the last sequence only has literals
+        if (ip == ipEnd)
+        {
+            break;
+        }
+        
+        // match
+        if (ipEnd - ip < 2)
+        {
+            return -1;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - out))
+        {
+            return -1;
+        }
+        
+        length = token & 15;
+        if (length == 15)
+        {
+            unsigned int s;
+            do
+            {
+                if (ip >= ipEnd)
+                {
+                    return -1;
+                }
+                s = *ip++;
+                length += s;
+            } while (s == 255);
+        }
+        length += 4;
+        if (length > (size_t)(opEnd - op))
+        {
+            return -1;
+        }
+        
+        const unsigned char *match = op - offset;
+        if (offset >= length)
+        {
+            memcpy(op, match, length);
+            op += length;
+        }
+        else
+        {
+            // overlapping copy repeats the last 'offset' bytes
+            while (length--)
+            {
+                *op++ = *match++;
+            }
+        }
+    }
+    
+    return (int)(op - out);
+}
+
+struct LZ4BlockJob
+{
+    const unsigned char *in;
+    unsigned int inLength;
+    unsigned char *out;
+    unsigned int outLength;
+    bool stored;
+};
+
+struct LZ4BlockWorker
+{
+    LZ4BlockJob *jobs;
+    unsigned int first;
+    unsigned int stride;
+    unsigned int count;
+    bool ok;
+};
+
+static void* lz4DecodeBlocks(void *data)
+{
+    LZ4BlockWorker *worker = (LZ4BlockWorker*)data;
+    worker->ok = true;
+    for (unsigned int i = worker->first; i < worker->count && worker->ok; i += worker->stride)
+    {
+        LZ4BlockJob &job = worker->jobs[i];
+        if (job.stored)
+        {
+            worker->ok = (job.inLength == job.outLength);
+            if (worker->ok)
+            {
+                memcpy(job.out, job.in, job.inLength);
+            }
+        }
+        else
+        {
+            worker->ok = ZipUtils::ccDecompressLZ4Block(job.in, job.inLength, job.out, job.outLength) == (int)job.outLength;
+        }
+    }
+    return NULL;
+}
+
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WINRT) && (CC_TARGET_PLATFORM != CC_PLATFORM_WP8) && !defined(EMSCRIPTEN)
+#define CC_CCZ_PARALLEL_DECODE 1
+#endif
+
+// blocks smaller than this aren't worth a thread
+#define CCZ_PARALLEL_MIN_SIZE (256 * 1024)
+
+unsigned int ZipUtils::s_uCCZDecodeThreads = 4;
+
+void ZipUtils::ccSetCCZDecodeThreadCount(unsigned int count)
+{
+    s_uCCZDecodeThreads = count > 0 ? count : 1;
+}
+
+bool ZipUtils::ccInflateLZ4Blocks(const unsigned char *in, unsigned long inLength, unsigned char *out, unsigned int outLength)
+{
+    // block table: block size, block count, and the compressed size of every block
+    if (inLength < 8)
+    {
+        return false;
+    }
+    
+    unsigned int blockSize = CC_SWAP_INT32_BIG_TO_HOST(*(const unsigned int*)in);
+    unsigned int blockCount = CC_SWAP_INT32_BIG_TO_HOST(*(const unsigned int*)(in + 4));
+    if (blockSize == 0 || blockCount == 0
+        || (unsigned long long)blockSize * (blockCount - 1) >= outLength
+        || (unsigned long long)blockSize * blockCount < outLength
+        || 8 + (unsigned long long)blockCount * 4 > inLength)
+    {
+        return false;
+    }
+    
+    const unsigned char *table = in + 8;
+    const unsigned char *data = table + blockCount * 4;
+    const unsigned char *dataEnd = in + inLength;
+    
+    LZ4BlockJob *jobs = new LZ4BlockJob[blockCount];
+    for (unsigned int i = 0; i < blockCount; ++i)
+    {
+        unsigned int size = CC_SWAP_INT32_BIG_TO_HOST(*(const unsigned int*)(table + i * 4));
+        jobs[i].stored = (size & CCZ_LZ4_BLOCK_STORED) != 0;
+        jobs[i].inLength = size & ~CCZ_LZ4_BLOCK_STORED;
+        jobs[i].in = data;
+        jobs[i].out = out + i * blockSize;
+        jobs[i].outLength = (i == blockCount - 1) ? outLength - i * blockSize : blockSize;
+        
+        if (jobs[i].inLength > (unsigned long)(dataEnd - data))
+        {
+            delete [] jobs;
+            return false;
+        }
+        data += jobs[i].inLength;
+    }
+    
+    unsigned int threads = 1;
+#if CC_CCZ_PARALLEL_DECODE
+    if (outLength >= CCZ_PARALLEL_MIN_SIZE)
+    {
+        threads = s_uCCZDecodeThreads < blockCount ? s_uCCZDecodeThreads : blockCount;
+    }
+#endif
+    
+    LZ4BlockWorker *workers = new LZ4BlockWorker[threads];
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        workers[i].jobs = jobs;
+        workers[i].first = i;
+        workers[i].stride = threads;
+        workers[i].count = blockCount;
+        workers[i].ok = false;
+    }
+    
+#if CC_CCZ_PARALLEL_DECODE
+    // the calling thread decodes its share too
+    pthread_t *pids = new pthread_t[threads];
+    bool *started = new bool[threads];
+    for (unsigned int i = 1; i < threads; ++i)
+    {
+        started[i] = pthread_create(&pids[i], NULL, lz4DecodeBlocks, &workers[i]) == 0;
+        if (!started[i])
+        {
+            lz4DecodeBlocks(&workers[i]);
+        }
+    }
+    lz4DecodeBlocks(&workers[0]);
+    for (unsigned int i = 1; i < threads; ++i)
+    {
+        if (started[i])
+        {
+            pthread_join(pids[i], NULL);
+        }
+    }
+    delete [] started;
+    delete [] pids;
+#else
+    lz4DecodeBlocks(&workers[0]);
+#endif
+    
+    bool ret = true;
+    for (unsigned int i = 0; i < threads; ++i)
+    {
+        ret = ret && workers[i].ok;
+    }
+    
+    delete [] workers;
+    delete [] jobs;
+    return ret;
+}
+
 void ZipUtils::ccSetPvrEncryptionKeyPart(int index, unsigned int value)
 {
     CCAssert(index >= 0, "Cocos2d: key part index cannot be less than 0");
@@ -434,100 +711,325 @@ void ZipUtils::ccSetPvrEncryptionKey(unsigned int keyPart1, unsigned int keyPart
 }
 
 // --------------------- ZipFile ---------------------
-// from unzip.cpp
-#define UNZ_MAXFILENAMEINZIP 256
+
+#define ZIP_EOCD_SIGNATURE              0x06054b50
+#define ZIP_EOCD_SIZE                   22
+#define ZIP64_EOCD_LOCATOR_SIGNATURE    0x07064b50
+#define ZIP64_EOCD_LOCATOR_SIZE         20
+#define ZIP64_EOCD_SIGNATURE            0x06064b50
+#define ZIP_CENTRAL_HEADER_SIGNATURE    0x02014b50
+#define ZIP_CENTRAL_HEADER_SIZE         46
+#define ZIP_LOCAL_HEADER_SIGNATURE      0x04034b50
+#define ZIP_LOCAL_HEADER_SIZE           30
+#define ZIP_MAX_COMMENT_SIZE            0xffff
+
+#define ZIP_METHOD_STORED               0
+#define ZIP_METHOD_DEFLATED             8
+#define ZIP_FLAG_ENCRYPTED              0x0001
+
+static inline unsigned int zipRead16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline unsigned int zipRead32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+static inline unsigned long long zipRead64(const unsigned char *p)
+{
+    return zipRead32(p) | ((unsigned long long)zipRead32(p + 4) << 32);
+}
 
 struct ZipEntryInfo
 {
-    unz_file_pos pos;
-    uLong uncompressed_size;
+    unsigned long long localHeaderOffset;
+    unsigned long long compressedSize;
+    unsigned long long uncompressedSize;
+    unsigned short     compressionMethod;
 };
 
 class ZipFilePrivate
 {
 public:
-    unzFile zipFile;
-    
-    // std::unordered_map is faster if available on the platform
-    typedef std::map<std::string, struct ZipEntryInfo> FileListContainer;
+    ZipFilePrivate()
+    : archive(NULL)
+    , archiveSize(0)
+    , mapped(false)
+    {
+    }
+
+    ~ZipFilePrivate()
+    {
+        close();
+    }
+
+    bool open(const std::string &zipFile);
+    void close();
+
+    /** Returns the start of the entry data, or NULL if the local header is invalid. */
+    const unsigned char *entryData(const ZipEntryInfo &entry) const;
+
+    /** The whole archive, mapped or read into memory */
+    const unsigned char *archive;
+    size_t archiveSize;
+    bool mapped;
+
+    typedef std::unordered_map<std::string, ZipEntryInfo> FileListContainer;
     FileListContainer fileList;
 };
 
-ZipFile::ZipFile(const std::string &zipFile, const std::string &filter)
-: _data(new ZipFilePrivate)
-, _dataThread(new ZipFilePrivate)
+bool ZipFilePrivate::open(const std::string &zipFile)
 {
-    _data->zipFile = unzOpen(zipFile.c_str());
-    _dataThread->zipFile = unzOpen(zipFile.c_str());
-    if (_data->zipFile && _dataThread->zipFile)
+#if CC_ZIP_USE_MMAP
+    int fd = ::open(zipFile.c_str(), O_RDONLY);
+    if (fd < 0)
     {
-        setFilter(filter);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr != MAP_FAILED)
+        {
+            archive = (const unsigned char*)addr;
+            archiveSize = (size_t)st.st_size;
+            mapped = true;
+        }
     }
+    ::close(fd);
+
+    if (archive)
+    {
+        return true;
+    }
+#endif
+
+    // no mmap on this platform (or it failed), keep the whole archive in memory instead
+    FILE *fp = fopen(zipFile.c_str(), "rb");
+    if (!fp)
+    {
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size > 0)
+    {
+        unsigned char *buffer = new unsigned char[size];
+        if (fread(buffer, 1, size, fp) == (size_t)size)
+        {
+            archive = buffer;
+            archiveSize = (size_t)size;
+        }
+        else
+        {
+            delete[] buffer;
+        }
+    }
+    fclose(fp);
+
+    return archive != NULL;
 }
 
-ZipFile::~ZipFile()
+void ZipFilePrivate::close()
 {
-    if (_data && _data->zipFile)
+    if (archive)
     {
-        unzClose(_data->zipFile);
+#if CC_ZIP_USE_MMAP
+        if (mapped)
+        {
+            munmap((void*)archive, archiveSize);
+        }
+        else
+#endif
+        {
+            delete[] archive;
+        }
+    }
+    archive = NULL;
+    archiveSize = 0;
+    mapped = false;
+    fileList.clear();
+}
+
+const unsigned char *ZipFilePrivate::entryData(const ZipEntryInfo &entry) const
+{
+    // written so that offsets near 2^64 from a corrupted directory can't wrap around
+    if (entry.localHeaderOffset > archiveSize || ZIP_LOCAL_HEADER_SIZE > archiveSize - entry.localHeaderOffset)
+    {
+        return NULL;
+    }
+
+    const unsigned char *header = archive + entry.localHeaderOffset;
+    if (zipRead32(header) != ZIP_LOCAL_HEADER_SIGNATURE)
+    {
+        return NULL;
     }
-    if (_dataThread && _dataThread->zipFile)
+
+    // name and extra field lengths of the local header may differ from the central directory
+    unsigned long long dataOffset = entry.localHeaderOffset + ZIP_LOCAL_HEADER_SIZE
+                                  + zipRead16(header + 26) + zipRead16(header + 28);
+    if (dataOffset > archiveSize || entry.compressedSize > archiveSize - dataOffset)
     {
-        unzClose(_dataThread->zipFile);
+        return NULL;
     }
+
+    return archive + dataOffset;
+}
+
+ZipFile::ZipFile(const std::string &zipFile, const std::string &filter)
+: _data(new ZipFilePrivate)
+{
+    if (_data->open(zipFile))
+    {
+        setFilter(filter);
+    }
+}
+
+ZipFile::~ZipFile()
+{
     CC_SAFE_DELETE(_data);
-    CC_SAFE_DELETE(_dataThread);
 }
 
-bool ZipFile::setFilter(const std::string &filter, ZipFilePrivate *data)
+bool ZipFile::setFilter(const std::string &filter)
 {
     bool ret = false;
     do
     {
-        CC_BREAK_IF(!data);
-        CC_BREAK_IF(!data->zipFile);
-        
+        CC_BREAK_IF(!_data);
+        CC_BREAK_IF(!_data->archive);
+
         // clear existing file list
-        data->fileList.clear();
-        
-        // UNZ_MAXFILENAMEINZIP + 1 - it is done so in unzLocateFile
-        char szCurrentFileName[UNZ_MAXFILENAMEINZIP + 1];
-        unz_file_info64 fileInfo;
-        
+        _data->fileList.clear();
+
+        const unsigned char *archive = _data->archive;
+        const size_t archiveSize = _data->archiveSize;
+        CC_BREAK_IF(archiveSize < ZIP_EOCD_SIZE);
+
+        // the end of central directory record is at the end, followed by an optional comment
+        const unsigned char *eocd = NULL;
+        size_t scanEnd = archiveSize - ZIP_EOCD_SIZE;
+        size_t scanStart = scanEnd > ZIP_MAX_COMMENT_SIZE ? scanEnd - ZIP_MAX_COMMENT_SIZE : 0;
+        for (size_t i = scanEnd + 1; i-- > scanStart; )
+        {
+            if (zipRead32(archive + i) == ZIP_EOCD_SIGNATURE)
+            {
+                eocd = archive + i;
+                break;
+            }
+        }
+        CC_BREAK_IF(!eocd);
+
+        unsigned long long entryCount = zipRead16(eocd + 10);
+        unsigned long long directorySize = zipRead32(eocd + 12);
+        unsigned long long directoryOffset = zipRead32(eocd + 16);
+
+        // zip64 archives keep the real values in a separate record, pointed to by a locator
+        size_t eocdOffset = eocd - archive;
+        if (eocdOffset >= ZIP64_EOCD_LOCATOR_SIZE
+            && zipRead32(eocd - ZIP64_EOCD_LOCATOR_SIZE) == ZIP64_EOCD_LOCATOR_SIGNATURE)
+        {
+            unsigned long long eocd64Offset = zipRead64(eocd - ZIP64_EOCD_LOCATOR_SIZE + 8);
+            CC_BREAK_IF(eocd64Offset > archiveSize || 56 > archiveSize - eocd64Offset);
+            const unsigned char *eocd64 = archive + eocd64Offset;
+            CC_BREAK_IF(zipRead32(eocd64) != ZIP64_EOCD_SIGNATURE);
+            entryCount = zipRead64(eocd64 + 32);
+            directorySize = zipRead64(eocd64 + 40);
+            directoryOffset = zipRead64(eocd64 + 48);
+        }
+        CC_BREAK_IF(directoryOffset > archiveSize || directorySize > archiveSize - directoryOffset);
+
+        _data->fileList.reserve((size_t)entryCount);
+
         // go through all files and store position information about the required files
-        int err = unzGoToFirstFile64(data->zipFile, &fileInfo,
-                                     szCurrentFileName, sizeof(szCurrentFileName) - 1);
-        while (err == UNZ_OK)
+        const unsigned char *p = archive + directoryOffset;
+        const unsigned char *directoryEnd = p + directorySize;
+        for (unsigned long long i = 0; i < entryCount; ++i)
         {
-            unz_file_pos posInfo;
-            int posErr = unzGetFilePos(data->zipFile, &posInfo);
-            if (posErr == UNZ_OK)
+            if (directoryEnd - p < ZIP_CENTRAL_HEADER_SIZE || zipRead32(p) != ZIP_CENTRAL_HEADER_SIGNATURE)
+            {
+                CCLOG("cocos2d: ZipFile: corrupted central directory");
+                break;
+            }
+
+            unsigned int flags = zipRead16(p + 8);
+            unsigned int nameLength = zipRead16(p + 28);
+            unsigned int extraLength = zipRead16(p + 30);
+            unsigned int commentLength = zipRead16(p + 32);
+            const unsigned char *name = p + ZIP_CENTRAL_HEADER_SIZE;
+            const size_t entrySize = (size_t)nameLength + extraLength + commentLength;
+            if ((size_t)(directoryEnd - name) < entrySize)
+            {
+                CCLOG("cocos2d: ZipFile: corrupted central directory");
+                break;
+            }
+
+            // cache info about filtered files only (like 'assets/'), directories and encrypted files are skipped
+            if ((flags & ZIP_FLAG_ENCRYPTED) == 0
+                && nameLength > 0 && name[nameLength - 1] != '/'
+                && (filter.empty()
+                    || (nameLength >= filter.length() && memcmp(name, filter.c_str(), filter.length()) == 0)))
             {
-                std::string currentFileName = szCurrentFileName;
-                // cache info about filtered files only (like 'assets/')
-                if (filter.empty()
-                    || currentFileName.substr(0, filter.length()) == filter)
+                ZipEntryInfo entry;
+                entry.compressionMethod = (unsigned short)zipRead16(p + 10);
+                entry.compressedSize = zipRead32(p + 20);
+                entry.uncompressedSize = zipRead32(p + 24);
+                entry.localHeaderOffset = zipRead32(p + 42);
+
+                // zip64 extended information only holds the fields which are saturated above
+                const unsigned char *extra = name + nameLength;
+                const unsigned char *extraEnd = extra + extraLength;
+                while (extra + 4 <= extraEnd)
                 {
-                    ZipEntryInfo entry;
-                    entry.pos = posInfo;
-                    entry.uncompressed_size = (uLong)fileInfo.uncompressed_size;
-                    data->fileList[currentFileName] = entry;
+                    unsigned int tag = zipRead16(extra);
+                    unsigned int size = zipRead16(extra + 2);
+                    const unsigned char *field = extra + 4;
+                    if ((size_t)(extraEnd - field) < size)
+                    {
+                        break;
+                    }
+                    const unsigned char *fieldEnd = field + size;
+                    if (tag == 0x0001)
+                    {
+                        if (entry.uncompressedSize == 0xffffffff && field + 8 <= fieldEnd)
+                        {
+                            entry.uncompressedSize = zipRead64(field);
+                            field += 8;
+                        }
+                        if (entry.compressedSize == 0xffffffff && field + 8 <= fieldEnd)
+                        {
+                            entry.compressedSize = zipRead64(field);
+                            field += 8;
+                        }
+                        if (entry.localHeaderOffset == 0xffffffff && field + 8 <= fieldEnd)
+                        {
+                            entry.localHeaderOffset = zipRead64(field);
+                        }
+                        break;
+                    }
+                    extra = fieldEnd;
                 }
+
+                _data->fileList[std::string((const char*)name, nameLength)] = entry;
             }
-            // next file - also get the information about it
-            err = unzGoToNextFile64(data->zipFile, &fileInfo,
-                                    szCurrentFileName, sizeof(szCurrentFileName) - 1);
+
+            p = name + entrySize;
         }
         ret = true;
-        
+
     } while(false);
-    
+
     return ret;
 }
 
-bool ZipFile::setFilter(const std::string &filter)
+bool ZipFile::isOpen() const
 {
-    return (setFilter(filter, _data) && setFilter(filter, _dataThread));
+    return _data && _data->archive;
 }
 
 bool ZipFile::fileExists(const std::string &fileName) const
@@ -543,12 +1045,7 @@ bool ZipFile::fileExists(const std::string &fileName) const
     return ret;
 }
 
-unsigned char *ZipFile::getFileData(const std::string &fileName, unsigned long *pSize)
-{
-    return getFileData(fileName, pSize, _data);
-}
-
-unsigned char *ZipFile::getFileData(const std::string &fileName, unsigned long *pSize, ZipFilePrivate *data)
+unsigned char *ZipFile::getFileData(const std::string &fileName, unsigned long *pSize) const
 {
     unsigned char * pBuffer = NULL;
     if (pSize)
@@ -558,32 +1055,87 @@ unsigned char *ZipFile::getFileData(const std::string &fileName, unsigned long *
     
     do
     {
-        CC_BREAK_IF(!data->zipFile);
+        CC_BREAK_IF(!_data->archive);
         CC_BREAK_IF(fileName.empty());
         
-        ZipFilePrivate::FileListContainer::const_iterator it = data->fileList.find(fileName);
-        CC_BREAK_IF(it ==  data->fileList.end());
-        
-        ZipEntryInfo fileInfo = it->second;
+        ZipFilePrivate::FileListContainer::const_iterator it = _data->fileList.find(fileName);
+        CC_BREAK_IF(it ==  _data->fileList.end());
         
-        int nRet = unzGoToFilePos(data->zipFile, &fileInfo.pos);
-        CC_BREAK_IF(UNZ_OK != nRet);
-        
-        nRet = unzOpenCurrentFile(data->zipFile);
-        CC_BREAK_IF(UNZ_OK != nRet);
-        
-        pBuffer = new unsigned char[fileInfo.uncompressed_size];
-        int CC_UNUSED nSize = unzReadCurrentFile(data->zipFile, pBuffer, fileInfo.uncompressed_size);
-        CCAssert(nSize == 0 || nSize == (int)fileInfo.uncompressed_size, "the file size is wrong");
+        const ZipEntryInfo &fileInfo = it->second;
+        const unsigned char *pSource = _data->entryData(fileInfo);
+        CC_BREAK_IF(!pSource);
+
+        if (fileInfo.compressionMethod == ZIP_METHOD_STORED)
+        {
+            CC_BREAK_IF(fileInfo.compressedSize != fileInfo.uncompressedSize);
+            pBuffer = new unsigned char[fileInfo.uncompressedSize];
+            memcpy(pBuffer, pSource, fileInfo.uncompressedSize);
+        }
+        else if (fileInfo.compressionMethod == ZIP_METHOD_DEFLATED)
+        {
+            // every call owns its own stream, so several threads can inflate at once
+            z_stream d_stream;
+            memset(&d_stream, 0, sizeof(d_stream));
+            CC_BREAK_IF(inflateInit2(&d_stream, -MAX_WBITS) != Z_OK);
+
+            pBuffer = new unsigned char[fileInfo.uncompressedSize];
+            d_stream.next_in = (Bytef*)pSource;
+            d_stream.avail_in = (uInt)fileInfo.compressedSize;
+            d_stream.next_out = pBuffer;
+            d_stream.avail_out = (uInt)fileInfo.uncompressedSize;
+
+            int err = inflate(&d_stream, Z_FINISH);
+            inflateEnd(&d_stream);
+
+            if (err != Z_STREAM_END || d_stream.total_out != fileInfo.uncompressedSize)
+            {
+                CCLOG("cocos2d: ZipFile: failed to inflate %s", fileName.c_str());
+                CC_SAFE_DELETE_ARRAY(pBuffer);
+                break;
+            }
+        }
+        else
+        {
+            CCLOG("cocos2d: ZipFile: unsupported compression method %d for %s", fileInfo.compressionMethod, fileName.c_str());
+            break;
+        }
         
         if (pSize)
         {
-            *pSize = fileInfo.uncompressed_size;
+            *pSize = (unsigned long)fileInfo.uncompressedSize;
         }
-        unzCloseCurrentFile(data->zipFile);
     } while (0);
     
     return pBuffer;
 }
 
+const unsigned char *ZipFile::getStoredFileData(const std::string &fileName, unsigned long *pSize) const
+{
+    const unsigned char *pData = NULL;
+    if (pSize)
+    {
+        *pSize = 0;
+    }
+
+    do
+    {
+        CC_BREAK_IF(!_data->archive);
+
+        ZipFilePrivate::FileListContainer::const_iterator it = _data->fileList.find(fileName);
+        CC_BREAK_IF(it == _data->fileList.end());
+
+        const ZipEntryInfo &fileInfo = it->second;
+        CC_BREAK_IF(fileInfo.compressionMethod != ZIP_METHOD_STORED);
+        CC_BREAK_IF(fileInfo.compressedSize != fileInfo.uncompressedSize);
+
+        pData = _data->entryData(fileInfo);
+        if (pData && pSize)
+        {
+            *pSize = (unsigned long)fileInfo.uncompressedSize;
+        }
+    } while (0);
+
+    return pData;
+}
+
 NS_CC_END
@@ -28,10 +28,6 @@ THE SOFTWARE.
 #include "CCPlatformDefine.h"
 #include "platform/CCPlatformConfig.h"
 
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
-#include "platform/android/CCFileUtilsAndroid.h"
-#endif
-
 namespace cocos2d
 {
     /* XXX: pragma pack ??? */
@@ -50,8 +46,12 @@ namespace cocos2d
         CCZ_COMPRESSION_BZIP2,              // bzip2 format (not supported yet)
         CCZ_COMPRESSION_GZIP,               // gzip format (not supported yet)
         CCZ_COMPRESSION_NONE,               // plain (not supported yet)
+        CCZ_COMPRESSION_LZ4,                // lz4 (or lz4hc) blocks, see ZipUtils::ccInflateLZ4Blocks
     };
 
+    /** Set in the compressed size of an lz4 block which is stored uncompressed */
+    #define CCZ_LZ4_BLOCK_STORED 0x80000000u
+
     class CC_DLL ZipUtils
     {
     public:
@@ -94,6 +94,48 @@ namespace cocos2d
         */
         static int ccInflateCCZFile(const char *filename, unsigned char **out);
 
+        /** inflates a CCZ file already loaded into memory, either zlib or lz4 compressed
+        *
+        * The buffer is decrypted in place if the file is encrypted.
+        * The inflated memory is allocated with malloc and is expected to be freed by the caller.
+        *
+        * @returns the length of the deflated buffer, or -1 on error
+        *
+        * @since v2.2.1
+        */
+        static int ccInflateCCZBuffer(unsigned char *buffer, unsigned long bufferLen, unsigned char **out);
+
+        /** Checks the CCZ signature ('CCZ!' or 'CCZp') at the beginning of a buffer.
+        *
+        * @since v2.2.1
+        */
+        static bool ccIsCCZBuffer(const unsigned char *buffer, unsigned long len);
+
+        /** Decompresses a single raw LZ4 block into a buffer of known size.
+        *
+        * The decoder never reads or writes outside of the given buffers, so it is safe on corrupted data.
+        * @returns the number of decompressed bytes, or -1 if the block is malformed
+        *
+        * @since v2.2.1
+        */
+        static int ccDecompressLZ4Block(const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outLength);
+
+        /** Decompresses the payload of an lz4 CCZ file.
+        *
+        * The payload starts with a table of big endian uint32: the uncompressed block size, the block count, and
+        * the compressed size of every block (CCZ_LZ4_BLOCK_STORED set for blocks stored as is), followed by the blocks.
+        * Blocks are independent, so large files are decoded on several threads (see ccSetCCZDecodeThreadCount).
+        *
+        * @since v2.2.1
+        */
+        static bool ccInflateLZ4Blocks(const unsigned char *in, unsigned long inLength, unsigned char *out, unsigned int outLength);
+
+        /** Sets how many threads may decode the blocks of a large lz4 CCZ file. 1 decodes on the calling thread only.
+        *
+        * @since v2.2.1
+        */
+        static void ccSetCCZDecodeThreadCount(unsigned int count);
+
         /** Sets the pvr.ccz encryption key parts separately for added
         * security.
         *
@@ -155,6 +197,7 @@ namespace cocos2d
         static unsigned int s_uEncryptedPvrKeyParts[4];
         static unsigned int s_uEncryptionKey[1024];
         static bool s_bEncryptionKeyIsValid;
+        static unsigned int s_uCCZDecodeThreads;
     };
 
     // forward declaration
@@ -163,18 +206,18 @@ namespace cocos2d
     /**
     * Zip file - reader helper class.
     *
-    * It will cache the file list of a particular zip file with positions inside an archive,
-    * so it would be much faster to read some particular files or to check their existance.
+    * The central directory of the archive is parsed once into a hash index of the files
+    * matching the filter, and the archive itself is memory mapped where the platform supports it.
+    * STORED entries are served straight from the mapping, DEFLATED entries are inflated on demand.
+    *
+    * Reading is stateless, so getFileData, getStoredFileData and fileExists may be called from
+    * several threads at once. setFilter rebuilds the index and must not run concurrently with them.
     *
     * @since v2.0.5
     */
-    class ZipFile
+    class CC_DLL ZipFile
     {
     public:
-#if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
-        friend class CCFileUtilsAndroid;
-#endif
-        
         /**
         * Constructor, open zip file and store file list.
         *
@@ -198,6 +241,13 @@ namespace cocos2d
         */
         bool setFilter(const std::string &filter);
 
+        /**
+        * Check whether the archive was opened and its central directory could be read.
+        *
+        * @since v2.2.1
+        */
+        bool isOpen() const;
+
         /**
         * Check does a file exists or not in zip file
         *
@@ -217,16 +267,22 @@ namespace cocos2d
         *
         * @since v2.0.5
         */
-        unsigned char *getFileData(const std::string &fileName, unsigned long *pSize);
+        unsigned char *getFileData(const std::string &fileName, unsigned long *pSize) const;
+
+        /**
+        * Get the data of a STORED (uncompressed) file without copying it.
+        * @param fileName File name
+        * @param[out] pSize If the file is found and stored uncompressed, it will be the data size, otherwise 0.
+        * @return A pointer into the archive, valid as long as this ZipFile lives, or NULL when
+        *         the file does not exist or is compressed. Never free or modify the returned data.
+        *
+        * @since v2.2.1
+        */
+        const unsigned char *getStoredFileData(const std::string &fileName, unsigned long *pSize) const;
 
     private:
-        bool setFilter(const std::string &filer, ZipFilePrivate *data);
-        unsigned char *getFileData(const std::string &fileName, unsigned long *pSize, ZipFilePrivate *data);
-        
-        /** Internal data like zip file pointer / file list array and so on */
+        /** Internal data like the archive mapping and the file index */
         ZipFilePrivate *_data;
-        /** Another data used not in main thread */
-        ZipFilePrivate *_dataThread;
     };
 } // end of namespace cocos2d
 #endif // __SUPPORT_ZIPUTILS_H__
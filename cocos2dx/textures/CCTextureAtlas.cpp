@@ -37,6 +37,12 @@ THE SOFTWARE.
 #include "CCTexture2D.h"
 #include "cocoa/CCString.h"
 #include <stdlib.h>
+#include <algorithm>
+
+// once more quads than capacity / kCCTextureAtlasDirtyQuadsRatio are updated, the whole buffer is uploaded
+#define kCCTextureAtlasDirtyQuadsRatio 4
+// dirty quads closer than this are uploaded in the same call, a few clean quads cost less than a GL call
+#define kCCTextureAtlasDirtyQuadsGap 8
 
 //According to some tests GL_TRIANGLE_STRIP is slower, MUCH slower. Probably I'm doing something very wrong
 
@@ -316,9 +322,19 @@ void CCTextureAtlas::updateQuad(ccV3F_C4B_T2F_Quad *quad, unsigned int index)
 
     m_pQuads[index] = *quad;    
 
-
-    m_bDirty = true;
-
+    if (! m_bDirty)
+    {
+        if (m_obDirtyQuads.size() < m_uCapacity / kCCTextureAtlasDirtyQuadsRatio)
+        {
+            m_obDirtyQuads.push_back(index);
+        }
+        else
+        {
+            // too many scattered quads, upload everything
+            m_bDirty = true;
+            m_obDirtyQuads.clear();
+        }
+    }
 }
 
 void CCTextureAtlas::insertQuad(ccV3F_C4B_T2F_Quad *quad, unsigned int index)
@@ -614,14 +630,22 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
         //		glBufferData(GL_ARRAY_BUFFER, sizeof(quads_[0]) * (n-start), &quads_[start], GL_DYNAMIC_DRAW);
 		
 		// option 3: orphaning + glMapBuffer
-		glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * (n-start), NULL, GL_DYNAMIC_DRAW);
+        // the buffer keeps the atlas capacity so that single quads can be uploaded later with glBufferSubData
+		glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uCapacity, NULL, GL_DYNAMIC_DRAW);
 		void *buf = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-		memcpy(buf, m_pQuads, sizeof(m_pQuads[0])* (n-start));
+		memcpy(buf, m_pQuads, sizeof(m_pQuads[0])* (start+n));
 		glUnmapBuffer(GL_ARRAY_BUFFER);
 		
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         m_bDirty = false;
+        m_obDirtyQuads.clear();
+    }
+    else if (! m_obDirtyQuads.empty())
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+        uploadDirtyQuads();
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 
     ccGLBindVAO(m_uVAOname);
@@ -656,6 +680,11 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
     {
         glBufferSubData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0])*start, sizeof(m_pQuads[0]) * n , &m_pQuads[start] );
         m_bDirty = false;
+        m_obDirtyQuads.clear();
+    }
+    else if (! m_obDirtyQuads.empty())
+    {
+        uploadDirtyQuads();
     }
 
     ccGLEnableVertexAttribs(kCCVertexAttribFlag_PosColorTex);
@@ -686,6 +715,26 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
     CHECK_GL_ERROR_DEBUG();
 }
 
+void CCTextureAtlas::uploadDirtyQuads()
+{
+    // the array buffer must be bound
+    std::sort(m_obDirtyQuads.begin(), m_obDirtyQuads.end());
+
+    std::vector<unsigned int>::const_iterator it = m_obDirtyQuads.begin();
+    while (it != m_obDirtyQuads.end())
+    {
+        unsigned int first = *it;
+        unsigned int last = first;
+        for (++it; it != m_obDirtyQuads.end() && *it <= last + kCCTextureAtlasDirtyQuadsGap; ++it)
+        {
+            last = *it;
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * first, sizeof(m_pQuads[0]) * (last - first + 1), &m_pQuads[first]);
+    }
+
+    m_obDirtyQuads.clear();
+}
+
 
 NS_CC_END
 
@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "cocoa/CCObject.h"
 #include "ccConfig.h"
 #include <string>
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -62,6 +63,7 @@ protected:
 #endif
     GLuint              m_pBuffersVBO[2]; //0: vertex  1: indices
     bool                m_bDirty; //indicates whether or not the array buffer of the VBO needs to be updated
+    std::vector<unsigned int> m_obDirtyQuads; //quads changed by updateQuad, uploaded alone when the whole buffer isn't dirty
 
 
     /** quantity of quads that are going to be drawn */
@@ -118,6 +120,7 @@ public:
 
     /** updates a Quad (texture, vertex and color) at a certain index
     * index must be between 0 and the atlas capacity - 1
+    * Only the updated quads are uploaded on the next draw, unless the whole buffer is dirty.
     @since v0.8
     */
     void updateQuad(ccV3F_C4B_T2F_Quad* quad, unsigned int index);
@@ -213,13 +216,14 @@ public:
     void listenBackToForeground(CCObject *obj);
 
     /** whether or not the array buffer of the VBO needs to be updated*/
-    inline bool isDirty(void) { return m_bDirty; }
-    /** specify if the array buffer of the VBO needs to be updated */
-    inline void setDirty(bool bDirty) { m_bDirty = bDirty; }
+    inline bool isDirty(void) { return m_bDirty || ! m_obDirtyQuads.empty(); }
+    /** specify if the whole array buffer of the VBO needs to be updated */
+    inline void setDirty(bool bDirty) { m_bDirty = bDirty; m_obDirtyQuads.clear(); }
 
 private:
     void setupIndices();
     void mapBuffers();
+    void uploadDirtyQuads();
 #if CC_TEXTURE_ATLAS_USE_VAO
     void setupVBOandVAO();
 #else
@@ -622,17 +622,30 @@ bool CCTexturePVR::initWithContentsOfFile(const char* path)
         lowerCase[i] = tolower(lowerCase[i]);
     }
         
-    if (lowerCase.find(".ccz") != std::string::npos)
-    {
-        pvrlen = ZipUtils::ccInflateCCZFile(path, &pvrdata);
-    }
-    else if (lowerCase.find(".gz") != std::string::npos)
+    if (lowerCase.find(".gz") != std::string::npos)
     {
         pvrlen = ZipUtils::ccInflateGZipFile(path, &pvrdata);
     }
     else
     {
-        pvrdata = CCFileUtils::sharedFileUtils()->getFileData(path, "rb", (unsigned long *)(&pvrlen));
+        unsigned long fileLen = 0;
+        pvrdata = CCFileUtils::sharedFileUtils()->getFileData(path, "rb", &fileLen);
+        pvrlen = (int)fileLen;
+        
+        // .ccz files (zlib or lz4) are recognized by their signature
+        if (ZipUtils::ccIsCCZBuffer(pvrdata, fileLen))
+        {
+            unsigned char* inflated = NULL;
+            pvrlen = ZipUtils::ccInflateCCZBuffer(pvrdata, fileLen, &inflated);
+            CC_SAFE_DELETE_ARRAY(pvrdata);
+            pvrdata = inflated;
+        }
+        else if (lowerCase.find(".ccz") != std::string::npos)
+        {
+            CCLOG("cocos2d: Invalid CCZ file");
+            CC_SAFE_DELETE_ARRAY(pvrdata);
+            pvrlen = -1;
+        }
     }
     
     if (pvrlen < 0)
@@ -64,6 +64,7 @@ spine/Json.cpp \
 spine/JsonAllocator.cpp \
 spine/RegionAttachment.cpp \
 spine/Skeleton.cpp \
+spine/SkeletonBinary.cpp \
 spine/SkeletonData.cpp \
 spine/SkeletonJson.cpp \
 spine/Skin.cpp \
@@ -25,6 +25,8 @@ CCBAnimationManager::CCBAnimationManager()
 , mRootContainerSize(CCSizeZero)
 , mDelegate(NULL)
 , mRunningSequence(NULL)
+, mRunningTracks(NULL)
+, mRunningTweenDuration(0)
 , jsControlled(false)
 , mOwner(NULL)
 {
@@ -222,6 +224,7 @@ void CCBAnimationManager::addNode(CCNode *pNode, CCDictionary *pSeq)
     // pNode->retain();
     
     mNodeSequences->setObject(pSeq, (intptr_t)pNode);
+    invalidateCompiledSequences();
 }
 
 void CCBAnimationManager::setBaseValue(CCObject *pValue, CCNode *pNode, const char *pPropName)
@@ -235,6 +238,7 @@ void CCBAnimationManager::setBaseValue(CCObject *pValue, CCNode *pNode, const ch
     }
     
     props->setObject(pValue, pPropName);
+    invalidateCompiledSequences();
 }
 
 CCObject* CCBAnimationManager::getBaseValue(CCNode *pNode, const char* pPropName)
@@ -295,299 +299,8 @@ void CCBAnimationManager::moveAnimationsFromNode(CCNode* fromNode, CCNode* toNod
 //         fromNode->release();
 //         toNode->retain();
     }
-}
-
-// Refer to CCBReader::readKeyframe() for the real type of value
-CCActionInterval* CCBAnimationManager::getAction(CCBKeyframe *pKeyframe0, CCBKeyframe *pKeyframe1, const char *pPropName, CCNode *pNode)
-{
-    float duration = pKeyframe1->getTime() - (pKeyframe0 ? pKeyframe0->getTime() : 0);
-    
-    if (strcmp(pPropName, "rotationX") == 0)
-    {
-        CCBValue *value = (CCBValue*)pKeyframe1->getValue();
-        return CCBRotateXTo::create(duration, value->getFloatValue());
-    }
-    else if(strcmp(pPropName, "rotationY") == 0)
-    {
-        CCBValue *value = (CCBValue*)pKeyframe1->getValue();
-        return CCBRotateYTo::create(duration, value->getFloatValue());
-    }
-    else if (strcmp(pPropName, "rotation") == 0)
-    {
-        CCBValue *value = (CCBValue*)pKeyframe1->getValue();
-        return CCBRotateTo::create(duration, value->getFloatValue());
-    } 
-    else if (strcmp(pPropName, "opacity") == 0)
-    {
-        CCBValue *value = (CCBValue*)pKeyframe1->getValue();
-        return CCFadeTo::create(duration, value->getByteValue());
-    }
-    else if (strcmp(pPropName, "color") == 0)
-    {
-        ccColor3BWapper* color = (ccColor3BWapper*)pKeyframe1->getValue();
-        ccColor3B c = color->getColor();
-        
-        return CCTintTo::create(duration, c.r, c.g, c.b);
-    }
-    else if (strcmp(pPropName, "visible") == 0)
-    {
-        CCBValue *value = (CCBValue*)pKeyframe1->getValue();
-        if (value->getBoolValue())
-        {
-            return CCSequence::createWithTwoActions(CCDelayTime::create(duration), CCShow::create());
-        }
-        else 
-        {
-            return CCSequence::createWithTwoActions(CCDelayTime::create(duration), CCHide::create());
-        }
-    }
-    else if (strcmp(pPropName, "displayFrame") == 0)
-    {
-        return CCSequence::createWithTwoActions(CCDelayTime::create(duration),
-                                                CCBSetSpriteFrame::create((CCSpriteFrame *)pKeyframe1->getValue()));
-    }
-    else if (strcmp(pPropName, "position") == 0)
-    {
-        // Get position type
-        CCArray *array = (CCArray*)getBaseValue(pNode, pPropName);
-        int type = ((CCBValue*)array->objectAtIndex(2))->getIntValue();
-        
-        // Get relative position
-        CCArray *value = (CCArray*)pKeyframe1->getValue();
-        float x = ((CCBValue*)value->objectAtIndex(0))->getFloatValue();
-        float y = ((CCBValue*)value->objectAtIndex(1))->getFloatValue();
-        
-        CCSize containerSize = getContainerSize(pNode->getParent());
-        
-        CCPoint absPos = getAbsolutePosition(ccp(x,y), type, containerSize, pPropName);
-        
-        return CCMoveTo::create(duration, absPos);
-    }
-    else if (strcmp(pPropName, "scale") == 0)
-    {
-        // Get position type
-        CCArray *array = (CCArray*)getBaseValue(pNode, pPropName);
-        int type = ((CCBValue*)array->objectAtIndex(2))->getIntValue();
-        
-        // Get relative scale
-        CCArray *value = (CCArray*)pKeyframe1->getValue();
-        float x = ((CCBValue*)value->objectAtIndex(0))->getFloatValue();
-        float y = ((CCBValue*)value->objectAtIndex(1))->getFloatValue();
-        
-        if (type == kCCBScaleTypeMultiplyResolution)
-        {
-            float resolutionScale = CCBReader::getResolutionScale();
-            x *= resolutionScale;
-            y *= resolutionScale;
-        }
-        
-        return CCScaleTo::create(duration, x, y);
-    }
-    else if(strcmp(pPropName, "skew") == 0) 
-    {
-        // Get relative skew
-        CCArray *value = (CCArray*)pKeyframe1->getValue();
-        float x = ((CCBValue*)value->objectAtIndex(0))->getFloatValue();
-        float y = ((CCBValue*)value->objectAtIndex(1))->getFloatValue();
-        
-        return CCSkewTo::create(duration, x, y);
-    }
-    else 
-    {
-        CCLog("CCBReader: Failed to create animation for property: %s", pPropName);
-    }
-    
-    return NULL;
-}
-
-void CCBAnimationManager::setAnimatedProperty(const char *pPropName, CCNode *pNode, CCObject *pValue, float fTweenDuration)
-{
-    if (fTweenDuration > 0)
-    {
-        // Create a fake keyframe to generate the action from
-        CCBKeyframe *kf1 = new CCBKeyframe();
-        kf1->autorelease();
-        kf1->setValue(pValue);
-        kf1->setTime(fTweenDuration);
-        kf1->setEasingType(kCCBKeyframeEasingLinear);
-        
-        // Animate
-        CCActionInterval *tweenAction = getAction(NULL, kf1, pPropName, pNode);
-        pNode->runAction(tweenAction);
-    }
-    else 
-    {
-        // Just set the value
-        
-        if (strcmp(pPropName, "position") == 0)
-        {
-            // Get position type
-            CCArray *array = (CCArray*)getBaseValue(pNode, pPropName);
-            int type = ((CCBValue*)array->objectAtIndex(2))->getIntValue();
-            
-            // Get relative position
-            CCArray *value = (CCArray*)pValue;
-            float x = ((CCBValue*)value->objectAtIndex(0))->getFloatValue();
-            float y = ((CCBValue*)value->objectAtIndex(1))->getFloatValue();
-            
-            pNode->setPosition(getAbsolutePosition(ccp(x,y), type, getContainerSize(pNode->getParent()), pPropName));
-        }
-        else if (strcmp(pPropName, "scale") == 0)
-        {
-            // Get scale type
-            CCArray *array = (CCArray*)getBaseValue(pNode, pPropName);
-            int type = ((CCBValue*)array->objectAtIndex(2))->getIntValue();
-            
-            // Get relative scale
-            CCArray *value = (CCArray*)pValue;
-            float x = ((CCBValue*)value->objectAtIndex(0))->getFloatValue();
-            float y = ((CCBValue*)value->objectAtIndex(1))->getFloatValue();
-            
-            setRelativeScale(pNode, x, y, type, pPropName);
-        }
-        else if(strcmp(pPropName, "skew") == 0)
-        {
-            // Get relative scale
-            CCArray *value = (CCArray*)pValue;
-            float x = ((CCBValue*)value->objectAtIndex(0))->getFloatValue();
-            float y = ((CCBValue*)value->objectAtIndex(1))->getFloatValue();
-
-            pNode->setSkewX(x);
-            pNode->setSkewY(y);
-        }
-        else 
-        {
-            // [node setValue:value forKey:name];
-
-            // TODO only handle rotation, opacity, displayFrame, color
-            if (strcmp(pPropName, "rotation") == 0)
-            {
-                float rotate = ((CCBValue*)pValue)->getFloatValue();
-                pNode->setRotation(rotate);
-            } else if(strcmp(pPropName, "rotationX") == 0)
-            {
-                float rotate = ((CCBValue*)pValue)->getFloatValue();
-                pNode->setRotationX(rotate);
-            }else if(strcmp(pPropName, "rotationY") == 0)
-            {
-                float rotate = ((CCBValue*)pValue)->getFloatValue();
-                pNode->setRotationY(rotate);
-            }
-            else if (strcmp(pPropName, "opacity") == 0)
-            {
-                int opacity = ((CCBValue*)pValue)->getByteValue();
-                (dynamic_cast<CCRGBAProtocol*>(pNode))->setOpacity(opacity);
-            }
-            else if (strcmp(pPropName, "displayFrame") == 0)
-            {
-                ((CCSprite*)pNode)->setDisplayFrame((CCSpriteFrame*)pValue);
-            }
-            else if (strcmp(pPropName, "color") == 0)
-            {
-                ccColor3BWapper *color = (ccColor3BWapper*)pValue;
-                (dynamic_cast<CCRGBAProtocol*>(pNode))->setColor(color->getColor());
-            }
-            else if (strcmp(pPropName, "visible") == 0)
-            {
-                bool visible = ((CCBValue*)pValue)->getBoolValue();
-                pNode->setVisible(visible);
-            }
-            else
-            {
-                CCLog("unsupported property name is %s", pPropName);
-                CCAssert(false, "unsupported property now");
-            }
-        }
-    }
-}
-
-void CCBAnimationManager::setFirstFrame(CCNode *pNode, CCBSequenceProperty *pSeqProp, float fTweenDuration)
-{
-    CCArray *keyframes = pSeqProp->getKeyframes();
-    
-    if (keyframes->count() == 0)
-    {
-        // Use base value (no animation)
-        CCObject *baseValue = getBaseValue(pNode, pSeqProp->getName());
-        CCAssert(baseValue, "No baseValue found for property");
-        setAnimatedProperty(pSeqProp->getName(), pNode, baseValue, fTweenDuration);
-    }
-    else 
-    {
-        // Use first keyframe
-        CCBKeyframe *keyframe = (CCBKeyframe*)keyframes->objectAtIndex(0);
-        setAnimatedProperty(pSeqProp->getName(), pNode, keyframe->getValue(), fTweenDuration);
-    }
-}
-
-CCActionInterval* CCBAnimationManager::getEaseAction(CCActionInterval *pAction, int nEasingType, float fEasingOpt)
-{
-    if (dynamic_cast<CCSequence*>(pAction))
-    {
-        return pAction;
-    }
     
-    if (nEasingType == kCCBKeyframeEasingLinear)
-    {
-        return pAction;
-    }
-    else if (nEasingType == kCCBKeyframeEasingInstant)
-    {
-        return CCBEaseInstant::create(pAction);
-    }
-    else if (nEasingType == kCCBKeyframeEasingCubicIn)
-    {
-        return CCEaseIn::create(pAction, fEasingOpt);
-    }
-    else if (nEasingType == kCCBKeyframeEasingCubicOut)
-    {
-        return CCEaseOut::create(pAction, fEasingOpt);
-    }
-    else if (nEasingType == kCCBKeyframeEasingCubicInOut)
-    {
-        return CCEaseInOut::create(pAction, fEasingOpt);
-    }
-    else if (nEasingType == kCCBKeyframeEasingBackIn)
-    {
-        return CCEaseBackIn::create(pAction);
-    }
-    else if (nEasingType == kCCBKeyframeEasingBackOut)
-    {
-        return CCEaseBackOut::create(pAction);
-    }
-    else if (nEasingType == kCCBKeyframeEasingBackInOut)
-    {
-        return CCEaseBackInOut::create(pAction);
-    }
-    else if (nEasingType == kCCBKeyframeEasingBounceIn)
-    {
-        return CCEaseBounceIn::create(pAction);
-    }
-    else if (nEasingType == kCCBKeyframeEasingBounceOut)
-    {
-        return CCEaseBounceOut::create(pAction);
-    }
-    else if (nEasingType == kCCBKeyframeEasingBounceInOut)
-    {
-        return CCEaseBounceInOut::create(pAction);
-    }
-    else if (nEasingType == kCCBKeyframeEasingElasticIn)
-    {
-        return CCEaseElasticIn::create(pAction, fEasingOpt);
-    }
-    else if (nEasingType == kCCBKeyframeEasingElasticOut)
-    {
-        return CCEaseElasticOut::create(pAction, fEasingOpt);
-    }
-    else if (nEasingType == kCCBKeyframeEasingElasticInOut)
-    {
-        return CCEaseElasticInOut::create(pAction, fEasingOpt);
-    }
-    else
-    {
-        CCLog("CCBReader: Unkown easing type %d", nEasingType);
-        return pAction;
-    }
+    invalidateCompiledSequences();
 }
 
 CCObject* CCBAnimationManager::actionForCallbackChannel(CCBSequenceProperty* channel) {
@@ -692,117 +405,674 @@ CCObject* CCBAnimationManager::actionForSoundChannel(CCBSequenceProperty* channe
 
 
 
-void CCBAnimationManager::runAction(CCNode *pNode, CCBSequenceProperty *pSeqProp, float fTweenDuration)
+/************************************************************
+ Compiled keyframe tracks
+ ************************************************************/
+
+enum
 {
-    CCArray *keyframes = pSeqProp->getKeyframes();
-    int numKeyframes = keyframes->count();
+    kCCBTrackPosition,
+    kCCBTrackScale,
+    kCCBTrackSkew,
+    kCCBTrackRotation,
+    kCCBTrackRotationX,
+    kCCBTrackRotationY,
+    kCCBTrackOpacity,
+    kCCBTrackColor,
+    kCCBTrackVisible,
+    kCCBTrackDisplayFrame
+};
+
+static int getTrackProperty(const char *pPropName)
+{
+    static const char *names[] = {
+        "position", "scale", "skew", "rotation", "rotationX", "rotationY",
+        "opacity", "color", "visible", "displayFrame"
+    };
     
-    if (numKeyframes > 1)
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); ++i)
     {
-        // Make an animation!
-        CCArray *actions = CCArray::create();
-        
-        CCBKeyframe *keyframeFirst = (CCBKeyframe*)keyframes->objectAtIndex(0);
-        float timeFirst = keyframeFirst->getTime() + fTweenDuration;
-        
-        if (timeFirst > 0)
+        if (strcmp(pPropName, names[i]) == 0)
         {
-            actions->addObject(CCDelayTime::create(timeFirst));
+            return i;
         }
-        
-        for (int i = 0; i < numKeyframes - 1; ++i)
+    }
+    return -1;
+}
+
+// visible and displayFrame change when a keyframe is reached, without easing
+static bool isStepTrackProperty(int property)
+{
+    return property == kCCBTrackVisible || property == kCCBTrackDisplayFrame;
+}
+
+// Refer to CCBReader::readKeyframe() for the real type of value
+static void decodeKeyframeValue(int property, CCObject *pValue, float *pValues, float *pSource, CCSpriteFrame **ppSpriteFrame)
+{
+    switch (property)
+    {
+        case kCCBTrackPosition:
+        case kCCBTrackScale:
+        case kCCBTrackSkew:
         {
-            CCBKeyframe *kf0 = (CCBKeyframe*)keyframes->objectAtIndex(i);
-            CCBKeyframe *kf1 = (CCBKeyframe*)keyframes->objectAtIndex(i+1);
-            
-            CCActionInterval *action = getAction(kf0, kf1, pSeqProp->getName(), pNode);
-            if (action)
-            {
-                // Apply easing
-                action = getEaseAction(action, kf0->getEasingType(), kf0->getEasingOpt());
-                
-                actions->addObject(action);
-            }
+            CCArray *value = (CCArray*)pValue;
+            pSource[0] = ((CCBValue*)value->objectAtIndex(0))->getFloatValue();
+            pSource[1] = ((CCBValue*)value->objectAtIndex(1))->getFloatValue();
+            pValues[0] = pSource[0];
+            pValues[1] = pSource[1];
+            break;
         }
-        
-        CCFiniteTimeAction *seq = CCSequence::create(actions);
-        pNode->runAction(seq);
+        case kCCBTrackRotation:
+        case kCCBTrackRotationX:
+        case kCCBTrackRotationY:
+            pValues[0] = ((CCBValue*)pValue)->getFloatValue();
+            break;
+        case kCCBTrackOpacity:
+            pValues[0] = ((CCBValue*)pValue)->getByteValue();
+            break;
+        case kCCBTrackColor:
+        {
+            ccColor3B c = ((ccColor3BWapper*)pValue)->getColor();
+            pValues[0] = c.r;
+            pValues[1] = c.g;
+            pValues[2] = c.b;
+            break;
+        }
+        case kCCBTrackVisible:
+            pValues[0] = ((CCBValue*)pValue)->getBoolValue() ? 1 : 0;
+            break;
+        case kCCBTrackDisplayFrame:
+            *ppSpriteFrame = (CCSpriteFrame*)pValue;
+            break;
     }
 }
 
-void CCBAnimationManager::runAnimations(const char *pName, float fTweenDuration)
+static float bounceTime(float time)
 {
-    runAnimationsForSequenceNamedTweenDuration(pName, fTweenDuration);
+    if (time < 1 / 2.75)
+    {
+        return 7.5625f * time * time;
+    }
+    else if (time < 2 / 2.75)
+    {
+        time -= 1.5f / 2.75f;
+        return 7.5625f * time * time + 0.75f;
+    }
+    else if (time < 2.5 / 2.75)
+    {
+        time -= 2.25f / 2.75f;
+        return 7.5625f * time * time + 0.9375f;
+    }
+    
+    time -= 2.625f / 2.75f;
+    return 7.5625f * time * time + 0.984375f;
 }
 
-void CCBAnimationManager::runAnimations(const char *pName)
+// Same curves as the CCActionEase actions
+static float getEasedTime(int nEasingType, float fEasingOpt, float time)
 {
-    runAnimationsForSequenceNamed(pName);
+    const float piX2 = (float)M_PI * 2.0f;
+    
+    switch (nEasingType)
+    {
+        case kCCBKeyframeEasingLinear:
+            return time;
+        case kCCBKeyframeEasingInstant:
+            return time < 0 ? 0 : 1;
+        case kCCBKeyframeEasingCubicIn:
+            return powf(time, fEasingOpt);
+        case kCCBKeyframeEasingCubicOut:
+            return powf(time, 1 / fEasingOpt);
+        case kCCBKeyframeEasingCubicInOut:
+            time *= 2;
+            if (time < 1)
+            {
+                return 0.5f * powf(time, fEasingOpt);
+            }
+            return 1.0f - 0.5f * powf(2 - time, fEasingOpt);
+        case kCCBKeyframeEasingBackIn:
+        {
+            float overshoot = 1.70158f;
+            return time * time * ((overshoot + 1) * time - overshoot);
+        }
+        case kCCBKeyframeEasingBackOut:
+        {
+            float overshoot = 1.70158f;
+            time = time - 1;
+            return time * time * ((overshoot + 1) * time + overshoot) + 1;
+        }
+        case kCCBKeyframeEasingBackInOut:
+        {
+            float overshoot = 1.70158f * 1.525f;
+            time = time * 2;
+            if (time < 1)
+            {
+                return (time * time * ((overshoot + 1) * time - overshoot)) / 2;
+            }
+            time = time - 2;
+            return (time * time * ((overshoot + 1) * time + overshoot)) / 2 + 1;
+        }
+        case kCCBKeyframeEasingBounceIn:
+            return 1 - bounceTime(1 - time);
+        case kCCBKeyframeEasingBounceOut:
+            return bounceTime(time);
+        case kCCBKeyframeEasingBounceInOut:
+            if (time < 0.5f)
+            {
+                return (1 - bounceTime(1 - time * 2)) * 0.5f;
+            }
+            return bounceTime(time * 2 - 1) * 0.5f + 0.5f;
+        case kCCBKeyframeEasingElasticIn:
+        {
+            if (time == 0 || time == 1)
+            {
+                return time;
+            }
+            float s = fEasingOpt / 4;
+            time = time - 1;
+            return -powf(2, 10 * time) * sinf((time - s) * piX2 / fEasingOpt);
+        }
+        case kCCBKeyframeEasingElasticOut:
+        {
+            if (time == 0 || time == 1)
+            {
+                return time;
+            }
+            float s = fEasingOpt / 4;
+            return powf(2, -10 * time) * sinf((time - s) * piX2 / fEasingOpt) + 1;
+        }
+        case kCCBKeyframeEasingElasticInOut:
+        {
+            if (time == 0 || time == 1)
+            {
+                return time;
+            }
+            float period = fEasingOpt ? fEasingOpt : 0.3f * 1.5f;
+            float s = period / 4;
+            time = time * 2 - 1;
+            if (time < 0)
+            {
+                return -0.5f * powf(2, 10 * time) * sinf((time - s) * piX2 / period);
+            }
+            return powf(2, -10 * time) * sinf((time - s) * piX2 / period) * 0.5f + 1;
+        }
+        default:
+            CCLog("CCBReader: Unkown easing type %d", nEasingType);
+            return time;
+    }
 }
+
+/**
+ Evaluates the tracks of one node, it runs on that node so stopping the actions
+ of the node, or removing it, stops its animation like the actions it replaces.
+ */
+class CCBNodeTimeline : public CCActionInterval
+{
+private:
+    CCBAnimationManager *mAnimationManager;
+    std::vector<CCBAnimationManager::Track> *mTracks;
+    size_t mFirst;
+    size_t mLast;
     
-void CCBAnimationManager::runAnimations(int nSeqId, float fTweenDuraiton)
+public:
+    CCBNodeTimeline()
+    : mAnimationManager(NULL)
+    , mTracks(NULL)
+    , mFirst(0)
+    , mLast(0)
+    {}
+    
+    ~CCBNodeTimeline()
+    {
+        CC_SAFE_RELEASE(mAnimationManager);
+    }
+    
+    static CCBNodeTimeline* create(CCBAnimationManager *pAnimationManager, std::vector<CCBAnimationManager::Track> *pTracks,
+                                   size_t first, size_t last, float fDuration)
+    {
+        CCBNodeTimeline *ret = new CCBNodeTimeline();
+        ret->initWithDuration(fDuration);
+        ret->mAnimationManager = pAnimationManager;
+        CC_SAFE_RETAIN(pAnimationManager);
+        ret->mTracks = pTracks;
+        ret->mFirst = first;
+        ret->mLast = last;
+        ret->autorelease();
+        return ret;
+    }
+    
+    virtual void update(float time)
+    {
+        mAnimationManager->updateTracks(mTracks, mFirst, mLast, time * m_fDuration);
+    }
+};
+
+/**
+ Completes the running sequence, it runs on the root node next to the timelines
+ of the nodes.
+ */
+class CCBTimeline : public CCActionInterval
 {
-    runAnimationsForSequenceIdTweenDuration(nSeqId, fTweenDuraiton);
+private:
+    CCBAnimationManager *mAnimationManager;
+    bool mCompleted;
+    
+public:
+    CCBTimeline()
+    : mAnimationManager(NULL)
+    , mCompleted(false)
+    {}
+    
+    ~CCBTimeline()
+    {
+        CC_SAFE_RELEASE(mAnimationManager);
+    }
+    
+    static CCBTimeline* create(CCBAnimationManager *pAnimationManager, float fDuration)
+    {
+        CCBTimeline *ret = new CCBTimeline();
+        ret->initWithDuration(fDuration);
+        ret->mAnimationManager = pAnimationManager;
+        CC_SAFE_RETAIN(pAnimationManager);
+        ret->autorelease();
+        return ret;
+    }
+    
+    virtual void update(float time)
+    {
+        if (mCompleted)
+        {
+            return;
+        }
+        
+        if (time >= 1)
+        {
+            // sequenceCompleted() may run another timeline, which stops this one
+            mCompleted = true;
+            mAnimationManager->sequenceCompleted();
+        }
+    }
+};
+
+void CCBAnimationManager::invalidateCompiledSequences()
+{
+    mCompiledSequences.clear();
+    mRunningTracks = NULL;
 }
 
-void CCBAnimationManager::runAnimationsForSequenceIdTweenDuration(int nSeqId, float fTweenDuration)
+bool CCBAnimationManager::compileTrack(Track &track, CCNode *pNode, const char *pPropName, CCArray *pKeyframes, CCObject *pBaseValue)
 {
-    CCAssert(nSeqId != -1, "Sequence id couldn't be found");
+    track.property = getTrackProperty(pPropName);
+    if (track.property == -1)
+    {
+        CCLog("CCBReader: Failed to create animation for property: %s", pPropName);
+        return false;
+    }
     
-    mRootNode->stopAllActions();
+    track.node = pNode;
+    track.rgba = dynamic_cast<CCRGBAProtocol*>(pNode);
+    track.type = 0;
+    track.keyframe = -1;
+    
+    if (track.property == kCCBTrackPosition || track.property == kCCBTrackScale)
+    {
+        CCArray *baseValue = (CCArray*)getBaseValue(pNode, pPropName);
+        if (baseValue)
+        {
+            track.type = ((CCBValue*)baseValue->objectAtIndex(2))->getIntValue();
+        }
+    }
+    
+    int numKeyframes = pKeyframes ? pKeyframes->count() : 0;
+    if (numKeyframes == 0)
+    {
+        // Use base value (no animation)
+        CCAssert(pBaseValue, "No baseValue found for property");
+        if (! pBaseValue)
+        {
+            return false;
+        }
+        
+        TrackKeyframe keyframe;
+        memset(&keyframe, 0, sizeof(keyframe));
+        keyframe.easingType = kCCBKeyframeEasingLinear;
+        decodeKeyframeValue(track.property, pBaseValue, keyframe.values, keyframe.source, &keyframe.spriteFrame);
+        track.keyframes.push_back(keyframe);
+        return true;
+    }
+    
+    track.keyframes.resize(numKeyframes);
+    for (int i = 0; i < numKeyframes; ++i)
+    {
+        CCBKeyframe *ccbKeyframe = (CCBKeyframe*)pKeyframes->objectAtIndex(i);
+        TrackKeyframe &keyframe = track.keyframes[i];
+        memset(&keyframe, 0, sizeof(keyframe));
+        keyframe.time = ccbKeyframe->getTime();
+        keyframe.easingType = ccbKeyframe->getEasingType();
+        keyframe.easingOpt = ccbKeyframe->getEasingOpt();
+        decodeKeyframeValue(track.property, ccbKeyframe->getValue(), keyframe.values, keyframe.source, &keyframe.spriteFrame);
+    }
+    return true;
+}
+
+std::vector<CCBAnimationManager::Track>& CCBAnimationManager::getCompiledSequence(int nSequenceId)
+{
+    std::map<int, std::vector<Track> >::iterator it = mCompiledSequences.find(nSequenceId);
+    if (it != mCompiledSequences.end())
+    {
+        return it->second;
+    }
+    
+    std::vector<Track> &tracks = mCompiledSequences[nSequenceId];
     
     CCDictElement* pElement = NULL;
     CCDICT_FOREACH(mNodeSequences, pElement)
     {
         CCNode *node = (CCNode*)pElement->getIntKey();
-        node->stopAllActions();
         
         // Refer to CCBReader::readKeyframe() for the real type of value
         CCDictionary *seqs = (CCDictionary*)pElement->getObject();
-        CCDictionary *seqNodeProps = (CCDictionary*)seqs->objectForKey(nSeqId);
-        
-        set<string> seqNodePropNames;
+        CCDictionary *seqNodeProps = (CCDictionary*)seqs->objectForKey(nSequenceId);
+        CCDictionary *nodeBaseValues = (CCDictionary*)mBaseValues->objectForKey(pElement->getIntKey());
         
         if (seqNodeProps)
         {
-            // Reset nodes that have sequence node properties, and run actions on them
+            // Properties animated by this sequence
             CCDictElement* pElement1 = NULL;
             CCDICT_FOREACH(seqNodeProps, pElement1)
             {
                 const char *propName = pElement1->getStrKey();
-                CCBSequenceProperty *seqProp = (CCBSequenceProperty*)seqNodeProps->objectForKey(propName);
-                seqNodePropNames.insert(propName);
+                CCBSequenceProperty *seqProp = (CCBSequenceProperty*)pElement1->getObject();
+                CCObject *baseValue = nodeBaseValues ? nodeBaseValues->objectForKey(propName) : NULL;
                 
-                setFirstFrame(node, seqProp, fTweenDuration);
-                runAction(node, seqProp, fTweenDuration);
+                tracks.push_back(Track());
+                if (! compileTrack(tracks.back(), node, propName, seqProp->getKeyframes(), baseValue))
+                {
+                    tracks.pop_back();
+                }
             }
         }
         
-        // Reset the nodes that may have been changed by other timelines
-        CCDictionary *nodeBaseValues = (CCDictionary*)mBaseValues->objectForKey(pElement->getIntKey());
+        // Reset the properties that may have been changed by other timelines
         if (nodeBaseValues)
         {
             CCDictElement* pElement2 = NULL;
             CCDICT_FOREACH(nodeBaseValues, pElement2)
             {
-                if (seqNodePropNames.find(pElement2->getStrKey()) == seqNodePropNames.end())
+                const char *propName = pElement2->getStrKey();
+                if (seqNodeProps && seqNodeProps->objectForKey(propName))
                 {
-                    CCObject *value = pElement2->getObject();
-                    
-                    if (value)
+                    continue;
+                }
+                
+                if (pElement2->getObject())
+                {
+                    tracks.push_back(Track());
+                    if (! compileTrack(tracks.back(), node, propName, NULL, pElement2->getObject()))
                     {
-                       setAnimatedProperty(pElement2->getStrKey(), node, value, fTweenDuration);
+                        tracks.pop_back();
                     }
                 }
             }
         }
     }
     
-    // Make callback at end of sequence
+    return tracks;
+}
+
+void CCBAnimationManager::startTrack(Track &track, float fTweenDuration)
+{
+    // Positions depend on the size of the parent when the timeline starts
+    if (track.property == kCCBTrackPosition)
+    {
+        CCSize containerSize = getContainerSize(track.node->getParent());
+        for (size_t i = 0; i < track.keyframes.size(); ++i)
+        {
+            TrackKeyframe &keyframe = track.keyframes[i];
+            CCPoint absPos = getAbsolutePosition(ccp(keyframe.source[0], keyframe.source[1]), track.type, containerSize, "position");
+            keyframe.values[0] = absPos.x;
+            keyframe.values[1] = absPos.y;
+        }
+    }
+    else if (track.property == kCCBTrackScale)
+    {
+        float resolutionScale = track.type == kCCBScaleTypeMultiplyResolution ? CCBReader::getResolutionScale() : 1;
+        for (size_t i = 0; i < track.keyframes.size(); ++i)
+        {
+            TrackKeyframe &keyframe = track.keyframes[i];
+            keyframe.values[0] = keyframe.source[0] * resolutionScale;
+            keyframe.values[1] = keyframe.source[1] * resolutionScale;
+        }
+    }
+    
+    if (fTweenDuration <= 0)
+    {
+        // Just set the first value
+        track.keyframe = 0;
+        setTrackKeyframe(track, track.keyframes[0]);
+        return;
+    }
+    
+    // Tween from the current values to the first keyframe
+    track.keyframe = -1;
+    CCNode *node = track.node;
+    switch (track.property)
+    {
+        case kCCBTrackPosition:
+            track.startValues[0] = node->getPositionX();
+            track.startValues[1] = node->getPositionY();
+            break;
+        case kCCBTrackScale:
+            track.startValues[0] = node->getScaleX();
+            track.startValues[1] = node->getScaleY();
+            break;
+        case kCCBTrackSkew:
+            track.startValues[0] = node->getSkewX();
+            track.startValues[1] = node->getSkewY();
+            break;
+        case kCCBTrackRotation:
+            track.startValues[0] = node->getRotation();
+            break;
+        case kCCBTrackRotationX:
+            track.startValues[0] = node->getRotationX();
+            break;
+        case kCCBTrackRotationY:
+            track.startValues[0] = node->getRotationY();
+            break;
+        case kCCBTrackOpacity:
+            track.startValues[0] = track.rgba ? track.rgba->getOpacity() : 255;
+            break;
+        case kCCBTrackColor:
+        {
+            ccColor3B c = track.rgba ? track.rgba->getColor() : ccWHITE;
+            track.startValues[0] = c.r;
+            track.startValues[1] = c.g;
+            track.startValues[2] = c.b;
+            break;
+        }
+    }
+}
+
+void CCBAnimationManager::setTrackValues(Track &track, const float *pValues)
+{
+    CCNode *node = track.node;
+    switch (track.property)
+    {
+        case kCCBTrackPosition:
+            node->setPosition(ccp(pValues[0], pValues[1]));
+            break;
+        case kCCBTrackScale:
+            node->setScaleX(pValues[0]);
+            node->setScaleY(pValues[1]);
+            break;
+        case kCCBTrackSkew:
+            node->setSkewX(pValues[0]);
+            node->setSkewY(pValues[1]);
+            break;
+        case kCCBTrackRotation:
+            node->setRotation(pValues[0]);
+            break;
+        case kCCBTrackRotationX:
+            node->setRotationX(pValues[0]);
+            break;
+        case kCCBTrackRotationY:
+            node->setRotationY(pValues[0]);
+            break;
+        case kCCBTrackOpacity:
+            if (track.rgba)
+            {
+                track.rgba->setOpacity((GLubyte)pValues[0]);
+            }
+            break;
+        case kCCBTrackColor:
+            if (track.rgba)
+            {
+                track.rgba->setColor(ccc3((GLubyte)pValues[0], (GLubyte)pValues[1], (GLubyte)pValues[2]));
+            }
+            break;
+        case kCCBTrackVisible:
+            node->setVisible(pValues[0] != 0);
+            break;
+    }
+}
+
+void CCBAnimationManager::setTrackKeyframe(Track &track, const TrackKeyframe &keyframe)
+{
+    if (track.property == kCCBTrackDisplayFrame)
+    {
+        ((CCSprite*)track.node)->setDisplayFrame(keyframe.spriteFrame);
+    }
+    else
+    {
+        setTrackValues(track, keyframe.values);
+    }
+}
+
+void CCBAnimationManager::updateTracks(std::vector<Track> *pTracks, size_t first, size_t last, float fTime)
+{
+    // the sequence was replaced, or recompiled
+    if (pTracks != mRunningTracks)
+    {
+        return;
+    }
+    
+    float time = fTime - mRunningTweenDuration;
+    float values[3];
+    
+    for (size_t i = first; i < last; ++i)
+    {
+        Track &track = (*pTracks)[i];
+        const std::vector<TrackKeyframe> &keyframes = track.keyframes;
+        int numKeyframes = (int)keyframes.size();
+        
+        if (track.keyframe == -1)
+        {
+            if (time < 0)
+            {
+                // Tween towards the first keyframe, linearly
+                if (! isStepTrackProperty(track.property))
+                {
+                    float t = fTime / mRunningTweenDuration;
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        values[i] = track.startValues[i] + (keyframes[0].values[i] - track.startValues[i]) * t;
+                    }
+                    setTrackValues(track, values);
+                }
+                continue;
+            }
+            
+            track.keyframe = 0;
+            setTrackKeyframe(track, keyframes[0]);
+        }
+        
+        if (track.keyframe == numKeyframes - 1)
+        {
+            continue;
+        }
+        
+        // Set the last keyframe reached
+        int reached = track.keyframe;
+        while (reached + 1 < numKeyframes && time >= keyframes[reached + 1].time)
+        {
+            reached++;
+        }
+        if (reached != track.keyframe)
+        {
+            track.keyframe = reached;
+            setTrackKeyframe(track, keyframes[reached]);
+        }
+        
+        // Interpolate towards the next one
+        if (reached + 1 < numKeyframes && time > keyframes[reached].time && ! isStepTrackProperty(track.property))
+        {
+            const TrackKeyframe &kf0 = keyframes[reached];
+            const TrackKeyframe &kf1 = keyframes[reached + 1];
+            float t = getEasedTime(kf0.easingType, kf0.easingOpt, (time - kf0.time) / (kf1.time - kf0.time));
+            for (int i = 0; i < 3; ++i)
+            {
+                values[i] = kf0.values[i] + (kf1.values[i] - kf0.values[i]) * t;
+            }
+            setTrackValues(track, values);
+        }
+    }
+}
+
+void CCBAnimationManager::runAnimations(const char *pName, float fTweenDuration)
+{
+    runAnimationsForSequenceNamedTweenDuration(pName, fTweenDuration);
+}
+
+void CCBAnimationManager::runAnimations(const char *pName)
+{
+    runAnimationsForSequenceNamed(pName);
+}
+    
+void CCBAnimationManager::runAnimations(int nSeqId, float fTweenDuraiton)
+{
+    runAnimationsForSequenceIdTweenDuration(nSeqId, fTweenDuraiton);
+}
+
+void CCBAnimationManager::runAnimationsForSequenceIdTweenDuration(int nSeqId, float fTweenDuration)
+{
+    CCAssert(nSeqId != -1, "Sequence id couldn't be found");
+    
+    mRootNode->stopAllActions();
+    
+    CCDictElement* pElement = NULL;
+    CCDICT_FOREACH(mNodeSequences, pElement)
+    {
+        CCNode *node = (CCNode*)pElement->getIntKey();
+        node->stopAllActions();
+    }
+    
+    // Reset the animated properties and the ones that may have been changed by
+    // other timelines, the timeline action evaluates the tracks from there
+    std::vector<Track> &tracks = getCompiledSequence(nSeqId);
+    std::vector<Track>::iterator it = tracks.begin();
+    for (; it != tracks.end(); ++it)
+    {
+        startTrack(*it, fTweenDuration);
+    }
+    mRunningTracks = &tracks;
+    mRunningTweenDuration = fTweenDuration;
+    
+    // One timeline per node, the tracks of a node are next to each other
     CCBSequence *seq = getSequence(nSeqId);
-    CCAction *completeAction = CCSequence::createWithTwoActions(CCDelayTime::create(seq->getDuration() + fTweenDuration),
-                                                                CCCallFunc::create(this, callfunc_selector(CCBAnimationManager::sequenceCompleted)));
-    mRootNode->runAction(completeAction);
+    float duration = seq->getDuration() + fTweenDuration;
+    for (size_t first = 0; first < tracks.size();)
+    {
+        size_t last = first + 1;
+        while (last < tracks.size() && tracks[last].node == tracks[first].node)
+        {
+            last++;
+        }
+        tracks[first].node->runAction(CCBNodeTimeline::create(this, &tracks, first, last, duration));
+        first = last;
+    }
+    
+    // Make callback at end of sequence
+    mRootNode->runAction(CCBTimeline::create(this, duration));
     
     // Set the running scene
 
@@ -820,7 +1090,7 @@ void CCBAnimationManager::runAnimationsForSequenceIdTweenDuration(int nSeqId, fl
         }
     }
 
-    mRunningSequence = getSequence(nSeqId);
+    mRunningSequence = seq;
 }
 
 void CCBAnimationManager::runAnimationsForSequenceNamedTweenDuration(const char *pName, float fTweenDuration)
@@ -7,6 +7,8 @@
 #include "CCBValue.h"
 #include "CCBSequenceProperty.h"
 #include "GUI/CCControlExtension/CCControl.h"
+#include <map>
+#include <vector>
 
 NS_CC_EXT_BEGIN
 /**
@@ -48,6 +50,32 @@ private:
     SEL_CallFunc mAnimationCompleteCallbackFunc;
     CCObject *mTarget;
     
+    // Timelines compiled into flat keyframe tracks, evaluated by the manager
+    // instead of building a chain of actions per property every time they run
+    struct TrackKeyframe
+    {
+        float time;
+        int easingType;
+        float easingOpt;
+        float source[2];                // relative position or scale, resolved when the track starts
+        float values[3];
+        CCSpriteFrame *spriteFrame;     // retained by the CCBKeyframe
+    };
+    
+    struct Track
+    {
+        CCNode *node;                   // runs the timeline of its tracks, which keeps it alive
+        CCRGBAProtocol *rgba;
+        int property;
+        int type;                       // position or scale type
+        std::vector<TrackKeyframe> keyframes;
+        float startValues[3];           // values of the node when the tween starts
+        int keyframe;                   // last keyframe set, -1 during the tween
+    };
+    
+    std::map<int, std::vector<Track> > mCompiledSequences;
+    std::vector<Track> *mRunningTracks;
+    float mRunningTweenDuration;
     
 public:
     bool jsControlled;
@@ -136,12 +164,17 @@ private:
     CCObject* getBaseValue(CCNode *pNode, const char* pPropName);
     int getSequenceId(const char* pSequenceName);
     CCBSequence* getSequence(int nSequenceId);
-    CCActionInterval* getAction(CCBKeyframe *pKeyframe0, CCBKeyframe *pKeyframe1, const char *pPropName, CCNode *pNode);
-    void setAnimatedProperty(const char *pPropName, CCNode *pNode, CCObject *pValue, float fTweenDuraion);
-    void setFirstFrame(CCNode *pNode, CCBSequenceProperty *pSeqProp, float fTweenDuration);
-    CCActionInterval* getEaseAction(CCActionInterval *pAction, int nEasingType, float fEasingOpt);
-    void runAction(CCNode *pNode, CCBSequenceProperty *pSeqProp, float fTweenDuration);
+    std::vector<Track>& getCompiledSequence(int nSequenceId);
+    bool compileTrack(Track &track, CCNode *pNode, const char *pPropName, CCArray *pKeyframes, CCObject *pBaseValue);
+    void invalidateCompiledSequences();
+    void startTrack(Track &track, float fTweenDuration);
+    void updateTracks(std::vector<Track> *pTracks, size_t first, size_t last, float fTime);
+    void setTrackValues(Track &track, const float *pValues);
+    void setTrackKeyframe(Track &track, const TrackKeyframe &keyframe);
     void sequenceCompleted();
+    
+    friend class CCBTimeline;
+    friend class CCBNodeTimeline;
 };
 /**
  *  @js NA
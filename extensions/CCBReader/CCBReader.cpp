@@ -53,12 +53,85 @@ void CCBFile::setCCBFileNode(CCNode *pNode)
     CC_SAFE_RETAIN(mCCBFileNode);
 }
 
+/*************************************************************************
+ Implementation of CCBPrototype
+ *************************************************************************/
+
+CCBPrototype::CCBPrototype()
+: mData(NULL)
+, mBodyOffset(0)
+, mJSControlled(false)
+, mCCNodeLoaderLibrary(NULL)
+{}
+
+CCBPrototype::~CCBPrototype()
+{
+    CC_SAFE_RELEASE(mData);
+    CC_SAFE_RELEASE(mCCNodeLoaderLibrary);
+
+    std::map<int, ResolvedValue>::iterator it = mResolvedValues.begin();
+    for (; it != mResolvedValues.end(); ++it)
+    {
+        CC_SAFE_RELEASE(it->second.value);
+    }
+}
+
+const std::string& CCBPrototype::getFilePath() const
+{
+    return mFilePath;
+}
+
+CCData* CCBPrototype::getData()
+{
+    return mData;
+}
+
+CCNodeLoader* CCBPrototype::getNodeLoader(int classNameIndex, CCNodeLoaderLibrary *pCCNodeLoaderLibrary)
+{
+    // The table only caches the loaders of the library used by the first instantiation
+    if (mCCNodeLoaderLibrary == NULL)
+    {
+        mCCNodeLoaderLibrary = pCCNodeLoaderLibrary;
+        mCCNodeLoaderLibrary->retain();
+        mNodeLoaders.resize(mStringCache.size(), NULL);
+    }
+    if (pCCNodeLoaderLibrary != mCCNodeLoaderLibrary)
+    {
+        return pCCNodeLoaderLibrary->getCCNodeLoader(mStringCache[classNameIndex].c_str());
+    }
+
+    CCNodeLoader *pLoader = mNodeLoaders[classNameIndex];
+    if (pLoader == NULL)
+    {
+        pLoader = pCCNodeLoaderLibrary->getCCNodeLoader(mStringCache[classNameIndex].c_str());
+        mNodeLoaders[classNameIndex] = pLoader;
+    }
+    return pLoader;
+}
+
 /*************************************************************************
  Implementation of CCBReader
  *************************************************************************/
 
+static bool __ccbUsePrototypes = false;
+static CCDictionary* __ccbPrototypes = NULL;
+
+static std::string ccbFullPath(const char *pCCBFileName)
+{
+    std::string strCCBFileName(pCCBFileName);
+    std::string strSuffix(".ccbi");
+    // Add ccbi suffix
+    if (!CCBReader::endsWith(strCCBFileName.c_str(), strSuffix.c_str()))
+    {
+        strCCBFileName += strSuffix;
+    }
+
+    return CCFileUtils::sharedFileUtils()->fullPathForFilename(strCCBFileName.c_str());
+}
+
 CCBReader::CCBReader(CCNodeLoaderLibrary * pCCNodeLoaderLibrary, CCBMemberVariableAssigner * pCCBMemberVariableAssigner, CCBSelectorResolver * pCCBSelectorResolver, CCNodeLoaderListener * pCCNodeLoaderListener) 
 : mData(NULL)
+, mPrototype(NULL)
 , mBytes(NULL)
 , mCurrentByte(-1)
 , mCurrentBit(-1)
@@ -81,6 +154,7 @@ CCBReader::CCBReader(CCNodeLoaderLibrary * pCCNodeLoaderLibrary, CCBMemberVariab
 
 CCBReader::CCBReader(CCBReader * pCCBReader) 
 : mData(NULL)
+, mPrototype(NULL)
 , mBytes(NULL)
 , mCurrentByte(-1)
 , mCurrentBit(-1)
@@ -107,6 +181,7 @@ CCBReader::CCBReader(CCBReader * pCCBReader)
 
 CCBReader::CCBReader()
 : mData(NULL)
+, mPrototype(NULL)
 , mBytes(NULL)
 , mCurrentByte(-1)
 , mCurrentBit(-1)
@@ -126,6 +201,7 @@ CCBReader::CCBReader()
 CCBReader::~CCBReader() {
     CC_SAFE_RELEASE_NULL(mOwner);
     CC_SAFE_RELEASE_NULL(mData);
+    CC_SAFE_RELEASE_NULL(mPrototype);
 
     this->mCCNodeLoaderLibrary->release();
 
@@ -232,15 +308,12 @@ CCNode* CCBReader::readNodeGraphFromFile(const char *pCCBFileName, CCObject *pOw
         return NULL;
     }
 
-    std::string strCCBFileName(pCCBFileName);
-    std::string strSuffix(".ccbi");
-    // Add ccbi suffix
-    if (!CCBReader::endsWith(strCCBFileName.c_str(), strSuffix.c_str()))
+    if (isPrototypeCacheEnabled())
     {
-        strCCBFileName += strSuffix;
+        return this->readNodeGraphFromPrototype(this->getPrototype(pCCBFileName), pOwner, parentSize);
     }
 
-    std::string strPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(strCCBFileName.c_str());
+    std::string strPath = ccbFullPath(pCCBFileName);
     unsigned long size = 0;
 
     unsigned char * pBytes = CCFileUtils::sharedFileUtils()->getFileData(strPath.c_str(), "rb", &size);
@@ -256,6 +329,13 @@ CCNode* CCBReader::readNodeGraphFromFile(const char *pCCBFileName, CCObject *pOw
 
 CCNode* CCBReader::readNodeGraphFromData(CCData *pData, CCObject *pOwner, const CCSize &parentSize)
 {
+    // only readNodeGraphFromPrototype() reads the data of its prototype, other data is parsed
+    // without the offsets and values compiled for a previous file
+    if (mPrototype && mPrototype->getData() != pData)
+    {
+        CC_SAFE_RELEASE_NULL(mPrototype);
+    }
+
     mData = pData;
     CC_SAFE_RETAIN(mData);
     mBytes = mData->getBytes();
@@ -298,6 +378,85 @@ CCNode* CCBReader::readNodeGraphFromData(CCData *pData, CCObject *pOwner, const
     return pNodeGraph;
 }
 
+CCBPrototype* CCBReader::getPrototype(const char *pCCBFileName)
+{
+    if (NULL == pCCBFileName || strlen(pCCBFileName) == 0)
+    {
+        return NULL;
+    }
+
+    std::string strPath = ccbFullPath(pCCBFileName);
+    if (__ccbPrototypes == NULL)
+    {
+        __ccbPrototypes = new CCDictionary();
+    }
+    CCBPrototype *pPrototype = (CCBPrototype*)__ccbPrototypes->objectForKey(strPath);
+    if (pPrototype != NULL)
+    {
+        return pPrototype;
+    }
+
+    unsigned long size = 0;
+    unsigned char * pBytes = CCFileUtils::sharedFileUtils()->getFileData(strPath.c_str(), "rb", &size);
+    if (pBytes == NULL)
+    {
+        return NULL;
+    }
+    CCData *data = new CCData(pBytes, size);
+    CC_SAFE_DELETE_ARRAY(pBytes);
+
+    // Decode the header and the string cache with a scratch reader
+    CCBReader *pReader = new CCBReader(this);
+    pReader->mData = data;
+    data->retain();
+    pReader->mBytes = data->getBytes();
+    pReader->mCurrentByte = 0;
+    pReader->mCurrentBit = 0;
+
+    if (pReader->readHeader() && pReader->readStringCache())
+    {
+        pPrototype = new CCBPrototype();
+        pPrototype->mFilePath = strPath;
+        pPrototype->mData = data;
+        data->retain();
+        pPrototype->mBodyOffset = pReader->mCurrentByte;
+        pPrototype->mJSControlled = pReader->jsControlled;
+        pPrototype->mStringCache.swap(pReader->mStringCache);
+        pPrototype->mCCBRootPath = mCCBRootPath;
+
+        __ccbPrototypes->setObject(pPrototype, strPath);
+        pPrototype->release();
+    }
+    else
+    {
+        CCLog("CCBReader: can't compile %s", strPath.c_str());
+    }
+
+    pReader->release();
+    data->release();
+
+    return pPrototype;
+}
+
+CCNode* CCBReader::readNodeGraphFromPrototype(CCBPrototype *pPrototype, CCObject *pOwner)
+{
+    return this->readNodeGraphFromPrototype(pPrototype, pOwner, CCDirector::sharedDirector()->getWinSize());
+}
+
+CCNode* CCBReader::readNodeGraphFromPrototype(CCBPrototype *pPrototype, CCObject *pOwner, const CCSize &parentSize)
+{
+    if (pPrototype == NULL)
+    {
+        return NULL;
+    }
+
+    CC_SAFE_RETAIN(pPrototype);
+    CC_SAFE_RELEASE(mPrototype);
+    mPrototype = pPrototype;
+
+    return this->readNodeGraphFromData(pPrototype->getData(), pOwner, parentSize);
+}
+
 CCScene* CCBReader::createSceneWithNodeGraphFromFile(const char *pCCBFileName)
 {
     return createSceneWithNodeGraphFromFile(pCCBFileName, NULL);
@@ -330,14 +489,25 @@ void CCBReader::cleanUpNodeGraph(CCNode *pNode)
 
 CCNode* CCBReader::readFileWithCleanUp(bool bCleanUp, CCDictionary* am)
 {
-    if (! readHeader())
+    if (mPrototype)
     {
-        return NULL;
+        // The header and the string cache are decoded by the prototype
+        mCurrentByte = mPrototype->mBodyOffset;
+        mCurrentBit = 0;
+        jsControlled = mPrototype->mJSControlled;
+        mActionManager->jsControlled = jsControlled;
     }
-    
-    if (! readStringCache())
+    else
     {
-        return NULL;
+        if (! readHeader())
+        {
+            return NULL;
+        }
+        
+        if (! readStringCache())
+        {
+            return NULL;
+        }
     }
     
     if (! readSequences())
@@ -530,12 +700,45 @@ float CCBReader::readFloat() {
 
 std::string CCBReader::readCachedString() {
     int n = this->readInt(false);
-    return this->mStringCache[n];
+    return this->getCachedString(n);
+}
+
+const std::string& CCBReader::getCachedString(int n) {
+    return mPrototype ? mPrototype->mStringCache[n] : this->mStringCache[n];
+}
+
+bool CCBReader::readResolvedValue(CCObject **ppValue) {
+    if (mPrototype == NULL || mPrototype->mCCBRootPath != mCCBRootPath) {
+        return false;
+    }
+
+    std::map<int, CCBPrototype::ResolvedValue>::const_iterator it = mPrototype->mResolvedValues.find(mCurrentByte);
+    if (it == mPrototype->mResolvedValues.end()) {
+        return false;
+    }
+
+    // Skip the encoded value
+    *ppValue = it->second.value;
+    mCurrentByte = it->second.end;
+    return true;
+}
+
+void CCBReader::addResolvedValue(int nStart, CCObject *pValue) {
+    if (mPrototype == NULL || mPrototype->mCCBRootPath != mCCBRootPath) {
+        return;
+    }
+
+    CCBPrototype::ResolvedValue &value = mPrototype->mResolvedValues[nStart];
+    CC_SAFE_RETAIN(pValue);
+    CC_SAFE_RELEASE(value.value);
+    value.value = pValue;
+    value.end = mCurrentByte;
 }
 
 CCNode * CCBReader::readNodeGraph(CCNode * pParent) {
     /* Read class name. */
-    std::string className = this->readCachedString();
+    int classNameIndex = this->readInt(false);
+    const std::string& className = this->getCachedString(classNameIndex);
 
     std::string jsControlledName;
     
@@ -550,7 +753,15 @@ CCNode * CCBReader::readNodeGraph(CCNode * pParent) {
         memberVarAssignmentName = this->readCachedString();
     }
     
-    CCNodeLoader *ccNodeLoader = this->mCCNodeLoaderLibrary->getCCNodeLoader(className.c_str());
+    CCNodeLoader *ccNodeLoader = NULL;
+    if (mPrototype)
+    {
+        ccNodeLoader = mPrototype->getNodeLoader(classNameIndex, this->mCCNodeLoaderLibrary);
+    }
+    else
+    {
+        ccNodeLoader = this->mCCNodeLoaderLibrary->getCCNodeLoader(className.c_str());
+    }
      
     if (! ccNodeLoader)
     {
@@ -798,8 +1009,13 @@ CCBKeyframe* CCBReader::readKeyframe(int type)
                                 CCBValue::create(b),
                                 NULL);
     }
+    else if (type == kCCBPropTypeSpriteFrame && readResolvedValue(&value))
+    {
+        // Resolved by an earlier instantiation of the prototype
+    }
     else if (type == kCCBPropTypeSpriteFrame)
     {
+        int start = mCurrentByte;
         std::string spriteSheet = readCachedString();
         std::string spriteFile = readCachedString();
         
@@ -827,6 +1043,7 @@ CCBKeyframe* CCBReader::readKeyframe(int type)
             spriteFrame = frameCache->spriteFrameByName(spriteFile.c_str());
         }
         value = spriteFrame;
+        addResolvedValue(start, value);
     }
     
     keyframe->setValue(value);
@@ -1072,4 +1289,19 @@ void CCBReader::setResolutionScale(float scale)
     __ccbResolutionScale = scale;
 }
 
+void CCBReader::setPrototypeCacheEnabled(bool bEnabled)
+{
+    __ccbUsePrototypes = bEnabled;
+}
+
+bool CCBReader::isPrototypeCacheEnabled()
+{
+    return __ccbUsePrototypes;
+}
+
+void CCBReader::purgePrototypeCache()
+{
+    CC_SAFE_RELEASE_NULL(__ccbPrototypes);
+}
+
 NS_CC_EXT_END;
@@ -5,6 +5,7 @@
 #include "ExtensionMacros.h"
 #include <string>
 #include <vector>
+#include <map>
 #include "CCBSequence.h"
 #include "GUI/CCControlExtension/CCControl.h"
 
@@ -166,6 +167,51 @@ class CCBAnimationManager;
 class CCData;
 class CCBKeyframe;
 
+/**
+ * @brief A ccbi file compiled once by CCBReader::getPrototype().
+ *
+ * The prototype keeps the file bytes and the decoded header and string table,
+ * so that CCBReader::readNodeGraphFromPrototype() builds a new node graph
+ * without reading and decoding the file again. The node loader of every class
+ * and the sprite frames, textures and animations referenced by the file are
+ * resolved by the first instantiation and reused by the next ones.
+ * @js NA
+ * @lua NA
+ */
+class CC_EX_DLL CCBPrototype : public CCObject
+{
+public:
+    CCBPrototype();
+    virtual ~CCBPrototype();
+
+    const std::string& getFilePath() const;
+    CCData* getData();
+
+private:
+    struct ResolvedValue
+    {
+        CCObject *value;
+        int end;
+    };
+
+    CCNodeLoader* getNodeLoader(int classNameIndex, CCNodeLoaderLibrary *pCCNodeLoaderLibrary);
+
+    std::string mFilePath;
+    CCData *mData;
+    int mBodyOffset;
+    bool mJSControlled;
+    std::vector<std::string> mStringCache;
+    
+    // resolved by the first instantiation, indexed by the position of the
+    // encoded value and only used by readers with the same root path
+    std::string mCCBRootPath;
+    CCNodeLoaderLibrary *mCCNodeLoaderLibrary;
+    std::vector<CCNodeLoader*> mNodeLoaders;
+    std::map<int, ResolvedValue> mResolvedValues;
+
+    friend class CCBReader;
+};
+
 /**
  * @brief Parse CCBI file which is generated by CocosBuilder
  */
@@ -174,6 +220,7 @@ class CC_EX_DLL CCBReader : public CCObject
 private:
     
     CCData *mData;
+    CCBPrototype *mPrototype;
     unsigned char *mBytes;
     int mCurrentByte;
     int mCurrentBit;
@@ -249,6 +296,26 @@ public:
      *  @lua NA
      */
     CCNode* readNodeGraphFromData(CCData *pData, CCObject *pOwner, const CCSize &parentSize);
+    /**
+     *  Returns the prototype of a ccbi file, compiled the first time and then
+     *  cached until purgePrototypeCache() is called. Returns NULL if the file
+     *  can't be read.
+     *  @js NA
+     *  @lua NA
+     */
+    CCBPrototype* getPrototype(const char *pCCBFileName);
+    /**
+     *  Builds a node graph from a compiled ccbi file. The member variables,
+     *  selectors and node loader listeners are called like readNodeGraphFromFile() does.
+     *  @js NA
+     *  @lua NA
+     */
+    CCNode* readNodeGraphFromPrototype(CCBPrototype *pPrototype, CCObject *pOwner);
+    /**
+     *  @js NA
+     *  @lua NA
+     */
+    CCNode* readNodeGraphFromPrototype(CCBPrototype *pPrototype, CCObject *pOwner, const CCSize &parentSize);
     /**
      *  @js loadScene
      *  @lua NA
@@ -406,6 +473,22 @@ public:
      */
     static float getResolutionScale();
     static void setResolutionScale(float scale);
+    /**
+     *  When enabled, readNodeGraphFromFile() and the sub ccb files are built
+     *  from the cached prototypes instead of reading the files every time.
+     *  Disabled by default.
+     *  @js NA
+     *  @lua NA
+     */
+    static void setPrototypeCacheEnabled(bool bEnabled);
+    static bool isPrototypeCacheEnabled();
+    /**
+     *  Releases the cached prototypes, and with them the sprite frames,
+     *  textures and animations they hold.
+     *  @js NA
+     *  @lua NA
+     */
+    static void purgePrototypeCache();
     /**
      *  @js NA
      *  @lua NA
@@ -422,6 +505,9 @@ private:
     
     bool readHeader();
     bool readStringCache();
+    const std::string& getCachedString(int n);
+    bool readResolvedValue(CCObject **ppValue);
+    void addResolvedValue(int nStart, CCObject *pValue);
     //void readStringCacheEntry();
     CCNode* readNodeGraph();
     CCNode* readNodeGraph(CCNode * pParent);
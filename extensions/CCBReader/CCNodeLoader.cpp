@@ -558,6 +558,18 @@ bool CCNodeLoader::parsePropTypeCheck(CCNode * pNode, CCNode * pParent, CCBReade
 
 CCSpriteFrame * CCNodeLoader::parsePropTypeSpriteFrame(CCNode * pNode, CCNode * pParent, CCBReader * pCCBReader, const char *pPropertyName) 
 {
+    CCObject *pResolved = NULL;
+    if (pCCBReader->readResolvedValue(&pResolved))
+    {
+        CCSpriteFrame *spriteFrame = (CCSpriteFrame*)pResolved;
+        if (spriteFrame != NULL && pCCBReader->getAnimatedProperties()->find(pPropertyName) != pCCBReader->getAnimatedProperties()->end())
+        {
+            pCCBReader->getAnimationManager()->setBaseValue(spriteFrame, pNode, pPropertyName);
+        }
+        return spriteFrame;
+    }
+
+    int start = pCCBReader->mCurrentByte;
     std::string spriteSheet = pCCBReader->readCachedString();
     std::string spriteFile = pCCBReader->readCachedString();
     
@@ -592,11 +604,19 @@ CCSpriteFrame * CCNodeLoader::parsePropTypeSpriteFrame(CCNode * pNode, CCNode *
             pCCBReader->getAnimationManager()->setBaseValue(spriteFrame, pNode, pPropertyName);
         }
     }
+    pCCBReader->addResolvedValue(start, spriteFrame);
     
     return spriteFrame;
 }
 
 CCAnimation * CCNodeLoader::parsePropTypeAnimation(CCNode * pNode, CCNode * pParent, CCBReader * pCCBReader) {
+    CCObject *pResolved = NULL;
+    if (pCCBReader->readResolvedValue(&pResolved))
+    {
+        return (CCAnimation*)pResolved;
+    }
+
+    int start = pCCBReader->mCurrentByte;
     std::string animationFile = pCCBReader->getCCBRootPath() + pCCBReader->readCachedString();
     std::string animation = pCCBReader->readCachedString();
     
@@ -617,20 +637,27 @@ CCAnimation * CCNodeLoader::parsePropTypeAnimation(CCNode * pNode, CCNode * pPar
         
         ccAnimation = animationCache->animationByName(animation.c_str());
     }
+    pCCBReader->addResolvedValue(start, ccAnimation);
     return ccAnimation;
 }
 
 CCTexture2D * CCNodeLoader::parsePropTypeTexture(CCNode * pNode, CCNode * pParent, CCBReader * pCCBReader) {
+    CCObject *pResolved = NULL;
+    if (pCCBReader->readResolvedValue(&pResolved))
+    {
+        return (CCTexture2D*)pResolved;
+    }
+
+    int start = pCCBReader->mCurrentByte;
     std::string spriteFile = pCCBReader->getCCBRootPath() + pCCBReader->readCachedString();
     
+    CCTexture2D *texture = NULL;
     if (spriteFile.length() > 0)
     {
-        return CCTextureCache::sharedTextureCache()->addImage(spriteFile.c_str());
-    }
-    else 
-    {
-        return NULL;
+        texture = CCTextureCache::sharedTextureCache()->addImage(spriteFile.c_str());
     }
+    pCCBReader->addResolvedValue(start, texture);
+    return texture;
 }
 
 unsigned char CCNodeLoader::parsePropTypeByte(CCNode * pNode, CCNode * pParent, CCBReader * pCCBReader, const char *pPropertyName) 
@@ -871,19 +898,34 @@ CCNode * CCNodeLoader::parsePropTypeCCBFile(CCNode * pNode, CCNode * pParent, CC
     std::string ccbFileWithoutPathExtension = CCBReader::deletePathExtension(ccbFileName.c_str());
     ccbFileName = ccbFileWithoutPathExtension + ".ccbi";
     
-    // Load sub file
-    std::string path = CCFileUtils::sharedFileUtils()->fullPathForFilename(ccbFileName.c_str());
-    unsigned long size = 0;
-    unsigned char * pBytes = CCFileUtils::sharedFileUtils()->getFileData(path.c_str(), "rb", &size);
-
     CCBReader * ccbReader = new CCBReader(pCCBReader);
     ccbReader->autorelease();
     ccbReader->getAnimationManager()->setRootContainerSize(pParent->getContentSize());
     
-    CCData *data = new CCData(pBytes, size);
-    CC_SAFE_DELETE_ARRAY(pBytes);
+    // Load sub file, or reuse its prototype
+    CCBPrototype * prototype = NULL;
+    if (pCCBReader->mPrototype != NULL || CCBReader::isPrototypeCacheEnabled())
+    {
+        prototype = pCCBReader->getPrototype(ccbFileName.c_str());
+    }
+
+    CCData *data = NULL;
+    if (prototype != NULL)
+    {
+        prototype->retain();
+        ccbReader->mPrototype = prototype;
+        data = prototype->getData();
+        data->retain();
+    }
+    else
+    {
+        std::string path = CCFileUtils::sharedFileUtils()->fullPathForFilename(ccbFileName.c_str());
+        unsigned long size = 0;
+        unsigned char * pBytes = CCFileUtils::sharedFileUtils()->getFileData(path.c_str(), "rb", &size);
+        data = new CCData(pBytes, size);
+        CC_SAFE_DELETE_ARRAY(pBytes);
+    }
 
-    data->retain();
     ccbReader->mData = data;
     ccbReader->mBytes = data->getBytes();
     ccbReader->mCurrentByte = 0;
@@ -900,8 +942,6 @@ CCNode * CCNodeLoader::parsePropTypeCCBFile(CCNode * pNode, CCNode * pParent, CC
 //     ccbReader->mOwnerCallbackNames = pCCBReader->mOwnerCallbackNames;
 //     ccbReader->mOwnerCallbackNodes = pCCBReader->mOwnerCallbackNodes;
 //     ccbReader->mOwnerCallbackNodes->retain();
-
-    data->release();
     
     CCNode * ccbFileNode = ccbReader->readFileWithCleanUp(false, pCCBReader->getAnimationManagers());
     
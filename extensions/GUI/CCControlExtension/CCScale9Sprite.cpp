@@ -26,22 +26,64 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "CCScale9Sprite.h"
+#include <vector>
 
 NS_CC_EXT_BEGIN
 
-enum positions
-{
-    pCentre = 0,
-    pTop,
-    pLeft,
-    pRight,
-    pBottom,
-    pTopRight,
-    pTopLeft,
-    pBottomRight,
-    pBottomLeft
+// The stream indices are GLushort, 16 vertices per nine-slice.
+#define SCALE9_BATCH_MAX_VERTICES 65536
+
+// Slices as (column, row) of their bottom left vertex, the centre first and the
+// corners last so that they are drawn over the other slices when the sprite is
+// smaller than its caps.
+static const int s_sliceOrder[9][2] =
+{
+    {1, 1},
+    {1, 2}, {1, 0}, {0, 1}, {2, 1},
+    {0, 2}, {2, 2}, {0, 0}, {2, 0}
 };
 
+// Meshes of the nine-slices drawn since the last flush, in eye coordinates. CCGridBase, CCRenderTexture
+// and CCClippingNode flush them before they change the projection or the render target.
+static std::vector<ccV3F_C4B_T2F> s_batchVertices;
+static std::vector<GLushort> s_batchIndices;
+static CCTexture2D* s_pBatchTexture = NULL;
+static CCGLProgram* s_pBatchShader = NULL;
+static ccBlendFunc s_tBatchBlendFunc = {CC_BLEND_SRC, CC_BLEND_DST};
+
+static void flushScale9Batch()
+{
+    if (s_batchIndices.empty())
+    {
+        CC_SAFE_RELEASE_NULL(s_pBatchTexture);
+        return;
+    }
+
+    kmGLMatrixMode(KM_GL_MODELVIEW);
+    kmGLPushMatrix();
+    kmGLLoadIdentity();
+    s_pBatchShader->use();
+    s_pBatchShader->setUniformsForBuiltins();
+    ccGLBlendFunc(s_tBatchBlendFunc.src, s_tBatchBlendFunc.dst);
+    ccGLBindTexture2D(s_pBatchTexture->getName());
+    ccGLEnableVertexAttribs(kCCVertexAttribFlag_PosColorTex);
+
+    const ccV3F_C4B_T2F* vertices = &s_batchVertices[0];
+    glVertexAttribPointer(kCCVertexAttrib_Position, 3, GL_FLOAT, GL_FALSE, sizeof(ccV3F_C4B_T2F), &vertices->vertices);
+    glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ccV3F_C4B_T2F), &vertices->colors);
+    glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, sizeof(ccV3F_C4B_T2F), &vertices->texCoords);
+    glDrawElements(GL_TRIANGLES, (GLsizei)s_batchIndices.size(), GL_UNSIGNED_SHORT, &s_batchIndices[0]);
+    CC_INCREMENT_GL_DRAWS(1);
+    kmGLPopMatrix();
+
+    // the vectors keep their capacity for the next frames
+    s_batchVertices.clear();
+    s_batchIndices.clear();
+
+    // don't keep the texture alive
+    CC_SAFE_RELEASE_NULL(s_pBatchTexture);
+}
+
 CCScale9Sprite::CCScale9Sprite()
 : m_insetLeft(0)
 , m_insetTop(0)
@@ -50,40 +92,24 @@ CCScale9Sprite::CCScale9Sprite()
 , m_bSpritesGenerated(false)
 , m_bSpriteFrameRotated(false)
 , m_positionsAreDirty(false)
-, _scale9Image(NULL)
-, _topLeft(NULL)
-, _top(NULL)
-, _topRight(NULL)
-, _left(NULL)
-, _centre(NULL)
-, _right(NULL)
-, _bottomLeft(NULL)
-, _bottom(NULL)
-, _bottomRight(NULL)
+, _texture(NULL)
 , _opacityModifyRGB(false)
 , _opacity(255)
 , _color(ccWHITE)
 {
-
+    _blendFunc.src = CC_BLEND_SRC;
+    _blendFunc.dst = CC_BLEND_DST;
+    memset(_vertices, 0, sizeof(_vertices));
 }
 
 CCScale9Sprite::~CCScale9Sprite()
 {
-    CC_SAFE_RELEASE(_topLeft);
-    CC_SAFE_RELEASE(_top);
-    CC_SAFE_RELEASE(_topRight);
-    CC_SAFE_RELEASE(_left);
-    CC_SAFE_RELEASE(_centre);
-    CC_SAFE_RELEASE(_right);
-    CC_SAFE_RELEASE(_bottomLeft);
-    CC_SAFE_RELEASE(_bottom);
-    CC_SAFE_RELEASE(_bottomRight);
-    CC_SAFE_RELEASE(_scale9Image);
+    CC_SAFE_RELEASE(_texture);
 }
 
 bool CCScale9Sprite::init()
 {
-    return this->initWithBatchNode(NULL, CCRectZero, CCRectZero);
+    return this->initWithTexture(NULL, CCRectZero, false, CCRectZero);
 }
 
 bool CCScale9Sprite::initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, CCRect capInsets)
@@ -93,9 +119,14 @@ bool CCScale9Sprite::initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect
 
 bool CCScale9Sprite::initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, bool rotated, CCRect capInsets)
 {
-    if(batchnode)
+    return this->initWithTexture(batchnode ? batchnode->getTexture() : NULL, rect, rotated, capInsets);
+}
+
+bool CCScale9Sprite::initWithTexture(CCTexture2D* texture, CCRect rect, bool rotated, CCRect capInsets)
+{
+    if(texture)
     {
-        this->updateWithBatchNode(batchnode, rect, rotated, capInsets);
+        this->updateWithTexture(texture, rect, rotated, capInsets);
         this->setAnchorPoint(ccp(0.5f, 0.5f));
     }
     this->m_positionsAreDirty = true;
@@ -103,48 +134,28 @@ bool CCScale9Sprite::initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect
     return true;
 }
 
-#define    TRANSLATE_X(x, y, xtranslate) \
-    x+=xtranslate;                       \
-
-#define    TRANSLATE_Y(x, y, ytranslate) \
-    y+=ytranslate;                       \
-
 bool CCScale9Sprite::updateWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, bool rotated, CCRect capInsets)
 {
-    m_bSpriteFrameRotated = rotated;
-    GLubyte opacity = getOpacity();
-    ccColor3B color = getColor();
-
-    // Release old sprites
-    this->removeAllChildrenWithCleanup(true);
-
-    CC_SAFE_RELEASE(this->_centre);
-    CC_SAFE_RELEASE(this->_top);
-    CC_SAFE_RELEASE(this->_topLeft);
-    CC_SAFE_RELEASE(this->_topRight);
-    CC_SAFE_RELEASE(this->_left);
-    CC_SAFE_RELEASE(this->_right);
-    CC_SAFE_RELEASE(this->_bottomLeft);
-    CC_SAFE_RELEASE(this->_bottom);
-    CC_SAFE_RELEASE(this->_bottomRight);
+    CCAssert(batchnode != NULL, "CCSpriteBatchNode must be not nil");
+    return this->updateWithTexture(batchnode->getTexture(), rect, rotated, capInsets);
+}
 
-    
-    if(this->_scale9Image != batchnode)
-    {
-        CC_SAFE_RELEASE(this->_scale9Image);
-        _scale9Image = batchnode;
-        CC_SAFE_RETAIN(_scale9Image);
-    }
+bool CCScale9Sprite::updateWithTexture(CCTexture2D* texture, CCRect rect, bool rotated, CCRect capInsets)
+{
+    CCAssert(texture != NULL, "CCTexture must be not nil");
 
-    _scale9Image->removeAllChildrenWithCleanup(true);
+    CC_SAFE_RETAIN(texture);
+    CC_SAFE_RELEASE(_texture);
+    _texture = texture;
 
+    m_bSpriteFrameRotated = rotated;
     m_capInsets = capInsets;
     
     // If there is no given rect
     if ( rect.equals(CCRectZero) )
     {
         // Get the texture size as original
-        CCSize textureSize = _scale9Image->getTextureAtlas()->getTexture()->getContentSize();
+        CCSize textureSize = _texture->getContentSize();
     
         rect = CCRectMake(0, 0, textureSize.width, textureSize.height);
     }
@@ -155,242 +166,96 @@ bool CCScale9Sprite::updateWithBatchNode(CCSpriteBatchNode* batchnode, CCRect re
     m_preferredSize = m_originalSize;
     m_capInsetsInternal = capInsets;
     
-    float w = rect.size.width;
-    float h = rect.size.height;
-
     // If there is no specified center region
     if ( m_capInsetsInternal.equals(CCRectZero) )
     {
         // CCLog("... cap insets not specified : using default cap insets ...");
+        float w = rect.size.width;
+        float h = rect.size.height;
         m_capInsetsInternal = CCRectMake(w/3, h/3, w/3, h/3);
     }
 
+    // same shader, blending and opacity as the sprites of a batch node
+    this->setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureColor));
+    _opacityModifyRGB = _texture->hasPremultipliedAlpha();
+    if (_opacityModifyRGB)
+    {
+        _blendFunc.src = CC_BLEND_SRC;
+        _blendFunc.dst = CC_BLEND_DST;
+    }
+    else
+    {
+        _blendFunc.src = GL_SRC_ALPHA;
+        _blendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
+    }
+
+    this->updateTexCoords();
+    this->updateColor();
+    m_bSpritesGenerated = true;
+
+    this->setContentSize(rect.size);
+
+    return true;
+}
+
+void CCScale9Sprite::updateTexCoords()
+{
+    float w = m_spriteRect.size.width;
+    float h = m_spriteRect.size.height;
     float left_w = m_capInsetsInternal.origin.x;
     float center_w = m_capInsetsInternal.size.width;
-    float right_w = rect.size.width - (left_w + center_w);
-
     float top_h = m_capInsetsInternal.origin.y;
     float center_h = m_capInsetsInternal.size.height;
-    float bottom_h = rect.size.height - (top_h + center_h);
-
-    // calculate rects
-
-    // ... top row
-    float x = 0.0;
-    float y = 0.0;
-
-    // top left
-    CCRect lefttopbounds = CCRectMake(x, y,
-                                      left_w, top_h);
-
-    // top center
-    TRANSLATE_X(x, y, left_w);
-    CCRect centertopbounds = CCRectMake(x, y,
-                                        center_w, top_h);
-        
-    // top right
-    TRANSLATE_X(x, y, center_w);
-    CCRect righttopbounds = CCRectMake(x, y,
-                                       right_w, top_h);
-
-    // ... center row
-    x = 0.0;
-    y = 0.0;
-    TRANSLATE_Y(x, y, top_h);
-
-    // center left
-    CCRect leftcenterbounds = CCRectMake(x, y,
-                                         left_w, center_h);
-
-    // center center
-    TRANSLATE_X(x, y, left_w);
-    CCRect centerbounds = CCRectMake(x, y,
-                                     center_w, center_h);
-
-    // center right
-    TRANSLATE_X(x, y, center_w);
-    CCRect rightcenterbounds = CCRectMake(x, y,
-                                          right_w, center_h);
-
-    // ... bottom row
-    x = 0.0;
-    y = 0.0;
-    TRANSLATE_Y(x, y, top_h);
-    TRANSLATE_Y(x, y, center_h);
-
-    // bottom left
-    CCRect leftbottombounds = CCRectMake(x, y,
-                                         left_w, bottom_h);
-
-    // bottom center
-    TRANSLATE_X(x, y, left_w);
-    CCRect centerbottombounds = CCRectMake(x, y,
-                                           center_w, bottom_h);
-
-    // bottom right
-    TRANSLATE_X(x, y, center_w);
-    CCRect rightbottombounds = CCRectMake(x, y,
-                                          right_w, bottom_h);
-
-    if (!rotated) {
-        // CCLog("!rotated");
-
-        CCAffineTransform t = CCAffineTransformMakeIdentity();
-        t = CCAffineTransformTranslate(t, rect.origin.x, rect.origin.y);
-
-        centerbounds = CCRectApplyAffineTransform(centerbounds, t);
-        rightbottombounds = CCRectApplyAffineTransform(rightbottombounds, t);
-        leftbottombounds = CCRectApplyAffineTransform(leftbottombounds, t);
-        righttopbounds = CCRectApplyAffineTransform(righttopbounds, t);
-        lefttopbounds = CCRectApplyAffineTransform(lefttopbounds, t);
-        rightcenterbounds = CCRectApplyAffineTransform(rightcenterbounds, t);
-        leftcenterbounds = CCRectApplyAffineTransform(leftcenterbounds, t);
-        centerbottombounds = CCRectApplyAffineTransform(centerbottombounds, t);
-        centertopbounds = CCRectApplyAffineTransform(centertopbounds, t);
-
-        // Centre
-        _centre = new CCSprite();
-        _centre->initWithTexture(_scale9Image->getTexture(), centerbounds);
-        _scale9Image->addChild(_centre, 0, pCentre);
-        
-        // Top
-        _top = new CCSprite();
-        _top->initWithTexture(_scale9Image->getTexture(), centertopbounds);
-        _scale9Image->addChild(_top, 1, pTop);
-        
-        // Bottom
-        _bottom = new CCSprite();
-        _bottom->initWithTexture(_scale9Image->getTexture(), centerbottombounds);
-        _scale9Image->addChild(_bottom, 1, pBottom);
-        
-        // Left
-        _left = new CCSprite();
-        _left->initWithTexture(_scale9Image->getTexture(), leftcenterbounds);
-        _scale9Image->addChild(_left, 1, pLeft);
-        
-        // Right
-        _right = new CCSprite();
-        _right->initWithTexture(_scale9Image->getTexture(), rightcenterbounds);
-        _scale9Image->addChild(_right, 1, pRight);
-        
-        // Top left
-        _topLeft = new CCSprite();
-        _topLeft->initWithTexture(_scale9Image->getTexture(), lefttopbounds);
-        _scale9Image->addChild(_topLeft, 2, pTopLeft);
-        
-        // Top right
-        _topRight = new CCSprite();
-        _topRight->initWithTexture(_scale9Image->getTexture(), righttopbounds);
-        _scale9Image->addChild(_topRight, 2, pTopRight);
-        
-        // Bottom left
-        _bottomLeft = new CCSprite();
-        _bottomLeft->initWithTexture(_scale9Image->getTexture(), leftbottombounds);
-        _scale9Image->addChild(_bottomLeft, 2, pBottomLeft);
-        
-        // Bottom right
-        _bottomRight = new CCSprite();
-        _bottomRight->initWithTexture(_scale9Image->getTexture(), rightbottombounds);
-        _scale9Image->addChild(_bottomRight, 2, pBottomRight);
-    } else {
-        // set up transformation of coordinates
-        // to handle the case where the sprite is stored rotated
-        // in the spritesheet
-        // CCLog("rotated");
-
-        CCAffineTransform t = CCAffineTransformMakeIdentity();
-
-        CCRect rotatedcenterbounds = centerbounds;
-        CCRect rotatedrightbottombounds = rightbottombounds;
-        CCRect rotatedleftbottombounds = leftbottombounds;
-        CCRect rotatedrighttopbounds = righttopbounds;
-        CCRect rotatedlefttopbounds = lefttopbounds;
-        CCRect rotatedrightcenterbounds = rightcenterbounds;
-        CCRect rotatedleftcenterbounds = leftcenterbounds;
-        CCRect rotatedcenterbottombounds = centerbottombounds;
-        CCRect rotatedcentertopbounds = centertopbounds;
-        
-        t = CCAffineTransformTranslate(t, rect.size.height+rect.origin.x, rect.origin.y);
-        t = CCAffineTransformRotate(t, 1.57079633f);
-        
-        centerbounds = CCRectApplyAffineTransform(centerbounds, t);
-        rightbottombounds = CCRectApplyAffineTransform(rightbottombounds, t);
-        leftbottombounds = CCRectApplyAffineTransform(leftbottombounds, t);
-        righttopbounds = CCRectApplyAffineTransform(righttopbounds, t);
-        lefttopbounds = CCRectApplyAffineTransform(lefttopbounds, t);
-        rightcenterbounds = CCRectApplyAffineTransform(rightcenterbounds, t);
-        leftcenterbounds = CCRectApplyAffineTransform(leftcenterbounds, t);
-        centerbottombounds = CCRectApplyAffineTransform(centerbottombounds, t);
-        centertopbounds = CCRectApplyAffineTransform(centertopbounds, t);
-
-        rotatedcenterbounds.origin = centerbounds.origin;
-        rotatedrightbottombounds.origin = rightbottombounds.origin;
-        rotatedleftbottombounds.origin = leftbottombounds.origin;
-        rotatedrighttopbounds.origin = righttopbounds.origin;
-        rotatedlefttopbounds.origin = lefttopbounds.origin;
-        rotatedrightcenterbounds.origin = rightcenterbounds.origin;
-        rotatedleftcenterbounds.origin = leftcenterbounds.origin;
-        rotatedcenterbottombounds.origin = centerbottombounds.origin;
-        rotatedcentertopbounds.origin = centertopbounds.origin;
-
-        // Centre
-        _centre = new CCSprite();
-        _centre->initWithTexture(_scale9Image->getTexture(), rotatedcenterbounds, true);
-        _scale9Image->addChild(_centre, 0, pCentre);
-        
-        // Top
-        _top = new CCSprite();
-        _top->initWithTexture(_scale9Image->getTexture(), rotatedcentertopbounds, true);
-        _scale9Image->addChild(_top, 1, pTop);
-        
-        // Bottom
-        _bottom = new CCSprite();
-        _bottom->initWithTexture(_scale9Image->getTexture(), rotatedcenterbottombounds, true);
-        _scale9Image->addChild(_bottom, 1, pBottom);
-        
-        // Left
-        _left = new CCSprite();
-        _left->initWithTexture(_scale9Image->getTexture(), rotatedleftcenterbounds, true);
-        _scale9Image->addChild(_left, 1, pLeft);
-        
-        // Right
-        _right = new CCSprite();
-        _right->initWithTexture(_scale9Image->getTexture(), rotatedrightcenterbounds, true);
-        _scale9Image->addChild(_right, 1, pRight);
-        
-        // Top left
-        _topLeft = new CCSprite();
-        _topLeft->initWithTexture(_scale9Image->getTexture(), rotatedlefttopbounds, true);
-        _scale9Image->addChild(_topLeft, 2, pTopLeft);
-        
-        // Top right
-        _topRight = new CCSprite();
-        _topRight->initWithTexture(_scale9Image->getTexture(), rotatedrighttopbounds, true);
-        _scale9Image->addChild(_topRight, 2, pTopRight);
-        
-        // Bottom left
-        _bottomLeft = new CCSprite();
-        _bottomLeft->initWithTexture(_scale9Image->getTexture(), rotatedleftbottombounds, true);
-        _scale9Image->addChild(_bottomLeft, 2, pBottomLeft);
-        
-        // Bottom right
-        _bottomRight = new CCSprite();
-        _bottomRight->initWithTexture(_scale9Image->getTexture(), rotatedrightbottombounds, true);
-        _scale9Image->addChild(_bottomRight, 2, pBottomRight);
-    }
 
-    this->setContentSize(rect.size);
-    this->addChild(_scale9Image);
-    
-    if (m_bSpritesGenerated)
+    // columns from the left and rows from the top of the image, the first row is the bottom one
+    float columns[4] = { 0, left_w, left_w + center_w, w };
+    float rows[4] = { h, top_h + center_h, top_h, 0 };
+
+    CCRect rect = CC_RECT_POINTS_TO_PIXELS(m_spriteRect);
+    float scale = CC_CONTENT_SCALE_FACTOR();
+    float atlasWidth = (float)_texture->getPixelsWide();
+    float atlasHeight = (float)_texture->getPixelsHigh();
+
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
         {
-            // Restore color and opacity
-            this->setOpacity(opacity);
-            this->setColor(color);
+            float x, y;
+            if (m_bSpriteFrameRotated)
+            {
+                // the image is stored rotated by 90 degrees clockwise
+                x = h - rows[row];
+                y = columns[column];
+            }
+            else
+            {
+                x = columns[column];
+                y = rows[row];
+            }
+
+            ccTex2F& texCoords = _vertices[row * 4 + column].texCoords;
+            texCoords.u = (rect.origin.x + x * scale) / atlasWidth;
+            texCoords.v = (rect.origin.y + y * scale) / atlasHeight;
         }
-    m_bSpritesGenerated = true;
+    }
+}
 
-    return true;
+void CCScale9Sprite::updateColor()
+{
+    ccColor4B color4 = { _displayedColor.r, _displayedColor.g, _displayedColor.b, _displayedOpacity };
+
+    // special opacity for premultiplied textures
+    if (_opacityModifyRGB)
+    {
+        color4.r *= _displayedOpacity/255.0f;
+        color4.g *= _displayedOpacity/255.0f;
+        color4.b *= _displayedOpacity/255.0f;
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        _vertices[i].colors = color4;
+    }
 }
 
 void CCScale9Sprite::setContentSize(const CCSize &size)
@@ -401,69 +266,89 @@ void CCScale9Sprite::setContentSize(const CCSize &size)
 
 void CCScale9Sprite::updatePositions()
 {
-    // Check that instances are non-NULL
-    if(!((_topLeft) &&
-         (_topRight) &&
-         (_bottomRight) &&
-         (_bottomLeft) &&
-         (_centre))) {
-        // if any of the above sprites are NULL, return
+    if (!m_bSpritesGenerated)
+    {
         return;
     }
 
     CCSize size = this->m_obContentSize;
 
-    float sizableWidth = size.width - _topLeft->getContentSize().width - _topRight->getContentSize().width;
-    float sizableHeight = size.height - _topLeft->getContentSize().height - _bottomRight->getContentSize().height;
-    
-    float horizontalScale = sizableWidth/_centre->getContentSize().width;
-    float verticalScale = sizableHeight/_centre->getContentSize().height;
-
-    _centre->setScaleX(horizontalScale);
-    _centre->setScaleY(verticalScale);
-
-    float rescaledWidth = _centre->getContentSize().width * horizontalScale;
-    float rescaledHeight = _centre->getContentSize().height * verticalScale;
-
-    float leftWidth = _bottomLeft->getContentSize().width;
-    float bottomHeight = _bottomLeft->getContentSize().height;
-
-    _bottomLeft->setAnchorPoint(ccp(0,0));
-    _bottomRight->setAnchorPoint(ccp(0,0));
-    _topLeft->setAnchorPoint(ccp(0,0));
-    _topRight->setAnchorPoint(ccp(0,0));
-    _left->setAnchorPoint(ccp(0,0));
-    _right->setAnchorPoint(ccp(0,0));
-    _top->setAnchorPoint(ccp(0,0));
-    _bottom->setAnchorPoint(ccp(0,0));
-    _centre->setAnchorPoint(ccp(0,0));
-
-    // Position corners
-    _bottomLeft->setPosition(ccp(0,0));
-    _bottomRight->setPosition(ccp(leftWidth+rescaledWidth,0));
-    _topLeft->setPosition(ccp(0, bottomHeight+rescaledHeight));
-    _topRight->setPosition(ccp(leftWidth+rescaledWidth, bottomHeight+rescaledHeight));
-
-    // Scale and position borders
-    _left->setPosition(ccp(0, bottomHeight));
-    _left->setScaleY(verticalScale);
-    _right->setPosition(ccp(leftWidth+rescaledWidth,bottomHeight));
-    _right->setScaleY(verticalScale);
-    _bottom->setPosition(ccp(leftWidth,0));
-    _bottom->setScaleX(horizontalScale);
-    _top->setPosition(ccp(leftWidth,bottomHeight+rescaledHeight));
-    _top->setScaleX(horizontalScale);
-
-    // Position centre
-    _centre->setPosition(ccp(leftWidth, bottomHeight));
+    float left_w = m_capInsetsInternal.origin.x;
+    float right_w = m_spriteRect.size.width - (left_w + m_capInsetsInternal.size.width);
+    float top_h = m_capInsetsInternal.origin.y;
+    float bottom_h = m_spriteRect.size.height - (top_h + m_capInsetsInternal.size.height);
+
+    // the caps keep their size, the centre takes what is left
+    float columns[4] = { 0, left_w, size.width - right_w, size.width };
+    float rows[4] = { 0, bottom_h, size.height - top_h, size.height };
+
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            ccVertex3F& vertex = _vertices[row * 4 + column].vertices;
+            vertex.x = columns[column];
+            vertex.y = rows[row];
+        }
+    }
+}
+
+void CCScale9Sprite::draw()
+{
+    if (!m_bSpritesGenerated)
+    {
+        return;
+    }
+
+    CCGLProgram* shader = getShaderProgram();
+    if (_texture != s_pBatchTexture || shader != s_pBatchShader
+        || _blendFunc.src != s_tBatchBlendFunc.src || _blendFunc.dst != s_tBatchBlendFunc.dst
+        || s_batchVertices.size() + 16 > SCALE9_BATCH_MAX_VERTICES)
+    {
+        ccGLFlushDeferredDraw();
+        _texture->retain();
+        CC_SAFE_RELEASE(s_pBatchTexture);
+        s_pBatchTexture = _texture;
+        s_pBatchShader = shader;
+        s_tBatchBlendFunc = _blendFunc;
+    }
+
+    kmMat4 modelview;
+    kmGLGetMatrix(KM_GL_MODELVIEW, &modelview);
+    const float* m = modelview.mat;
+
+    GLushort base = (GLushort)s_batchVertices.size();
+    for (int i = 0; i < 16; i++)
+    {
+        ccV3F_C4B_T2F vertex = _vertices[i];
+        // transform() already put the vertexZ in the modelview, the vertices themselves are at z 0
+        float x = vertex.vertices.x, y = vertex.vertices.y, z = vertex.vertices.z;
+        vertex.vertices.x = m[0] * x + m[4] * y + m[8] * z + m[12];
+        vertex.vertices.y = m[1] * x + m[5] * y + m[9] * z + m[13];
+        vertex.vertices.z = m[2] * x + m[6] * y + m[10] * z + m[14];
+        s_batchVertices.push_back(vertex);
+    }
+
+    for (int i = 0; i < 9; i++)
+    {
+        GLushort v = base + s_sliceOrder[i][1] * 4 + s_sliceOrder[i][0];
+        s_batchIndices.push_back(v);
+        s_batchIndices.push_back(v + 1);
+        s_batchIndices.push_back(v + 4);
+        s_batchIndices.push_back(v + 1);
+        s_batchIndices.push_back(v + 5);
+        s_batchIndices.push_back(v + 4);
+    }
+
+    ccGLSetDeferredDraw(flushScale9Batch);
 }
 
 bool CCScale9Sprite::initWithFile(const char* file, CCRect rect,  CCRect capInsets)
 {
     CCAssert(file != NULL, "Invalid file for sprite");
     
-    CCSpriteBatchNode *batchnode = CCSpriteBatchNode::create(file, 9);
-    bool pReturn = this->initWithBatchNode(batchnode, rect, capInsets);
+    CCTexture2D *texture = CCTextureCache::sharedTextureCache()->addImage(file);
+    bool pReturn = this->initWithTexture(texture, rect, false, capInsets);
     return pReturn;
 }
 
@@ -541,10 +426,7 @@ bool CCScale9Sprite::initWithSpriteFrame(CCSpriteFrame* spriteFrame, CCRect capI
     CCTexture2D* texture = spriteFrame->getTexture();
     CCAssert(texture != NULL, "CCTexture must be not nil");
 
-    CCSpriteBatchNode *batchnode = CCSpriteBatchNode::createWithTexture(texture, 9);
-    CCAssert(batchnode != NULL, "CCSpriteBatchNode must be not nil");
-
-    bool pReturn = this->initWithBatchNode(batchnode, spriteFrame->getRect(), spriteFrame->isRotated(), capInsets);
+    bool pReturn = this->initWithTexture(texture, spriteFrame->getRect(), spriteFrame->isRotated(), capInsets);
     return pReturn;
 }
 
@@ -629,7 +511,7 @@ CCScale9Sprite* CCScale9Sprite::createWithSpriteFrameName(const char* spriteFram
 CCScale9Sprite* CCScale9Sprite::resizableSpriteWithCapInsets(CCRect capInsets)
 {
     CCScale9Sprite* pReturn = new CCScale9Sprite();
-    if ( pReturn && pReturn->initWithBatchNode(_scale9Image, m_spriteRect, capInsets) )
+    if ( pReturn && pReturn->initWithTexture(_texture, m_spriteRect, m_bSpriteFrameRotated, capInsets) )
     {
         pReturn->autorelease();
         return pReturn;
@@ -668,12 +550,12 @@ CCSize CCScale9Sprite::getPreferredSize()
 
 void CCScale9Sprite::setCapInsets(CCRect capInsets)
 {
-    if (!_scale9Image)
+    if (!_texture)
     {
         return;
     }
     CCSize contentSize = this->m_obContentSize;
-    this->updateWithBatchNode(this->_scale9Image, this->m_spriteRect, m_bSpriteFrameRotated, capInsets);
+    this->updateWithTexture(this->_texture, this->m_spriteRect, m_bSpriteFrameRotated, capInsets);
     this->setContentSize(contentSize);
 }
 
@@ -711,21 +593,8 @@ void CCScale9Sprite::updateCapInset()
 
 void CCScale9Sprite::setOpacityModifyRGB(bool var)
 {
-    if (!_scale9Image)
-    {
-        return;
-    }
     _opacityModifyRGB = var;
-    CCObject* child;
-    CCArray* children = _scale9Image->getChildren();
-    CCARRAY_FOREACH(children, child)
-    {
-        CCRGBAProtocol* pNode = dynamic_cast<CCRGBAProtocol*>(child);
-        if (pNode)
-        {
-            pNode->setOpacityModifyRGB(_opacityModifyRGB);
-        }
-    }
+    this->updateColor();
 }
 
 
@@ -737,19 +606,23 @@ bool CCScale9Sprite::isOpacityModifyRGB()
 void CCScale9Sprite::updateDisplayedOpacity(GLubyte parentOpacity)
 {
     CCNodeRGBA::updateDisplayedOpacity(parentOpacity);
-    setOpacity(parentOpacity);
+    this->updateColor();
 }
 
 void CCScale9Sprite::updateDisplayedColor(const cocos2d::ccColor3B &color)
 {
     CCNodeRGBA::updateDisplayedColor(color);
-    setColor(color);
+    this->updateColor();
+}
+
+CCTexture2D* CCScale9Sprite::getTexture()
+{
+    return _texture;
 }
 
 void CCScale9Sprite::setSpriteFrame(CCSpriteFrame * spriteFrame)
 {
-    CCSpriteBatchNode * batchnode = CCSpriteBatchNode::createWithTexture(spriteFrame->getTexture(), 9);
-    this->updateWithBatchNode(batchnode, spriteFrame->getRect(), spriteFrame->isRotated(), CCRectZero);
+    this->updateWithTexture(spriteFrame->getTexture(), spriteFrame->getRect(), spriteFrame->isRotated(), CCRectZero);
 
     // Reset insets
     this->m_insetLeft = 0;
@@ -814,22 +687,9 @@ void CCScale9Sprite::visit()
 
 void CCScale9Sprite::setColor(const ccColor3B& color)
 {
-    if (!_scale9Image)
-    {
-        return;
-    }
     _color = color;
-
-    CCObject* child;
-    CCArray* children = _scale9Image->getChildren();
-    CCARRAY_FOREACH(children, child)
-    {
-        CCRGBAProtocol* pNode = dynamic_cast<CCRGBAProtocol*>(child);
-        if (pNode)
-        {
-            pNode->setColor(color);
-        }
-    }
+    CCNodeRGBA::setColor(color);
+    this->updateColor();
 }
 
 const ccColor3B& CCScale9Sprite::getColor()
@@ -839,22 +699,9 @@ const ccColor3B& CCScale9Sprite::getColor()
 
 void CCScale9Sprite::setOpacity(GLubyte opacity)
 {
-    if (!_scale9Image)
-    {
-        return;
-    }
     _opacity = opacity;
-
-    CCObject* child;
-    CCArray* children = _scale9Image->getChildren();
-    CCARRAY_FOREACH(children, child)
-    {
-        CCRGBAProtocol* pNode = dynamic_cast<CCRGBAProtocol*>(child);
-        if (pNode)
-        {
-            pNode->setOpacity(opacity);
-        }
-    }
+    CCNodeRGBA::setOpacity(opacity);
+    this->updateColor();
 }
 
 GLubyte CCScale9Sprite::getOpacity()
@@ -48,6 +48,9 @@ NS_CC_EXT_BEGIN
  * you can ensure that the sprite does not become distorted when
  * scaled.
  *
+ * The nine slices are a single 4x4 vertices mesh cut from the sprite frame,
+ * there is no batch node nor child sprites.
+ *
  * @see http://yannickloriot.com/library/ios/cccontrolextension/Classes/CCScale9Sprite.html
  */
 class CC_EX_DLL CCScale9Sprite : public CCNodeRGBA
@@ -85,16 +88,11 @@ protected:
     CCRect m_capInsetsInternal;
     bool m_positionsAreDirty;
     
-    CCSpriteBatchNode* _scale9Image;
-    CCSprite* _topLeft;
-    CCSprite* _top;
-    CCSprite* _topRight;
-    CCSprite* _left;
-    CCSprite* _centre;
-    CCSprite* _right;
-    CCSprite* _bottomLeft;
-    CCSprite* _bottom;
-    CCSprite* _bottomRight;
+    /** texture the nine slices are cut from */
+    CCTexture2D* _texture;
+    ccBlendFunc _blendFunc;
+    /** 4x4 grid of the mesh in node space, row by row from the bottom left corner */
+    ccV3F_C4B_T2F _vertices[16];
 
     bool _opacityModifyRGB;
     GLubyte _opacity;
@@ -102,6 +100,8 @@ protected:
     
     void updateCapInset();
     void updatePositions();
+    void updateTexCoords();
+    void updateColor();
 
 public:
     
@@ -110,9 +110,27 @@ public:
      *  @js NA
      */
     virtual void visit();
+    /**
+     * Appends the 16 vertices / 18 triangles mesh to the nine-slice stream,
+     * consecutive nine-slices with the same texture, shader and blending are
+     * drawn with a single draw call.
+     */
+    virtual void draw();
     
     virtual bool init();
 
+    /**
+     * Initializes a 9-slice sprite with a part of a texture and the specified
+     * cap insets.
+     *
+     * @param texture The texture the slices are cut from.
+     * @param rect The part of the texture that is the whole image, in points.
+     * @param rotated Whether the image is stored rotated in the texture, as in sprite sheets.
+     * @param capInsets The values to use for the cap insets.
+     */
+    virtual bool initWithTexture(CCTexture2D* texture, CCRect rect, bool rotated, CCRect capInsets);
+
+    /** Only the texture of the batch node is used, the sprite does not keep it. */
     virtual bool initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, bool rotated, CCRect capInsets);
     virtual bool initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, CCRect capInsets);
     /**
@@ -315,8 +333,13 @@ public:
     virtual void setColor(const ccColor3B& color);
 	virtual const ccColor3B& getColor();
 
+    /** Rebuilds the mesh from a part of a texture and the specified cap insets. */
+    virtual bool updateWithTexture(CCTexture2D* texture, CCRect rect, bool rotated, CCRect capInsets);
     virtual bool updateWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, bool rotated, CCRect capInsets);
 
+    /** The texture the nine slices are cut from. */
+    virtual CCTexture2D* getTexture();
+
     virtual void setSpriteFrame(CCSpriteFrame * spriteFrame);
     
     virtual void updateDisplayedOpacity(GLubyte parentOpacity);
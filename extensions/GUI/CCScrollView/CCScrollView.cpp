@@ -497,6 +497,7 @@ void CCScrollView::beforeDraw()
 {
     if (m_bClippingToBounds)
     {
+        ccGLFlushDeferredDraw();
 		m_bScissorRestored = false;
         CCRect frame = getViewRect();
         if (CCEGLView::sharedOpenGLView()->isScissorEnabled()) {
@@ -512,7 +513,7 @@ void CCScrollView::beforeDraw()
             }
         }
         else {
-            glEnable(GL_SCISSOR_TEST);
+            ccGLEnableScissorTest(true);
             CCEGLView::sharedOpenGLView()->setScissorInPoints(frame.origin.x, frame.origin.y, frame.size.width, frame.size.height);
         }
     }
@@ -526,11 +527,12 @@ void CCScrollView::afterDraw()
 {
     if (m_bClippingToBounds)
     {
+        ccGLFlushDeferredDraw();
         if (m_bScissorRestored) {//restore the parent's scissor rect
             CCEGLView::sharedOpenGLView()->setScissorInPoints(m_tParentScissorRect.origin.x, m_tParentScissorRect.origin.y, m_tParentScissorRect.size.width, m_tParentScissorRect.size.height);
         }
         else {
-            glDisable(GL_SCISSOR_TEST);
+            ccGLEnableScissorTest(false);
         }
     }
 }
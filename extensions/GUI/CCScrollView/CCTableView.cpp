@@ -56,7 +56,7 @@ bool CCTableView::initWithViewSize(CCSize size, CCNode* container/* = NULL*/)
     {
         m_pCellsUsed      = new CCArrayForObjectSorting();
         m_pCellsFreed     = new CCArrayForObjectSorting();
-        m_pIndices        = new std::set<unsigned int>();
+        m_pCellsFreedByIdentifier = new CCDictionary();
         m_eVordering      = kCCTableViewFillBottomUp;
         this->setDirection(kCCScrollViewDirectionVertical);
 
@@ -68,9 +68,13 @@ bool CCTableView::initWithViewSize(CCSize size, CCNode* container/* = NULL*/)
 
 CCTableView::CCTableView()
 : m_pTouchedCell(NULL)
-, m_pIndices(NULL)
 , m_pCellsUsed(NULL)
 , m_pCellsFreed(NULL)
+, m_pCellsFreedByIdentifier(NULL)
+, m_uCellCreationBudget(0)
+, m_uCellsCreated(0)
+, m_uCellsCreatedFrame(0)
+, m_bCellsPending(false)
 , m_pDataSource(NULL)
 , m_pTableViewDelegate(NULL)
 , m_eOldDirection(kCCScrollViewDirectionNone)
@@ -80,9 +84,9 @@ CCTableView::CCTableView()
 
 CCTableView::~CCTableView()
 {
-    CC_SAFE_DELETE(m_pIndices);
     CC_SAFE_RELEASE(m_pCellsUsed);
     CC_SAFE_RELEASE(m_pCellsFreed);
+    CC_SAFE_RELEASE(m_pCellsFreedByIdentifier);
     unregisterAllScriptHandler();
 }
 
@@ -113,7 +117,7 @@ void CCTableView::reloadData()
             m_pTableViewDelegate->tableCellWillRecycle(this, cell);
         }
 
-        m_pCellsFreed->addObject(cell);
+        this->_enqueueCell(cell);
         cell->reset();
         if (cell->getParent() == this->getContainer())
         {
@@ -121,28 +125,25 @@ void CCTableView::reloadData()
         }
     }
 
-    m_pIndices->clear();
-    m_pCellsUsed->release();
-    m_pCellsUsed = new CCArrayForObjectSorting();
+    m_mapCellsByIndex.clear();
+    m_pCellsUsed->removeAllObjects();
 
     this->_updateCellPositions();
     this->_updateContentSize();
     if (m_pDataSource->numberOfCellsInTableView(this) > 0)
     {
+        // the budget spreads the cells of a scroll, a reload fills the whole window at once
+        unsigned int budget = m_uCellCreationBudget;
+        m_uCellCreationBudget = 0;
         this->scrollViewDidScroll(this);
+        m_uCellCreationBudget = budget;
     }
 }
 
 CCTableViewCell *CCTableView::cellAtIndex(unsigned int idx)
 {
-    CCTableViewCell *found = NULL;
-
-    if (m_pIndices->find(idx) != m_pIndices->end())
-    {
-        found = (CCTableViewCell *)m_pCellsUsed->objectWithObjectID(idx);
-    }
-
-    return found;
+    std::unordered_map<unsigned int, CCTableViewCell*>::const_iterator it = m_mapCellsByIndex.find(idx);
+    return it != m_mapCellsByIndex.end() ? it->second : NULL;
 }
 
 void CCTableView::updateCellAtIndex(unsigned int idx)
@@ -180,29 +181,29 @@ void CCTableView::insertCellAtIndex(unsigned  int idx)
         return;
     }
 
-    CCTableViewCell* cell = NULL;
-    int newIdx = 0;
+    // the cells after the new one move down by one index
+    this->_insertCellPosition(idx);
+    this->_updateContentSize();
 
-    cell = (CCTableViewCell*)m_pCellsUsed->objectWithObjectID(idx);
-    if (cell)
+    unsigned int newIdx = this->_usedCellLowerBound(idx);
+    for (unsigned int i = m_pCellsUsed->count(); i > newIdx; i--)
     {
-        newIdx = m_pCellsUsed->indexOfSortedObject(cell);
-        for (unsigned int i=newIdx; i<m_pCellsUsed->count(); i++)
-        {
-            cell = (CCTableViewCell*)m_pCellsUsed->objectAtIndex(i);
-            this->_setIndexForCell(cell->getIdx()+1, cell);
-        }
+        CCTableViewCell* cell = (CCTableViewCell*)m_pCellsUsed->objectAtIndex(i - 1);
+        m_mapCellsByIndex.erase(cell->getIdx());
+        this->_setIndexForCell(cell->getIdx() + 1, cell);
+        m_mapCellsByIndex[cell->getIdx()] = cell;
+    }
+    // the content size changed, which moves every cell filled top down
+    for (unsigned int i = 0; i < newIdx; i++)
+    {
+        CCTableViewCell* cell = (CCTableViewCell*)m_pCellsUsed->objectAtIndex(i);
+        this->_setIndexForCell(cell->getIdx(), cell);
     }
-
- //   [m_pIndices shiftIndexesStartingAtIndex:idx by:1];
 
     //insert a new cell
-    cell = m_pDataSource->tableCellAtIndex(this, idx);
+    CCTableViewCell* cell = m_pDataSource->tableCellAtIndex(this, idx);
     this->_setIndexForCell(idx, cell);
     this->_addCellIfNecessary(cell);
-
-    this->_updateCellPositions();
-    this->_updateContentSize();
 }
 
 void CCTableView::removeCellAtIndex(unsigned int idx)
@@ -218,53 +219,109 @@ void CCTableView::removeCellAtIndex(unsigned int idx)
         return;
     }
 
-    unsigned int newIdx = 0;
-
     CCTableViewCell* cell = this->cellAtIndex(idx);
     if (!cell)
     {
         return;
     }
 
-    newIdx = m_pCellsUsed->indexOfSortedObject(cell);
-
     //remove first
     this->_moveCellOutOfSight(cell);
 
-    m_pIndices->erase(idx);
-    this->_updateCellPositions();
-//    [m_pIndices shiftIndexesStartingAtIndex:idx+1 by:-1];
-    for (unsigned int i=m_pCellsUsed->count()-1; i > newIdx; i--)
+    this->_removeCellPosition(idx);
+    this->_updateContentSize();
+
+    // the cells after the removed one move up by one index
+    unsigned int newIdx = this->_usedCellLowerBound(idx);
+    for (unsigned int i = 0; i < m_pCellsUsed->count(); i++)
     {
         cell = (CCTableViewCell*)m_pCellsUsed->objectAtIndex(i);
-        this->_setIndexForCell(cell->getIdx()-1, cell);
+        if (i >= newIdx)
+        {
+            m_mapCellsByIndex.erase(cell->getIdx());
+            this->_setIndexForCell(cell->getIdx() - 1, cell);
+            m_mapCellsByIndex[cell->getIdx()] = cell;
+        }
+        else
+        {
+            this->_setIndexForCell(cell->getIdx(), cell);
+        }
     }
 }
 
 CCTableViewCell *CCTableView::dequeueCell()
 {
+    return this->dequeueCell(NULL);
+}
+
+CCTableViewCell *CCTableView::dequeueCell(const char *identifier)
+{
+    CCArray *freed = m_pCellsFreed;
+    if (identifier && identifier[0] != '\0')
+    {
+        freed = (CCArray*)m_pCellsFreedByIdentifier->objectForKey(identifier);
+    }
+
     CCTableViewCell *cell;
 
-    if (m_pCellsFreed->count() == 0) {
+    if (!freed || freed->count() == 0) {
         cell = NULL;
     } else {
-        cell = (CCTableViewCell*)m_pCellsFreed->objectAtIndex(0);
+        // the last one, nothing to move in the array
+        cell = (CCTableViewCell*)freed->lastObject();
         cell->retain();
-        m_pCellsFreed->removeObjectAtIndex(0);
+        freed->removeLastObject();
         cell->autorelease();
     }
     return cell;
 }
 
+void CCTableView::_enqueueCell(CCTableViewCell *cell)
+{
+    const char *identifier = cell->getReuseIdentifier();
+    if (identifier[0] == '\0')
+    {
+        m_pCellsFreed->addObject(cell);
+        return;
+    }
+
+    CCArray *freed = (CCArray*)m_pCellsFreedByIdentifier->objectForKey(identifier);
+    if (!freed)
+    {
+        freed = CCArray::create();
+        m_pCellsFreedByIdentifier->setObject(freed, identifier);
+    }
+    freed->addObject(cell);
+}
+
+unsigned int CCTableView::_usedCellLowerBound(unsigned int index)
+{
+    // m_pCellsUsed is sorted by index
+    unsigned int low = 0;
+    unsigned int high = m_pCellsUsed->count();
+    while (low < high)
+    {
+        unsigned int middle = low + (high - low) / 2;
+        if (((CCTableViewCell*)m_pCellsUsed->objectAtIndex(middle))->getIdx() < index)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
 void CCTableView::_addCellIfNecessary(CCTableViewCell * cell)
 {
     if (cell->getParent() != this->getContainer())
     {
         this->getContainer()->addChild(cell);
     }
-    m_pCellsUsed->insertSortedObject(cell);
-    m_pIndices->insert(cell->getIdx());
-    // [m_pIndices addIndex:cell.idx];
+    m_pCellsUsed->insertObject(cell, this->_usedCellLowerBound(cell->getIdx()));
+    m_mapCellsByIndex[cell->getIdx()] = cell;
 }
 
 void CCTableView::_updateContentSize()
@@ -359,7 +416,8 @@ unsigned int CCTableView::_indexFromOffset(CCPoint offset)
 int CCTableView::__indexFromOffset(CCPoint offset)
 {
     int low = 0;
-    int high = m_pDataSource->numberOfCellsInTableView(this) - 1;
+    // the cells the positions were computed for
+    int high = (int)m_vCellsPositions.size() - 2;
     float search;
     switch (this->getDirection())
     {
@@ -404,10 +462,13 @@ void CCTableView::_moveCellOutOfSight(CCTableViewCell *cell)
         m_pTableViewDelegate->tableCellWillRecycle(this, cell);
     }
 
-    m_pCellsFreed->addObject(cell);
-    m_pCellsUsed->removeSortedObject(cell);
-    m_pIndices->erase(cell->getIdx());
-    // [m_pIndices removeIndex:cell.idx];
+    this->_enqueueCell(cell);
+    unsigned int position = this->_usedCellLowerBound(cell->getIdx());
+    if (position < m_pCellsUsed->count() && m_pCellsUsed->objectAtIndex(position) == cell)
+    {
+        m_pCellsUsed->removeObjectAtIndex(position);
+    }
+    m_mapCellsByIndex.erase(cell->getIdx());
     cell->reset();
     if (cell->getParent() == this->getContainer()) {
         this->getContainer()->removeChild(cell, true);;
@@ -448,6 +509,45 @@ void CCTableView::_updateCellPositions() {
 
 }
 
+void CCTableView::_insertCellPosition(unsigned int index)
+{
+    unsigned int cellsCount = m_pDataSource->numberOfCellsInTableView(this);
+    if (m_vCellsPositions.empty() || cellsCount != m_vCellsPositions.size() || index >= cellsCount)
+    {
+        // the data source did not just gain this cell
+        this->_updateCellPositions();
+        return;
+    }
+
+    // only the cells after the new one move, by its size
+    CCSize cellSize = m_pDataSource->tableCellSizeForIndex(this, index);
+    float size = this->getDirection() == kCCScrollViewDirectionHorizontal ? cellSize.width : cellSize.height;
+    float position = m_vCellsPositions[index];
+    m_vCellsPositions.insert(m_vCellsPositions.begin() + index, position);
+    for (unsigned int i = index + 1; i < m_vCellsPositions.size(); i++)
+    {
+        m_vCellsPositions[i] += size;
+    }
+}
+
+void CCTableView::_removeCellPosition(unsigned int index)
+{
+    unsigned int cellsCount = m_pDataSource->numberOfCellsInTableView(this);
+    if (cellsCount + 2 != m_vCellsPositions.size() || index > cellsCount)
+    {
+        // the data source did not just lose this cell
+        this->_updateCellPositions();
+        return;
+    }
+
+    float size = m_vCellsPositions[index + 1] - m_vCellsPositions[index];
+    m_vCellsPositions.erase(m_vCellsPositions.begin() + index);
+    for (unsigned int i = index; i < m_vCellsPositions.size(); i++)
+    {
+        m_vCellsPositions[i] -= size;
+    }
+}
+
 void CCTableView::scrollViewDidScroll(CCScrollView* view)
 {
     unsigned int uCountOfItems = m_pDataSource->numberOfCellsInTableView(this);
@@ -460,6 +560,42 @@ void CCTableView::scrollViewDidScroll(CCScrollView* view)
         m_pTableViewDelegate->scrollViewDidScroll(this);
     }
 
+    this->_updateVisibleCells();
+}
+
+void CCTableView::onEnter()
+{
+    CCScrollView::onEnter();
+    if (m_pDataSource && !m_vCellsPositions.empty())
+    {
+        this->_updateVisibleCells();
+    }
+}
+
+void CCTableView::cleanup()
+{
+    // CCNode::cleanup() unschedules _createPendingCells
+    m_bCellsPending = false;
+    CCScrollView::cleanup();
+}
+
+void CCTableView::_createPendingCells(float dt)
+{
+    if (this->_updateVisibleCells())
+    {
+        this->unschedule(schedule_selector(CCTableView::_createPendingCells));
+        m_bCellsPending = false;
+    }
+}
+
+bool CCTableView::_updateVisibleCells()
+{
+    unsigned int uCountOfItems = m_pDataSource->numberOfCellsInTableView(this);
+    if (0 == uCountOfItems)
+    {
+        return true;
+    }
+
     unsigned int startIdx = 0, endIdx = 0, idx = 0, maxIdx = 0;
     CCPoint offset = ccpMult(this->getContentOffset(), -1);
     maxIdx = MAX(uCountOfItems-1, 0);
@@ -550,15 +686,33 @@ void CCTableView::scrollViewDidScroll(CCScrollView* view)
         }
     }
 
+    unsigned int frame = CCDirector::sharedDirector()->getTotalFrames();
+    if (frame != m_uCellsCreatedFrame)
+    {
+        m_uCellsCreatedFrame = frame;
+        m_uCellsCreated = 0;
+    }
+
     for (unsigned int i=startIdx; i <= endIdx; i++)
     {
-        //if ([m_pIndices containsIndex:i])
-        if (m_pIndices->find(i) != m_pIndices->end())
+        if (m_mapCellsByIndex.find(i) != m_mapCellsByIndex.end())
         {
             continue;
         }
+        if (m_uCellCreationBudget > 0 && m_uCellsCreated >= m_uCellCreationBudget)
+        {
+            // the rest of the window is filled in the next frames
+            if (!m_bCellsPending)
+            {
+                m_bCellsPending = true;
+                this->schedule(schedule_selector(CCTableView::_createPendingCells));
+            }
+            return false;
+        }
         this->updateCellAtIndex(i);
+        m_uCellsCreated++;
     }
+    return true;
 }
 
 void CCTableView::ccTouchEnded(CCTouch *pTouch, CCEvent *pEvent)
@@ -29,7 +29,7 @@
 #include "CCScrollView.h"
 #include "CCTableViewCell.h"
 
-#include <set>
+#include <unordered_map>
 #include <vector>
 
 NS_CC_EXT_BEGIN
@@ -216,6 +216,14 @@ public:
      * @return free cell
      */
     CCTableViewCell *dequeueCell();
+    /**
+     * Dequeues a free cell that was created with the given reuse identifier,
+     * each identifier has its own free list. nil if not available.
+     *
+     * @param identifier reuse identifier of the cell, see CCTableViewCell::setReuseIdentifier
+     * @return free cell
+     */
+    CCTableViewCell *dequeueCell(const char *identifier);
 
     /**
      * Returns an existing cell at a given index. Returns nil if a cell is nonexistent at the moment of query.
@@ -225,10 +233,24 @@ public:
      */
     CCTableViewCell *cellAtIndex(unsigned int idx);
 
+    /**
+     * Maximum number of cells requested from the data source per frame while
+     * scrolling, the cells over budget are created in the next frames.
+     * 0, the default, creates every visible cell immediately.
+     */
+    void setCellCreationBudget(unsigned int budget) { m_uCellCreationBudget = budget; }
+    unsigned int getCellCreationBudget() { return m_uCellCreationBudget; }
+
 
     virtual void scrollViewDidScroll(CCScrollView* view);
     virtual void scrollViewDidZoom(CCScrollView* view) {}
 
+    /**
+     * The cells left pending by cleanup() are created again when the table is added back.
+     */
+    virtual void onEnter();
+    virtual void cleanup();
+
     virtual bool ccTouchBegan(CCTouch *pTouch, CCEvent *pEvent);
     virtual void ccTouchMoved(CCTouch *pTouch, CCEvent *pEvent);
     virtual void ccTouchEnded(CCTouch *pTouch, CCEvent *pEvent);
@@ -243,9 +265,9 @@ protected:
     CCTableViewVerticalFillOrder m_eVordering;
 
     /**
-     * index set to query the indexes of the cells used.
+     * cells used, by index.
      */
-    std::set<unsigned int>* m_pIndices;
+    std::unordered_map<unsigned int, CCTableViewCell*> m_mapCellsByIndex;
 
     /**
      * vector with all cell positions
@@ -253,13 +275,24 @@ protected:
     std::vector<float> m_vCellsPositions;
     //NSMutableIndexSet *indices_;
     /**
-     * cells that are currently in the table
+     * cells that are currently in the table, sorted by index
      */
     CCArrayForObjectSorting* m_pCellsUsed;
     /**
-     * free list of cells
+     * free list of cells without reuse identifier
      */
     CCArrayForObjectSorting* m_pCellsFreed;
+    /**
+     * free lists of the cells with a reuse identifier, by identifier
+     */
+    CCDictionary* m_pCellsFreedByIdentifier;
+    /**
+     * see setCellCreationBudget
+     */
+    unsigned int m_uCellCreationBudget;
+    unsigned int m_uCellsCreated;
+    unsigned int m_uCellsCreatedFrame;
+    bool m_bCellsPending;
     /**
      * weak link to the data source object
      */
@@ -277,10 +310,16 @@ protected:
     CCPoint _offsetFromIndex(unsigned int index);
 
     void _moveCellOutOfSight(CCTableViewCell *cell);
+    void _enqueueCell(CCTableViewCell *cell);
     void _setIndexForCell(unsigned int index, CCTableViewCell *cell);
     void _addCellIfNecessary(CCTableViewCell * cell);
+    unsigned int _usedCellLowerBound(unsigned int index);
 
     void _updateCellPositions();
+    void _insertCellPosition(unsigned int index);
+    void _removeCellPosition(unsigned int index);
+    bool _updateVisibleCells();
+    void _createPendingCells(float dt);
 public:
     void _updateContentSize();
     
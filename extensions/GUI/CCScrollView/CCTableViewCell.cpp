@@ -52,4 +52,14 @@ void CCTableViewCell::setIdx(unsigned int uIdx)
     m_uIdx = uIdx;
 }
 
+const char* CCTableViewCell::getReuseIdentifier()
+{
+    return m_sReuseIdentifier.c_str();
+}
+
+void CCTableViewCell::setReuseIdentifier(const char* identifier)
+{
+    m_sReuseIdentifier = identifier ? identifier : "";
+}
+
 NS_CC_EXT_END
@@ -51,8 +51,16 @@ public:
 
     void setObjectID(unsigned int uIdx);
     unsigned int getObjectID();
+
+    /**
+     * Cells with the same reuse identifier share a free list in the table view,
+     * see CCTableView::dequeueCell(const char*). Empty by default.
+     */
+    const char* getReuseIdentifier();
+    void setReuseIdentifier(const char* identifier);
 private:
     unsigned int m_uIdx;
+    std::string m_sReuseIdentifier;
 };
 
 NS_CC_EXT_END
@@ -36,13 +36,54 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <sqlite3.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+
+// time the writer thread gathers changes before committing them, about one frame
+#define LOCALSTORAGE_BATCH_DELAY_MS 16
+
+/*
+ Writes are applied to an in memory overlay and committed by a background thread,
+ one transaction per batch. Reads look at the overlay first, so they always see the
+ last write even before it reaches the database. The database uses its own connection
+ for the reads, WAL journaling lets them run while the writer commits.
+ */
+
+/** a change not committed yet */
+struct LocalStoragePendingItem
+{
+	bool removed;
+	std::string value;
+};
+typedef std::map<std::string, LocalStoragePendingItem> LocalStoragePendingItems;
 
 static int _initialized = 0;
-static sqlite3 *_db;
+static sqlite3 *_db;            // used by the writer thread, or by the calling thread when there is no writer
+static sqlite3 *_readDb;        // used by the calling thread
 static sqlite3_stmt *_stmt_select;
 static sqlite3_stmt *_stmt_remove;
 static sqlite3_stmt *_stmt_update;
 
+// guards the overlay and the writer state
+static std::mutex _mutex;
+static std::condition_variable _writerCondition;   // the writer waits for changes
+static std::condition_variable _committedCondition; // localStorageFlush() waits for the commits
+static std::thread _writerThread;
+static bool _useWriterThread = false;
+static bool _writerQuit = false;
+static bool _flushRequested = false;
+static LocalStoragePendingItems _pendingItems;      // changes waiting for the writer
+static LocalStoragePendingItems _committingItems;   // changes being committed
+
+// returned by localStorageGetItem() for the values of the overlay
+static std::string _lastValue;
+static std::vector<std::string> _bulkValues;
+
 
 static void localStorageLazyInit();
 static void localStorageCreateTable();
@@ -59,6 +100,151 @@ static void localStorageCreateTable()
 		printf("Error in CREATE TABLE\n");
 }
 
+static void localStorageExec( sqlite3 *db, const char *sql )
+{
+	if( sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK )
+		printf("Error in %s: %s\n", sql, sqlite3_errmsg(db));
+}
+
+/** writes a batch of changes in a single transaction */
+static void localStorageCommit( const LocalStoragePendingItems& items )
+{
+	localStorageExec(_db, "BEGIN;");
+
+	for( LocalStoragePendingItems::const_iterator it = items.begin(); it != items.end(); ++it ) {
+		int ok;
+		if( it->second.removed ) {
+			ok = sqlite3_bind_text(_stmt_remove, 1, it->first.c_str(), -1, SQLITE_STATIC);
+			ok |= sqlite3_step(_stmt_remove);
+			ok |= sqlite3_reset(_stmt_remove);
+		} else {
+			ok = sqlite3_bind_text(_stmt_update, 1, it->first.c_str(), -1, SQLITE_STATIC);
+			ok |= sqlite3_bind_text(_stmt_update, 2, it->second.value.c_str(), -1, SQLITE_STATIC);
+			ok |= sqlite3_step(_stmt_update);
+			ok |= sqlite3_reset(_stmt_update);
+		}
+
+		if( ok != SQLITE_OK && ok != SQLITE_DONE)
+			printf("Error in localStorage commit of %s\n", it->first.c_str());
+	}
+
+	localStorageExec(_db, "COMMIT;");
+}
+
+/** commits the pending changes, a batch gathers the changes of about one frame */
+static void localStorageWriterLoop()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while( true ) {
+		if( _pendingItems.empty() ) {
+			if( _writerQuit )
+				break;
+			_writerCondition.wait(lock);
+			continue;
+		}
+
+		// the changes made until the deadline join the batch, only a flush or the exit cut it short
+		if( ! _writerQuit && ! _flushRequested ) {
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(LOCALSTORAGE_BATCH_DELAY_MS);
+			_writerCondition.wait_until(lock, deadline, []{ return _writerQuit || _flushRequested; });
+		}
+
+		// the batch stays readable from the overlay until it is committed
+		_committingItems.swap(_pendingItems);
+		_flushRequested = false;
+		lock.unlock();
+
+		localStorageCommit(_committingItems);
+
+		lock.lock();
+		_committingItems.clear();
+		_committedCondition.notify_all();
+	}
+}
+
+/** commits the pending changes and stops the writer thread */
+static void localStorageStopWriter()
+{
+	if( _writerThread.joinable() ) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_writerQuit = true;
+		}
+		_writerCondition.notify_one();
+		_writerThread.join();
+	}
+}
+
+// Commits the pending changes when the program exits without calling localStorageFree(),
+// it is destroyed before the writer state above.
+static struct LocalStorageWriterGuard
+{
+	~LocalStorageWriterGuard()
+	{
+		localStorageStopWriter();
+	}
+} _writerGuard;
+
+/** looks for a change in the overlay, the mutex must be locked */
+static const LocalStoragePendingItem* localStorageFindPending( const char *key )
+{
+	LocalStoragePendingItems::const_iterator it = _pendingItems.find(key);
+	if( it != _pendingItems.end() )
+		return &it->second;
+
+	it = _committingItems.find(key);
+	if( it != _committingItems.end() )
+		return &it->second;
+
+	return NULL;
+}
+
+/** applies a set or a remove, synchronously when there is no writer thread */
+static void localStorageChange( const char *key, const char *value )
+{
+	assert( _initialized );
+	if( ! key )
+		return;
+
+	if( ! _useWriterThread ) {
+		LocalStoragePendingItems items;
+		LocalStoragePendingItem& item = items[key];
+		item.removed = (value == NULL);
+		item.value = value ? value : "";
+		localStorageCommit(items);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		LocalStoragePendingItem& item = _pendingItems[key];
+		item.removed = (value == NULL);
+		item.value = value ? value : "";
+	}
+	_writerCondition.notify_one();
+}
+
+/** reads a committed value into value, returns false when the key is not set.
+ The statement is reset before returning: a stepped statement keeps a read transaction
+ open, which would pin the WAL snapshot and stop the checkpoints of the writer.
+ */
+static bool localStorageSelect( const char *key, std::string& value )
+{
+	int ok = sqlite3_reset(_stmt_select);
+
+	ok |= sqlite3_bind_text(_stmt_select, 1, key, -1, SQLITE_TRANSIENT);
+	ok |= sqlite3_step(_stmt_select);
+	const unsigned char *ret = sqlite3_column_text(_stmt_select, 0);
+	if( ret )
+		value.assign((const char*)ret);
+
+	if( ok != SQLITE_OK && ok != SQLITE_DONE && ok != SQLITE_ROW)
+		printf("Error in localStorage.getItem()\n");
+
+	sqlite3_reset(_stmt_select);
+	return ret != NULL;
+}
+
 void localStorageInit( const char *fullpath)
 {
 	if( ! _initialized ) {
@@ -70,11 +256,31 @@ void localStorageInit( const char *fullpath)
 		else
 			ret = sqlite3_open(fullpath, &_db);
 
+		// a file database gets a second connection for the reads and a writer thread,
+		// an in-memory database can't be shared between connections
+#ifdef EMSCRIPTEN
+		_useWriterThread = false;
+#else
+		_useWriterThread = (fullpath != NULL) && sqlite3_threadsafe();
+#endif
+		if( _useWriterThread ) {
+			// appends to the log instead of rewriting pages, readers don't block the writer
+			localStorageExec(_db, "PRAGMA journal_mode=WAL;");
+			localStorageExec(_db, "PRAGMA synchronous=NORMAL;");
+		}
+
 		localStorageCreateTable();
 
+		_readDb = _db;
+		if( _useWriterThread && sqlite3_open_v2(fullpath, &_readDb, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK ) {
+			sqlite3_close(_readDb);
+			_readDb = _db;
+			_useWriterThread = false;
+		}
+
 		// SELECT
 		const char *sql_select = "SELECT value FROM data WHERE key=?;";
-		ret |= sqlite3_prepare_v2(_db, sql_select, -1, &_stmt_select, NULL);
+		ret |= sqlite3_prepare_v2(_readDb, sql_select, -1, &_stmt_select, NULL);
 
 		// REPLACE
 		const char *sql_update = "REPLACE INTO data (key, value) VALUES (?,?);";
@@ -88,6 +294,11 @@ void localStorageInit( const char *fullpath)
 			printf("Error initializing DB\n");
 			// report error
 		}
+
+		if( _useWriterThread ) {
+			_writerQuit = false;
+			_writerThread = std::thread(localStorageWriterLoop);
+		}
 		
 		_initialized = 1;
 	}
@@ -96,30 +307,42 @@ void localStorageInit( const char *fullpath)
 void localStorageFree()
 {
 	if( _initialized ) {
+		// the pending changes are committed before the thread exits
+		localStorageStopWriter();
+
 		sqlite3_finalize(_stmt_select);
 		sqlite3_finalize(_stmt_remove);
 		sqlite3_finalize(_stmt_update);		
 
+		if( _readDb != _db )
+			sqlite3_close(_readDb);
 		sqlite3_close(_db);
 		
 		_initialized = 0;
 	}
 }
 
+void localStorageFlush()
+{
+	assert( _initialized );
+
+	if( ! _useWriterThread )
+		return;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_flushRequested = true;
+	_writerCondition.notify_one();
+	while( ! _pendingItems.empty() || ! _committingItems.empty() )
+		_committedCondition.wait(lock);
+}
+
 /** sets an item in the LS */
 void localStorageSetItem( const char *key, const char *value)
 {
-	assert( _initialized );
-	
-	int ok = sqlite3_bind_text(_stmt_update, 1, key, -1, SQLITE_TRANSIENT);
-	ok |= sqlite3_bind_text(_stmt_update, 2, value, -1, SQLITE_TRANSIENT);
+	if( ! value )
+		return;
 
-	ok |= sqlite3_step(_stmt_update);
-	
-	ok |= sqlite3_reset(_stmt_update);
-	
-	if( ok != SQLITE_OK && ok != SQLITE_DONE)
-		printf("Error in localStorage.setItem()\n");
+	localStorageChange(key, value);
 }
 
 /** gets an item from the LS */
@@ -127,32 +350,95 @@ const char* localStorageGetItem( const char *key )
 {
 	assert( _initialized );
 
-	int ok = sqlite3_reset(_stmt_select);
-
-	ok |= sqlite3_bind_text(_stmt_select, 1, key, -1, SQLITE_TRANSIENT);
-	ok |= sqlite3_step(_stmt_select);
-	const unsigned char *ret = sqlite3_column_text(_stmt_select, 0);
-	
-
-	if( ok != SQLITE_OK && ok != SQLITE_DONE && ok != SQLITE_ROW)
-		printf("Error in localStorage.getItem()\n");
+	if( _useWriterThread ) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		const LocalStoragePendingItem *item = localStorageFindPending(key);
+		if( item ) {
+			if( item->removed )
+				return NULL;
+			_lastValue = item->value;
+			return _lastValue.c_str();
+		}
+	}
 
-	return (const char*)ret;
+	return localStorageSelect(key, _lastValue) ? _lastValue.c_str() : NULL;
 }
 
 /** removes an item from the LS */
 void localStorageRemoveItem( const char *key )
+{
+	localStorageChange(key, NULL);
+}
+
+void localStorageSetItems( const char **keys, const char **values, int count )
 {
 	assert( _initialized );
 
-	int ok = sqlite3_bind_text(_stmt_remove, 1, key, -1, SQLITE_TRANSIENT);
-	
-	ok |= sqlite3_step(_stmt_remove);
-	
-	ok |= sqlite3_reset(_stmt_remove);
+	if( ! _useWriterThread ) {
+		LocalStoragePendingItems items;
+		for( int i = 0; i < count; i++ ) {
+			if( keys[i] && values[i] ) {
+				LocalStoragePendingItem& item = items[keys[i]];
+				item.removed = false;
+				item.value = values[i];
+			}
+		}
+		localStorageCommit(items);
+		return;
+	}
 
-	if( ok != SQLITE_OK && ok != SQLITE_DONE)
-		printf("Error in localStorage.removeItem()\n");
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for( int i = 0; i < count; i++ ) {
+			if( keys[i] && values[i] ) {
+				LocalStoragePendingItem& item = _pendingItems[keys[i]];
+				item.removed = false;
+				item.value = values[i];
+			}
+		}
+	}
+	_writerCondition.notify_one();
+}
+
+void localStorageGetItems( const char **keys, const char **values, int count )
+{
+	assert( _initialized );
+
+	_bulkValues.resize(count);
+	std::vector<bool> found(count, false);
+
+	std::vector<bool> pending(count, false);
+
+	// the overlay first, the lock is not held while reading the database
+	if( _useWriterThread ) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		for( int i = 0; i < count; i++ ) {
+			const LocalStoragePendingItem *item = keys[i] ? localStorageFindPending(keys[i]) : NULL;
+			if( item ) {
+				pending[i] = true;
+				found[i] = ! item->removed;
+				_bulkValues[i] = item->value;
+			}
+		}
+	}
+
+	bool transaction = false;
+	for( int i = 0; i < count; i++ ) {
+		if( pending[i] || ! keys[i] )
+			continue;
+
+		// one read transaction for all the keys
+		if( ! transaction ) {
+			localStorageExec(_readDb, "BEGIN;");
+			transaction = true;
+		}
+		found[i] = localStorageSelect(keys[i], _bulkValues[i]);
+	}
+	if( transaction )
+		localStorageExec(_readDb, "COMMIT;");
+
+	for( int i = 0; i < count; i++ )
+		values[i] = found[i] ? _bulkValues[i].c_str() : NULL;
 }
 
 #endif // #if (CC_TARGET_PLATFORM != CC_PLATFORM_ANDROID)
@@ -49,4 +49,17 @@ CC_EX_DLL const char* localStorageGetItem( const char *key );
 /** removes an item from the LS */
 CC_EX_DLL void localStorageRemoveItem( const char *key );
 
+/** sets count items at once, they are written in a single transaction */
+CC_EX_DLL void localStorageSetItems( const char **keys, const char **values, int count );
+
+/** gets count items at once. values[i] is NULL when keys[i] is not set.
+ The values are valid until the next call of localStorageGetItems().
+ */
+CC_EX_DLL void localStorageGetItems( const char **keys, const char **values, int count );
+
+/** Blocks until the pending writes are committed to the database.
+ Writes are batched and committed by a background thread, reads always see them.
+ */
+CC_EX_DLL void localStorageFlush();
+
 #endif // __JSB_LOCALSTORAGE_H
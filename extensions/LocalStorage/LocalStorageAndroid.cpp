@@ -141,4 +141,21 @@ void localStorageRemoveItem( const char *key )
 
 }
 
+/** the Java side commits each item, the items are forwarded one by one */
+void localStorageSetItems( const char **keys, const char **values, int count )
+{
+	for( int i = 0; i < count; i++ )
+		localStorageSetItem(keys[i], values[i]);
+}
+
+void localStorageGetItems( const char **keys, const char **values, int count )
+{
+	for( int i = 0; i < count; i++ )
+		values[i] = localStorageGetItem(keys[i]);
+}
+
+void localStorageFlush()
+{
+}
+
 #endif // #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
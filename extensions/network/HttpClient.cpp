@@ -28,6 +28,8 @@
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WP8) ||  (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
 #include "CCPThreadWinRT.h"
+#include <thread>
+#include <chrono>
 typedef void THREAD_VOID;
 #define THREAD_RETURN
 #else
@@ -37,7 +39,10 @@ typedef void* THREAD_VOID;
 #endif
 
 #include <errno.h>
+#include <algorithm>
+#include <map>
 #include <queue>
+#include <vector>
 
 #include "curl/curl.h"
 
@@ -63,19 +68,136 @@ static CCArray* s_responseQueue = NULL;
 
 static CCHttpClient *s_pHttpClient = NULL; // pointer to singleton
 
-static char s_errorBuffer[CURL_ERROR_SIZE];
+// longest time the network thread waits on the sockets before looking for new requests, in ms
+#define HTTP_POLL_INTERVAL 10
+
+// default size of the pieces delivered to a chunk callback
+#define HTTP_DEFAULT_CHUNK_SIZE (16 * 1024)
+// largest body buffer reserved up front from the Content-Length header
+#define HTTP_MAX_RESERVED_SIZE (32 * 1024 * 1024)
 
 typedef size_t (*write_callback)(void *ptr, size_t size, size_t nmemb, void *stream);
 
+/**
+ * A request being processed by the curl multi handle.
+ * Only touched by the network thread.
+ */
+struct HttpTransfer
+{
+    CCHttpRequest       *request;
+    CCHttpResponse      *response;
+    CURL                *handle;
+    curl_slist          *headers;
+    std::string         host;
+    char                errorBuffer[CURL_ERROR_SIZE];
+
+    FILE                *file;          // body sink of a download to file
+    long long           resumeFrom;     // size of the partial file being resumed
+    bool                ignoreRange;    // the server doesn't support ranges, download the whole file
+    size_t              chunkSize;      // body is streamed to the main thread when not 0
+    std::vector<char>   chunk;          // streamed bytes not delivered yet
+    bool                bodyStarted;    // the first body bytes were received
+    bool                keepBody;       // false for the body of an error status in a download to file
+    long long           receivedBytes;
+};
+
+/**
+ * Piece of a streamed response body, queued in the response queue
+ * before the response itself so that callbacks keep the order of the data.
+ */
+class HttpResponseChunk : public CCObject
+{
+public:
+    HttpResponseChunk(CCHttpResponse *response)
+    : _response(response)
+    {
+        _response->retain();
+    }
+
+    virtual ~HttpResponseChunk()
+    {
+        _response->release();
+    }
+
+    CCHttpResponse      *_response;
+    std::vector<char>   _data;
+};
+
+// Hands the streamed bytes of a transfer to the main thread, the buffer is swapped, not copied
+static void queueResponseChunk(HttpTransfer *transfer)
+{
+    if (transfer->chunk.empty())
+    {
+        return;
+    }
+
+    HttpResponseChunk *chunk = new HttpResponseChunk(transfer->response);
+    chunk->_data.swap(transfer->chunk);
+    transfer->chunk.reserve(transfer->chunkSize);
+
+    pthread_mutex_lock(&s_responseQueueMutex);
+    s_responseQueue->addObject(chunk);
+    pthread_mutex_unlock(&s_responseQueueMutex);
+    chunk->release();
+
+    CCDirector::sharedDirector()->getScheduler()->resumeTarget(CCHttpClient::getInstance());
+}
+
+// Looks at the status and length of the body before its first bytes are stored
+static void startBody(HttpTransfer *transfer)
+{
+    transfer->bodyStarted = true;
+
+    long responseCode = 0;
+    curl_easy_getinfo(transfer->handle, CURLINFO_RESPONSE_CODE, &responseCode);
+    if (transfer->file)
+    {
+        // never write an error page into the downloaded file
+        transfer->keepBody = (responseCode >= 200 && responseCode < 300);
+        return;
+    }
+
+    double contentLength = -1;
+    curl_easy_getinfo(transfer->handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLength);
+    if (0 == transfer->chunkSize && contentLength > 0 && contentLength <= HTTP_MAX_RESERVED_SIZE)
+    {
+        // avoid growing the buffer by copies for large bodies
+        transfer->response->getResponseData()->reserve((size_t)contentLength);
+    }
+}
+
 // Callback function used by libcurl for collect response data
 static size_t writeData(void *ptr, size_t size, size_t nmemb, void *stream)
 {
-    std::vector<char> *recvBuffer = (std::vector<char>*)stream;
+    HttpTransfer *transfer = (HttpTransfer*)stream;
     size_t sizes = size * nmemb;
+
+    if (!transfer->bodyStarted)
+    {
+        startBody(transfer);
+    }
+    if (!transfer->keepBody)
+    {
+        return sizes;
+    }
+    transfer->receivedBytes += sizes;
+
+    if (transfer->file)
+    {
+        // a short write makes libcurl abort the transfer with CURLE_WRITE_ERROR
+        return fwrite(ptr, 1, sizes, transfer->file);
+    }
+
+    std::vector<char> *recvBuffer = transfer->chunkSize ? &transfer->chunk : transfer->response->getResponseData();
     
     // add data to the end of recvBuffer
     // write data maybe called more than once in a single request
     recvBuffer->insert(recvBuffer->end(), (char*)ptr, (char*)ptr+sizes);
+
+    if (transfer->chunkSize && transfer->chunk.size() >= transfer->chunkSize)
+    {
+        queueResponseChunk(transfer);
+    }
     
     return sizes;
 }
@@ -93,159 +215,76 @@ static size_t writeHeaderData(void *ptr, size_t size, size_t nmemb, void *stream
     return sizes;
 }
 
+// Returns the "scheme://host:port" part of an url, used to apply the per host limit
+static std::string hostOfUrl(const char *url)
+{
+    std::string str(url ? url : "");
+    size_t begin = str.find("://");
+    begin = (begin == std::string::npos) ? 0 : begin + 3;
+    size_t end = str.find_first_of("/?#", begin);
+    return str.substr(0, end);
+}
 
-static int processGetTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *errorCode, write_callback headerCallback, void *headerStream);
-static int processPostTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *errorCode, write_callback headerCallback, void *headerStream);
-static int processPutTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *errorCode, write_callback headerCallback, void *headerStream);
-static int processDeleteTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *errorCode, write_callback headerCallback, void *headerStream);
-// int processDownloadTask(HttpRequest *task, write_callback callback, void *stream, int32_t *errorCode);
+/**
+ * Easy handles are recycled with curl_easy_reset, which keeps their DNS cache
+ * and TLS session ids. Connections are kept alive by the multi handle cache,
+ * so requests to the same host reuse them.
+ */
+class HttpHandlePool
+{
+public:
+    HttpHandlePool() {}
 
+    ~HttpHandlePool()
+    {
+        clear();
+    }
 
-// Worker thread
-static THREAD_VOID networkThread(THREAD_VOID)
-{    
-    CCHttpRequest *request = NULL;
-    
-    while (true) 
+    // the network thread ends with pthread_exit, which doesn't run destructors on bionic
+    void clear()
     {
-        if (need_quit)
-        {
-            break;
-        }
-        
-        // step 1: send http request if the requestQueue isn't empty
-        request = NULL;
-        
-        pthread_mutex_lock(&s_requestQueueMutex); //Get request task from queue
-        if (0 != s_requestQueue->count())
+        for (size_t i = 0; i < _handles.size(); ++i)
         {
-            request = dynamic_cast<CCHttpRequest*>(s_requestQueue->objectAtIndex(0));
-            s_requestQueue->removeObjectAtIndex(0);  
-            // request's refcount = 1 here
+            curl_easy_cleanup(_handles[i]);
         }
-        pthread_mutex_unlock(&s_requestQueueMutex);
-        
-        if (NULL == request)
-        {
-        	// Wait for http request tasks from main thread
-        	pthread_cond_wait(&s_SleepCondition, &s_SleepMutex);
-            continue;
-        }
-        
-        // step 2: libcurl sync access
-        
-        // Create a HttpResponse object, the default setting is http access failed
-        CCHttpResponse *response = new CCHttpResponse(request);
-        
-        // request's refcount = 2 here, it's retained by HttpRespose constructor
-        request->release();
-        // ok, refcount = 1 now, only HttpResponse hold it.
-        
-        int32_t responseCode = -1;
-        int retValue = 0;
-
-        // Process the request -> get response packet
-        switch (request->getRequestType())
-        {
-            case CCHttpRequest::kHttpGet: // HTTP GET
-                retValue = processGetTask(request,
-                                          writeData, 
-                                          response->getResponseData(), 
-                                          &responseCode,
-                                          writeHeaderData,
-                                          response->getResponseHeader());
-                break;
-            
-            case CCHttpRequest::kHttpPost: // HTTP POST
-                retValue = processPostTask(request,
-                                           writeData, 
-                                           response->getResponseData(), 
-                                           &responseCode,
-                                           writeHeaderData,
-                                           response->getResponseHeader());
-                break;
-
-            case CCHttpRequest::kHttpPut:
-                retValue = processPutTask(request,
-                                          writeData,
-                                          response->getResponseData(),
-                                          &responseCode,
-                                          writeHeaderData,
-                                          response->getResponseHeader());
-                break;
+        _handles.clear();
+    }
 
-            case CCHttpRequest::kHttpDelete:
-                retValue = processDeleteTask(request,
-                                             writeData,
-                                             response->getResponseData(),
-                                             &responseCode,
-                                             writeHeaderData,
-                                             response->getResponseHeader());
-                break;
-            
-            default:
-                CCAssert(true, "CCHttpClient: unkown request type, only GET and POSt are supported");
-                break;
-        }
-                
-        // write data to HttpResponse
-        response->setResponseCode(responseCode);
-        
-        if (retValue != 0) 
-        {
-            response->setSucceed(false);
-            response->setErrorBuffer(s_errorBuffer);
-        }
-        else
+    CURL* get()
+    {
+        if (_handles.empty())
         {
-            response->setSucceed(true);
+            return curl_easy_init();
         }
-
-        
-        // add response packet into queue
-        pthread_mutex_lock(&s_responseQueueMutex);
-        s_responseQueue->addObject(response);
-        pthread_mutex_unlock(&s_responseQueueMutex);
-        
-        // resume dispatcher selector
-        CCDirector::sharedDirector()->getScheduler()->resumeTarget(CCHttpClient::getInstance());
+        CURL *handle = _handles.back();
+        _handles.pop_back();
+        return handle;
     }
-    
-    // cleanup: if worker thread received quit signal, clean up un-completed request queue
-    pthread_mutex_lock(&s_requestQueueMutex);
-    s_requestQueue->removeAllObjects();
-    pthread_mutex_unlock(&s_requestQueueMutex);
-    s_asyncRequestCount -= s_requestQueue->count();
-    
-    if (s_requestQueue != NULL) {
-        
-        pthread_mutex_destroy(&s_requestQueueMutex);
-        pthread_mutex_destroy(&s_responseQueueMutex);
-        
-        pthread_mutex_destroy(&s_SleepMutex);
-        pthread_cond_destroy(&s_SleepCondition);
 
-        s_requestQueue->release();
-        s_requestQueue = NULL;
-        s_responseQueue->release();
-        s_responseQueue = NULL;
+    void put(CURL *handle, size_t maxPooled)
+    {
+        if (_handles.size() >= maxPooled)
+        {
+            curl_easy_cleanup(handle);
+            return;
+        }
+        curl_easy_reset(handle);
+        _handles.push_back(handle);
     }
 
-    pthread_exit(NULL);
-    
-    return THREAD_RETURN;
-
-}
+private:
+    std::vector<CURL*> _handles;
+};
 
 //Configure curl's timeout property
-static bool configureCURL(CURL *handle)
+static bool configureCURL(CURL *handle, char *errorBuffer)
 {
     if (!handle) {
         return false;
     }
     
     int32_t code;
-    code = curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, s_errorBuffer);
+    code = curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, errorBuffer);
     if (code != CURLE_OK) {
         return false;
     }
@@ -267,127 +306,492 @@ static bool configureCURL(CURL *handle)
     return true;
 }
 
-class CURLRaii
+// Size of an open file, on 64 bits even where long is 32 bits
+static long long getFileSize(FILE *file)
 {
-    /// Instance of CURL
-    CURL *m_curl;
-    /// Keeps custom header data
-    curl_slist *m_headers;
-public:
-    CURLRaii()
-        : m_curl(curl_easy_init())
-        , m_headers(NULL)
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    if (_fseeki64(file, 0, SEEK_END) != 0)
     {
+        return -1;
     }
+    return _ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END) != 0)
+    {
+        return -1;
+    }
+    return (long long)ftello(file);
+#endif
+}
 
-    ~CURLRaii()
+// Opens the file of a download to file, resumes it from its current size when asked to
+static bool openDownloadFile(HttpTransfer *transfer)
+{
+    CCHttpRequest *request = transfer->request;
+    const char *path = request->getDownloadFile();
+
+    transfer->resumeFrom = 0;
+    if (request->isResumeDownload() && !transfer->ignoreRange)
     {
-        if (m_curl)
-            curl_easy_cleanup(m_curl);
-        /* free the linked list for header data */
-        if (m_headers)
-            curl_slist_free_all(m_headers);
+        FILE *partial = fopen(path, "rb");
+        if (partial)
+        {
+            long long size = getFileSize(partial);
+            fclose(partial);
+            transfer->resumeFrom = size > 0 ? size : 0;
+        }
     }
 
-    template <class T>
-    bool setOption(CURLoption option, T data)
+    transfer->file = fopen(path, transfer->resumeFrom > 0 ? "ab" : "wb");
+    if (!transfer->file)
     {
-        return CURLE_OK == curl_easy_setopt(m_curl, option, data);
+        snprintf(transfer->errorBuffer, CURL_ERROR_SIZE, "can't open %s for writing", path);
+        return false;
     }
 
-    /**
-     * @brief Inits CURL instance for common usage
-     * @param request Null not allowed
-     * @param callback Response write callback
-     * @param stream Response write stream
-     */
-    bool init(CCHttpRequest *request, write_callback callback, void *stream, write_callback headerCallback, void *headerStream)
+    if (transfer->resumeFrom > 0)
     {
-        if (!m_curl)
-            return false;
-        if (!configureCURL(m_curl))
-            return false;
+        return CURLE_OK == curl_easy_setopt(transfer->handle, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)transfer->resumeFrom);
+    }
+    return true;
+}
 
-        /* get custom header data (if set) */
-       	std::vector<std::string> headers=request->getHeaders();
-        if(!headers.empty())
-        {
-            /* append custom headers one by one */
-            for (std::vector<std::string>::iterator it = headers.begin(); it != headers.end(); ++it)
-                m_headers = curl_slist_append(m_headers,it->c_str());
-            /* set custom headers for curl */
-            if (!setOption(CURLOPT_HTTPHEADER, m_headers))
-                return false;
-        }
+// Closes the file of a download to file, a failed download is removed unless it can be resumed
+static bool closeDownloadFile(HttpTransfer *transfer, bool succeed)
+{
+    if (!transfer->file)
+    {
+        return succeed;
+    }
 
-        return setOption(CURLOPT_URL, request->getUrl())
-                && setOption(CURLOPT_WRITEFUNCTION, callback)
-                && setOption(CURLOPT_WRITEDATA, stream)
-                && setOption(CURLOPT_HEADERFUNCTION, headerCallback)
-                && setOption(CURLOPT_HEADERDATA, headerStream);
-        
+    bool written = (0 == ferror(transfer->file));
+    written = (0 == fclose(transfer->file)) && written;
+    transfer->file = NULL;
+
+    if (succeed && !written)
+    {
+        snprintf(transfer->errorBuffer, CURL_ERROR_SIZE, "can't write %s", transfer->request->getDownloadFile());
+        succeed = false;
+    }
+    if (!succeed && !transfer->request->isResumeDownload())
+    {
+        remove(transfer->request->getDownloadFile());
+    }
+    return succeed;
+}
+
+// A 416 answer to a resumed download means the file is complete when the resource has the size of the file
+static bool isDownloadComplete(HttpTransfer *transfer)
+{
+    std::vector<char> *header = transfer->response->getResponseHeader();
+    std::string str(header->begin(), header->end());
+    std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+
+    // e.g. "Content-Range: bytes */1234"
+    size_t pos = str.find("content-range: bytes */");
+    if (pos == std::string::npos)
+    {
+        return false;
+    }
+    long long size = atoll(str.c_str() + pos + strlen("content-range: bytes */"));
+    return size == transfer->resumeFrom;
+}
+
+// Sets up the easy handle of a transfer according to its request type
+static bool setupTransfer(HttpTransfer *transfer)
+{
+    CURL *handle = transfer->handle;
+    CCHttpRequest *request = transfer->request;
+    CCHttpResponse *response = transfer->response;
+
+    if (!configureCURL(handle, transfer->errorBuffer))
+        return false;
+
+    bool toFile = request->getDownloadFile()[0] != '\0';
+    transfer->chunkSize = 0;
+    if (!toFile && request->getChunkTarget() && request->getChunkSelector())
+    {
+        transfer->chunkSize = request->getChunkSize() ? request->getChunkSize() : HTTP_DEFAULT_CHUNK_SIZE;
+        transfer->chunk.reserve(transfer->chunkSize);
     }
 
-    /// @param responseCode Null not allowed
-    bool perform(int *responseCode)
+    if (toFile || transfer->chunkSize)
     {
-        if (CURLE_OK != curl_easy_perform(m_curl))
+        // large bodies may take longer than the read timeout, only abort stalled transfers
+        curl_easy_setopt(handle, CURLOPT_TIMEOUT, 0L);
+        curl_easy_setopt(handle, CURLOPT_LOW_SPEED_LIMIT, 1L);
+        curl_easy_setopt(handle, CURLOPT_LOW_SPEED_TIME, (long)CCHttpClient::getInstance()->getTimeoutForRead());
+    }
+    if (toFile && !openDownloadFile(transfer))
+        return false;
+
+    /* get custom header data (if set) */
+    std::vector<std::string> headers = request->getHeaders();
+    if (!headers.empty())
+    {
+        /* append custom headers one by one */
+        for (std::vector<std::string>::iterator it = headers.begin(); it != headers.end(); ++it)
+            transfer->headers = curl_slist_append(transfer->headers, it->c_str());
+        /* set custom headers for curl */
+        if (CURLE_OK != curl_easy_setopt(handle, CURLOPT_HTTPHEADER, transfer->headers))
             return false;
-        CURLcode code = curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, responseCode);
-        if (code != CURLE_OK || *responseCode != 200)
+    }
+
+    bool ok = CURLE_OK == curl_easy_setopt(handle, CURLOPT_URL, request->getUrl())
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeData)
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_WRITEDATA, transfer)
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, writeHeaderData)
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_HEADERDATA, response->getResponseHeader())
+        && CURLE_OK == curl_easy_setopt(handle, CURLOPT_PRIVATE, transfer);
+    if (!ok)
+        return false;
+
+    switch (request->getRequestType())
+    {
+        case CCHttpRequest::kHttpGet: // HTTP GET
+            return CURLE_OK == curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+
+        case CCHttpRequest::kHttpPost: // HTTP POST
+            return CURLE_OK == curl_easy_setopt(handle, CURLOPT_POST, 1L)
+                && CURLE_OK == curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request->getRequestData())
+                && CURLE_OK == curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, (long)request->getRequestDataSize());
+
+        case CCHttpRequest::kHttpPut:
+            return CURLE_OK == curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, "PUT")
+                && CURLE_OK == curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request->getRequestData())
+                && CURLE_OK == curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, (long)request->getRequestDataSize());
+
+        case CCHttpRequest::kHttpDelete:
+            return CURLE_OK == curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, "DELETE")
+                && CURLE_OK == curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+
+        default:
+            CCAssert(true, "CCHttpClient: unkown request type, only GET and POSt are supported");
             return false;
-        
-        // Get some mor data.
-        
-        return true;
     }
-};
+}
 
-//Process Get Request
-static int processGetTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *responseCode, write_callback headerCallback, void *headerStream)
+// Queues the response of a finished transfer for the main thread and recycles its handle
+static void finishTransfer(HttpTransfer *transfer, bool succeed, HttpHandlePool *pool, size_t maxPooled)
 {
-    CURLRaii curl;
-    bool ok = curl.init(request, callback, stream, headerCallback, headerStream)
-            && curl.setOption(CURLOPT_FOLLOWLOCATION, true)
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
+    CCHttpResponse *response = transfer->response;
+
+    succeed = closeDownloadFile(transfer, succeed);
+    queueResponseChunk(transfer);
+    response->setReceivedBytes(transfer->receivedBytes);
+
+    if (succeed)
+    {
+        response->setSucceed(true);
+    }
+    else
+    {
+        response->setSucceed(false);
+        response->setErrorBuffer(transfer->errorBuffer);
+    }
+
+    if (transfer->headers)
+    {
+        curl_slist_free_all(transfer->headers);
+    }
+    if (transfer->handle)
+    {
+        pool->put(transfer->handle, maxPooled);
+    }
+    delete transfer;
+
+    // add response packet into queue
+    pthread_mutex_lock(&s_responseQueueMutex);
+    s_responseQueue->addObject(response);
+    pthread_mutex_unlock(&s_responseQueueMutex);
+    response->release();
+
+    // resume dispatcher selector
+    CCDirector::sharedDirector()->getScheduler()->resumeTarget(CCHttpClient::getInstance());
 }
 
-//Process POST Request
-static int processPostTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *responseCode, write_callback headerCallback, void *headerStream)
+// Moves the queued requests allowed by the concurrency limits to the multi handle
+static void startQueuedRequests(CURLM *multi, std::vector<HttpTransfer*> &active, std::map<std::string, int> &activePerHost,
+                                HttpHandlePool *pool, size_t maxPooled)
 {
-    CURLRaii curl;
-    bool ok = curl.init(request, callback, stream, headerCallback, headerStream)
-            && curl.setOption(CURLOPT_POST, 1)
-            && curl.setOption(CURLOPT_POSTFIELDS, request->getRequestData())
-            && curl.setOption(CURLOPT_POSTFIELDSIZE, request->getRequestDataSize())
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
+    CCHttpClient *client = CCHttpClient::getInstance();
+    int maxConcurrent = client->getMaxConcurrentRequests();
+    int maxPerHost = client->getMaxConnectionsPerHost();
+
+    while ((int)active.size() < maxConcurrent)
+    {
+        CCHttpRequest *request = NULL;
+        std::string host;
+
+        // take the oldest request whose host is below its limit
+        pthread_mutex_lock(&s_requestQueueMutex);
+        for (unsigned int i = 0; i < s_requestQueue->count(); ++i)
+        {
+            CCHttpRequest *candidate = (CCHttpRequest*)s_requestQueue->objectAtIndex(i);
+            host = hostOfUrl(candidate->getUrl());
+            if (maxPerHost <= 0 || activePerHost[host] < maxPerHost)
+            {
+                request = candidate;
+                // keep the request alive once it leaves the queue
+                request->retain();
+                s_requestQueue->removeObjectAtIndex(i);
+                break;
+            }
+        }
+        pthread_mutex_unlock(&s_requestQueueMutex);
+
+        if (NULL == request)
+        {
+            break;
+        }
+
+        // Create a HttpResponse object, the default setting is http access failed
+        HttpTransfer *transfer = new HttpTransfer();
+        transfer->request = request;
+        transfer->response = new CCHttpResponse(request);
+        transfer->handle = pool->get();
+        transfer->headers = NULL;
+        transfer->host = host;
+        transfer->errorBuffer[0] = '\0';
+        transfer->file = NULL;
+        transfer->resumeFrom = 0;
+        transfer->ignoreRange = false;
+        transfer->chunkSize = 0;
+        transfer->bodyStarted = false;
+        transfer->keepBody = true;
+        transfer->receivedBytes = 0;
+
+        // request's refcount = 3 here: send, the response and this thread,
+        // drop both references taken for the queue, only HttpResponse holds it now.
+        request->release();
+        request->release();
+
+        if (!transfer->handle || !setupTransfer(transfer)
+            || CURLM_OK != curl_multi_add_handle(multi, transfer->handle))
+        {
+            transfer->response->setResponseCode(-1);
+            finishTransfer(transfer, false, pool, maxPooled);
+            continue;
+        }
+
+        ++activePerHost[host];
+        active.push_back(transfer);
+    }
 }
 
-//Process PUT Request
-static int processPutTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *responseCode, write_callback headerCallback, void *headerStream)
+// Waits for socket activity on the running transfers, or for a new request when idle
+static void waitForActivity(CURLM *multi, size_t activeCount)
 {
-    CURLRaii curl;
-    bool ok = curl.init(request, callback, stream, headerCallback, headerStream)
-            && curl.setOption(CURLOPT_CUSTOMREQUEST, "PUT")
-            && curl.setOption(CURLOPT_POSTFIELDS, request->getRequestData())
-            && curl.setOption(CURLOPT_POSTFIELDSIZE, request->getRequestDataSize())
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
+    long timeout = HTTP_POLL_INTERVAL;
+    if (activeCount > 0)
+    {
+        curl_multi_timeout(multi, &timeout);
+        if (timeout < 0 || timeout > HTTP_POLL_INTERVAL)
+        {
+            // wake up regularly to start the requests sent in the meantime
+            timeout = HTTP_POLL_INTERVAL;
+        }
+
+        fd_set fdread, fdwrite, fdexcep;
+        int maxfd = -1;
+        FD_ZERO(&fdread);
+        FD_ZERO(&fdwrite);
+        FD_ZERO(&fdexcep);
+        curl_multi_fdset(multi, &fdread, &fdwrite, &fdexcep, &maxfd);
+
+        if (maxfd >= 0)
+        {
+            struct timeval tv;
+            tv.tv_sec = timeout / 1000;
+            tv.tv_usec = (timeout % 1000) * 1000;
+            select(maxfd + 1, &fdread, &fdwrite, &fdexcep, &tv);
+            return;
+        }
+        if (timeout == 0)
+        {
+            return;
+        }
+        // curl is busy without sockets (e.g. resolving), just sleep a bit
+    }
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WP8) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT)
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+#else
+    pthread_mutex_lock(&s_SleepMutex);
+    pthread_mutex_lock(&s_requestQueueMutex);
+    // startQueuedRequests() just ran: with transfers running, the requests left in the queue
+    // are held by the concurrency limits until a transfer ends, they don't need a wake up
+    bool idle = (activeCount > 0 || 0 == s_requestQueue->count()) && !need_quit;
+    pthread_mutex_unlock(&s_requestQueueMutex);
+    if (idle)
+    {
+        if (activeCount > 0)
+        {
+            struct timeval now;
+            struct timespec deadline;
+            gettimeofday(&now, NULL);
+            long long usec = now.tv_usec + timeout * 1000LL;
+            deadline.tv_sec = now.tv_sec + usec / 1000000;
+            deadline.tv_nsec = (usec % 1000000) * 1000;
+            pthread_cond_timedwait(&s_SleepCondition, &s_SleepMutex, &deadline);
+        }
+        else
+        {
+            // Wait for http request tasks from main thread
+            pthread_cond_wait(&s_SleepCondition, &s_SleepMutex);
+        }
+    }
+    pthread_mutex_unlock(&s_SleepMutex);
+#endif
 }
 
-//Process DELETE Request
-static int processDeleteTask(CCHttpRequest *request, write_callback callback, void *stream, int32_t *responseCode, write_callback headerCallback, void *headerStream)
+// Downloads again the whole file of a resumed download, for servers which don't support ranges
+static bool restartTransfer(CURLM *multi, HttpTransfer *transfer)
 {
-    CURLRaii curl;
-    bool ok = curl.init(request, callback, stream, headerCallback, headerStream)
-            && curl.setOption(CURLOPT_CUSTOMREQUEST, "DELETE")
-            && curl.setOption(CURLOPT_FOLLOWLOCATION, true)
-            && curl.perform(responseCode);
-    return ok ? 0 : 1;
+    fclose(transfer->file);
+    transfer->file = NULL;
+    if (transfer->headers)
+    {
+        curl_slist_free_all(transfer->headers);
+        transfer->headers = NULL;
+    }
+    curl_easy_reset(transfer->handle);
+    transfer->response->getResponseHeader()->clear();
+    transfer->ignoreRange = true;
+    transfer->bodyStarted = false;
+    transfer->keepBody = true;
+    transfer->receivedBytes = 0;
+    transfer->errorBuffer[0] = '\0';
+
+    return setupTransfer(transfer) && CURLM_OK == curl_multi_add_handle(multi, transfer->handle);
 }
 
+// Worker thread
+static THREAD_VOID networkThread(THREAD_VOID)
+{    
+    CURLM *multi = curl_multi_init();
+    HttpHandlePool pool;
+    std::vector<HttpTransfer*> active;
+    std::map<std::string, int> activePerHost;
+
+    while (true) 
+    {
+        if (need_quit)
+        {
+            break;
+        }
+
+        CCHttpClient *client = CCHttpClient::getInstance();
+        size_t maxPooled = (size_t)client->getMaxConcurrentRequests();
+        // keep enough connections alive for every concurrent request
+        curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)MAX(maxPooled, 8));
+
+        // step 1: start the queued requests allowed by the concurrency limits
+        startQueuedRequests(multi, active, activePerHost, &pool, maxPooled);
+
+        // step 2: let libcurl progress on all the running transfers
+        int running = 0;
+        while (CURLM_CALL_MULTI_PERFORM == curl_multi_perform(multi, &running))
+        {
+        }
+
+        // step 3: hand the finished transfers to the main thread
+        bool finished = false;
+        CURLMsg *msg = NULL;
+        int msgsLeft = 0;
+        while ((msg = curl_multi_info_read(multi, &msgsLeft)) != NULL)
+        {
+            if (msg->msg != CURLMSG_DONE)
+            {
+                continue;
+            }
+
+            CURL *handle = msg->easy_handle;
+            CURLcode result = msg->data.result;
+            HttpTransfer *transfer = NULL;
+            curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char**)&transfer);
+            curl_multi_remove_handle(multi, handle);
+
+            if (CURLE_RANGE_ERROR == result && transfer->resumeFrom > 0 && restartTransfer(multi, transfer))
+            {
+                CCLOG("CCHttpClient: %s doesn't support ranges, downloading the whole file", transfer->request->getUrl());
+                continue;
+            }
+
+            long responseCode = -1;
+            bool succeed = false;
+            if (CURLE_OK == result && CURLE_OK == curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &responseCode))
+            {
+                succeed = (responseCode == 200);
+                if (transfer->resumeFrom > 0)
+                {
+                    // libcurl answers 200 when the server ignores the range of a complete file
+                    succeed = succeed || responseCode == 206 || (responseCode == 416 && isDownloadComplete(transfer));
+                }
+            }
+            transfer->response->setResponseCode((int)responseCode);
+
+            --activePerHost[transfer->host];
+            active.erase(std::find(active.begin(), active.end(), transfer));
+            finishTransfer(transfer, succeed, &pool, maxPooled);
+            finished = true;
+        }
+
+        // step 4: sleep until there is something to do,
+        // unless finished transfers made room for queued requests
+        if (!finished)
+        {
+            waitForActivity(multi, active.size());
+        }
+    }
+
+    // cleanup: abort the running transfers
+    for (size_t i = 0; i < active.size(); ++i)
+    {
+        HttpTransfer *transfer = active[i];
+        curl_multi_remove_handle(multi, transfer->handle);
+        curl_easy_cleanup(transfer->handle);
+        if (transfer->headers)
+        {
+            curl_slist_free_all(transfer->headers);
+        }
+        if (transfer->file)
+        {
+            fclose(transfer->file);
+        }
+        transfer->response->release();
+        delete transfer;
+    }
+    s_asyncRequestCount -= active.size();
+    active.clear();
+    pool.clear();
+    curl_multi_cleanup(multi);
+    
+    // cleanup: if worker thread received quit signal, clean up un-completed request queue
+    pthread_mutex_lock(&s_requestQueueMutex);
+    s_asyncRequestCount -= s_requestQueue->count();
+    s_requestQueue->removeAllObjects();
+    pthread_mutex_unlock(&s_requestQueueMutex);
+    
+    if (s_requestQueue != NULL) {
+        
+        pthread_mutex_destroy(&s_requestQueueMutex);
+        pthread_mutex_destroy(&s_responseQueueMutex);
+        
+        pthread_mutex_destroy(&s_SleepMutex);
+        pthread_cond_destroy(&s_SleepCondition);
+
+        s_requestQueue->release();
+        s_requestQueue = NULL;
+        s_responseQueue->release();
+        s_responseQueue = NULL;
+    }
+
+    pthread_exit(NULL);
+    
+    return THREAD_RETURN;
+
+}
 // HttpClient implementation
 CCHttpClient* CCHttpClient::getInstance()
 {
@@ -414,6 +818,9 @@ CCArray* CCHttpClient::getRequestQueue() {
 CCHttpClient::CCHttpClient()
 : _timeoutForConnect(30)
 , _timeoutForRead(60)
+, _maxConcurrentRequests(6)
+, _maxConnectionsPerHost(4)
+, _dispatchTimeBudget(0.004f)
 {
     CCDirector::sharedDirector()->getScheduler()->scheduleSelector(
                     schedule_selector(CCHttpClient::dispatchResponseCallbacks), this, 0, false);
@@ -425,7 +832,9 @@ CCHttpClient::~CCHttpClient()
     need_quit = true;
     
     if (s_requestQueue != NULL) {
+        pthread_mutex_lock(&s_SleepMutex);
     	pthread_cond_signal(&s_SleepCondition);
+        pthread_mutex_unlock(&s_SleepMutex);
     }
     
     s_pHttpClient = NULL;
@@ -481,7 +890,19 @@ void CCHttpClient::send(CCHttpRequest* request)
     pthread_mutex_unlock(&s_requestQueueMutex);
     
     // Notify thread start to work
+    pthread_mutex_lock(&s_SleepMutex);
     pthread_cond_signal(&s_SleepCondition);
+    pthread_mutex_unlock(&s_SleepMutex);
+}
+
+void CCHttpClient::setMaxConcurrentRequests(int value)
+{
+    _maxConcurrentRequests = MAX(1, value);
+}
+
+void CCHttpClient::setMaxConnectionsPerHost(int value)
+{
+    _maxConnectionsPerHost = MAX(0, value);
 }
 
 // Poll and notify main thread if responses exists in queue
@@ -489,18 +910,50 @@ void CCHttpClient::dispatchResponseCallbacks(float delta)
 {
     // CCLog("CCHttpClient::dispatchResponseCallbacks is running");
     
-    CCHttpResponse* response = NULL;
-    
-    pthread_mutex_lock(&s_responseQueueMutex);
-    if (s_responseQueue->count())
-    {
-        response = dynamic_cast<CCHttpResponse*>(s_responseQueue->objectAtIndex(0));
-        s_responseQueue->removeObjectAtIndex(0);
-    }
-    pthread_mutex_unlock(&s_responseQueueMutex);
-    
-    if (response)
+    long long start = CCTime::getMonotonicTimeNs();
+    long long budget = (long long)(_dispatchTimeBudget * 1000000000.0);
+
+    // deliver every completed response, unless the callbacks exceed the frame budget
+    while (true)
     {
+        CCObject* pObject = NULL;
+
+        pthread_mutex_lock(&s_responseQueueMutex);
+        if (s_responseQueue->count())
+        {
+            pObject = s_responseQueue->objectAtIndex(0);
+            // the queue holds the only reference, keep it while the callback runs
+            pObject->retain();
+            s_responseQueue->removeObjectAtIndex(0);
+        }
+        pthread_mutex_unlock(&s_responseQueueMutex);
+
+        if (!pObject)
+        {
+            break;
+        }
+
+        HttpResponseChunk* chunk = dynamic_cast<HttpResponseChunk*>(pObject);
+        if (chunk)
+        {
+            CCHttpRequest *request = chunk->_response->getHttpRequest();
+            CCObject *pTarget = request->getChunkTarget();
+            SEL_HttpResponseChunk pSelector = request->getChunkSelector();
+            if (pTarget && pSelector)
+            {
+                (pTarget->*pSelector)(this, chunk->_response, &chunk->_data);
+            }
+            chunk->release();
+
+            if (budget > 0 && CCTime::getMonotonicTimeNs() - start >= budget)
+            {
+                break;
+            }
+            continue;
+        }
+
+        CCHttpResponse* response = (CCHttpResponse*)pObject;
+
         --s_asyncRequestCount;
         
         CCHttpRequest *request = response->getHttpRequest();
@@ -513,6 +966,11 @@ void CCHttpClient::dispatchResponseCallbacks(float delta)
         }
         
         response->release();
+
+        if (budget > 0 && CCTime::getMonotonicTimeNs() - start >= budget)
+        {
+            break;
+        }
     }
     
     if (0 == s_asyncRequestCount) 
@@ -94,6 +94,49 @@ public:
      * @return int
      */
     inline int getTimeoutForRead() {return _timeoutForRead;};
+
+    /**
+     * Change the number of requests processed at the same time, 6 by default
+     * @param value
+     * @return NULL
+     */
+    void setMaxConcurrentRequests(int value);
+
+    /**
+     * Get the number of requests processed at the same time
+     * @return int
+     */
+    inline int getMaxConcurrentRequests() {return _maxConcurrentRequests;};
+
+    /**
+     * Change the number of requests processed at the same time for a single host, 4 by default.
+     * Connections to a host are kept alive and reused by the following requests.
+     * 0 removes the limit.
+     * @param value
+     * @return NULL
+     */
+    void setMaxConnectionsPerHost(int value);
+
+    /**
+     * Get the number of requests processed at the same time for a single host
+     * @return int
+     */
+    inline int getMaxConnectionsPerHost() {return _maxConnectionsPerHost;};
+
+    /**
+     * Change the time the response callbacks may take in a frame, in seconds, 0.004 by default.
+     * All the completed responses are delivered in a frame unless their callbacks exceed it,
+     * the remaining ones are delivered in the next frames. 0 removes the limit.
+     * @param value
+     * @return NULL
+     */
+    inline void setDispatchTimeBudget(float value) {_dispatchTimeBudget = value;};
+
+    /**
+     * Get the time the response callbacks may take in a frame
+     * @return float
+     */
+    inline float getDispatchTimeBudget() {return _dispatchTimeBudget;};
         
 private:
     CCHttpClient();
@@ -111,6 +154,9 @@ private:
 private:
     int _timeoutForConnect;
     int _timeoutForRead;
+    int _maxConcurrentRequests;
+    int _maxConnectionsPerHost;
+    float _dispatchTimeBudget;
     
     // std::string reqId;
 };
@@ -38,6 +38,12 @@ typedef void (CCObject::*SEL_HttpResponseAux)(auxiliary::CCHttpClientAux * clien
 #define httpresponse_selector(_SELECTOR) (cocos2d::extension::SEL_HttpResponse)(&_SELECTOR)
 #define httpresponse_selector_aux(_SELECTOR) (cocos2d::extension::SEL_HttpResponseAux)(&_SELECTOR)
 
+/** Receives the body of a streamed response piece by piece, see CCHttpRequest::setResponseChunkCallback().
+    The callee may swap the chunk into its own buffer to keep it without a copy.
+ */
+typedef void (CCObject::*SEL_HttpResponseChunk)(CCHttpClient* client, CCHttpResponse* response, std::vector<char>* chunk);
+#define httpresponsechunk_selector(_SELECTOR) (cocos2d::extension::SEL_HttpResponseChunk)(&_SELECTOR)
+
 /** 
  @brief defines the object which users must packed for CCHttpClient::send(HttpRequest*) method.
  Please refer to samples/TestCpp/Classes/ExtensionTest/NetworkTest/HttpClientTest.cpp as a sample
@@ -81,6 +87,11 @@ public:
         _pSelector = NULL;
         _pSelectorAux = NULL;
         _pUserData = NULL;
+        _pChunkTarget = NULL;
+        _pChunkSelector = NULL;
+        _chunkSize = 0;
+        _downloadFile.clear();
+        _resumeDownload = false;
         
         retries = 5;
     };
@@ -92,6 +103,10 @@ public:
         {
             _pTarget->release();
         }
+        if (_pChunkTarget)
+        {
+            _pChunkTarget->release();
+        }
     };
     
     /** Override autorelease method to avoid developers to call it */
@@ -246,6 +261,66 @@ public:
         return _prxy_aux(_pSelectorAux);
     }
 
+    /** Option field. Streams the response body to the main thread instead of collecting it:
+        pSelector is called with consecutive pieces of about chunkSize bytes (16KB when 0),
+        always before the response callback, whose response data is then left empty.
+        It is ignored when a download file is set.
+     */
+    inline void setResponseChunkCallback(CCObject* pTarget, SEL_HttpResponseChunk pSelector, unsigned int chunkSize = 0)
+    {
+        if (pTarget)
+        {
+            pTarget->retain();
+        }
+        if (_pChunkTarget)
+        {
+            _pChunkTarget->release();
+        }
+        _pChunkTarget = pTarget;
+        _pChunkSelector = pSelector;
+        _chunkSize = chunkSize;
+    }
+
+    /** Get the target of the chunk callback, mainly used by CCHttpClient */
+    inline CCObject* getChunkTarget()
+    {
+        return _pChunkTarget;
+    }
+
+    /** Get the chunk callback, mainly used by CCHttpClient */
+    inline SEL_HttpResponseChunk getChunkSelector()
+    {
+        return _pChunkSelector;
+    }
+
+    /** Get the preferred chunk size, 0 for the default one */
+    inline unsigned int getChunkSize()
+    {
+        return _chunkSize;
+    }
+
+    /** Option field. Writes the response body to a file instead of memory, the response data is then left empty.
+        When resume is true and the file exists, only the missing part is requested with a http Range header,
+        the file is rewritten from the start if the server doesn't support ranges.
+     */
+    inline void setDownloadFile(const char* path, bool resume = false)
+    {
+        _downloadFile = path ? path : "";
+        _resumeDownload = resume;
+    }
+
+    /** Get the file the response body is written to, empty when downloading to memory */
+    inline const char* getDownloadFile()
+    {
+        return _downloadFile.c_str();
+    }
+
+    /** To see if a partially downloaded file is resumed */
+    inline bool isResumeDownload()
+    {
+        return _resumeDownload;
+    }
+
     /** Set any custom headers **/
     inline void setHeaders(std::vector<std::string> pHeaders)
    	{
@@ -270,6 +345,11 @@ protected:
     SEL_HttpResponseAux         _pSelectorAux;   /// callback function using auxiliary network channel, e.g. MyLayer::onHttpResponse(CCHttpClient *sender, CCHttpResponse * response)
     void*                       _pUserData;      /// You can add your customed data here 
     std::vector<std::string>    _headers;		 /// custom http headers
+    CCObject*                   _pChunkTarget;   /// callback target of _pChunkSelector
+    SEL_HttpResponseChunk       _pChunkSelector; /// streaming callback, e.g. MyLayer::onHttpChunk(CCHttpClient *sender, CCHttpResponse *response, std::vector<char> *chunk)
+    unsigned int                _chunkSize;      /// preferred size of the streamed chunks
+    std::string                 _downloadFile;   /// file the response body is written to
+    bool                        _resumeDownload; /// resume the download of an existing file with a Range request
 };
 
 NS_CC_EXT_END
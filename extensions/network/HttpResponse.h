@@ -53,6 +53,7 @@ public:
         }
         
         _succeed = false;
+        _receivedBytes = 0;
         _responseData.clear();
         _errorBuffer.clear();
     }
@@ -101,6 +102,23 @@ public:
         return &_responseData;
     }
     
+    /** Moves the response raw data into data without copying it, the response data is left empty.
+        Use it to keep a large body after the callback returns.
+     */
+    inline void takeResponseData(std::vector<char>& data)
+    {
+        data.clear();
+        data.swap(_responseData);
+    }
+    
+    /** Number of body bytes received, also counts the bytes streamed or written to a file.
+        For a resumed download, the bytes already in the file are not counted.
+     */
+    inline long long getReceivedBytes()
+    {
+        return _receivedBytes;
+    }
+    
     /** get the Rawheader **/
     inline std::vector<char>* getResponseHeader()
     {
@@ -143,6 +161,13 @@ public:
         _responseData = *data;
     }
     
+    /** Set the number of body bytes received, is used by CCHttpClient
+     */
+    inline void setReceivedBytes(long long value)
+    {
+        _receivedBytes = value;
+    }
+    
     /** Set the http response Header raw buffer, is used by CCHttpClient
      */
     inline void setResponseHeader(std::vector<char>* data)
@@ -176,6 +201,7 @@ protected:
     std::vector<char>   _responseData;  /// the returned raw data. You can also dump it as a string
     std::vector<char>   _responseHeader;  /// the returned raw header data. You can also dump it as a string
     int                 _responseCode;    /// the status code returned from libcurl, e.g. 200, 404
+    long long           _receivedBytes;   /// body bytes received, wherever they were delivered
     std::string         _errorBuffer;   /// if _responseCode != 200, please read _errorBuffer to find the reason 
     
 };
@@ -32,9 +32,36 @@
 #include <queue>
 #include <signal.h>
 #include <errno.h>
+#include <atomic>
+
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32)
+// the websocket thread blocks in poll() on the sockets of libwebsockets and on a wakeup descriptor
+#define WS_USE_EXTERNAL_POLL 1
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_TIZEN)
+#include <sys/eventfd.h>
+#define WS_USE_EVENTFD 1
+#endif
+#endif
+
+// longest time the websocket thread waits, libwebsockets checks its timeouts in between
+#define WS_POLL_TIMEOUT 1000
+// without a wakeup descriptor (win32) the messages to send wait at most this long, in ms
+#define WS_SERVICE_TIMEOUT_NO_WAKEUP 5
 
 NS_CC_EXT_BEGIN
 
+enum WS_MSG {
+    WS_MSG_TO_SUBTRHEAD_SENDING_STRING = 0,
+    WS_MSG_TO_SUBTRHEAD_SENDING_BINARY,
+    WS_MSG_TO_UITHREAD_OPEN,
+    WS_MSG_TO_UITHREAD_MESSAGE,
+    WS_MSG_TO_UITHREAD_ERROR,
+    WS_MSG_TO_UITHREAD_CLOSE
+};
+
 class WsMessage
 {
 public:
@@ -43,6 +70,86 @@ public:
     void* obj;
 };
 
+// Deletes a message and the data it carries
+static void deleteWsMessage(WsMessage* msg)
+{
+    if (WS_MSG_TO_SUBTRHEAD_SENDING_STRING == msg->what
+        || WS_MSG_TO_SUBTRHEAD_SENDING_BINARY == msg->what
+        || WS_MSG_TO_UITHREAD_MESSAGE == msg->what)
+    {
+        WebSocket::Data* data = (WebSocket::Data*)msg->obj;
+        if (data)
+        {
+            CC_SAFE_DELETE_ARRAY(data->bytes);
+            CC_SAFE_DELETE(data);
+        }
+    }
+    CC_SAFE_DELETE(msg);
+}
+
+/**
+ *  @brief Unbounded lock free queue between exactly one producer thread and one consumer thread.
+ *  The consumer always keeps a stub node, so push and pop never touch the same node.
+ */
+class WsMessageQueue
+{
+public:
+    WsMessageQueue()
+    {
+        _head = _tail = new Node();
+    }
+
+    ~WsMessageQueue()
+    {
+        while (WsMessage* msg = pop())
+        {
+            deleteWsMessage(msg);
+        }
+        delete _tail;
+    }
+
+    // Producer thread only
+    void push(WsMessage* msg)
+    {
+        Node* node = new Node();
+        node->msg = msg;
+        _head->next.store(node, std::memory_order_release);
+        _head = node;
+    }
+
+    // Consumer thread only, returns NULL when the queue is empty
+    WsMessage* pop()
+    {
+        Node* next = _tail->next.load(std::memory_order_acquire);
+        if (NULL == next)
+        {
+            return NULL;
+        }
+        WsMessage* msg = next->msg;
+        next->msg = NULL;
+        delete _tail;
+        _tail = next;
+        return msg;
+    }
+
+    // Consumer thread only
+    bool empty() const
+    {
+        return NULL == _tail->next.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Node
+    {
+        Node() : msg(NULL), next(NULL) {}
+        WsMessage* msg;
+        std::atomic<Node*> next;
+    };
+
+    Node* _head; // last pushed node, owned by the producer
+    Node* _tail; // stub node, owned by the consumer
+};
+
 /**
  *  @brief Websocket thread helper, it's used for sending message between UI thread and websocket thread.
  */
@@ -68,20 +175,34 @@ public:
     
     // Waits the sub-thread (websocket thread) to exit,
     void joinSubThread();
-    
+
+    // Interrupts the wait of the sub-thread, can be invoked in any thread.
+    void wakeUpSubThread();
+
+    // Waits for socket activity or a wakeup and lets libwebsockets process it. It's invoked in sub-thread.
+    void service(struct libwebsocket_context* ctx);
+
+    // Mirrors the poll array of libwebsockets, see LWS_CALLBACK_ADD_POLL_FD.
+    void addPollFd(int fd, short events);
+    void removePollFd(int fd);
+    void changePollFdEvents(int fd, short setEvents, short clearEvents);
     
 protected:
     friend class WsThreadEntry;
     void* wsThreadEntryFunc(void* arg);
     
 private:
-    std::list<WsMessage*>* _UIWsMessageQueue;
-    std::list<WsMessage*>* _subThreadWsMessageQueue;
-    pthread_mutex_t _UIWsMessageQueueMutex;
-    pthread_mutex_t _subThreadWsMessageQueueMutex;
+    WsMessageQueue* _UIWsMessageQueue;
+    WsMessageQueue* _subThreadWsMessageQueue;
     pthread_t  _subThreadInstance;
     WebSocket* _ws;
-    bool _needQuit;
+    volatile bool _needQuit;
+    bool _subThreadJoinable;
+    std::atomic<bool> _wakeUpPending;
+#ifdef WS_USE_EXTERNAL_POLL
+    int _wakeUpFds[2];  // read and write ends, the same eventfd twice when available
+    std::vector<struct pollfd> _pollFds;
+#endif
     friend class WebSocket;
 };
 
@@ -108,11 +229,28 @@ public:
 WsThreadHelper::WsThreadHelper()
 : _ws(NULL)
 , _needQuit(false)
+, _subThreadJoinable(false)
+, _wakeUpPending(false)
 {
-    _UIWsMessageQueue = new std::list<WsMessage*>();
-    pthread_mutex_init(&_UIWsMessageQueueMutex, NULL);
-    _subThreadWsMessageQueue = new std::list<WsMessage*>();
-    pthread_mutex_init(&_subThreadWsMessageQueueMutex, NULL);
+    _UIWsMessageQueue = new WsMessageQueue();
+    _subThreadWsMessageQueue = new WsMessageQueue();
+
+#ifdef WS_USE_EXTERNAL_POLL
+    _wakeUpFds[0] = _wakeUpFds[1] = -1;
+#ifdef WS_USE_EVENTFD
+    _wakeUpFds[0] = _wakeUpFds[1] = eventfd(0, EFD_NONBLOCK);
+#else
+    if (0 == pipe(_wakeUpFds))
+    {
+        fcntl(_wakeUpFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(_wakeUpFds[1], F_SETFL, O_NONBLOCK);
+    }
+#endif
+    if (_wakeUpFds[0] < 0)
+    {
+        CCLOGERROR("websocket: can't create the wakeup descriptor (%d)", errno);
+    }
+#endif
     
     CCDirector::sharedDirector()->getScheduler()->scheduleUpdateForTarget(this, 0, false);
 }
@@ -120,10 +258,19 @@ WsThreadHelper::WsThreadHelper()
 WsThreadHelper::~WsThreadHelper()
 {
     CCDirector::sharedDirector()->getScheduler()->unscheduleAllForTarget(this);
-    pthread_mutex_destroy(&_UIWsMessageQueueMutex);
-    pthread_mutex_destroy(&_subThreadWsMessageQueueMutex);
     delete _UIWsMessageQueue;
     delete _subThreadWsMessageQueue;
+
+#ifdef WS_USE_EXTERNAL_POLL
+    if (_wakeUpFds[0] >= 0)
+    {
+        close(_wakeUpFds[0]);
+    }
+    if (_wakeUpFds[1] >= 0 && _wakeUpFds[1] != _wakeUpFds[0])
+    {
+        close(_wakeUpFds[1]);
+    }
+#endif
 }
 
 // For converting static function to member function
@@ -147,6 +294,7 @@ bool WsThreadHelper::createThread(const WebSocket& ws)
     // Creates websocket thread
 	if (0 == pthread_create(&_subThreadInstance, &attr, WsThreadEntry::entry, this))
     {
+        _subThreadJoinable = true;
         return true;
     }
     return false;
@@ -176,57 +324,148 @@ void* WsThreadHelper::wsThreadEntryFunc(void* arg)
 
 void WsThreadHelper::sendMessageToUIThread(WsMessage *msg)
 {
-    pthread_mutex_lock(&_UIWsMessageQueueMutex);
-    _UIWsMessageQueue->push_back(msg);
-    pthread_mutex_unlock(&_UIWsMessageQueueMutex);
+    _UIWsMessageQueue->push(msg);
 }
 
 void WsThreadHelper::sendMessageToSubThread(WsMessage *msg)
 {
-    pthread_mutex_lock(&_subThreadWsMessageQueueMutex);
-    _subThreadWsMessageQueue->push_back(msg);
-    pthread_mutex_unlock(&_subThreadWsMessageQueueMutex);
+    _subThreadWsMessageQueue->push(msg);
+    wakeUpSubThread();
+}
+
+void WsThreadHelper::wakeUpSubThread()
+{
+#ifdef WS_USE_EXTERNAL_POLL
+    // one write is enough until the sub-thread drains the descriptor
+    if (_wakeUpFds[1] < 0 || _wakeUpPending.exchange(true))
+    {
+        return;
+    }
+#ifdef WS_USE_EVENTFD
+    uint64_t value = 1;
+#else
+    char value = 1;
+#endif
+    if (write(_wakeUpFds[1], &value, sizeof(value)) < 0 && errno != EAGAIN)
+    {
+        CCLOGERROR("websocket: can't wake up the websocket thread (%d)", errno);
+    }
+#endif
 }
 
 void WsThreadHelper::joinSubThread()
 {
+    if (!_subThreadJoinable)
+    {
+        return;
+    }
+    _subThreadJoinable = false;
+
+    wakeUpSubThread();
     void* ret = NULL;
     pthread_join(_subThreadInstance, &ret);
 }
 
-void WsThreadHelper::update(float dt)
+void WsThreadHelper::service(struct libwebsocket_context* ctx)
 {
-    WsMessage *msg = NULL;
+#ifdef WS_USE_EXTERNAL_POLL
+    // the wakeup descriptor comes last, libwebsockets may change the array while servicing
+    std::vector<struct pollfd> fds(_pollFds);
+    struct pollfd wakeUp;
+    wakeUp.fd = _wakeUpFds[0];
+    wakeUp.events = POLLIN;
+    wakeUp.revents = 0;
+    fds.push_back(wakeUp);
+
+    int ready = poll(&fds[0], fds.size(), _wakeUpFds[0] >= 0 ? WS_POLL_TIMEOUT : WS_SERVICE_TIMEOUT_NO_WAKEUP);
+    if (ready < 0 && errno != EINTR)
+    {
+        CCLOGERROR("websocket: poll failed (%d)", errno);
+    }
+
+    // timeouts of libwebsockets
+    libwebsocket_service_fd(ctx, NULL);
 
-    // Returns quickly if no message
-    pthread_mutex_lock(&_UIWsMessageQueueMutex);
-    if (0 == _UIWsMessageQueue->size())
+    for (size_t i = 0; ready > 0 && i + 1 < fds.size(); ++i)
     {
-        pthread_mutex_unlock(&_UIWsMessageQueueMutex);
-        return;
+        if (fds[i].revents)
+        {
+            --ready;
+            libwebsocket_service_fd(ctx, &fds[i]);
+        }
     }
-    
-    // Gets message
-    msg = *(_UIWsMessageQueue->begin());
-    _UIWsMessageQueue->pop_front();
-    pthread_mutex_unlock(&_UIWsMessageQueueMutex);
-    
-    if (_ws)
+
+    if (fds.back().revents & POLLIN)
     {
-        _ws->onUIThreadReceiveMessage(msg);
+        _wakeUpPending.store(false);
+#ifdef WS_USE_EVENTFD
+        uint64_t value;
+#else
+        char value[64];
+#endif
+        while (read(_wakeUpFds[0], &value, sizeof(value)) > 0)
+        {
+        }
     }
-    
-    CC_SAFE_DELETE(msg);
+#else
+    libwebsocket_service(ctx, WS_SERVICE_TIMEOUT_NO_WAKEUP);
+#endif
 }
 
-enum WS_MSG {
-    WS_MSG_TO_SUBTRHEAD_SENDING_STRING = 0,
-    WS_MSG_TO_SUBTRHEAD_SENDING_BINARY,
-    WS_MSG_TO_UITHREAD_OPEN,
-    WS_MSG_TO_UITHREAD_MESSAGE,
-    WS_MSG_TO_UITHREAD_ERROR,
-    WS_MSG_TO_UITHREAD_CLOSE
-};
+void WsThreadHelper::addPollFd(int fd, short events)
+{
+#ifdef WS_USE_EXTERNAL_POLL
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+    _pollFds.push_back(pfd);
+#endif
+}
+
+void WsThreadHelper::removePollFd(int fd)
+{
+#ifdef WS_USE_EXTERNAL_POLL
+    for (size_t i = 0; i < _pollFds.size(); ++i)
+    {
+        if (_pollFds[i].fd == fd)
+        {
+            _pollFds.erase(_pollFds.begin() + i);
+            break;
+        }
+    }
+#endif
+}
+
+void WsThreadHelper::changePollFdEvents(int fd, short setEvents, short clearEvents)
+{
+#ifdef WS_USE_EXTERNAL_POLL
+    for (size_t i = 0; i < _pollFds.size(); ++i)
+    {
+        if (_pollFds[i].fd == fd)
+        {
+            _pollFds[i].events = (_pollFds[i].events | setEvents) & ~clearEvents;
+            break;
+        }
+    }
+#endif
+}
+
+void WsThreadHelper::update(float dt)
+{
+    // Dispatches every message received since the last frame,
+    // stops as soon as the websocket is deleted by a delegate callback.
+    while (_ws)
+    {
+        WsMessage *msg = _UIWsMessageQueue->pop();
+        if (NULL == msg)
+        {
+            break;
+        }
+        _ws->onUIThreadReceiveMessage(msg);
+        deleteWsMessage(msg);
+    }
+}
 
 WebSocket::WebSocket()
 : _readyState(kStateConnecting)
@@ -237,12 +476,21 @@ WebSocket::WebSocket()
 , _delegate(NULL)
 , _SSLConnection(0)
 , _wsProtocols(NULL)
+, _pendingData(NULL)
+, _pendingDataCapacity(0)
 {
 }
 
 WebSocket::~WebSocket()
 {
     close();
+    if (_wsHelper)
+    {
+        // the thread may still run when the server closed the connection
+        _wsHelper->joinSubThread();
+        // messages which are not dispatched yet mustn't reach this instance anymore
+        _wsHelper->_ws = NULL;
+    }
     CC_SAFE_RELEASE_NULL(_wsHelper);
     
     for (int i = 0; _wsProtocols[i].callback != NULL; ++i) {
@@ -344,8 +592,10 @@ void WebSocket::send(const std::string& message)
         WsMessage* msg = new WsMessage();
         msg->what = WS_MSG_TO_SUBTRHEAD_SENDING_STRING;
         Data* data = new Data();
-        data->bytes = new char[message.length()+1];
-        strcpy(data->bytes, message.c_str());
+        // the padding libwebsockets needs for the frame header is reserved here,
+        // so the websocket thread sends this buffer without copying it again
+        data->bytes = new char[LWS_SEND_BUFFER_PRE_PADDING + message.length() + LWS_SEND_BUFFER_POST_PADDING];
+        memcpy(data->bytes + LWS_SEND_BUFFER_PRE_PADDING, message.c_str(), message.length());
         data->len = message.length();
         msg->obj = data;
         _wsHelper->sendMessageToSubThread(msg);
@@ -362,9 +612,10 @@ void WebSocket::send(const unsigned char* binaryMsg, unsigned int len)
         WsMessage* msg = new WsMessage();
         msg->what = WS_MSG_TO_SUBTRHEAD_SENDING_BINARY;
         Data* data = new Data();
-        data->bytes = new char[len];
-        memcpy((void*)data->bytes, (void*)binaryMsg, len);
+        data->bytes = new char[LWS_SEND_BUFFER_PRE_PADDING + len + LWS_SEND_BUFFER_POST_PADDING];
+        memcpy((void*)(data->bytes + LWS_SEND_BUFFER_PRE_PADDING), (void*)binaryMsg, len);
         data->len = len;
+        data->isBinary = true;
         msg->obj = data;
         _wsHelper->sendMessageToSubThread(msg);
     }
@@ -394,24 +645,20 @@ WebSocket::State WebSocket::getReadyState()
 
 int WebSocket::onSubThreadLoop()
 {
-    if (_readyState == kStateClosed || _readyState == kStateClosing)
+    if (_readyState == kStateClosed || _readyState == kStateClosing || NULL == _wsContext)
     {
-        libwebsocket_context_destroy(_wsContext);
         // return 1 to exit the loop.
         return 1;
     }
     
-    if (_wsContext && _readyState != kStateClosed && _readyState != kStateClosing)
+    // Blocks until the sockets are ready or the UI thread sends a message
+    _wsHelper->service(_wsContext);
+
+    if (_wsInstance && _readyState == kStateOpen && !_wsHelper->_subThreadWsMessageQueue->empty())
     {
-        libwebsocket_service(_wsContext, 0);
+        libwebsocket_callback_on_writable(_wsContext, _wsInstance);
     }
-    
-    // Sleep 50 ms
-#ifdef WIN32
-	Sleep(50);
-#else
-    usleep(50000);
-#endif
+
     // return 0 to continue the loop.
     return 0;
 }
@@ -454,11 +701,28 @@ void WebSocket::onSubThreadStarted()
                                              _path.c_str(), _host.c_str(), _host.c_str(),
                                              name.c_str(), -1);
 	}
+    else
+    {
+        WsMessage* msg = new WsMessage();
+        msg->what = WS_MSG_TO_UITHREAD_ERROR;
+        _readyState = kStateClosing;
+        _wsHelper->sendMessageToUIThread(msg);
+    }
 }
 
 void WebSocket::onSubThreadEnded()
 {
+    if (_wsContext)
+    {
+        libwebsocket_context_destroy(_wsContext);
+        _wsContext = NULL;
+    }
 
+    if (_pendingData)
+    {
+        CC_SAFE_DELETE_ARRAY(_pendingData->bytes);
+        CC_SAFE_DELETE(_pendingData);
+    }
 }
 
 int WebSocket::onSocketCallback(struct libwebsocket_context *ctx,
@@ -472,10 +736,27 @@ int WebSocket::onSocketCallback(struct libwebsocket_context *ctx,
 
 	switch (reason)
     {
+        case LWS_CALLBACK_ADD_POLL_FD:
+            _wsHelper->addPollFd((int)(long)in, (short)len);
+            break;
+
+        case LWS_CALLBACK_SET_MODE_POLL_FD:
+            _wsHelper->changePollFdEvents((int)(long)in, (short)len, 0);
+            break;
+
+        case LWS_CALLBACK_CLEAR_MODE_POLL_FD:
+            _wsHelper->changePollFdEvents((int)(long)in, 0, (short)len);
+            break;
+
         case LWS_CALLBACK_DEL_POLL_FD:
         case LWS_CALLBACK_PROTOCOL_DESTROY:
         case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
             {
+                if (reason == LWS_CALLBACK_DEL_POLL_FD)
+                {
+                    _wsHelper->removePollFd((int)(long)in);
+                }
+
                 WsMessage* msg = NULL;
                 if (reason == LWS_CALLBACK_CLIENT_CONNECTION_ERROR
                     || (reason == LWS_CALLBACK_PROTOCOL_DESTROY && _readyState == kStateConnecting)
@@ -514,25 +795,21 @@ int WebSocket::onSocketCallback(struct libwebsocket_context *ctx,
             
         case LWS_CALLBACK_CLIENT_WRITEABLE:
             {
-                pthread_mutex_lock(&_wsHelper->_subThreadWsMessageQueueMutex);
-                std::list<WsMessage*>::iterator iter = _wsHelper->_subThreadWsMessageQueue->begin();
-                
-                int bytesWrite = 0;
-                for (; iter != _wsHelper->_subThreadWsMessageQueue->end(); ++iter) {
+                // Sends the queued messages until the socket buffer is full,
+                // onSubThreadLoop asks for another writable callback if some are left.
+                while (!lws_send_pipe_choked(wsi))
+                {
+                    WsMessage* subThreadMsg = _wsHelper->_subThreadWsMessageQueue->pop();
+                    if (NULL == subThreadMsg)
+                    {
+                        break;
+                    }
 
-                    WsMessage* subThreadMsg = *iter;
-                    
                     if ( WS_MSG_TO_SUBTRHEAD_SENDING_STRING == subThreadMsg->what
                       || WS_MSG_TO_SUBTRHEAD_SENDING_BINARY == subThreadMsg->what)
                     {
                         Data* data = (Data*)subThreadMsg->obj;
 
-                        unsigned char* buf = new unsigned char[LWS_SEND_BUFFER_PRE_PADDING
-                                                               + data->len + LWS_SEND_BUFFER_POST_PADDING];
-                        
-                        memset(&buf[LWS_SEND_BUFFER_PRE_PADDING], 0, data->len);
-                        memcpy((char*)&buf[LWS_SEND_BUFFER_PRE_PADDING], data->bytes, data->len);
-                        
                         enum libwebsocket_write_protocol writeProtocol;
                         
                         if (WS_MSG_TO_SUBTRHEAD_SENDING_STRING == subThreadMsg->what)
@@ -544,7 +821,9 @@ int WebSocket::onSocketCallback(struct libwebsocket_context *ctx,
                             writeProtocol = LWS_WRITE_BINARY;
                         }
                         
-                        bytesWrite = libwebsocket_write(wsi,  &buf[LWS_SEND_BUFFER_PRE_PADDING], data->len, writeProtocol);
+                        // the buffer was allocated with the padding by send()
+                        unsigned char* buf = (unsigned char*)data->bytes;
+                        int bytesWrite = libwebsocket_write(wsi,  &buf[LWS_SEND_BUFFER_PRE_PADDING], data->len, writeProtocol);
                         
                         if (bytesWrite < 0) {
                             CCLOGERROR("%s", "libwebsocket_write error...");
@@ -552,22 +831,10 @@ int WebSocket::onSocketCallback(struct libwebsocket_context *ctx,
                         if (bytesWrite < data->len) {
                             CCLOGERROR("Partial write LWS_CALLBACK_CLIENT_WRITEABLE\n");
                         }
-                        
-                        CC_SAFE_DELETE_ARRAY(data->bytes);
-                        CC_SAFE_DELETE(data);
-                        CC_SAFE_DELETE_ARRAY(buf);
                     }
                     
-                    CC_SAFE_DELETE(subThreadMsg);
+                    deleteWsMessage(subThreadMsg);
                 }
-
-                _wsHelper->_subThreadWsMessageQueue->clear();
-                
-                pthread_mutex_unlock(&_wsHelper->_subThreadWsMessageQueueMutex);
-                
-                /* get notified as soon as we can write again */
-                
-                libwebsocket_callback_on_writable(ctx, wsi);
             }
             break;
             
@@ -592,32 +859,41 @@ int WebSocket::onSocketCallback(struct libwebsocket_context *ctx,
             {
                 if (in && len > 0)
                 {
-                    WsMessage* msg = new WsMessage();
-                    msg->what = WS_MSG_TO_UITHREAD_MESSAGE;
-                    
-                    char* bytes = NULL;
-                    Data* data = new Data();
-                    
-                    if (lws_frame_is_binary(wsi))
+                    // A message may arrive in several fragments, they are gathered in one buffer
+                    // which is then handed to the UI thread as is.
+                    size_t remaining = libwebsockets_remaining_packet_payload(wsi);
+                    if (NULL == _pendingData)
                     {
-                        
-                        bytes = new char[len];
-                        data->isBinary = true;
+                        _pendingData = new Data();
+                        _pendingData->isBinary = lws_frame_is_binary(wsi) ? true : false;
+                        // room for the whole frame and the terminating '\0' of a text message
+                        _pendingDataCapacity = len + remaining + 1;
+                        _pendingData->bytes = new char[_pendingDataCapacity];
                     }
-                    else
+                    else if (_pendingData->len + len + remaining + 1 > _pendingDataCapacity)
                     {
-                        bytes = new char[len+1];
-                        bytes[len] = '\0';
-                        data->isBinary = false;
+                        _pendingDataCapacity = MAX(_pendingDataCapacity * 2, _pendingData->len + len + remaining + 1);
+                        char* bytes = new char[_pendingDataCapacity];
+                        memcpy(bytes, _pendingData->bytes, _pendingData->len);
+                        delete [] _pendingData->bytes;
+                        _pendingData->bytes = bytes;
                     }
 
-                    memcpy(bytes, in, len);
-                    
-                    data->bytes = bytes;
-                    data->len = len;
-                    msg->obj = (void*)data;
-                    
-                    _wsHelper->sendMessageToUIThread(msg);
+                    memcpy(_pendingData->bytes + _pendingData->len, in, len);
+                    _pendingData->len += len;
+
+                    if (0 == remaining && libwebsocket_is_final_fragment(wsi))
+                    {
+                        _pendingData->bytes[_pendingData->len] = '\0';
+
+                        WsMessage* msg = new WsMessage();
+                        msg->what = WS_MSG_TO_UITHREAD_MESSAGE;
+                        msg->obj = (void*)_pendingData;
+                        _pendingData = NULL;
+                        _pendingDataCapacity = 0;
+                        
+                        _wsHelper->sendMessageToUIThread(msg);
+                    }
                 }
             }
             break;
@@ -639,10 +915,9 @@ void WebSocket::onUIThreadReceiveMessage(WsMessage* msg)
             break;
         case WS_MSG_TO_UITHREAD_MESSAGE:
             {
+                // the data is deleted with the message
                 Data* data = (Data*)msg->obj;
                 _delegate->onMessage(this, *data);
-                CC_SAFE_DELETE_ARRAY(data->bytes);
-                CC_SAFE_DELETE(data);
             }
             break;
         case WS_MSG_TO_UITHREAD_CLOSE:
@@ -163,6 +163,10 @@ private:
     Delegate* _delegate;
     int _SSLConnection;
     struct libwebsocket_protocols* _wsProtocols;
+
+    // message being received in several fragments, only used by the websocket thread
+    Data* _pendingData;
+    size_t _pendingDataCapacity;
 };
 
 NS_CC_EXT_END
@@ -25,6 +25,15 @@
 
 #include <spine/CCSkeleton.h>
 #include <spine/spine-cocos2dx.h>
+#include <spine/SkeletonBinary.h>
+#include <spine/extension.h>
+#include <map>
+#ifndef EMSCRIPTEN
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#endif
 
 using namespace std;
 USING_NS_CC;
@@ -33,6 +42,285 @@ using std::max;
 
 namespace cocos2d { namespace extension {
 
+// The batch stream indices are GLushort, 4 vertices per quad.
+#define SKELETON_BATCH_MAX_QUADS 16384
+
+// Quads of the skeletons drawn with batchRendering, in eye coordinates.
+static CCTextureAtlas* batchAtlas = 0;
+static CCGLProgram* batchShader = 0;
+static ccBlendFunc batchBlendFunc;
+// The atlas is released with the last skeleton.
+static unsigned int skeletonCount = 0;
+
+static void flushSkeletonBatch () {
+	if (!batchAtlas || batchAtlas->getTotalQuads() == 0) return;
+
+	kmGLMatrixMode(KM_GL_MODELVIEW);
+	kmGLPushMatrix();
+	kmGLLoadIdentity();
+	batchShader->use();
+	batchShader->setUniformsForBuiltins();
+	ccGLBlendFunc(batchBlendFunc.src, batchBlendFunc.dst);
+	batchAtlas->drawQuads();
+	batchAtlas->removeAllQuads();
+	kmGLPopMatrix();
+
+	// don't keep the page alive
+	batchAtlas->setTexture(0);
+}
+
+static void transformQuad (ccV3F_C4B_T2F_Quad* quad, const kmMat4* m) {
+	ccV3F_C4B_T2F* corners[4] = {&quad->tl, &quad->bl, &quad->tr, &quad->br};
+	for (int i = 0; i < 4; i++) {
+		ccVertex3F* v = &corners[i]->vertices;
+		float x = v->x, y = v->y, z = v->z;
+		v->x = m->mat[0] * x + m->mat[4] * y + m->mat[8] * z + m->mat[12];
+		v->y = m->mat[1] * x + m->mat[5] * y + m->mat[9] * z + m->mat[13];
+		v->z = m->mat[2] * x + m->mat[6] * y + m->mat[10] * z + m->mat[14];
+	}
+}
+
+// SkeletonData and Atlas loaded from files, shared by the skeletons created with the same files and scale. Entries no
+// skeleton references are kept until removeUnusedSkeletonData so spawning again doesn't reload them.
+struct SkeletonDataCacheEntry {
+	SkeletonData* skeletonData;
+	Atlas* atlas;
+	int referenceCount;
+};
+typedef map<string, SkeletonDataCacheEntry> SkeletonDataCache;
+static SkeletonDataCache skeletonDataCache;
+
+static string skeletonDataCacheKey (const char* skeletonDataFile, const char* atlasFile, float scale) {
+	CCFileUtils* fileUtils = CCFileUtils::sharedFileUtils();
+	char scaleString[32];
+	sprintf(scaleString, "%.9g", scale);
+	return fileUtils->fullPathForFilename(skeletonDataFile) + '\n' + fileUtils->fullPathForFilename(atlasFile) + '\n' + scaleString;
+}
+
+// Reads either the JSON or the binary format written by tools/spine-binary.
+static SkeletonData* readSkeletonDataFile (const char* skeletonDataFile, Atlas* atlas, float scale) {
+	int length;
+	SkeletonData* skeletonData;
+	char* data = _Util_readFile(skeletonDataFile, &length);
+	CCAssert(data, "Error reading skeleton data file.");
+	if (!data) return 0;
+
+	if (SkeletonBinary_isBinary(data, length)) {
+		SkeletonBinary* binary = SkeletonBinary_create(atlas);
+		binary->scale = scale;
+		skeletonData = SkeletonBinary_readSkeletonData(binary, data, length);
+		CCAssert(skeletonData, binary->error ? binary->error : "Error reading skeleton data file.");
+		SkeletonBinary_dispose(binary);
+	} else {
+		SkeletonJson* json = SkeletonJson_create(atlas);
+		json->scale = scale;
+		skeletonData = SkeletonJson_readSkeletonData(json, data);
+		CCAssert(skeletonData, json->error ? json->error : "Error reading skeleton data file.");
+		SkeletonJson_dispose(json);
+	}
+	FREE(data);
+	return skeletonData;
+}
+
+// Returns the cache entry, loading the files if needed. The caller takes a reference.
+static SkeletonDataCacheEntry* addSkeletonData (const string& key, const char* skeletonDataFile, const char* atlasFile,
+		float scale) {
+	SkeletonDataCache::iterator it = skeletonDataCache.find(key);
+	if (it != skeletonDataCache.end()) return &it->second;
+
+	Atlas* atlas = Atlas_readAtlasFile(atlasFile);
+	CCAssert(atlas, "Error reading atlas file.");
+	if (!atlas) return 0;
+
+	SkeletonData* skeletonData = readSkeletonDataFile(skeletonDataFile, atlas, scale);
+	if (!skeletonData) {
+		Atlas_dispose(atlas);
+		return 0;
+	}
+
+	SkeletonDataCacheEntry& entry = skeletonDataCache[key];
+	entry.skeletonData = skeletonData;
+	entry.atlas = atlas;
+	entry.referenceCount = 0;
+	return &entry;
+}
+
+void CCSkeleton::preloadSkeletonData (const char* skeletonDataFile, const char* atlasFile, float scale) {
+	addSkeletonData(skeletonDataCacheKey(skeletonDataFile, atlasFile, scale), skeletonDataFile, atlasFile, scale);
+}
+
+void CCSkeleton::removeUnusedSkeletonData () {
+	for (SkeletonDataCache::iterator it = skeletonDataCache.begin(); it != skeletonDataCache.end();) {
+		if (it->second.referenceCount == 0) {
+			SkeletonData_dispose(it->second.skeletonData);
+			Atlas_dispose(it->second.atlas);
+			skeletonDataCache.erase(it++);
+		} else
+			++it;
+	}
+}
+
+// Skeletons whose pose is computed by updateQueuedSkeletons, a skeleton deleted while queued leaves a null entry.
+static vector<CCSkeleton*> queuedSkeletons;
+static unsigned int parallelUpdateThreads = 0;
+static unsigned int parallelUpdateThreshold = 64;
+
+#ifndef EMSCRIPTEN
+// Skeletons handed to a thread at once, posing one takes long enough to keep it small.
+#define SKELETON_UPDATE_CHUNK 4
+
+// Runs a job on count indices with the worker threads and the calling thread, returns once all are done.
+// run() also waits for every worker to take the generation, so none is left holding the count of a previous one.
+class SkeletonUpdatePool {
+public:
+	SkeletonUpdatePool (unsigned int threads) : job(0), count(0), next(0), generation(0), started(0), active(0), quit(false) {
+		for (unsigned int i = 0; i < threads; ++i)
+			this->threads.push_back(std::thread(&SkeletonUpdatePool::threadLoop, this));
+	}
+
+	~SkeletonUpdatePool () {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < threads.size(); ++i)
+			threads[i].join();
+	}
+
+	void run (void (*job) (unsigned int index), unsigned int count) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			this->job = job;
+			this->count = count;
+			next = 0;
+			started = 0;
+			++generation;
+		}
+		wake.notify_all();
+
+		runChunks(job, count);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return started == threads.size() && active == 0; });
+	}
+
+private:
+	void runChunks (void (*job) (unsigned int index), unsigned int count) {
+		for (;;) {
+			unsigned int first = next.fetch_add(SKELETON_UPDATE_CHUNK);
+			if (first >= count) break;
+			unsigned int last = min(first + SKELETON_UPDATE_CHUNK, count);
+			for (unsigned int i = first; i < last; ++i)
+				job(i);
+		}
+	}
+
+	void threadLoop () {
+		unsigned int seen = 0;
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+			wake.wait(lock, [&] { return quit || generation != seen; });
+			if (quit) break;
+			seen = generation;
+			void (*job) (unsigned int index) = this->job;
+			unsigned int count = this->count;
+			++started;
+			++active;
+			lock.unlock();
+
+			runChunks(job, count);
+
+			lock.lock();
+			if (--active == 0 && started == threads.size()) done.notify_all();
+		}
+	}
+
+	vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	void (*job) (unsigned int index);
+	unsigned int count;
+	std::atomic<unsigned int> next;
+	unsigned int generation;
+	unsigned int started;
+	unsigned int active;
+	bool quit;
+};
+
+static SkeletonUpdatePool* updatePool = 0;
+#endif
+
+void CCSkeleton::setParallelUpdateThreads (unsigned int threads) {
+	// don't leave queued skeletons without a pose
+	updateQueuedSkeletons();
+#ifndef EMSCRIPTEN
+	if (threads != parallelUpdateThreads) CC_SAFE_DELETE(updatePool);
+#endif
+	parallelUpdateThreads = threads;
+}
+
+void CCSkeleton::setParallelUpdateThreshold (unsigned int count) {
+	parallelUpdateThreshold = count;
+}
+
+void CCSkeleton::updateQueuedSkeleton (unsigned int index) {
+	CCSkeleton* skeleton = queuedSkeletons[index];
+	if (skeleton && skeleton->updateQueued) skeleton->updatePose(skeleton->queuedDeltaTime);
+}
+
+void CCSkeleton::updateQueuedSkeletons () {
+	unsigned int count = queuedSkeletons.size();
+	if (count == 0) return;
+
+#ifndef EMSCRIPTEN
+	if (parallelUpdateThreads > 0 && count >= parallelUpdateThreshold) {
+		if (!updatePool) updatePool = new SkeletonUpdatePool(parallelUpdateThreads);
+		updatePool->run(updateQueuedSkeleton, count);
+	} else
+#endif
+	{
+		for (unsigned int i = 0; i < count; ++i)
+			updateQueuedSkeleton(i);
+	}
+
+	for (unsigned int i = 0; i < count; ++i) {
+		CCSkeleton* skeleton = queuedSkeletons[i];
+		if (!skeleton) continue;
+		skeleton->updateQueueIndex = -1;
+		skeleton->updateQueued = false;
+		skeleton->queuedDeltaTime = 0;
+	}
+	queuedSkeletons.clear();
+}
+
+bool CCSkeleton::queueUpdate (float deltaTime) {
+	if (parallelUpdateThreads == 0) return false;
+	if (updateQueueIndex < 0) {
+		updateQueueIndex = queuedSkeletons.size();
+		queuedSkeletons.push_back(this);
+	}
+	updateQueued = true;
+	queuedDeltaTime += deltaTime;
+	return true;
+}
+
+void CCSkeleton::finishUpdate () {
+	if (!updateQueued) return;
+	// the entry stays in the queue and is skipped
+	updateQueued = false;
+	updatePose(queuedDeltaTime);
+	queuedDeltaTime = 0;
+}
+
+void CCSkeleton::updatePose (float deltaTime) {
+}
+
+bool CCSkeleton::isCulled () const {
+	return !m_visible;
+}
+
 CCSkeleton* CCSkeleton::createWithData (SkeletonData* skeletonData, bool ownsSkeletonData) {
 	CCSkeleton* node = new CCSkeleton(skeletonData, ownsSkeletonData);
 	node->autorelease();
@@ -52,9 +340,14 @@ CCSkeleton* CCSkeleton::createWithFile (const char* skeletonDataFile, const char
 }
 
 void CCSkeleton::initialize () {
+	skeletonCount++;
 	atlas = 0;
 	debugSlots = false;
 	debugBones = false;
+	batchRendering = false;
+	updateQueueIndex = -1;
+	updateQueued = false;
+	queuedDeltaTime = 0;
 	timeScale = 1;
 
 	blendFunc.src = GL_ONE;
@@ -85,11 +378,7 @@ CCSkeleton::CCSkeleton (SkeletonData *skeletonData, bool ownsSkeletonData) {
 CCSkeleton::CCSkeleton (const char* skeletonDataFile, Atlas* atlas, float scale) {
 	initialize();
 
-	SkeletonJson* json = SkeletonJson_create(atlas);
-	json->scale = scale;
-	SkeletonData* skeletonData = SkeletonJson_readSkeletonDataFile(json, skeletonDataFile);
-	CCAssert(skeletonData, json->error ? json->error : "Error reading skeleton data.");
-	SkeletonJson_dispose(json);
+	SkeletonData* skeletonData = readSkeletonDataFile(skeletonDataFile, atlas, scale);
 
 	setSkeletonData(skeletonData, true);
 }
@@ -97,23 +386,26 @@ CCSkeleton::CCSkeleton (const char* skeletonDataFile, Atlas* atlas, float scale)
 CCSkeleton::CCSkeleton (const char* skeletonDataFile, const char* atlasFile, float scale) {
 	initialize();
 
-	atlas = Atlas_readAtlasFile(atlasFile);
-	CCAssert(atlas, "Error reading atlas file.");
-
-	SkeletonJson* json = SkeletonJson_create(atlas);
-	json->scale = scale;
-	SkeletonData* skeletonData = SkeletonJson_readSkeletonDataFile(json, skeletonDataFile);
-	CCAssert(skeletonData, json->error ? json->error : "Error reading skeleton data file.");
-	SkeletonJson_dispose(json);
+	cacheKey = skeletonDataCacheKey(skeletonDataFile, atlasFile, scale);
+	SkeletonDataCacheEntry* entry = addSkeletonData(cacheKey, skeletonDataFile, atlasFile, scale);
+	entry->referenceCount++;
 
-	setSkeletonData(skeletonData, true);
+	setSkeletonData(entry->skeletonData, false);
 }
 
 CCSkeleton::~CCSkeleton () {
     unschedule(schedule_selector(CCSprite::checkCoolingOffscreen));
+	if (updateQueueIndex >= 0) queuedSkeletons[updateQueueIndex] = 0;
 	if (ownsSkeletonData) SkeletonData_dispose(skeleton->data);
 	if (atlas) Atlas_dispose(atlas);
+	if (!cacheKey.empty()) skeletonDataCache[cacheKey].referenceCount--;
 	Skeleton_dispose(skeleton);
+
+	if (--skeletonCount == 0 && batchAtlas) {
+		ccGLFlushDeferredDraw();
+		CC_SAFE_RELEASE_NULL(batchAtlas);
+		batchShader = 0;
+	}
 }
 
 void CCSkeleton::update (float deltaTime) {
@@ -121,14 +413,13 @@ void CCSkeleton::update (float deltaTime) {
 }
 
 void CCSkeleton::draw () {
+	// the first skeleton drawn poses all the queued ones
+	updateQueuedSkeletons();
 
     if (!m_visible) {
         return;
     }
     
-	CC_NODE_DRAW_SETUP();
-
-	ccGLBlendFunc(blendFunc.src, blendFunc.dst);
 	ccColor3B color = getColor();
 	skeleton->r = color.r / (float)255;
 	skeleton->g = color.g / (float)255;
@@ -140,49 +431,76 @@ void CCSkeleton::draw () {
 		skeleton->b *= skeleton->a;
 	}
 
-	CCTextureAtlas* textureAtlas = 0;
+	bool filterSlots = !slotFilter.empty();
+
 	ccV3F_C4B_T2F_Quad quad;
 	quad.tl.vertices.z = 0;
 	quad.tr.vertices.z = 0;
 	quad.bl.vertices.z = 0;
 	quad.br.vertices.z = 0;
-	for (int i = 0, n = skeleton->slotCount; i < n; i++) {
-		Slot* slot = skeleton->slots[i];
 
-        //@PlusPingya - Hide bones that are not specified, and only if any were specified
-        if (renderSpecificBones.size() > 0) {
-            bool _found = false;
-            for (vector<string>::iterator it=renderSpecificBones.begin(); it!=renderSpecificBones.end(); ++it) {
-                string _bone_name = (string)(*it);
-                if (slot->bone) {
-                    if (strcmp(slot->bone->data->name, _bone_name.c_str())==0) {
-                        _found = true;
-                    }
-                }
-            }
-            if (!_found) {
-                continue;
-            }
-        }
-        
-		if (!slot->attachment || slot->attachment->type != ATTACHMENT_REGION) continue;
-		RegionAttachment* attachment = (RegionAttachment*)slot->attachment;
-		CCTextureAtlas* regionTextureAtlas = getTextureAtlas(attachment);
-		if (regionTextureAtlas != textureAtlas) {
-			if (textureAtlas) {
-				textureAtlas->drawQuads();
-				textureAtlas->removeAllQuads();
+	if (batchRendering) {
+		kmMat4 modelview;
+		kmGLGetMatrix(KM_GL_MODELVIEW, &modelview);
+		CCGLProgram* shader = getShaderProgram();
+		if (!batchAtlas) {
+			batchAtlas = new CCTextureAtlas();
+			batchAtlas->initWithTexture(0, 256);
+		}
+
+		for (int i = 0, n = skeleton->slotCount; i < n; i++) {
+			//@PlusPingya - Hide bones that are not specified, and only if any were specified
+			if (filterSlots && !slotFilter[i]) continue;
+			Slot* slot = skeleton->slots[i];
+			if (!slot->attachment || slot->attachment->type != ATTACHMENT_REGION) continue;
+			RegionAttachment* attachment = (RegionAttachment*)slot->attachment;
+			CCTexture2D* texture = getTextureAtlas(attachment)->getTexture();
+			if (texture != batchAtlas->getTexture() || shader != batchShader
+				|| blendFunc.src != batchBlendFunc.src || blendFunc.dst != batchBlendFunc.dst) {
+				ccGLFlushDeferredDraw();
+				batchAtlas->setTexture(texture);
+				batchShader = shader;
+				batchBlendFunc = blendFunc;
+			}
+			if (batchAtlas->getCapacity() == batchAtlas->getTotalQuads()) {
+				if (batchAtlas->getCapacity() * 2 > SKELETON_BATCH_MAX_QUADS || !batchAtlas->resizeCapacity(batchAtlas->getCapacity() * 2)) {
+					ccGLFlushDeferredDraw();
+					batchAtlas->setTexture(texture);
+				}
 			}
+			RegionAttachment_updateQuad(attachment, slot, &quad, premultipliedAlpha);
+			transformQuad(&quad, &modelview);
+			batchAtlas->updateQuad(&quad, batchAtlas->getTotalQuads());
+			ccGLSetDeferredDraw(flushSkeletonBatch);
+		}
+	} else {
+		CC_NODE_DRAW_SETUP();
+		ccGLBlendFunc(blendFunc.src, blendFunc.dst);
+
+		CCTextureAtlas* textureAtlas = 0;
+		for (int i = 0, n = skeleton->slotCount; i < n; i++) {
+			//@PlusPingya - Hide bones that are not specified, and only if any were specified
+			if (filterSlots && !slotFilter[i]) continue;
+			Slot* slot = skeleton->slots[i];
+			if (!slot->attachment || slot->attachment->type != ATTACHMENT_REGION) continue;
+			RegionAttachment* attachment = (RegionAttachment*)slot->attachment;
+			CCTextureAtlas* regionTextureAtlas = getTextureAtlas(attachment);
+			if (regionTextureAtlas != textureAtlas) {
+				if (textureAtlas) {
+					textureAtlas->drawQuads();
+					textureAtlas->removeAllQuads();
+				}
+			}
+			textureAtlas = regionTextureAtlas;
+			if (textureAtlas->getCapacity() == textureAtlas->getTotalQuads() &&
+				!textureAtlas->resizeCapacity(textureAtlas->getCapacity() * 2)) return;
+			RegionAttachment_updateQuad(attachment, slot, &quad, premultipliedAlpha);
+			textureAtlas->updateQuad(&quad, textureAtlas->getTotalQuads());
+		}
+		if (textureAtlas) {
+			textureAtlas->drawQuads();
+			textureAtlas->removeAllQuads();
 		}
-		textureAtlas = regionTextureAtlas;
-		if (textureAtlas->getCapacity() == textureAtlas->getTotalQuads() &&
-			!textureAtlas->resizeCapacity(textureAtlas->getCapacity() * 2)) return;
-		RegionAttachment_updateQuad(attachment, slot, &quad, premultipliedAlpha);
-		textureAtlas->updateQuad(&quad, textureAtlas->getTotalQuads());
-	}
-	if (textureAtlas) {
-		textureAtlas->drawQuads();
-		textureAtlas->removeAllQuads();
 	}
 
 	if (debugSlots) {
@@ -229,6 +547,7 @@ CCTextureAtlas* CCSkeleton::getTextureAtlas (RegionAttachment* regionAttachment)
 }
 
 CCRect CCSkeleton::boundingBox () {
+	finishUpdate();
 	float minX = FLT_MAX, minY = FLT_MAX, maxX = FLT_MIN, maxY = FLT_MIN;
 	float scaleX = getScaleX();
 	float scaleY = getScaleY();
@@ -311,16 +630,20 @@ void CCSkeleton::checkCoolingOffscreen() {
 // --- Convenience methods for Skeleton_* functions.
 
 void CCSkeleton::updateWorldTransform () {
+	finishUpdate();
 	Skeleton_updateWorldTransform(skeleton);
 }
 
 void CCSkeleton::setToSetupPose () {
+	finishUpdate();
 	Skeleton_setToSetupPose(skeleton);
 }
 void CCSkeleton::setBonesToSetupPose () {
+	finishUpdate();
 	Skeleton_setBonesToSetupPose(skeleton);
 }
 void CCSkeleton::setSlotsToSetupPose () {
+	finishUpdate();
 	Skeleton_setSlotsToSetupPose(skeleton);
 }
     
@@ -345,17 +668,47 @@ void CCSkeleton::setSpecifiedBoneToRender(const char *bone_name_) {
 		Slot* slot = skeleton->slots[i];
         findAndSetSpecifiedBoneChilds(slot->bone->data, bone_name_);
     }
+    updateSlotFilter();
+}
+
+void CCSkeleton::setRenderSpecificBones (const std::vector<std::string>& boneNames) {
+	renderSpecificBones = boneNames;
+	updateSlotFilter();
+}
+
+const std::vector<std::string>& CCSkeleton::getRenderSpecificBones () const {
+	return renderSpecificBones;
+}
+
+void CCSkeleton::updateSlotFilter () {
+	slotFilter.clear();
+	if (renderSpecificBones.empty()) return;
+
+	slotFilter.resize(skeleton->slotCount, false);
+	for (int i = 0, n = skeleton->slotCount; i < n; i++) {
+		Slot* slot = skeleton->slots[i];
+		if (!slot->bone) continue;
+		for (vector<string>::iterator it = renderSpecificBones.begin(); it != renderSpecificBones.end(); ++it) {
+			if (strcmp(slot->bone->data->name, it->c_str()) == 0) {
+				slotFilter[i] = true;
+				break;
+			}
+		}
+	}
 }
 
 Bone* CCSkeleton::findBone (const char* boneName) const {
+	const_cast<CCSkeleton*>(this)->finishUpdate();
 	return Skeleton_findBone(skeleton, boneName);
 }
 
 Slot* CCSkeleton::findSlot (const char* slotName) const {
+	const_cast<CCSkeleton*>(this)->finishUpdate();
 	return Skeleton_findSlot(skeleton, slotName);
 }
 
 bool CCSkeleton::setSkin (const char* skinName) {
+	finishUpdate();
 	return Skeleton_setSkinByName(skeleton, skinName) ? true : false;
 }
 
@@ -363,6 +716,7 @@ Attachment* CCSkeleton::getAttachment (const char* slotName, const char* attachm
 	return Skeleton_getAttachmentForSlotName(skeleton, slotName, attachmentName);
 }
 bool CCSkeleton::setAttachment (const char* slotName, const char* attachmentName) {
+	finishUpdate();
 	return Skeleton_setAttachment(skeleton, slotName, attachmentName) ? true : false;
 }
 
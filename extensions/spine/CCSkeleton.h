@@ -43,16 +43,18 @@ public:
 	Skeleton* skeleton;
 	Bone* rootBone;
     
-    //@PlusPingya - Added list of bones to render
-    std::vector<std::string> renderSpecificBones;
     void *preferenceRootParent = NULL;
     
 	float timeScale;
 	bool debugSlots;
 	bool debugBones;
 	bool premultipliedAlpha;
+	/* Appends the quads to a stream shared by all skeletons, drawn in one call until the texture, blend function or
+	 * shader changes or another node is drawn. */
+	bool batchRendering;
 
 	static CCSkeleton* createWithData (SkeletonData* skeletonData, bool ownsSkeletonData = false);
+	/* skeletonDataFile is either a JSON file or a binary file converted by tools/spine-binary/spine_binary.py. */
 	static CCSkeleton* createWithFile (const char* skeletonDataFile, Atlas* atlas, float scale = 1);
 	static CCSkeleton* createWithFile (const char* skeletonDataFile, const char* atlasFile, float scale = 1);
 
@@ -62,6 +64,22 @@ public:
 
 	virtual ~CCSkeleton ();
 
+	/* Skeletons created from a skeleton data file and an atlas file share the SkeletonData and Atlas with the other skeletons
+	 * created from the same files and scale. The files can be loaded ahead of time so the first skeleton doesn't wait. */
+	static void preloadSkeletonData (const char* skeletonDataFile, const char* atlasFile, float scale = 1);
+	/* Frees the shared SkeletonData and Atlas not used by any skeleton. */
+	static void removeUnusedSkeletonData ();
+
+	/* Sets the number of worker threads posing the skeletons queued by their update, 0 (the default) poses every skeleton
+	 * in its own update. Queued skeletons are posed together before the first skeleton is drawn. */
+	static void setParallelUpdateThreads (unsigned int threads);
+	/* Minimum number of queued skeletons for the worker threads to be used, 64 by default. */
+	static void setParallelUpdateThreshold (unsigned int count);
+
+	/* Poses the skeleton now if its update is queued. The methods of CCSkeleton and CCSkeletonAnimation do it themselves,
+	 * call it before using skeleton or states directly between the update and the draw of a frame. */
+	void finishUpdate ();
+
 	virtual void update (float deltaTime);
 	virtual void draw ();
 	virtual cocos2d::CCRect boundingBox ();
@@ -78,7 +96,9 @@ public:
     
     //@PlusPingya - Added function to find and list all childs bones of the specificed bone
     void setSpecifiedBoneToRender(const char* boneName);
-    bool findAndSetSpecifiedBoneChilds(BoneData* bone_data_, const char *bone_name_);
+    /* Renders only the slots of the listed bones, or every slot when the list is empty. */
+    void setRenderSpecificBones (const std::vector<std::string>& boneNames);
+    const std::vector<std::string>& getRenderSpecificBones () const;
 
 	/* Returns 0 if the bone was not found. */
 	Bone* findBone (const char* boneName) const;
@@ -105,10 +125,33 @@ protected:
 	void setSkeletonData (SkeletonData* skeletonData, bool ownsSkeletonData);
 	cocos2d::CCTextureAtlas* getTextureAtlas (RegionAttachment* regionAttachment) const;
 
+	/* Queues the pose for the worker threads, returns false if they are disabled and the caller must pose the skeleton. */
+	bool queueUpdate (float deltaTime);
+	/* Poses the skeleton deltaTime later, runs on a worker thread for queued updates so it must only touch this skeleton. */
+	virtual void updatePose (float deltaTime);
+	/* Returns true if checkCoolingOffscreen found the skeleton off screen. */
+	bool isCulled () const;
+
 private:
 	bool ownsSkeletonData;
+	//@PlusPingya - Added list of bones to render
+	std::vector<std::string> renderSpecificBones;
+	/* One bit per slot, compiled from renderSpecificBones. */
+	std::vector<bool> slotFilter;
 	Atlas* atlas;
+	/* Key of the shared data in the skeleton data cache, empty if the data isn't shared. */
+	std::string cacheKey;
+	/* Index in the queue of updates posed before drawing, -1 if not queued. */
+	int updateQueueIndex;
+	bool updateQueued;
+	float queuedDeltaTime;
 	void initialize ();
+	bool findAndSetSpecifiedBoneChilds(BoneData* bone_data_, const char *bone_name_);
+	/* Compiles renderSpecificBones into slotFilter, called by the setters of the list. */
+	void updateSlotFilter ();
+
+	static void updateQueuedSkeletons ();
+	static void updateQueuedSkeleton (unsigned int index);
 };
 
 }} // namespace cocos2d { namespace extension {
@@ -54,19 +54,29 @@ CCSkeletonAnimation* CCSkeletonAnimation::createWithFile (const char* skeletonDa
 
 CCSkeletonAnimation::CCSkeletonAnimation (SkeletonData *skeletonData)
 		: CCSkeleton(skeletonData) {
+	initialize();
 	addAnimationState();
 }
 
 CCSkeletonAnimation::CCSkeletonAnimation (const char* skeletonDataFile, Atlas* atlas, float scale)
 		: CCSkeleton(skeletonDataFile, atlas, scale) {
+	initialize();
 	addAnimationState();
 }
 
 CCSkeletonAnimation::CCSkeletonAnimation (const char* skeletonDataFile, const char* atlasFile, float scale)
 		: CCSkeleton(skeletonDataFile, atlasFile, scale) {
+	initialize();
 	addAnimationState();
 }
 
+void CCSkeletonAnimation::initialize () {
+	updateInterval = 0;
+	hiddenUpdateInterval = -1;
+	unposedTime = 0;
+	intervalTime = 0;
+}
+
 CCSkeletonAnimation::~CCSkeletonAnimation () {
 	for (std::vector<AnimationStateData*>::iterator iter = stateDatas.begin(); iter != stateDatas.end(); ++iter)
 		AnimationStateData_dispose(*iter);
@@ -78,7 +88,19 @@ CCSkeletonAnimation::~CCSkeletonAnimation () {
 void CCSkeletonAnimation::update (float deltaTime) {
 	super::update(deltaTime);
 
-	deltaTime *= timeScale;
+	unposedTime += deltaTime * timeScale;
+	intervalTime += deltaTime;
+	float interval = updateInterval;
+	if (hiddenUpdateInterval >= 0 && (isCulled() || !isVisible())) interval = hiddenUpdateInterval;
+	if (intervalTime < interval) return;
+
+	float time = unposedTime;
+	unposedTime = 0;
+	intervalTime = 0;
+	if (!queueUpdate(time)) updatePose(time);
+}
+
+void CCSkeletonAnimation::updatePose (float deltaTime) {
 	for (std::vector<AnimationState*>::iterator iter = states.begin(); iter != states.end(); ++iter) {
 		AnimationState_update(*iter, deltaTime);
 		AnimationState_apply(*iter, skeleton);
@@ -87,6 +109,7 @@ void CCSkeletonAnimation::update (float deltaTime) {
 }
 
 void CCSkeletonAnimation::addAnimationState (AnimationStateData* stateData) {
+	finishUpdate();
 	if (!stateData) {
 		stateData = AnimationStateData_create(skeleton->data);
 		stateDatas.push_back(stateData);
@@ -96,6 +119,7 @@ void CCSkeletonAnimation::addAnimationState (AnimationStateData* stateData) {
 }
 
 void CCSkeletonAnimation::setAnimationStateData (AnimationStateData* stateData, int stateIndex) {
+	finishUpdate();
 	CCAssert(stateIndex >= 0 && stateIndex < (int)states.size(), "stateIndex out of range.");
 	CCAssert(stateData, "stateData cannot be null.");
 
@@ -125,6 +149,7 @@ void CCSkeletonAnimation::setMix (const char* fromAnimation, const char* toAnima
 }
 
 bool CCSkeletonAnimation::setAnimation (const char* name, bool loop, int stateIndex) {
+    finishUpdate();
     CCAssert(stateIndex >= 0 && stateIndex < (int)states.size(), "stateIndex out of range.");
     if(AnimationState_setAnimationByName(states[stateIndex], name, loop)){
         return true;
@@ -133,11 +158,13 @@ bool CCSkeletonAnimation::setAnimation (const char* name, bool loop, int stateIn
 }
 
 void CCSkeletonAnimation::addAnimation (const char* name, bool loop, float delay, int stateIndex) {
+	finishUpdate();
 	CCAssert(stateIndex >= 0 && stateIndex < (int)states.size(), "stateIndex out of range.");
 	AnimationState_addAnimationByName(states[stateIndex], name, loop, delay);
 }
 
 void CCSkeletonAnimation::clearAnimation (int stateIndex) {
+	finishUpdate();
 	CCAssert(stateIndex >= 0 && stateIndex < (int)states.size(), "stateIndex out of range.");
 	AnimationState_clearAnimation(states[stateIndex]);
 }
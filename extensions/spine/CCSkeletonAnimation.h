@@ -38,6 +38,11 @@ Draws an animated skeleton, providing a simple API for applying one or more anim
 class CCSkeletonAnimation: public CCSkeleton {
 public:
 	std::vector<AnimationState*> states;
+	/* Seconds between two poses, 0 poses the skeleton every frame. The animations still advance by the elapsed time, so a
+	 * skeleton sampled at a lower rate because it is far away stays in sync with the others. */
+	float updateInterval;
+	/* Replaces updateInterval while the skeleton is culled off screen or not visible, negative to keep updateInterval. */
+	float hiddenUpdateInterval;
 
 	static CCSkeletonAnimation* createWithData (SkeletonData* skeletonData);
 	static CCSkeletonAnimation* createWithFile (const char* skeletonDataFile, Atlas* atlas, float scale = 1);
@@ -63,9 +68,14 @@ public:
 protected:
 	CCSkeletonAnimation ();
 
+	virtual void updatePose (float deltaTime);
+
 private:
 	typedef CCSkeleton super;
 	std::vector<AnimationStateData*> stateDatas;
+	/* Animation time and real time since the last pose. */
+	float unposedTime;
+	float intervalTime;
 
 	void initialize ();
 };
@@ -0,0 +1,455 @@
+/*******************************************************************************
+ * Copyright (c) 2013, Esoteric Software
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+#include <spine/SkeletonBinary.h>
+#include <stdio.h>
+#include <spine/extension.h>
+#include <spine/RegionAttachment.h>
+#include <spine/AtlasAttachmentLoader.h>
+
+/* Layout, little endian. Counts and indices are unsigned LEB128 varints, floats are IEEE 754 singles and colors are four
+ * bytes in RGBA order. A string is a varint holding its length plus one (0 for a null string) followed by the bytes and a
+ * terminating zero, so names are used in place.
+ *
+ * header: "SPNB", version byte
+ * bones: count, { name, parent index + 1, length, x, y, rotation, scaleX, scaleY }
+ * slots: count, { name, bone index, color, attachment name }
+ * skins: count, { name, slot count, { slot index, attachment count, { skin attachment name, attachment name, type byte,
+ *        x, y, scaleX, scaleY, rotation, width, height } } }
+ * animations: count, { name, timeline count, { type byte, bone or slot index, frame count, frames, curves } }
+ *
+ * Frames hold the time followed by the angle, x and y or the color, attachment timelines hold the time and a name. Curve
+ * timelines are followed by one curve type byte per frame but the last, bezier curves then hold cx1, cy1, cx2, cy2. */
+
+namespace cocos2d { namespace extension {
+
+static const char SKELETON_BINARY_MAGIC[4] = {'S', 'P', 'N', 'B'};
+static const int SKELETON_BINARY_VERSION = 1;
+
+enum {
+	TIMELINE_ROTATE, TIMELINE_TRANSLATE, TIMELINE_SCALE, TIMELINE_COLOR, TIMELINE_ATTACHMENT
+};
+
+enum {
+	CURVE_LINEAR, CURVE_STEPPED, CURVE_BEZIER
+};
+
+typedef struct {
+	SkeletonBinary super;
+	int ownsLoader;
+} _Internal;
+
+typedef struct {
+	const unsigned char* cursor;
+	const unsigned char* end;
+	int/*bool*/overflow;
+} _Input;
+
+SkeletonBinary* SkeletonBinary_createWithLoader (AttachmentLoader* attachmentLoader) {
+	SkeletonBinary* self = SUPER(NEW(_Internal));
+	self->scale = 1;
+	self->attachmentLoader = attachmentLoader;
+	return self;
+}
+
+SkeletonBinary* SkeletonBinary_create (Atlas* atlas) {
+	AtlasAttachmentLoader* attachmentLoader = AtlasAttachmentLoader_create(atlas);
+	SkeletonBinary* self = SkeletonBinary_createWithLoader(SUPER(attachmentLoader));
+	SUB_CAST(_Internal, self) ->ownsLoader = 1;
+	return self;
+}
+
+void SkeletonBinary_dispose (SkeletonBinary* self) {
+	if (SUB_CAST(_Internal, self) ->ownsLoader) AttachmentLoader_dispose(self->attachmentLoader);
+	FREE(self->error);
+	FREE(self);
+}
+
+static void _SkeletonBinary_setError (SkeletonBinary* self, const char* value1, const char* value2) {
+	char message[256];
+	int length;
+	FREE(self->error);
+	strncpy(message, value1, 255);
+	message[255] = '\0';
+	length = strlen(message);
+	if (value2) strncat(message + length, value2, 255 - length);
+	MALLOC_STR(self->error, message);
+}
+
+static SkeletonData* _SkeletonBinary_fail (SkeletonBinary* self, SkeletonData* skeletonData, const char* value1,
+		const char* value2) {
+	_SkeletonBinary_setError(self, value1, value2);
+	SkeletonData_dispose(skeletonData);
+	return 0;
+}
+
+static int readByte (_Input* input) {
+	if (input->cursor >= input->end) {
+		input->overflow = 1;
+		return 0;
+	}
+	return *input->cursor++;
+}
+
+static int readVarint (_Input* input) {
+	unsigned int value = 0;
+	int shift = 0, b;
+	do {
+		b = readByte(input);
+		value |= (unsigned int)(b & 0x7F) << shift;
+		shift += 7;
+	} while ((b & 0x80) && shift < 35);
+	if (value > 0x7FFFFFFF) input->overflow = 1;
+	return (int)(value & 0x7FFFFFFF);
+}
+
+/* Every counted element takes at least one byte, larger counts can only come from a corrupt file. */
+static int readCount (_Input* input) {
+	int count = readVarint(input);
+	if (count > input->end - input->cursor) {
+		input->overflow = 1;
+		input->cursor = input->end;
+		return 0;
+	}
+	return count;
+}
+
+static float readFloat (_Input* input) {
+	union {
+		unsigned int i;
+		float f;
+	} value;
+	const unsigned char* c = input->cursor;
+	if (input->end - c < 4) {
+		input->overflow = 1;
+		input->cursor = input->end;
+		return 0;
+	}
+	value.i = c[0] | (c[1] << 8) | (c[2] << 16) | ((unsigned int)c[3] << 24);
+	input->cursor += 4;
+	return value.f;
+}
+
+/* Returns a pointer into the data, never 0 for a non null string even if the data is truncated. */
+static const char* readString (_Input* input) {
+	const char* string;
+	int length = readVarint(input);
+	if (length == 0) return 0;
+	if (length > input->end - input->cursor || input->cursor[length - 1] != '\0') {
+		input->overflow = 1;
+		input->cursor = input->end;
+		return "";
+	}
+	string = (const char*)input->cursor;
+	input->cursor += length;
+	return string;
+}
+
+static float readColor (_Input* input) {
+	return readByte(input) / (float)255;
+}
+
+static void readCurves (_Input* input, CurveTimeline* timeline, int frameCount) {
+	int frameIndex;
+	for (frameIndex = 0; frameIndex < frameCount - 1; ++frameIndex) {
+		switch (readByte(input)) {
+		case CURVE_STEPPED:
+			CurveTimeline_setStepped(timeline, frameIndex);
+			break;
+		case CURVE_BEZIER: {
+			float cx1 = readFloat(input);
+			float cy1 = readFloat(input);
+			float cx2 = readFloat(input);
+			float cy2 = readFloat(input);
+			CurveTimeline_setCurve(timeline, frameIndex, cx1, cy1, cx2, cy2);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+/* Appends the animation to skeletonData before reading it, so disposing skeletonData frees it on error. */
+static int/*bool*/_SkeletonBinary_readAnimation (SkeletonBinary* self, _Input* input, SkeletonData* skeletonData) {
+	int i, frameIndex;
+	const char* name = readString(input);
+	int timelineCount = readCount(input);
+	Animation* animation = Animation_create(name ? name : "", timelineCount);
+	animation->timelineCount = 0;
+	skeletonData->animations[skeletonData->animationCount++] = animation;
+
+	for (i = 0; i < timelineCount && !input->overflow; ++i) {
+		int type = readByte(input);
+		int index = readVarint(input);
+		int frameCount = readCount(input);
+		float duration;
+
+		if (frameCount < 1) {
+			_SkeletonBinary_setError(self, "Empty timeline in animation: ", animation->name);
+			return 0;
+		}
+
+		switch (type) {
+		case TIMELINE_ROTATE: {
+			RotateTimeline* timeline;
+			if (index >= skeletonData->boneCount) break;
+			timeline = RotateTimeline_create(frameCount);
+			timeline->boneIndex = index;
+			animation->timelines[animation->timelineCount++] = (Timeline*)timeline;
+			for (frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+				float time = readFloat(input);
+				RotateTimeline_setFrame(timeline, frameIndex, time, readFloat(input));
+			}
+			readCurves(input, SUPER(timeline), frameCount);
+			duration = timeline->frames[frameCount * 2 - 2];
+			if (duration > animation->duration) animation->duration = duration;
+			continue;
+		}
+		case TIMELINE_TRANSLATE:
+		case TIMELINE_SCALE: {
+			float scale = type == TIMELINE_SCALE ? 1 : self->scale;
+			TranslateTimeline* timeline;
+			if (index >= skeletonData->boneCount) break;
+			timeline = type == TIMELINE_SCALE ? ScaleTimeline_create(frameCount) : TranslateTimeline_create(frameCount);
+			timeline->boneIndex = index;
+			animation->timelines[animation->timelineCount++] = (Timeline*)timeline;
+			for (frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+				float time = readFloat(input);
+				float x = readFloat(input) * scale;
+				TranslateTimeline_setFrame(timeline, frameIndex, time, x, readFloat(input) * scale);
+			}
+			readCurves(input, SUPER(timeline), frameCount);
+			duration = timeline->frames[frameCount * 3 - 3];
+			if (duration > animation->duration) animation->duration = duration;
+			continue;
+		}
+		case TIMELINE_COLOR: {
+			ColorTimeline* timeline;
+			if (index >= skeletonData->slotCount) break;
+			timeline = ColorTimeline_create(frameCount);
+			timeline->slotIndex = index;
+			animation->timelines[animation->timelineCount++] = (Timeline*)timeline;
+			for (frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+				float time = readFloat(input);
+				float r = readColor(input);
+				float g = readColor(input);
+				float b = readColor(input);
+				ColorTimeline_setFrame(timeline, frameIndex, time, r, g, b, readColor(input));
+			}
+			readCurves(input, SUPER(timeline), frameCount);
+			duration = timeline->frames[frameCount * 5 - 5];
+			if (duration > animation->duration) animation->duration = duration;
+			continue;
+		}
+		case TIMELINE_ATTACHMENT: {
+			AttachmentTimeline* timeline;
+			if (index >= skeletonData->slotCount) break;
+			timeline = AttachmentTimeline_create(frameCount);
+			timeline->slotIndex = index;
+			animation->timelines[animation->timelineCount++] = (Timeline*)timeline;
+			for (frameIndex = 0; frameIndex < frameCount; ++frameIndex) {
+				float time = readFloat(input);
+				AttachmentTimeline_setFrame(timeline, frameIndex, time, readString(input));
+			}
+			duration = timeline->frames[frameCount - 1];
+			if (duration > animation->duration) animation->duration = duration;
+			continue;
+		}
+		default:
+			_SkeletonBinary_setError(self, "Invalid timeline type in animation: ", animation->name);
+			return 0;
+		}
+
+		_SkeletonBinary_setError(self, "Invalid bone or slot index in animation: ", animation->name);
+		return 0;
+	}
+
+	return 1;
+}
+
+int/*bool*/SkeletonBinary_isBinary (const char* data, int length) {
+	return length > (int)sizeof(SKELETON_BINARY_MAGIC)
+			&& memcmp(data, SKELETON_BINARY_MAGIC, sizeof(SKELETON_BINARY_MAGIC)) == 0;
+}
+
+SkeletonData* SkeletonBinary_readSkeletonDataFile (SkeletonBinary* self, const char* path) {
+	int length;
+	SkeletonData* skeletonData;
+	const char* data = _Util_readFile(path, &length);
+	if (!data) {
+		_SkeletonBinary_setError(self, "Unable to read skeleton file: ", path);
+		return 0;
+	}
+	skeletonData = SkeletonBinary_readSkeletonData(self, data, length);
+	FREE(data);
+	return skeletonData;
+}
+
+SkeletonData* SkeletonBinary_readSkeletonData (SkeletonBinary* self, const char* data, int length) {
+	SkeletonData* skeletonData;
+	_Input input;
+	int i, ii, iii, count;
+
+	FREE(self->error);
+	CONST_CAST(char*, self->error) = 0;
+
+	if (!SkeletonBinary_isBinary(data, length)) {
+		_SkeletonBinary_setError(self, "Invalid binary skeleton header.", 0);
+		return 0;
+	}
+	input.cursor = (const unsigned char*)data + sizeof(SKELETON_BINARY_MAGIC);
+	input.end = (const unsigned char*)data + length;
+	input.overflow = 0;
+	if (readByte(&input) != SKELETON_BINARY_VERSION) {
+		_SkeletonBinary_setError(self, "Unsupported binary skeleton version.", 0);
+		return 0;
+	}
+
+	skeletonData = SkeletonData_create();
+
+	count = readCount(&input);
+	skeletonData->bones = MALLOC(BoneData*, count);
+	for (i = 0; i < count; ++i) {
+		BoneData* boneData;
+		BoneData* parent = 0;
+		const char* boneName = readString(&input);
+		int parentIndex = readVarint(&input) - 1;
+		if (parentIndex >= i) return _SkeletonBinary_fail(self, skeletonData, "Parent bone not found for: ", boneName);
+		if (parentIndex >= 0) parent = skeletonData->bones[parentIndex];
+
+		boneData = BoneData_create(boneName ? boneName : "", parent);
+		boneData->length = readFloat(&input) * self->scale;
+		boneData->x = readFloat(&input) * self->scale;
+		boneData->y = readFloat(&input) * self->scale;
+		boneData->rotation = readFloat(&input);
+		boneData->scaleX = readFloat(&input);
+		boneData->scaleY = readFloat(&input);
+
+		skeletonData->bones[i] = boneData;
+		skeletonData->boneCount++;
+	}
+	if (input.overflow) return _SkeletonBinary_fail(self, skeletonData, "Truncated binary skeleton: ", "bones");
+
+	count = readCount(&input);
+	skeletonData->slots = MALLOC(SlotData*, count);
+	for (i = 0; i < count; ++i) {
+		SlotData* slotData;
+		const char* attachmentName;
+		const char* slotName = readString(&input);
+		int boneIndex = readVarint(&input);
+		if (boneIndex >= skeletonData->boneCount)
+			return _SkeletonBinary_fail(self, skeletonData, "Slot bone not found for: ", slotName);
+
+		slotData = SlotData_create(slotName ? slotName : "", skeletonData->bones[boneIndex]);
+		slotData->r = readColor(&input);
+		slotData->g = readColor(&input);
+		slotData->b = readColor(&input);
+		slotData->a = readColor(&input);
+		attachmentName = readString(&input);
+		if (attachmentName) SlotData_setAttachmentName(slotData, attachmentName);
+
+		skeletonData->slots[i] = slotData;
+		skeletonData->slotCount++;
+	}
+	if (input.overflow) return _SkeletonBinary_fail(self, skeletonData, "Truncated binary skeleton: ", "slots");
+
+	count = readCount(&input);
+	skeletonData->skins = MALLOC(Skin*, count);
+	for (i = 0; i < count; ++i) {
+		const char* skinName = readString(&input);
+		Skin* skin = Skin_create(skinName ? skinName : "");
+		int slotCount = readCount(&input);
+
+		skeletonData->skins[i] = skin;
+		skeletonData->skinCount++;
+		if (strcmp(skin->name, "default") == 0) skeletonData->defaultSkin = skin;
+
+		for (ii = 0; ii < slotCount; ++ii) {
+			int slotIndex = readVarint(&input);
+			int attachmentCount = readCount(&input);
+			if (slotIndex >= skeletonData->slotCount)
+				return _SkeletonBinary_fail(self, skeletonData, "Skin slot not found in skin: ", skin->name);
+
+			for (iii = 0; iii < attachmentCount; ++iii) {
+				Attachment* attachment;
+				AttachmentType type;
+				float x, y, scaleX, scaleY, rotation, width, height;
+				const char* skinAttachmentName = readString(&input);
+				const char* attachmentName = readString(&input);
+				if (!skinAttachmentName) skinAttachmentName = "";
+				if (!attachmentName) attachmentName = skinAttachmentName;
+				type = (AttachmentType)readByte(&input);
+				x = readFloat(&input) * self->scale;
+				y = readFloat(&input) * self->scale;
+				scaleX = readFloat(&input);
+				scaleY = readFloat(&input);
+				rotation = readFloat(&input);
+				width = readFloat(&input) * self->scale;
+				height = readFloat(&input) * self->scale;
+				if (input.overflow) return _SkeletonBinary_fail(self, skeletonData, "Truncated binary skeleton: ", "skins");
+				if (type != ATTACHMENT_REGION && type != ATTACHMENT_REGION_SEQUENCE)
+					return _SkeletonBinary_fail(self, skeletonData, "Unknown attachment type for: ", skinAttachmentName);
+
+				attachment = AttachmentLoader_newAttachment(self->attachmentLoader, skin, type, attachmentName);
+				if (!attachment) {
+					if (self->attachmentLoader->error1)
+						return _SkeletonBinary_fail(self, skeletonData, self->attachmentLoader->error1,
+								self->attachmentLoader->error2);
+					continue;
+				}
+
+				if (attachment->type == ATTACHMENT_REGION || attachment->type == ATTACHMENT_REGION_SEQUENCE) {
+					RegionAttachment* regionAttachment = (RegionAttachment*)attachment;
+					regionAttachment->x = x;
+					regionAttachment->y = y;
+					regionAttachment->scaleX = scaleX;
+					regionAttachment->scaleY = scaleY;
+					regionAttachment->rotation = rotation;
+					regionAttachment->width = width;
+					regionAttachment->height = height;
+					RegionAttachment_updateOffset(regionAttachment);
+				}
+
+				Skin_addAttachment(skin, slotIndex, skinAttachmentName, attachment);
+			}
+		}
+	}
+	if (input.overflow) return _SkeletonBinary_fail(self, skeletonData, "Truncated binary skeleton: ", "skins");
+
+	count = readCount(&input);
+	skeletonData->animations = MALLOC(Animation*, count);
+	for (i = 0; i < count; ++i) {
+		if (!_SkeletonBinary_readAnimation(self, &input, skeletonData)) {
+			SkeletonData_dispose(skeletonData);
+			return 0;
+		}
+	}
+	if (input.overflow) return _SkeletonBinary_fail(self, skeletonData, "Truncated binary skeleton: ", "animations");
+
+	return skeletonData;
+}
+
+}} // namespace cocos2d { namespace extension {
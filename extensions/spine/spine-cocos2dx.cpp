@@ -49,7 +49,7 @@ void _AtlasPage_disposeTexture (AtlasPage* self) {
 char* _Util_readFile (const char* path, int* length) {
 	unsigned long size;
     char* data = reinterpret_cast<char*>(CCFileUtils::sharedFileUtils()->getFileData(
-		CCFileUtils::sharedFileUtils()->fullPathForFilename(path).c_str(), "r", &size));
+		CCFileUtils::sharedFileUtils()->fullPathForFilename(path).c_str(), "rb", &size));
 	*length = size;
 	return data;
 }
@@ -38,6 +38,7 @@
 #include <spine/RegionAttachment.h>
 #include <spine/Skeleton.h>
 #include <spine/SkeletonData.h>
+#include <spine/SkeletonBinary.h>
 #include <spine/SkeletonJson.h>
 #include <spine/Skin.h>
 #include <spine/Slot.h>
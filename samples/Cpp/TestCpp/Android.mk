@@ -127,6 +127,8 @@ Classes/MutiTouchTest/MutiTouchTest.cpp \
 Classes/ParallaxTest/ParallaxTest.cpp \
 Classes/ParticleTest/ParticleTest.cpp \
 Classes/PerformanceTest/PerformanceAllocTest.cpp \
+Classes/PerformanceTest/PerformanceBenchmarkRunner.cpp \
+Classes/PerformanceTest/PerformanceMathTest.cpp \
 Classes/PerformanceTest/PerformanceNodeChildrenTest.cpp \
 Classes/PerformanceTest/PerformanceParticleTest.cpp \
 Classes/PerformanceTest/PerformanceSpriteTest.cpp \
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include "controller.h"
 #include "SimpleAudioEngine.h"
 #include "cocos-ext.h"
+#include "PerformanceTest/PerformanceBenchmarkRunner.h"
 
 USING_NS_CC;
 using namespace CocosDenshion;
@@ -108,6 +109,13 @@ bool AppDelegate::applicationDidFinishLaunching()
     pScene->addChild(pLayer);
     pDirector->runWithScene(pScene);
 
+    // COCOS2D_BENCHMARK=1 runs the performance benchmarks without interaction and quits
+    const char* pszBenchmark = getenv("COCOS2D_BENCHMARK");
+    if (pszBenchmark && atoi(pszBenchmark) != 0)
+    {
+        runBenchmarkRunner(true);
+    }
+
     return true;
 }
 
@@ -24,6 +24,7 @@ TESTLAYER_CREATE_FUNC(SpriteTest);
 TESTLAYER_CREATE_FUNC(SpriteNoAlphaTest);
 TESTLAYER_CREATE_FUNC(SpriteInvertedTest);
 TESTLAYER_CREATE_FUNC(NestedTest);
+TESTLAYER_CREATE_FUNC(ScissorTest);
 TESTLAYER_CREATE_FUNC(RawStencilBufferTest);
 TESTLAYER_CREATE_FUNC(RawStencilBufferTest2);
 TESTLAYER_CREATE_FUNC(RawStencilBufferTest3);
@@ -40,6 +41,7 @@ static NEWTESTFUNC createFunctions[] = {
     CF(SpriteNoAlphaTest),
     CF(SpriteInvertedTest),
     CF(NestedTest),
+    CF(ScissorTest),
     CF(RawStencilBufferTest),
     CF(RawStencilBufferTest2),
     CF(RawStencilBufferTest3),
@@ -430,6 +432,72 @@ void NestedTest::setup()
 
 }
 
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+//#pragma mark - ScissorTest
+#endif
+
+std::string ScissorTest::title()
+{
+	return "Scissor Test";
+}
+
+std::string ScissorTest::subtitle()
+{
+	return "Nested rectangles use glScissor, see the stats (draws/stencil/scissor). Touch to rotate";
+}
+
+void ScissorTest::setup()
+{
+    static int depth = 4;
+
+    CCNode *parent = this;
+    ccColor4F white = {1, 1, 1, 1};
+
+    for (int i = 0; i < depth; i++) {
+
+        float size = 300 - i * 60;
+
+        CCClippingNode *clipper = CCClippingNode::create();
+        clipper->setContentSize(CCSizeMake(size, size));
+        clipper->setAnchorPoint(ccp(0.5, 0.5));
+        clipper->setPosition( ccp(parent->getContentSize().width / 2 + (i % 2 ? 20 : -20), parent->getContentSize().height / 2) );
+        parent->addChild(clipper);
+
+        // odd levels use a color layer, even ones a draw node
+        if (i % 2)
+        {
+            clipper->setStencil(CCLayerColor::create(ccc4(255, 255, 255, 255), size, size));
+        }
+        else
+        {
+            CCDrawNode *stencil = CCDrawNode::create();
+            CCPoint rectangle[4] = { ccp(0, 0), ccp(size, 0), ccp(size, size), ccp(0, size) };
+            stencil->drawPolygon(rectangle, 4, white, 0, white);
+            clipper->setStencil(stencil);
+        }
+
+        CCSprite *content = CCSprite::create(s_pPathGrossini);
+        content->setPosition( ccp(size / 2, size / 2) );
+        content->setScale(2.5f - i * 0.5f);
+        content->runAction(CCRepeatForever::create(CCSequence::createWithTwoActions(CCMoveBy::create(1, ccp(size / 2, 0)), CCMoveBy::create(1, ccp(-size / 2, 0)))));
+        clipper->addChild(content);
+
+        if (i == 0)
+        {
+            m_pOuterClipper = clipper;
+        }
+        parent = clipper;
+    }
+
+    this->setTouchEnabled(true);
+}
+
+void ScissorTest::ccTouchesBegan(CCSet *pTouches, CCEvent *pEvent)
+{
+    // a rotated rectangle falls back to the stencil buffer
+    m_pOuterClipper->setRotation(m_pOuterClipper->getRotation() == 0 ? 15 : 0);
+}
+
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
 //#pragma mark - HoleDemo
 #endif
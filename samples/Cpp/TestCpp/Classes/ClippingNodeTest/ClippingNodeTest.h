@@ -89,6 +89,17 @@ public:
     virtual void setup();
 };
 
+class ScissorTest : public BaseClippingNodeTest
+{
+public:
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void setup();
+    virtual void ccTouchesBegan(CCSet *pTouches, CCEvent *pEvent);
+private:
+    CCClippingNode* m_pOuterClipper;
+};
+
 class HoleDemo : public BaseClippingNodeTest
 {
 public:
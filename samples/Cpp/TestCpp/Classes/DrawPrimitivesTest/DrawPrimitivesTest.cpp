@@ -16,11 +16,13 @@ static CCLayer* create##className() \
 
 DRAWPRIMITIVES_CREATE_FUNC(DrawPrimitivesTest);
 DRAWPRIMITIVES_CREATE_FUNC(DrawNodeTest);
+DRAWPRIMITIVES_CREATE_FUNC(DrawNodeMinimapTest);
 
 static NEWDRAWPRIMITIVESFUNC createFunctions[] =
 {
     createDrawPrimitivesTest,
     createDrawNodeTest,
+    createDrawNodeMinimapTest,
 };
 
 #define MAX_LAYER    (sizeof(createFunctions) / sizeof(createFunctions[0]))
@@ -317,6 +319,70 @@ string DrawNodeTest::subtitle()
     return "Testing DrawNode - batched draws. Concave polygons are BROKEN";
 }
 
+// DrawNodeMinimapTest
+
+#define kMinimapGridLines   100
+#define kMinimapUnits       2000
+
+DrawNodeMinimapTest::DrawNodeMinimapTest()
+: m_fTime(0)
+{
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+    
+    // the terrain is drawn once, it stays in a static buffer
+    CCDrawNode *terrain = CCDrawNode::create();
+    terrain->setStatic(true);
+    addChild(terrain);
+    for (int i = 0; i <= kMinimapGridLines; i++)
+    {
+        float x = s.width * i / kMinimapGridLines;
+        float y = s.height * i / kMinimapGridLines;
+        terrain->drawSegment(ccp(x, 0), ccp(x, s.height), 0.5f, ccc4f(0.2f, 0.4f, 0.2f, 1));
+        terrain->drawSegment(ccp(0, y), ccp(s.width, y), 0.5f, ccc4f(0.2f, 0.4f, 0.2f, 1));
+    }
+    
+    // the units are cleared and redrawn every frame
+    m_pUnits = CCDrawNode::create();
+    addChild(m_pUnits);
+    
+    // the trail only grows, only its new segment is uploaded every frame
+    m_pTrail = CCDrawNode::create();
+    addChild(m_pTrail);
+    m_tTrailEnd = ccp(s.width / 2, s.height / 2);
+    
+    scheduleUpdate();
+}
+
+void DrawNodeMinimapTest::update(float dt)
+{
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+    m_fTime += dt;
+    
+    m_pUnits->clear();
+    for (int i = 0; i < kMinimapUnits; i++)
+    {
+        float angle = m_fTime * (0.2f + (i % 7) * 0.05f) + i;
+        float radius = (i % 97) / 97.0f * s.height / 2;
+        CCPoint pos = ccp(s.width / 2 + cosf(angle) * radius, s.height / 2 + sinf(angle) * radius);
+        CCPoint heading = ccp(cosf(angle + 1.57f) * 6, sinf(angle + 1.57f) * 6);
+        m_pUnits->drawSegment(pos, ccpAdd(pos, heading), 1, ccc4f(i % 2, 0.5f, 1 - i % 2, 1));
+    }
+    
+    CCPoint next = ccp(s.width / 2 + cosf(m_fTime) * s.width / 3, s.height / 2 + sinf(m_fTime * 1.3f) * s.height / 3);
+    m_pTrail->drawSegment(m_tTrailEnd, next, 2, ccc4f(1, 1, 0, 1));
+    m_tTrailEnd = next;
+}
+
+string DrawNodeMinimapTest::title()
+{
+    return "CCDrawNode minimap";
+}
+
+string DrawNodeMinimapTest::subtitle()
+{
+    return "Static terrain, 2000 units redrawn per frame, growing trail";
+}
+
 void DrawPrimitivesTestScene::runThisTest()
 {
     CCLayer* pLayer = nextAction();
@@ -38,6 +38,22 @@ public:
     virtual std::string subtitle();
 };
 
+class DrawNodeMinimapTest : public BaseLayer
+{
+public:
+    DrawNodeMinimapTest();
+    
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void update(float dt);
+    
+private:
+    CCDrawNode  *m_pUnits;
+    CCDrawNode  *m_pTrail;
+    CCPoint     m_tTrailEnd;
+    float       m_fTime;
+};
+
 class DrawPrimitivesTestScene : public TestScene
 {
 public:
@@ -25,6 +25,8 @@
 #include "CocosBuilderTest.h"
 #include "../../testResource.h"
 #include "HelloCocosBuilder/HelloCocosBuilderLayerLoader.h"
+#include "TestHeader/TestHeaderLayerLoader.h"
+#include "SpriteTest/SpriteTestLayerLoader.h"
 
 USING_NS_CC;
 USING_NS_CC_EXT;
@@ -47,9 +49,116 @@ void CocosBuilderTestScene::runThisTest() {
         this->addChild(node);
     }
 
+    CCMenuItemFont * benchmarkItem = CCMenuItemFont::create("Prototype benchmark", this, menu_selector(CocosBuilderTestScene::onPrototypeBenchmarkClicked));
+    benchmarkItem->setPosition(ccp(VisibleRect::left().x + 120, VisibleRect::bottom().y + 25));
+    CCMenu * menu = CCMenu::create(benchmarkItem, NULL);
+    menu->setPosition(CCPointZero);
+    this->addChild(menu, 1);
+
     CCDirector::sharedDirector()->replaceScene(this);
 }
 
+void CocosBuilderTestScene::onPrototypeBenchmarkClicked(CCObject * pSender) {
+    CCScene * scene = CCScene::create();
+    scene->addChild(CCBPrototypeBenchmarkLayer::create());
+    CCDirector::sharedDirector()->pushScene(scene);
+}
+
+/*************************************************************************
+ CCBPrototypeBenchmarkLayer
+ *************************************************************************/
+
+static const char * s_pBenchmarkCCBFile = "ccb/ccb/TestSprites.ccbi";
+static const int kBenchmarkInstances = 1000;
+
+void CCBPrototypeBenchmarkLayer::onEnter() {
+    CCLayer::onEnter();
+
+    // Load the textures and sprite sheets before timing anything
+    instantiate(false, 1);
+
+    double fileTime = instantiate(false, kBenchmarkInstances);
+    int fileAssigned = mAssignedMembers;
+    double prototypeTime = instantiate(true, kBenchmarkInstances);
+    int prototypeAssigned = mAssignedMembers;
+
+    char results[512];
+    snprintf(results, sizeof(results),
+             "%d x %s\n\n"
+             "readNodeGraphFromFile: %.1f ms (%.3f ms per graph)\n"
+             "readNodeGraphFromPrototype: %.1f ms (%.3f ms per graph)\n"
+             "speedup: x%.2f\n\n"
+             "member variables assigned: %d / %d",
+             kBenchmarkInstances, s_pBenchmarkCCBFile,
+             fileTime, fileTime / kBenchmarkInstances,
+             prototypeTime, prototypeTime / kBenchmarkInstances,
+             prototypeTime > 0 ? fileTime / prototypeTime : 0.0,
+             fileAssigned, prototypeAssigned);
+    CCLOG("%s", results);
+
+    CCLabelTTF * label = CCLabelTTF::create(results, "Arial", 18);
+    label->setPosition(VisibleRect::center());
+    this->addChild(label);
+
+    CCMenuItemFont * backItem = CCMenuItemFont::create("Back", this, menu_selector(CCBPrototypeBenchmarkLayer::backCallback));
+    backItem->setPosition(ccp(VisibleRect::right().x - 50, VisibleRect::bottom().y + 25));
+    CCMenu * menu = CCMenu::create(backItem, NULL);
+    menu->setPosition(CCPointZero);
+    this->addChild(menu);
+}
+
+bool CCBPrototypeBenchmarkLayer::onAssignCCBMemberVariable(CCObject * pTarget, const char * pMemberVariableName, CCNode * pNode) {
+    mAssignedMembers++;
+    return true;
+}
+
+void CCBPrototypeBenchmarkLayer::backCallback(CCObject * pSender) {
+    CCDirector::sharedDirector()->popScene();
+}
+
+double CCBPrototypeBenchmarkLayer::instantiate(bool bUsePrototype, int nCount) {
+    CCNodeLoaderLibrary * ccNodeLoaderLibrary = CCNodeLoaderLibrary::newDefaultCCNodeLoaderLibrary();
+    ccNodeLoaderLibrary->registerCCNodeLoader("TestHeaderLayer", TestHeaderLayerLoader::loader());
+    ccNodeLoaderLibrary->registerCCNodeLoader("TestSpritesLayer", SpriteTestLayerLoader::loader());
+
+    cocos2d::extension::CCBReader::purgePrototypeCache();
+    CCBPrototype * prototype = NULL;
+    if (bUsePrototype) {
+        cocos2d::extension::CCBReader * ccbReader = new cocos2d::extension::CCBReader(ccNodeLoaderLibrary);
+        prototype = ccbReader->getPrototype(s_pBenchmarkCCBFile);
+        CC_SAFE_RETAIN(prototype);
+        ccbReader->release();
+    }
+
+    mAssignedMembers = 0;
+    long long start = CCTime::getMonotonicTimeNs();
+
+    // Release the node graphs every 100 instances to keep the memory bounded
+    CCPoolManager::sharedPoolManager()->push();
+    for (int i = 0; i < nCount; i++) {
+        cocos2d::extension::CCBReader * ccbReader = new cocos2d::extension::CCBReader(ccNodeLoaderLibrary);
+        if (prototype != NULL) {
+            ccbReader->readNodeGraphFromPrototype(prototype, this);
+        } else {
+            ccbReader->readNodeGraphFromFile(s_pBenchmarkCCBFile, this);
+        }
+        ccbReader->release();
+
+        if ((i + 1) % 100 == 0) {
+            CCPoolManager::sharedPoolManager()->pop();
+            CCPoolManager::sharedPoolManager()->push();
+        }
+    }
+    CCPoolManager::sharedPoolManager()->pop();
+
+    double elapsed = (double)(CCTime::getMonotonicTimeNs() - start) / 1000000.0;
+
+    CC_SAFE_RELEASE(prototype);
+    cocos2d::extension::CCBReader::purgePrototypeCache();
+
+    return elapsed;
+}
+
 
 //void CocosBuilderTestScene::runThisTest() {
 //    CCBIReaderLayer * ccbiReaderLayer = CCBIReaderLayer::node();
@@ -58,7 +167,7 @@ void CocosBuilderTestScene::runThisTest() {
 //    CCNodeLoaderLibrary * ccNodeLoaderLibrary = CCNodeLoaderLibrary::newDefaultCCNodeLoaderLibrary();
 //    
 //    /* Create an autorelease CCBReader. */
-//    CCBReader * ccbReader = new CCBReader(ccNodeLoaderLibrary, ccbiReaderLayer, ccbiReaderLayer);
+//    cocos2d::extension::CCBReader * ccbReader = new cocos2d::extension::CCBReader(ccNodeLoaderLibrary, ccbiReaderLayer, ccbiReaderLayer);
 //    ccbReader->autorelease();
 //    
 //    /* Read a ccbi file. */
@@ -2,10 +2,37 @@
 #define _CCBIREADER_TEST_H_
 
 #include "../../testBasic.h"
+#include "cocos-ext.h"
 
 class CocosBuilderTestScene : public TestScene {
     public: 
         virtual void runThisTest();
+
+        void onPrototypeBenchmarkClicked(cocos2d::CCObject * pSender);
+};
+
+/*
+ * Instantiates TestSprites.ccbi a thousand times with readNodeGraphFromFile()
+ * and with readNodeGraphFromPrototype(), and counts the member variables
+ * assigned to the owner by both.
+ */
+class CCBPrototypeBenchmarkLayer
+: public cocos2d::CCLayer
+, public cocos2d::extension::CCBMemberVariableAssigner
+{
+    public:
+        CREATE_FUNC(CCBPrototypeBenchmarkLayer);
+
+        virtual void onEnter();
+        virtual bool onAssignCCBMemberVariable(cocos2d::CCObject * pTarget, const char * pMemberVariableName, cocos2d::CCNode * pNode);
+
+        void backCallback(cocos2d::CCObject * pSender);
+
+    private:
+        /* Returns the time spent in milliseconds. */
+        double instantiate(bool bUsePrototype, int nCount);
+
+        int mAssignedMembers;
 };
 
 #endif
\ No newline at end of file
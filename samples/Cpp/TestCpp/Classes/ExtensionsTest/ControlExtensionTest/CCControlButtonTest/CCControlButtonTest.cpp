@@ -275,3 +275,166 @@ CCControlButton *CCControlButtonTest_Styling::standardButtonWithTitle(const char
     return button;
 }
 
+
+//CCControlButtonTest_Batching
+
+#define BATCHING_COLUMNS 20
+#define BATCHING_ROWS    15
+
+/** Builds a background the way CCScale9Sprite did before the mesh: a batch node of nine sprites. */
+static CCNode *nineSpriteBackground(CCTexture2D *texture, const CCSize& size)
+{
+    CCSize textureSize = texture->getContentSize();
+    float w = textureSize.width / 3;
+    float h = textureSize.height / 3;
+    float sizableWidth = size.width - 2 * w;
+    float sizableHeight = size.height - 2 * h;
+
+    // slices from the top left corner of the texture, the rows go down
+    float x[3] = { 0, w, w + sizableWidth };
+    float y[3] = { h + sizableHeight, h, 0 };
+    float scaleX[3] = { 1, sizableWidth / w, 1 };
+    float scaleY[3] = { 1, sizableHeight / h, 1 };
+
+    CCSpriteBatchNode *batchNode = CCSpriteBatchNode::createWithTexture(texture, 9);
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 3; column++)
+        {
+            CCSprite *sprite = CCSprite::createWithTexture(texture, CCRectMake(column * w, row * h, w, h));
+            sprite->setAnchorPoint(CCPointZero);
+            sprite->setPosition(ccp(x[column], y[row]));
+            sprite->setScaleX(scaleX[column]);
+            sprite->setScaleY(scaleY[row]);
+            batchNode->addChild(sprite);
+        }
+    }
+
+    CCNode *background = CCNode::create();
+    background->setContentSize(size);
+    background->setAnchorPoint(ccp(0.5f, 0.5f));
+    background->addChild(batchNode);
+    return background;
+}
+
+CCControlButtonTest_Batching::CCControlButtonTest_Batching()
+: m_bNineSprites(false)
+, m_bFrameProfiling(false)
+, m_uBytes(0)
+, m_pBackgrounds(NULL)
+, m_pStatsLabel(NULL)
+{
+
+}
+
+bool CCControlButtonTest_Batching::init()
+{
+    if (CCControlScene::init())
+    {
+        CCSize screenSize = CCDirector::sharedDirector()->getWinSize();
+
+        m_pStatsLabel = CCLabelTTF::create("", "Marker Felt", 16);
+        m_pStatsLabel->setPosition(ccp(screenSize.width / 2.0f, 24));
+        addChild(m_pStatsLabel, 2);
+
+        CCMenuItemFont::setFontSize(18);
+        CCMenuItemFont *toggle = CCMenuItemFont::create("Toggle mesh / nine sprites", this, menu_selector(CCControlButtonTest_Batching::toggleModeCallback));
+        CCMenu *menu = CCMenu::create(toggle, NULL);
+        menu->setPosition(ccp(screenSize.width / 2.0f, 48));
+        addChild(menu, 2);
+
+        createBackgrounds();
+        return true;
+    }
+    return false;
+}
+
+void CCControlButtonTest_Batching::createBackgrounds()
+{
+    CCSize screenSize = CCDirector::sharedDirector()->getWinSize();
+
+    if (m_pBackgrounds)
+    {
+        m_pBackgrounds->removeFromParentAndCleanup(true);
+    }
+    m_pBackgrounds = CCNode::create();
+    addChild(m_pBackgrounds, 1);
+
+    CCTexture2D *texture = CCTextureCache::sharedTextureCache()->addImage("extensions/button.png");
+    CCSize size = CCSizeMake(40, 30);
+    for (int row = 0; row < BATCHING_ROWS; row++)
+    {
+        for (int column = 0; column < BATCHING_COLUMNS; column++)
+        {
+            CCNode *background;
+            if (m_bNineSprites)
+            {
+                background = nineSpriteBackground(texture, size);
+            }
+            else
+            {
+                CCScale9Sprite *sprite = CCScale9Sprite::create("extensions/button.png");
+                sprite->setPreferredSize(size);
+                background = sprite;
+            }
+            background->setPosition(ccp(column * (size.width + 2), row * (size.height + 2)));
+            m_pBackgrounds->addChild(background);
+        }
+    }
+
+    // fit the grid between the title and the menu
+    float width = BATCHING_COLUMNS * (size.width + 2);
+    float height = BATCHING_ROWS * (size.height + 2);
+    m_pBackgrounds->setScale(MIN(screenSize.width * 0.9f / width, (screenSize.height - 140) / height));
+    m_pBackgrounds->setAnchorPoint(ccp(0.5f, 0.5f));
+    m_pBackgrounds->setContentSize(CCSizeMake(width, height));
+    m_pBackgrounds->setPosition(ccp(screenSize.width / 2.0f, screenSize.height / 2.0f));
+
+    // estimate from the object sizes, not measured: node objects and client side vertices,
+    // the texture is shared by both and heap blocks owned by the nodes are not counted
+    if (m_bNineSprites)
+    {
+        m_uBytes = sizeof(CCNode) + sizeof(CCSpriteBatchNode) + sizeof(CCTextureAtlas)
+            + 9 * (sizeof(CCSprite) + sizeof(ccV3F_C4B_T2F_Quad) + 6 * sizeof(GLushort));
+    }
+    else
+    {
+        m_uBytes = sizeof(CCScale9Sprite);
+    }
+    m_uBytes *= BATCHING_COLUMNS * BATCHING_ROWS;
+}
+
+void CCControlButtonTest_Batching::onEnter()
+{
+    CCControlScene::onEnter();
+
+    CCDirector *pDirector = CCDirector::sharedDirector();
+    m_bFrameProfiling = pDirector->isFrameProfilingEnabled();
+    pDirector->setFrameProfilingEnabled(true);
+    scheduleUpdate();
+}
+
+void CCControlButtonTest_Batching::onExit()
+{
+    unscheduleUpdate();
+    CCDirector::sharedDirector()->setFrameProfilingEnabled(m_bFrameProfiling);
+
+    CCControlScene::onExit();
+}
+
+void CCControlButtonTest_Batching::update(float dt)
+{
+    const ccDirectorFrameProfile& profile = CCDirector::sharedDirector()->getLastFrameProfile();
+
+    // the nine sprites batch nodes also keep a vertex and an index buffer each on the GPU, estimated the same way
+    unsigned int gpuBytes = m_bNineSprites ? BATCHING_COLUMNS * BATCHING_ROWS * 9 * (sizeof(ccV3F_C4B_T2F_Quad) + 6 * sizeof(GLushort)) : 0;
+    m_pStatsLabel->setString(CCString::createWithFormat("%s: %u draw calls, ~%u KB nodes, ~%u KB buffers (estimated)",
+                                                        m_bNineSprites ? "nine sprites" : "mesh",
+                                                        profile.drawCalls, m_uBytes / 1024, gpuBytes / 1024)->getCString());
+}
+
+void CCControlButtonTest_Batching::toggleModeCallback(CCObject *sender)
+{
+    m_bNineSprites = !m_bNineSprites;
+    createBackgrounds();
+}
@@ -68,5 +68,25 @@ public:
     CONTROL_SCENE_CREATE_FUNC(CCControlButtonTest_Styling)
 };
 
+/** 300 button backgrounds, drawn with the nine-slice mesh or with a batch node of nine sprites each. */
+class CCControlButtonTest_Batching : public CCControlScene
+{
+public:
+    CCControlButtonTest_Batching();
+    bool init();
+    virtual void onEnter();
+    virtual void onExit();
+    virtual void update(float dt);
+    void toggleModeCallback(CCObject *sender);
+protected:
+    void createBackgrounds();
+
+    bool m_bNineSprites;
+    bool m_bFrameProfiling;
+    unsigned int m_uBytes;
+    CCNode *m_pBackgrounds;
+    CCLabelTTF *m_pStatsLabel;
+    CONTROL_SCENE_CREATE_FUNC(CCControlButtonTest_Batching)
+};
 
 #endif /* __CCCONTROLBUTTONTEST_H__ */
@@ -42,6 +42,7 @@ enum
     kCCControlButtonTest_HelloVariableSize,
     kCCControlButtonTest_Event,
     kCCControlButtonTest_Styling,
+    kCCControlButtonTest_Batching,
     kCCControlPotentiometerTest,
     kCCControlStepperTest,
     kCCControlTestMax
@@ -54,6 +55,7 @@ static const char* s_testArray[] = {
     "ControlButtonTest_HelloVariableSize",
     "ControlButtonTest_Event",
     "ControlButtonTest_Styling",
+    "ControlButtonTest_Batching",
     "ControlPotentiometerTest",
     "CCControlStepperTest"
 };
@@ -108,6 +110,7 @@ CCScene *CCControlSceneManager::currentControlScene()
     case kCCControlButtonTest_HelloVariableSize:return CCControlButtonTest_HelloVariableSize::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     case kCCControlButtonTest_Event:return CCControlButtonTest_Event::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     case kCCControlButtonTest_Styling:return CCControlButtonTest_Styling::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
+    case kCCControlButtonTest_Batching:return CCControlButtonTest_Batching::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     case kCCControlPotentiometerTest:return CCControlPotentiometerTest::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     case kCCControlStepperTest:return CCControlStepperTest::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     }
@@ -5,13 +5,32 @@
 USING_NS_CC;
 USING_NS_CC_EXT;
 
+// start tools/http-test-server/server.py on the development machine to run the concurrent test,
+// replace 127.0.0.1 with its address when running on a device
+#define LOCAL_SERVER_URL "http://127.0.0.1:8080/?delay=50&size=2048"
+#define CONCURRENT_REQUESTS 30
+#define LOCAL_DOWNLOAD_URL "http://127.0.0.1:8080/?size=8000000"
+// the server sends the bytes i % 251, so the streamed chunks can be checked in order
+#define LOCAL_STREAM_URL "http://127.0.0.1:8080/?size=1000000"
+#define STREAM_CHUNK_SIZE (16 * 1024)
+
 HttpClientTest::HttpClientTest() 
 : m_labelStatusCode(NULL)
+, m_nConcurrentPending(0)
+, m_nConcurrentFailed(0)
+, m_lConcurrentStart(0)
+, m_dLatencySum(0)
+, m_dLatencyMax(0)
+, m_uConcurrentFirstFrame(0)
+, m_bStreaming(false)
+, m_bStreamOrdered(true)
+, m_uStreamChunks(0)
+, m_lStreamedBytes(0)
 {
     CCSize winSize = CCDirector::sharedDirector()->getWinSize();
 
     const int MARGIN = 40;
-    const int SPACE = 35;
+    const int SPACE = 30;
     
     CCLabelTTF *label = CCLabelTTF::create("Http Request Test", "Arial", 28);
     label->setPosition(ccp(winSize.width / 2, winSize.height - MARGIN));
@@ -50,10 +69,28 @@ HttpClientTest::HttpClientTest()
     CCMenuItemLabel *itemDelete = CCMenuItemLabel::create(labelDelete, this, menu_selector(HttpClientTest::onMenuDeleteTestClicked));
     itemDelete->setPosition(ccp(winSize.width / 2, winSize.height - MARGIN - 5 * SPACE));
     menuRequest->addChild(itemDelete);
+
+    // Concurrent
+    CCLabelTTF *labelConcurrent = CCLabelTTF::create("Test Concurrent (local server)", "Arial", 22);
+    CCMenuItemLabel *itemConcurrent = CCMenuItemLabel::create(labelConcurrent, this, menu_selector(HttpClientTest::onMenuConcurrentTestClicked));
+    itemConcurrent->setPosition(ccp(winSize.width / 2, winSize.height - MARGIN - 6 * SPACE));
+    menuRequest->addChild(itemConcurrent);
+
+    // Download
+    CCLabelTTF *labelDownload = CCLabelTTF::create("Test Download to File (local server)", "Arial", 22);
+    CCMenuItemLabel *itemDownload = CCMenuItemLabel::create(labelDownload, this, menu_selector(HttpClientTest::onMenuDownloadTestClicked));
+    itemDownload->setPosition(ccp(winSize.width / 2, winSize.height - MARGIN - 7 * SPACE));
+    menuRequest->addChild(itemDownload);
+
+    // Stream
+    CCLabelTTF *labelStream = CCLabelTTF::create("Test Streamed Response (local server)", "Arial", 22);
+    CCMenuItemLabel *itemStream = CCMenuItemLabel::create(labelStream, this, menu_selector(HttpClientTest::onMenuStreamTestClicked));
+    itemStream->setPosition(ccp(winSize.width / 2, winSize.height - MARGIN - 8 * SPACE));
+    menuRequest->addChild(itemStream);
     
     // Response Code Label
     m_labelStatusCode = CCLabelTTF::create("HTTP Status Code", "Marker Felt", 20);
-    m_labelStatusCode->setPosition(ccp(winSize.width / 2,  winSize.height - MARGIN - 6 * SPACE));
+    m_labelStatusCode->setPosition(ccp(winSize.width / 2,  winSize.height - MARGIN - 9 * SPACE));
     addChild(m_labelStatusCode);
     
     // Back Menu
@@ -245,6 +282,152 @@ void HttpClientTest::onMenuDeleteTestClicked(CCObject *sender)
     m_labelStatusCode->setString("waiting...");
 }
 
+void HttpClientTest::onMenuConcurrentTestClicked(CCObject *sender)
+{
+    if (m_nConcurrentPending > 0)
+    {
+        return;
+    }
+
+    m_nConcurrentPending = CONCURRENT_REQUESTS;
+    m_nConcurrentFailed = 0;
+    m_dLatencySum = 0;
+    m_dLatencyMax = 0;
+    m_uConcurrentFirstFrame = CCDirector::sharedDirector()->getTotalFrames();
+    m_lConcurrentStart = CCTime::getMonotonicTimeNs();
+
+    // like a lobby firing all its API calls at once
+    for (int i = 0; i < CONCURRENT_REQUESTS; ++i)
+    {
+        CCHttpRequest* request = new CCHttpRequest();
+        request->setUrl(LOCAL_SERVER_URL);
+        request->setRequestType(CCHttpRequest::kHttpGet);
+        request->setResponseCallback(this, httpresponse_selector(HttpClientTest::onConcurrentRequestCompleted));
+        request->setTag("Concurrent test");
+        CCHttpClient::getInstance()->send(request);
+        request->release();
+    }
+
+    m_labelStatusCode->setString("waiting...");
+}
+
+void HttpClientTest::onConcurrentRequestCompleted(CCHttpClient *sender, CCHttpResponse *response)
+{
+    if (!response->isSucceed())
+    {
+        ++m_nConcurrentFailed;
+    }
+
+    double latency = (CCTime::getMonotonicTimeNs() - m_lConcurrentStart) / 1000000.0;
+    m_dLatencySum += latency;
+    m_dLatencyMax = MAX(m_dLatencyMax, latency);
+
+    if (--m_nConcurrentPending > 0)
+    {
+        return;
+    }
+
+    unsigned int frames = CCDirector::sharedDirector()->getTotalFrames() - m_uConcurrentFirstFrame;
+    char statusString[128] = {};
+    sprintf(statusString, "%d requests, %d failed: mean %.0f ms, last %.0f ms, %u frames",
+            CONCURRENT_REQUESTS, m_nConcurrentFailed, m_dLatencySum / CONCURRENT_REQUESTS, m_dLatencyMax, frames);
+    m_labelStatusCode->setString(statusString);
+    CCLog("%s", statusString);
+}
+
+void HttpClientTest::onMenuDownloadTestClicked(CCObject *sender)
+{
+    // the body goes straight to the file, clicking again while it downloads or after a failure
+    // resumes the partial file with a Range request
+    std::string path = CCFileUtils::sharedFileUtils()->getWritablePath() + "http-download-test.bin";
+
+    CCHttpRequest* request = new CCHttpRequest();
+    request->setUrl(LOCAL_DOWNLOAD_URL);
+    request->setRequestType(CCHttpRequest::kHttpGet);
+    request->setDownloadFile(path.c_str(), true);
+    request->setResponseCallback(this, httpresponse_selector(HttpClientTest::onDownloadCompleted));
+    request->setTag("Download test");
+    CCHttpClient::getInstance()->send(request);
+    request->release();
+
+    m_labelStatusCode->setString("waiting...");
+}
+
+void HttpClientTest::onDownloadCompleted(CCHttpClient *sender, CCHttpResponse *response)
+{
+    char statusString[128] = {};
+    if (response->isSucceed())
+    {
+        sprintf(statusString, "HTTP Status Code: %d, %lld bytes written", response->getResponseCode(), response->getReceivedBytes());
+    }
+    else
+    {
+        sprintf(statusString, "Download failed: %.100s", response->getErrorBuffer());
+    }
+    m_labelStatusCode->setString(statusString);
+    CCLog("%s", statusString);
+}
+
+void HttpClientTest::onMenuStreamTestClicked(CCObject *sender)
+{
+    if (m_bStreaming)
+    {
+        return;
+    }
+
+    m_bStreaming = true;
+    m_bStreamOrdered = true;
+    m_uStreamChunks = 0;
+    m_lStreamedBytes = 0;
+
+    // the body is handed over in pieces while it downloads, the response callback comes last
+    CCHttpRequest* request = new CCHttpRequest();
+    request->setUrl(LOCAL_STREAM_URL);
+    request->setRequestType(CCHttpRequest::kHttpGet);
+    request->setResponseChunkCallback(this, httpresponsechunk_selector(HttpClientTest::onStreamChunkReceived), STREAM_CHUNK_SIZE);
+    request->setResponseCallback(this, httpresponse_selector(HttpClientTest::onStreamCompleted));
+    request->setTag("Stream test");
+    CCHttpClient::getInstance()->send(request);
+    request->release();
+
+    m_labelStatusCode->setString("waiting...");
+}
+
+void HttpClientTest::onStreamChunkReceived(CCHttpClient *sender, CCHttpResponse *response, std::vector<char> *chunk)
+{
+    // a lost, repeated or reordered chunk breaks the sequence of the bytes
+    for (unsigned int i = 0; i < chunk->size() && m_bStreamOrdered; i++)
+    {
+        if ((unsigned char)(*chunk)[i] != (m_lStreamedBytes + i) % 251)
+        {
+            m_bStreamOrdered = false;
+        }
+    }
+    m_lStreamedBytes += chunk->size();
+    ++m_uStreamChunks;
+}
+
+void HttpClientTest::onStreamCompleted(CCHttpClient *sender, CCHttpResponse *response)
+{
+    m_bStreaming = false;
+
+    char statusString[128] = {};
+    if (!response->isSucceed())
+    {
+        sprintf(statusString, "Stream failed: %.100s", response->getErrorBuffer());
+    }
+    else
+    {
+        // the chunks carry the whole body, the response keeps none of it
+        bool passed = m_bStreamOrdered && m_uStreamChunks > 1
+            && m_lStreamedBytes == response->getReceivedBytes() && response->getResponseData()->empty();
+        sprintf(statusString, "%s: %u chunks, %lld of %lld bytes%s", passed ? "Stream passed" : "Stream FAILED",
+                m_uStreamChunks, m_lStreamedBytes, response->getReceivedBytes(), m_bStreamOrdered ? "" : ", out of order");
+    }
+    m_labelStatusCode->setString(statusString);
+    CCLog("%s", statusString);
+}
+
 void HttpClientTest::onHttpRequestCompleted(CCHttpClient *sender, CCHttpResponse *response)
 {
     if (!response)
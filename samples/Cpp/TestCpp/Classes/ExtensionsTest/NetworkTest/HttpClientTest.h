@@ -17,12 +17,33 @@ public:
     void onMenuPostBinaryTestClicked(cocos2d::CCObject *sender);
     void onMenuPutTestClicked(cocos2d::CCObject *sender);
     void onMenuDeleteTestClicked(cocos2d::CCObject *sender);
+    void onMenuConcurrentTestClicked(cocos2d::CCObject *sender);
+    void onMenuDownloadTestClicked(cocos2d::CCObject *sender);
+    void onMenuStreamTestClicked(cocos2d::CCObject *sender);
     
     //Http Response Callback
     void onHttpRequestCompleted(cocos2d::extension::CCHttpClient *sender, cocos2d::extension::CCHttpResponse *response);
+    void onConcurrentRequestCompleted(cocos2d::extension::CCHttpClient *sender, cocos2d::extension::CCHttpResponse *response);
+    void onDownloadCompleted(cocos2d::extension::CCHttpClient *sender, cocos2d::extension::CCHttpResponse *response);
+    void onStreamChunkReceived(cocos2d::extension::CCHttpClient *sender, cocos2d::extension::CCHttpResponse *response, std::vector<char> *chunk);
+    void onStreamCompleted(cocos2d::extension::CCHttpClient *sender, cocos2d::extension::CCHttpResponse *response);
 
 private:
     cocos2d::CCLabelTTF* m_labelStatusCode;
+
+    // concurrent test statistics
+    int          m_nConcurrentPending;
+    int          m_nConcurrentFailed;
+    long long    m_lConcurrentStart;
+    double       m_dLatencySum;
+    double       m_dLatencyMax;
+    unsigned int m_uConcurrentFirstFrame;
+
+    // streaming test state
+    bool         m_bStreaming;
+    bool         m_bStreamOrdered;
+    unsigned int m_uStreamChunks;
+    long long    m_lStreamedBytes;
 };
 
 void runHttpClientTest();
@@ -8,19 +8,29 @@
 
 #include "WebSocketTest.h"
 #include "../ExtensionsTest.h"
+#include <algorithm>
 
 USING_NS_CC;
 USING_NS_CC_EXT;
 
+// start tools/websocket-echo-server/server.py on the development machine to run the latency test,
+// replace 127.0.0.1 with its address when running on a device
+#define LOCAL_ECHO_SERVER_URL "ws://127.0.0.1:8081/"
+#define LATENCY_PROBES 200
+#define LATENCY_PROBE_SIZE 64
+
 WebSocketTestLayer::WebSocketTestLayer()
 : _wsiSendText(NULL)
 , _wsiSendBinary(NULL)
 , _wsiError(NULL)
+, _wsiLatency(NULL)
 , _sendTextStatus(NULL)
 , _sendBinaryStatus(NULL)
 , _errorStatus(NULL)
+, _latencyStatus(NULL)
 , _sendTextTimes(0)
 , _sendBinaryTimes(0)
+, _latencyProbeStart(0)
 {
     CCSize winSize = CCDirector::sharedDirector()->getWinSize();
     
@@ -47,6 +57,16 @@ WebSocketTestLayer::WebSocketTestLayer()
     itemSendBinary->setPosition(ccp(winSize.width / 2, winSize.height - MARGIN - 2 * SPACE));
     menuRequest->addChild(itemSendBinary);
     
+    // Echo Latency
+    CCLabelTTF *labelEchoLatency = CCLabelTTF::create("Echo Latency (local server)", "Arial", 22);
+    CCMenuItemLabel *itemEchoLatency = CCMenuItemLabel::create(labelEchoLatency, this, menu_selector(WebSocketTestLayer::onMenuEchoLatencyClicked));
+    itemEchoLatency->setPosition(ccp(winSize.width / 2, winSize.height - MARGIN - 3 * SPACE));
+    menuRequest->addChild(itemEchoLatency);
+
+    // Echo Latency Status Label
+    _latencyStatus = CCLabelTTF::create("", "Arial", 14);
+    _latencyStatus->setPosition(ccp(winSize.width / 2, winSize.height - MARGIN - 4 * SPACE));
+    this->addChild(_latencyStatus);
 
     // Send Text Status Label
     _sendTextStatus = CCLabelTTF::create("Send Text WS is waiting...", "Arial", 14, CCSizeMake(160, 100), kCCTextAlignmentCenter, kCCVerticalTextAlignmentTop);
@@ -104,6 +124,9 @@ WebSocketTestLayer::~WebSocketTestLayer()
     
     if (_wsiError)
         _wsiError->close();
+
+    if (_wsiLatency)
+        _wsiLatency->close();
 }
 
 // Delegate methods
@@ -118,6 +141,11 @@ void WebSocketTestLayer::onOpen(cocos2d::extension::WebSocket* ws)
     {
         _sendBinaryStatus->setString("Send Binary WS was opened.");
     }
+    else if (ws == _wsiLatency)
+    {
+        _latencies.clear();
+        sendLatencyProbe();
+    }
     else if (ws == _wsiError)
     {
         CCAssert(0, "error test will never go here.");
@@ -126,6 +154,32 @@ void WebSocketTestLayer::onOpen(cocos2d::extension::WebSocket* ws)
 
 void WebSocketTestLayer::onMessage(cocos2d::extension::WebSocket* ws, const cocos2d::extension::WebSocket::Data& data)
 {
+    if (ws == _wsiLatency)
+    {
+        _latencies.push_back((CCTime::getMonotonicTimeNs() - _latencyProbeStart) / 1000000.0);
+        if (_latencies.size() < LATENCY_PROBES)
+        {
+            sendLatencyProbe();
+            return;
+        }
+
+        // replies are dispatched once per frame, so the round trips include the wait for the next frame
+        std::sort(_latencies.begin(), _latencies.end());
+        double sum = 0;
+        for (unsigned int i = 0; i < _latencies.size(); ++i)
+        {
+            sum += _latencies[i];
+        }
+        char status[128] = {0};
+        sprintf(status, "%d round trips: mean %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+                LATENCY_PROBES, sum / _latencies.size(), _latencies[_latencies.size() / 2],
+                _latencies[_latencies.size() * 99 / 100], _latencies.back());
+        CCLog("%s", status);
+        _latencyStatus->setString(status);
+        _wsiLatency->close();
+        return;
+    }
+
     if (!data.isBinary)
     {
         _sendTextTimes++;
@@ -176,6 +230,10 @@ void WebSocketTestLayer::onClose(cocos2d::extension::WebSocket* ws)
     {
         _wsiError = NULL;
     }
+    else if (ws == _wsiLatency)
+    {
+        _wsiLatency = NULL;
+    }
     // Delete websocket instance.
     CC_SAFE_DELETE(ws);
 }
@@ -189,6 +247,10 @@ void WebSocketTestLayer::onError(cocos2d::extension::WebSocket* ws, const cocos2
         sprintf(buf, "an error was fired, code: %d", error);
         _errorStatus->setString(buf);
     }
+    else if (ws == _wsiLatency)
+    {
+        _latencyStatus->setString("Can't connect to the local echo server");
+    }
 }
 
 void WebSocketTestLayer::toExtensionsMainLayer(cocos2d::CCObject *sender)
@@ -230,6 +292,28 @@ void WebSocketTestLayer::onMenuSendBinaryClicked(cocos2d::CCObject *sender)
     }
 }
 
+void WebSocketTestLayer::onMenuEchoLatencyClicked(cocos2d::CCObject *sender)
+{
+    if (_wsiLatency)
+    {
+        return;
+    }
+
+    _latencyStatus->setString("Measuring...");
+    _wsiLatency = new WebSocket();
+    if (!_wsiLatency->init(*this, LOCAL_ECHO_SERVER_URL))
+    {
+        CC_SAFE_DELETE(_wsiLatency);
+    }
+}
+
+void WebSocketTestLayer::sendLatencyProbe()
+{
+    unsigned char probe[LATENCY_PROBE_SIZE] = {0};
+    _latencyProbeStart = CCTime::getMonotonicTimeNs();
+    _wsiLatency->send(probe, sizeof(probe));
+}
+
 void runWebSocketTest()
 {
     CCScene *pScene = CCScene::create();
@@ -31,18 +31,26 @@ public:
     // Menu Callbacks
     void onMenuSendTextClicked(cocos2d::CCObject *sender);
     void onMenuSendBinaryClicked(cocos2d::CCObject *sender);
+    void onMenuEchoLatencyClicked(cocos2d::CCObject *sender);
 
 private:
     cocos2d::extension::WebSocket* _wsiSendText;
     cocos2d::extension::WebSocket* _wsiSendBinary;
     cocos2d::extension::WebSocket* _wsiError;
+    cocos2d::extension::WebSocket* _wsiLatency;
     
     cocos2d::CCLabelTTF* _sendTextStatus;
     cocos2d::CCLabelTTF* _sendBinaryStatus;
     cocos2d::CCLabelTTF* _errorStatus;
+    cocos2d::CCLabelTTF* _latencyStatus;
     
     int _sendTextTimes;
     int _sendBinaryTimes;
+
+    // echo latency benchmark
+    void sendLatencyProbe();
+    std::vector<double> _latencies;
+    long long _latencyProbeStart;
 };
 
 void runWebSocketTest();
@@ -38,6 +38,16 @@ bool TableViewTestLayer::init()
 	this->addChild(tableView);
 	tableView->reloadData();
 
+    // a long list, flings only request two cells per frame from the data source
+    m_pLeaderboard = CCTableView::create(this, CCSizeMake(120, 250));
+    m_pLeaderboard->setDirection(kCCScrollViewDirectionVertical);
+    m_pLeaderboard->setPosition(ccp(winSize.width/2-40,winSize.height/2-120));
+    m_pLeaderboard->setDelegate(this);
+    m_pLeaderboard->setVerticalFillOrder(kCCTableViewFillTopDown);
+    m_pLeaderboard->setCellCreationBudget(2);
+    this->addChild(m_pLeaderboard);
+    m_pLeaderboard->reloadData();
+
 	// Back Menu
 	CCMenuItemFont *itemBack = CCMenuItemFont::create("Back", this, menu_selector(TableViewTestLayer::toExtensionsMainLayer));
 	itemBack->setPosition(ccp(VisibleRect::rightBottom().x - 50, VisibleRect::rightBottom().y + 25));
@@ -62,6 +72,9 @@ void TableViewTestLayer::tableCellTouched(CCTableView* table, CCTableViewCell* c
 
 CCSize TableViewTestLayer::tableCellSizeForIndex(CCTableView *table, unsigned int idx)
 {
+    if (table == m_pLeaderboard) {
+        return idx % 100 == 0 ? CCSizeMake(120, 30) : CCSizeMake(120, 24);
+    }
     if (idx == 2) {
         return CCSizeMake(100, 100);
     }
@@ -70,6 +83,9 @@ CCSize TableViewTestLayer::tableCellSizeForIndex(CCTableView *table, unsigned in
 
 CCTableViewCell* TableViewTestLayer::tableCellAtIndex(CCTableView *table, unsigned int idx)
 {
+    if (table == m_pLeaderboard) {
+        return leaderboardCellAtIndex(table, idx);
+    }
     CCString *string = CCString::createWithFormat("%d", idx);
     CCTableViewCell *cell = table->dequeueCell();
     if (!cell) {
@@ -98,5 +114,36 @@ CCTableViewCell* TableViewTestLayer::tableCellAtIndex(CCTableView *table, unsign
 
 unsigned int TableViewTestLayer::numberOfCellsInTableView(CCTableView *table)
 {
+    if (table == m_pLeaderboard) {
+        return 10000;
+    }
     return 20;
 }
+
+CCTableViewCell* TableViewTestLayer::leaderboardCellAtIndex(CCTableView *table, unsigned int idx)
+{
+    bool header = idx % 100 == 0;
+    const char *identifier = header ? "header" : "row";
+    CCString *string = header ? CCString::createWithFormat("Top %d", idx + 100) : CCString::createWithFormat("#%d", idx + 1);
+
+    CCTableViewCell *cell = table->dequeueCell(identifier);
+    if (!cell) {
+        cell = new CustomTableViewCell();
+        cell->autorelease();
+        cell->setReuseIdentifier(identifier);
+
+        CCLabelTTF *label = CCLabelTTF::create(string->getCString(), "Helvetica", header ? 22.0 : 16.0);
+        label->setPosition(CCPointZero);
+        label->setAnchorPoint(CCPointZero);
+        label->setColor(header ? ccYELLOW : ccWHITE);
+        label->setTag(123);
+        cell->addChild(label);
+    }
+    else
+    {
+        CCLabelTTF *label = (CCLabelTTF*)cell->getChildByTag(123);
+        label->setString(string->getCString());
+    }
+
+    return cell;
+}
@@ -9,6 +9,7 @@ void runTableViewTest();
 class TableViewTestLayer : public cocos2d::CCLayer, public cocos2d::extension::CCTableViewDataSource, public cocos2d::extension::CCTableViewDelegate
 {
 public:
+    TableViewTestLayer() : m_pLeaderboard(NULL) {}
     virtual bool init();  
    
 	void toExtensionsMainLayer(cocos2d::CCObject *sender);
@@ -21,6 +22,11 @@ public:
     virtual cocos2d::CCSize tableCellSizeForIndex(cocos2d::extension::CCTableView *table, unsigned int idx);
     virtual cocos2d::extension::CCTableViewCell* tableCellAtIndex(cocos2d::extension::CCTableView *table, unsigned int idx);
     virtual unsigned int numberOfCellsInTableView(cocos2d::extension::CCTableView *table);
+
+protected:
+    /** 10000 rows with a header cell every 100 rows, the two kinds of cells have their own free list */
+    cocos2d::extension::CCTableView* m_pLeaderboard;
+    cocos2d::extension::CCTableViewCell* leaderboardCellAtIndex(cocos2d::extension::CCTableView *table, unsigned int idx);
 };
 
 #endif // __TABLEVIEWTESTSCENE_H__
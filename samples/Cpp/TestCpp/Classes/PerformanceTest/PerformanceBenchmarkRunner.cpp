@@ -0,0 +1,592 @@
+#include "PerformanceBenchmarkRunner.h"
+#include "PerformanceNodeChildrenTest.h"
+#include "PerformanceParticleTest.h"
+#include "PerformanceSpriteTest.h"
+#include "../SpineTest/SpineTest.h"
+
+#include <algorithm>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Allocation counter.
+ * The global operator new is replaced so that the runner can report how many
+ * allocations a frame does. On Windows the engine is a separate DLL with its
+ * own allocator, so the counter would only see the test code: it is disabled there.
+ */
+#ifndef CC_BENCHMARK_COUNT_ALLOCATIONS
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_WINRT) || (CC_TARGET_PLATFORM == CC_PLATFORM_WP8)
+#define CC_BENCHMARK_COUNT_ALLOCATIONS 0
+#else
+#define CC_BENCHMARK_COUNT_ALLOCATIONS 1
+#endif
+#endif
+
+#if CC_BENCHMARK_COUNT_ALLOCATIONS
+#include <atomic>
+
+static std::atomic<unsigned long> s_uAllocationCount(0);
+static std::atomic<unsigned long> s_uAllocatedBytes(0);
+
+static void* countedAlloc(std::size_t size)
+{
+    s_uAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    s_uAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size)
+{
+    void* p = countedAlloc(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    void* p = countedAlloc(size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) throw()
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+    free(p);
+}
+
+unsigned long PerformanceBenchmarkRunner::getAllocationCount()
+{
+    return s_uAllocationCount.load(std::memory_order_relaxed);
+}
+
+unsigned long PerformanceBenchmarkRunner::getAllocatedBytes()
+{
+    return s_uAllocatedBytes.load(std::memory_order_relaxed);
+}
+#else
+unsigned long PerformanceBenchmarkRunner::getAllocationCount()
+{
+    return 0;
+}
+
+unsigned long PerformanceBenchmarkRunner::getAllocatedBytes()
+{
+    return 0;
+}
+#endif // CC_BENCHMARK_COUNT_ALLOCATIONS
+
+enum
+{
+    kDefaultWarmupFrames = 60,
+    kDefaultMeasuredFrames = 300,
+};
+
+////////////////////////////////////////////////////////
+//
+// Scenario creators
+//
+////////////////////////////////////////////////////////
+template <class T>
+static CCScene* createSpriteScene(int nSubTest, int nQuantity)
+{
+    T* pScene = new T;
+    pScene->initWithSubTest(nSubTest, nQuantity);
+    return pScene;
+}
+
+template <class T>
+static CCScene* createNodeChildrenScene(int nSubTest, int nQuantity)
+{
+    T* pScene = new T;
+    pScene->initWithQuantityOfNodes(nQuantity);
+    return pScene;
+}
+
+template <class T>
+static CCScene* createParticleScene(int nSubTest, int nQuantity)
+{
+    T* pScene = new T;
+    pScene->initWithSubTest(nSubTest, nQuantity);
+    return pScene;
+}
+
+static CCScene* createSpineCrowdScene(int nSubTest, int nQuantity)
+{
+    CCScene* pScene = new CCScene;
+    pScene->init();
+    pScene->addChild(SpineCrowdTestLayer::create(nSubTest, nQuantity));
+    return pScene;
+}
+
+static const char* platformName()
+{
+    switch (CCApplication::sharedApplication()->getTargetPlatform())
+    {
+    case kTargetWindows:    return "win32";
+    case kTargetLinux:      return "linux";
+    case kTargetMacOS:      return "mac";
+    case kTargetAndroid:    return "android";
+    case kTargetIphone:     return "iphone";
+    case kTargetIpad:       return "ipad";
+    case kTargetBlackBerry: return "blackberry";
+    case kTargetNaCl:       return "nacl";
+    case kTargetEmscripten: return "emscripten";
+    case kTargetTizen:      return "tizen";
+    case kTargetWinRT:      return "winrt";
+    case kTargetWP8:        return "wp8";
+    default:                return "unknown";
+    }
+}
+
+static std::string jsonString(const char* psz)
+{
+    std::string ret = "\"";
+    for (const char* p = psz ? psz : ""; *p; ++p)
+    {
+        char c = *p;
+        if (c == '"' || c == '\\')
+        {
+            ret += '\\';
+            ret += c;
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            char buf[8];
+            sprintf(buf, "\\u%04x", (unsigned int)(unsigned char)c);
+            ret += buf;
+        }
+        else
+        {
+            ret += c;
+        }
+    }
+    ret += '"';
+    return ret;
+}
+
+static unsigned int envUInt(const char* pszName, unsigned int uDefault)
+{
+    const char* pszValue = getenv(pszName);
+    if (pszValue && *pszValue)
+    {
+        int nValue = atoi(pszValue);
+        if (nValue > 0)
+        {
+            return (unsigned int)nValue;
+        }
+    }
+    return uDefault;
+}
+
+////////////////////////////////////////////////////////
+//
+// PerformanceBenchmarkRunner
+//
+////////////////////////////////////////////////////////
+static PerformanceBenchmarkRunner* s_pSharedRunner = NULL;
+
+PerformanceBenchmarkRunner* PerformanceBenchmarkRunner::sharedRunner()
+{
+    if (!s_pSharedRunner)
+    {
+        s_pSharedRunner = new PerformanceBenchmarkRunner();
+        s_pSharedRunner->addDefaultScenarios();
+    }
+    return s_pSharedRunner;
+}
+
+PerformanceBenchmarkRunner::PerformanceBenchmarkRunner()
+: m_bRunning(false)
+, m_bExitWhenDone(false)
+, m_bDisplayStats(false)
+, m_uWarmupFrames(kDefaultWarmupFrames)
+, m_uMeasuredFrames(kDefaultMeasuredFrames)
+, m_uCurrentScenario(0)
+, m_uFrame(0)
+, m_uLastAllocations(0)
+, m_uLastAllocatedBytes(0)
+, m_pScene(NULL)
+{
+}
+
+void PerformanceBenchmarkRunner::addScenario(const char* pszGroup, const char* pszName, int nSubTest, int nQuantity, SceneCreator creator)
+{
+    Scenario scenario;
+    scenario.group = pszGroup;
+    scenario.name = pszName;
+    scenario.subTest = nSubTest;
+    scenario.quantity = nQuantity;
+    scenario.creator = creator;
+    m_scenarios.push_back(scenario);
+}
+
+void PerformanceBenchmarkRunner::addDefaultScenarios()
+{
+    static const int spriteCounts[] = { 500, 2000, 5000 };
+    for (unsigned int i = 0; i < sizeof(spriteCounts) / sizeof(spriteCounts[0]); ++i)
+    {
+        char name[64];
+        // subtests 1, 3 and 4 are: no batch RGBA8888, batch RGBA8888 and batch RGBA4444
+        sprintf(name, "sprite.position.nobatch.rgba8888.%d", spriteCounts[i]);
+        addScenario("sprite", name, 1, spriteCounts[i], createSpriteScene<SpritePerformTest1>);
+        sprintf(name, "sprite.position.batch.rgba8888.%d", spriteCounts[i]);
+        addScenario("sprite", name, 3, spriteCounts[i], createSpriteScene<SpritePerformTest1>);
+        sprintf(name, "sprite.position.batch.rgba4444.%d", spriteCounts[i]);
+        addScenario("sprite", name, 4, spriteCounts[i], createSpriteScene<SpritePerformTest1>);
+    }
+    addScenario("sprite", "sprite.scalerot.batch.rgba8888.2000", 3, 2000, createSpriteScene<SpritePerformTest3>);
+    addScenario("sprite", "sprite.actions.batch.rgba8888.2000", 3, 2000, createSpriteScene<SpritePerformTest6>);
+    addScenario("sprite", "sprite.actions5.batch.rgba8888.8000", 3, 8000, createSpriteScene<SpritePerformTest8>);
+
+    static const int nodeCounts[] = { 1000, 5000 };
+    for (unsigned int i = 0; i < sizeof(nodeCounts) / sizeof(nodeCounts[0]); ++i)
+    {
+        char name[64];
+        sprintf(name, "nodechildren.iterate.%d", nodeCounts[i]);
+        addScenario("nodechildren", name, 0, nodeCounts[i], createNodeChildrenScene<IterateSpriteSheetCArray>);
+        sprintf(name, "nodechildren.addremove.%d", nodeCounts[i]);
+        addScenario("nodechildren", name, 0, nodeCounts[i], createNodeChildrenScene<AddSpriteSheet>);
+        sprintf(name, "nodechildren.reorder.%d", nodeCounts[i]);
+        addScenario("nodechildren", name, 0, nodeCounts[i], createNodeChildrenScene<ReorderSpriteSheet>);
+        sprintf(name, "nodechildren.visit.%d", nodeCounts[i]);
+        addScenario("nodechildren", name, 0, nodeCounts[i], createNodeChildrenScene<VisitSceneGraph>);
+    }
+
+    static const int particleCounts[] = { 500, 2000 };
+    static const char* particleFormats[] = { "rgba8888", "rgba4444", "a8" };
+    for (unsigned int i = 0; i < sizeof(particleCounts) / sizeof(particleCounts[0]); ++i)
+    {
+        // subtests 1 to 3 only differ by the texture format
+        for (int nFormat = 0; nFormat < 3; ++nFormat)
+        {
+            char name[64];
+            sprintf(name, "particle.size4.%s.%d", particleFormats[nFormat], particleCounts[i]);
+            addScenario("particle", name, nFormat + 1, particleCounts[i], createParticleScene<ParticlePerformTest1>);
+        }
+    }
+    addScenario("particle", "particle.size64.rgba8888.2000", 1, 2000, createParticleScene<ParticlePerformTest2>);
+
+    addScenario("spine", "spine.crowd.serial.500", SpineCrowdTestLayer::kModeSerial, 500, createSpineCrowdScene);
+    addScenario("spine", "spine.crowd.parallel.500", SpineCrowdTestLayer::kModeParallel, 500, createSpineCrowdScene);
+    addScenario("spine", "spine.crowd.reducedrate.500", SpineCrowdTestLayer::kModeParallelReducedRate, 500, createSpineCrowdScene);
+}
+
+void PerformanceBenchmarkRunner::start(bool bExitWhenDone)
+{
+    if (m_bRunning)
+    {
+        return;
+    }
+
+    m_bExitWhenDone = bExitWhenDone;
+    m_uWarmupFrames = envUInt("COCOS2D_BENCHMARK_WARMUP", kDefaultWarmupFrames);
+    m_uMeasuredFrames = envUInt("COCOS2D_BENCHMARK_FRAMES", kDefaultMeasuredFrames);
+
+    const char* pszValue = getenv("COCOS2D_BENCHMARK_FILTER");
+    m_strFilter = pszValue ? pszValue : "";
+    pszValue = getenv("COCOS2D_BENCHMARK_LABEL");
+    m_strLabel = pszValue ? pszValue : "";
+    pszValue = getenv("COCOS2D_BENCHMARK_OUTPUT");
+    m_strOutputPath = (pszValue && *pszValue) ? pszValue : CCFileUtils::sharedFileUtils()->getWritablePath();
+    if (m_strOutputPath.length() && m_strOutputPath[m_strOutputPath.length() - 1] != '/')
+    {
+        m_strOutputPath += '/';
+    }
+
+    m_results.clear();
+    m_uCurrentScenario = 0;
+    m_pScene = NULL;
+    m_bRunning = true;
+
+    CCDirector* pDirector = CCDirector::sharedDirector();
+    // the stats labels would be part of every measured frame
+    m_bDisplayStats = pDirector->isDisplayStats();
+    pDirector->setDisplayStats(false);
+    pDirector->setFrameProfilingEnabled(true);
+    pDirector->getScheduler()->scheduleUpdateForTarget(this, kCCPrioritySystem, false);
+
+    CCLOG("benchmark: %u scenarios, %u warm-up and %u measured frames each",
+          (unsigned int)m_scenarios.size(), m_uWarmupFrames, m_uMeasuredFrames);
+}
+
+void PerformanceBenchmarkRunner::startScenario()
+{
+    // skip the scenarios rejected by the filter
+    while (m_uCurrentScenario < m_scenarios.size() &&
+           m_strFilter.length() &&
+           m_scenarios[m_uCurrentScenario].name.find(m_strFilter) == std::string::npos)
+    {
+        ++m_uCurrentScenario;
+    }
+
+    if (m_uCurrentScenario >= m_scenarios.size())
+    {
+        finish();
+        return;
+    }
+
+    const Scenario& scenario = m_scenarios[m_uCurrentScenario];
+    CCLOG("benchmark: running %s", scenario.name.c_str());
+
+    // textures of the previous scenario could otherwise be reused with the wrong format
+    CCTextureCache::sharedTextureCache()->removeUnusedTextures();
+
+    m_pScene = scenario.creator(scenario.subTest, scenario.quantity);
+    CCDirector::sharedDirector()->replaceScene(m_pScene);
+    m_pScene->release();
+
+    m_uFrame = 0;
+    m_update.clear();
+    m_visit.clear();
+    m_draw.clear();
+    m_swap.clear();
+    m_total.clear();
+    m_dt.clear();
+    m_drawCalls.clear();
+    m_allocations.clear();
+    m_allocatedBytes.clear();
+}
+
+void PerformanceBenchmarkRunner::update(float dt)
+{
+    CCDirector* pDirector = CCDirector::sharedDirector();
+    unsigned long uAllocations = getAllocationCount();
+    unsigned long uAllocatedBytes = getAllocatedBytes();
+
+    // the first scenario is started from the main loop, once the director runs a scene
+    if (m_bRunning && !m_pScene && pDirector->getRunningScene())
+    {
+        startScenario();
+    }
+
+    // the scene is only switched at the end of the director update
+    if (!m_bRunning || pDirector->getRunningScene() != m_pScene)
+    {
+        m_uLastAllocations = uAllocations;
+        m_uLastAllocatedBytes = uAllocatedBytes;
+        return;
+    }
+
+    if (m_uFrame++ >= m_uWarmupFrames)
+    {
+        // the profile covers the previous frame, which already ran with the scenario scene
+        const ccDirectorFrameProfile& profile = pDirector->getLastFrameProfile();
+        m_update.push_back(profile.update * 1000.0);
+        m_visit.push_back(profile.visit * 1000.0);
+        m_draw.push_back(profile.draw * 1000.0);
+        m_swap.push_back(profile.swap * 1000.0);
+        m_total.push_back(profile.total * 1000.0);
+        m_dt.push_back(dt * 1000.0);
+        m_drawCalls.push_back(profile.drawCalls);
+        m_allocations.push_back((double)(uAllocations - m_uLastAllocations));
+        m_allocatedBytes.push_back((double)(uAllocatedBytes - m_uLastAllocatedBytes));
+    }
+
+    m_uLastAllocations = uAllocations;
+    m_uLastAllocatedBytes = uAllocatedBytes;
+
+    if (m_total.size() >= m_uMeasuredFrames)
+    {
+        finishScenario();
+        ++m_uCurrentScenario;
+        startScenario();
+    }
+}
+
+PerformanceBenchmarkRunner::Statistics PerformanceBenchmarkRunner::computeStatistics(std::vector<double>& samples)
+{
+    Statistics stats = { 0, 0, 0, 0, 0 };
+    if (samples.empty())
+    {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    size_t count = samples.size();
+    double sum = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        sum += samples[i];
+    }
+
+    // nearest rank percentiles
+    stats.mean = sum / count;
+    stats.p50 = samples[(count * 50 + 99) / 100 - 1];
+    stats.p90 = samples[(count * 90 + 99) / 100 - 1];
+    stats.p99 = samples[(count * 99 + 99) / 100 - 1];
+    stats.max = samples[count - 1];
+    return stats;
+}
+
+void PerformanceBenchmarkRunner::finishScenario()
+{
+    Result result;
+    result.scenario = m_scenarios[m_uCurrentScenario];
+    result.frames = (unsigned int)m_total.size();
+    result.update = computeStatistics(m_update);
+    result.visit = computeStatistics(m_visit);
+    result.draw = computeStatistics(m_draw);
+    result.swap = computeStatistics(m_swap);
+    result.total = computeStatistics(m_total);
+    result.dt = computeStatistics(m_dt);
+    result.drawCalls = computeStatistics(m_drawCalls);
+    result.allocations = computeStatistics(m_allocations);
+    result.allocatedBytes = computeStatistics(m_allocatedBytes);
+    m_results.push_back(result);
+
+    CCLOG("benchmark: %s total %.3f ms (p99 %.3f ms), update %.3f, visit %.3f, draw %.3f, swap %.3f, %.1f draws, %.1f allocations",
+          result.scenario.name.c_str(), result.total.mean, result.total.p99, result.update.mean,
+          result.visit.mean, result.draw.mean, result.swap.mean, result.drawCalls.mean, result.allocations.mean);
+}
+
+void PerformanceBenchmarkRunner::finish()
+{
+    CCDirector* pDirector = CCDirector::sharedDirector();
+    pDirector->getScheduler()->unscheduleUpdateForTarget(this);
+    pDirector->setFrameProfilingEnabled(false);
+    pDirector->setDisplayStats(m_bDisplayStats);
+    m_bRunning = false;
+    m_pScene = NULL;
+
+    writeResults();
+
+    if (m_bExitWhenDone)
+    {
+        pDirector->end();
+    }
+    else
+    {
+        PerformanceTestScene* pScene = new PerformanceTestScene();
+        pScene->runThisTest();
+        pScene->release();
+    }
+}
+
+static void writeJsonStatistics(FILE* fp, const char* pszName, const PerformanceBenchmarkRunner::Statistics& stats, bool bLast)
+{
+    fprintf(fp, "      \"%s\": { \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+            pszName, stats.mean, stats.p50, stats.p90, stats.p99, stats.max, bLast ? "" : ",");
+}
+
+static void writeCsvStatistics(FILE* fp, const std::string& label, const PerformanceBenchmarkRunner::Result& result,
+                               const char* pszMetric, const PerformanceBenchmarkRunner::Statistics& stats)
+{
+    fprintf(fp, "%s,%s,%s,%d,%d,%s,%u,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+            label.c_str(), result.scenario.name.c_str(), result.scenario.group.c_str(),
+            result.scenario.subTest, result.scenario.quantity, pszMetric, result.frames,
+            stats.mean, stats.p50, stats.p90, stats.p99, stats.max);
+}
+
+void PerformanceBenchmarkRunner::writeResults()
+{
+    std::string jsonPath = m_strOutputPath + "benchmark.json";
+    std::string csvPath = m_strOutputPath + "benchmark.csv";
+
+    const char* pszRenderer = (const char*)glGetString(GL_RENDERER);
+
+    FILE* fp = fopen(jsonPath.c_str(), "w");
+    if (fp)
+    {
+        fprintf(fp, "{\n");
+        fprintf(fp, "  \"label\": %s,\n", jsonString(m_strLabel.c_str()).c_str());
+        fprintf(fp, "  \"timestamp\": %ld,\n", (long)time(NULL));
+        fprintf(fp, "  \"version\": %s,\n", jsonString(cocos2dVersion()).c_str());
+        fprintf(fp, "  \"platform\": %s,\n", jsonString(platformName()).c_str());
+        fprintf(fp, "  \"renderer\": %s,\n", jsonString(pszRenderer).c_str());
+        fprintf(fp, "  \"animationInterval\": %.6f,\n", CCDirector::sharedDirector()->getAnimationInterval());
+        fprintf(fp, "  \"allocationsCounted\": %s,\n", CC_BENCHMARK_COUNT_ALLOCATIONS ? "true" : "false");
+        fprintf(fp, "  \"warmupFrames\": %u,\n", m_uWarmupFrames);
+        fprintf(fp, "  \"measuredFrames\": %u,\n", m_uMeasuredFrames);
+        fprintf(fp, "  \"scenarios\": [\n");
+        for (size_t i = 0; i < m_results.size(); ++i)
+        {
+            const Result& result = m_results[i];
+            fprintf(fp, "    {\n");
+            fprintf(fp, "      \"name\": %s,\n", jsonString(result.scenario.name.c_str()).c_str());
+            fprintf(fp, "      \"group\": %s,\n", jsonString(result.scenario.group.c_str()).c_str());
+            fprintf(fp, "      \"subtest\": %d,\n", result.scenario.subTest);
+            fprintf(fp, "      \"quantity\": %d,\n", result.scenario.quantity);
+            fprintf(fp, "      \"frames\": %u,\n", result.frames);
+            writeJsonStatistics(fp, "update", result.update, false);
+            writeJsonStatistics(fp, "visit", result.visit, false);
+            writeJsonStatistics(fp, "draw", result.draw, false);
+            writeJsonStatistics(fp, "swap", result.swap, false);
+            writeJsonStatistics(fp, "total", result.total, false);
+            writeJsonStatistics(fp, "dt", result.dt, false);
+            writeJsonStatistics(fp, "drawCalls", result.drawCalls, false);
+            writeJsonStatistics(fp, "allocations", result.allocations, false);
+            writeJsonStatistics(fp, "allocatedBytes", result.allocatedBytes, true);
+            fprintf(fp, "    }%s\n", i + 1 < m_results.size() ? "," : "");
+        }
+        fprintf(fp, "  ]\n");
+        fprintf(fp, "}\n");
+        fclose(fp);
+        CCLOG("benchmark: results written to %s", jsonPath.c_str());
+    }
+    else
+    {
+        CCLOG("benchmark: can not write %s", jsonPath.c_str());
+    }
+
+    fp = fopen(csvPath.c_str(), "w");
+    if (fp)
+    {
+        fprintf(fp, "label,scenario,group,subtest,quantity,metric,frames,mean,p50,p90,p99,max\n");
+        for (size_t i = 0; i < m_results.size(); ++i)
+        {
+            const Result& result = m_results[i];
+            writeCsvStatistics(fp, m_strLabel, result, "update", result.update);
+            writeCsvStatistics(fp, m_strLabel, result, "visit", result.visit);
+            writeCsvStatistics(fp, m_strLabel, result, "draw", result.draw);
+            writeCsvStatistics(fp, m_strLabel, result, "swap", result.swap);
+            writeCsvStatistics(fp, m_strLabel, result, "total", result.total);
+            writeCsvStatistics(fp, m_strLabel, result, "dt", result.dt);
+            writeCsvStatistics(fp, m_strLabel, result, "drawCalls", result.drawCalls);
+            writeCsvStatistics(fp, m_strLabel, result, "allocations", result.allocations);
+            writeCsvStatistics(fp, m_strLabel, result, "allocatedBytes", result.allocatedBytes);
+        }
+        fclose(fp);
+    }
+    else
+    {
+        CCLOG("benchmark: can not write %s", csvPath.c_str());
+    }
+}
+
+void runBenchmarkRunner(bool bExitWhenDone)
+{
+    PerformanceBenchmarkRunner::sharedRunner()->start(bExitWhenDone);
+}
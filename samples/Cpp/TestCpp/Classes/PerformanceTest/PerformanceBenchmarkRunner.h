@@ -0,0 +1,121 @@
+#ifndef __PERFORMANCE_BENCHMARK_RUNNER_H__
+#define __PERFORMANCE_BENCHMARK_RUNNER_H__
+
+#include "PerformanceTest.h"
+#include <string>
+#include <vector>
+
+/**
+ Non interactive runner for the performance tests.
+
+ The runner replaces the running scene with every scenario of a fixed matrix
+ (sprite counts, node children counts, particle counts, texture formats and
+ spine crowds), lets it run for a number of warm-up frames, then samples the
+ director frame profile for a number of measured frames. Results are written
+ as JSON and CSV so that two runs, e.g. from two commits, can be compared by
+ tools/perf-benchmark/compare.py.
+
+ The following environment variables are read by start():
+  - COCOS2D_BENCHMARK_WARMUP: warm-up frames per scenario (default 60)
+  - COCOS2D_BENCHMARK_FRAMES: measured frames per scenario (default 300)
+  - COCOS2D_BENCHMARK_FILTER: only run the scenarios whose name contains it
+  - COCOS2D_BENCHMARK_OUTPUT: directory of the result files (default writable path)
+  - COCOS2D_BENCHMARK_LABEL: label stored in the results, e.g. a commit hash
+ */
+class PerformanceBenchmarkRunner : public CCObject
+{
+public:
+    typedef CCScene* (*SceneCreator)(int nSubTest, int nQuantity);
+
+    struct Scenario
+    {
+        std::string    name;
+        std::string    group;
+        int            subTest;
+        int            quantity;
+        SceneCreator   creator;
+    };
+
+    /** summary of a series of samples, in milliseconds for the timings */
+    struct Statistics
+    {
+        double mean;
+        double p50;
+        double p90;
+        double p99;
+        double max;
+    };
+
+    struct Result
+    {
+        Scenario        scenario;
+        unsigned int    frames;
+        Statistics      update;
+        Statistics      visit;
+        Statistics      draw;
+        Statistics      swap;
+        Statistics      total;
+        Statistics      dt;
+        Statistics      drawCalls;
+        Statistics      allocations;
+        Statistics      allocatedBytes;
+    };
+
+    static PerformanceBenchmarkRunner* sharedRunner();
+
+    /** Runs the whole matrix. When bExitWhenDone is true the director is ended
+     once the results are written, otherwise the performance menu is shown again.
+     */
+    void start(bool bExitWhenDone);
+    bool isRunning() { return m_bRunning; }
+
+    void addScenario(const char* pszGroup, const char* pszName, int nSubTest, int nQuantity, SceneCreator creator);
+    void addDefaultScenarios();
+
+    virtual void update(float dt);
+
+    /** number of operator new calls since the application started, 0 when not counted */
+    static unsigned long getAllocationCount();
+    static unsigned long getAllocatedBytes();
+
+protected:
+    PerformanceBenchmarkRunner();
+
+    void startScenario();
+    void finishScenario();
+    void finish();
+    void writeResults();
+
+    static Statistics computeStatistics(std::vector<double>& samples);
+
+    std::vector<Scenario>  m_scenarios;
+    std::vector<Result>    m_results;
+
+    std::vector<double>    m_update;
+    std::vector<double>    m_visit;
+    std::vector<double>    m_draw;
+    std::vector<double>    m_swap;
+    std::vector<double>    m_total;
+    std::vector<double>    m_dt;
+    std::vector<double>    m_drawCalls;
+    std::vector<double>    m_allocations;
+    std::vector<double>    m_allocatedBytes;
+
+    bool            m_bRunning;
+    bool            m_bExitWhenDone;
+    bool            m_bDisplayStats;
+    unsigned int    m_uWarmupFrames;
+    unsigned int    m_uMeasuredFrames;
+    unsigned int    m_uCurrentScenario;
+    unsigned int    m_uFrame;
+    unsigned long   m_uLastAllocations;
+    unsigned long   m_uLastAllocatedBytes;
+    CCScene         *m_pScene;
+    std::string     m_strFilter;
+    std::string     m_strLabel;
+    std::string     m_strOutputPath;
+};
+
+void runBenchmarkRunner(bool bExitWhenDone);
+
+#endif
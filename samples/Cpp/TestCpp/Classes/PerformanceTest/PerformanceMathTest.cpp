@@ -0,0 +1,390 @@
+#include "PerformanceMathTest.h"
+#include "kazmath/kazmath.h"
+#include "kazmath/vec4.h"
+#include "support/TransformUtils.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <string.h>
+
+enum
+{
+    TEST_COUNT = 2,
+    kRandomRuns = 1000,
+    kArraySize = 1024,
+};
+
+static int s_nMathCurCase = 0;
+
+static float randomValue()
+{
+    return CCRANDOM_MINUS1_1() * 100.0f;
+}
+
+static void randomMatrix(kmMat4* pOut)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        pOut->mat[i] = CCRANDOM_MINUS1_1();
+    }
+}
+
+/** a node like transform: rotation, scale and translation */
+static void randomTransform(kmMat4* pOut)
+{
+    kmMat4 rotation, scale, translation;
+    kmMat4RotationZ(&rotation, CCRANDOM_0_1() * kmPI * 2);
+    kmMat4Scaling(&scale, 0.1f + CCRANDOM_0_1() * 4, 0.1f + CCRANDOM_0_1() * 4, 1);
+    kmMat4Translation(&translation, randomValue(), randomValue(), randomValue());
+    kmMat4Multiply(pOut, &translation, &rotation);
+    kmMat4Multiply(pOut, pOut, &scale);
+}
+
+static float maxDifference(const float* a, const float* b, unsigned int count)
+{
+    float diff = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        diff = MAX(diff, fabsf(a[i] - b[i]));
+    }
+    return diff;
+}
+
+static const char* featuresName(int features)
+{
+    if (features & KM_SIMD_AVX)
+    {
+        return "SSE2+AVX";
+    }
+    return (features & KM_SIMD_SSE2) ? "SSE2" : "scalar";
+}
+
+static void appendLine(std::string& lines, const char* pszFormat, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, pszFormat);
+    vsnprintf(line, sizeof(line), pszFormat, args);
+    va_end(args);
+
+    CCLOG("%s", line);
+    lines += line;
+    lines += "\n";
+}
+
+////////////////////////////////////////////////////////
+//
+// MathMainLayer
+//
+////////////////////////////////////////////////////////
+void MathMainLayer::showCurrentTest()
+{
+    CCLayer* pLayer = NULL;
+    switch (m_nCurCase)
+    {
+    case 0:
+        pLayer = new MathSIMDCorrectnessTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 1:
+        pLayer = new MathSIMDBenchmarkTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    }
+    s_nMathCurCase = m_nCurCase;
+
+    if (pLayer)
+    {
+        CCScene* pScene = CCScene::create();
+        pScene->addChild(pLayer);
+        pLayer->release();
+
+        CCDirector::sharedDirector()->replaceScene(pScene);
+    }
+}
+
+void MathMainLayer::onEnter()
+{
+    PerformBasicLayer::onEnter();
+
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+
+    CCLabelTTF *label = CCLabelTTF::create(title().c_str(), "Arial", 32);
+    addChild(label, 1);
+    label->setPosition(ccp(s.width/2, s.height-50));
+
+    CCLabelTTF *subLabel = CCLabelTTF::create(subtitle().c_str(), "Thonburi", 16);
+    addChild(subLabel, 1);
+    subLabel->setPosition(ccp(s.width/2, s.height-80));
+
+    int features = kmSIMDFeatures();
+    std::string lines = runTest();
+    kmSetSIMDFeatures(features);
+
+    CCLabelTTF *results = CCLabelTTF::create(lines.c_str(), "Courier New", 14);
+    addChild(results, 1);
+    results->setPosition(ccp(s.width/2, s.height/2));
+}
+
+std::string MathMainLayer::title()
+{
+    return "No title";
+}
+
+std::string MathMainLayer::subtitle()
+{
+    return std::string("CPU: ") + featuresName(kmSIMDFeatures());
+}
+
+////////////////////////////////////////////////////////
+//
+// MathSIMDCorrectnessTest
+//
+////////////////////////////////////////////////////////
+std::string MathSIMDCorrectnessTest::title()
+{
+    return "SIMD vs scalar";
+}
+
+std::string MathSIMDCorrectnessTest::runTest()
+{
+    std::string lines;
+    int features = kmSIMDFeatures();
+    float mulDiff = 0, invDiff = 0, vec3Diff = 0, vec4Diff = 0, arrayDiff = 0, quadDiff = 0;
+    bool singularOk = true;
+
+    for (int run = 0; run < kRandomRuns; ++run)
+    {
+        kmMat4 a, b, scalar, simd;
+        if (run % 2)
+        {
+            randomMatrix(&a);
+            randomMatrix(&b);
+        }
+        else
+        {
+            randomTransform(&a);
+            randomTransform(&b);
+        }
+
+        kmSetSIMDFeatures(0);
+        kmMat4Multiply(&scalar, &a, &b);
+        kmSetSIMDFeatures(features);
+        kmMat4Multiply(&simd, &a, &b);
+        mulDiff = MAX(mulDiff, maxDifference(scalar.mat, simd.mat, 16));
+
+        // the inverse uses a different algorithm, compare relatively to the largest element
+        kmSetSIMDFeatures(0);
+        kmMat4* pScalar = kmMat4Inverse(&scalar, &a);
+        kmSetSIMDFeatures(features);
+        kmMat4* pSimd = kmMat4Inverse(&simd, &a);
+        if (pScalar && pSimd && run % 2 == 0)
+        {
+            float largest = 1;
+            for (int i = 0; i < 16; ++i)
+            {
+                largest = MAX(largest, fabsf(scalar.mat[i]));
+            }
+            invDiff = MAX(invDiff, maxDifference(scalar.mat, simd.mat, 16) / largest);
+        }
+
+        kmVec3 v3 = { randomValue(), randomValue(), randomValue() }, v3Scalar, v3Simd;
+        kmSetSIMDFeatures(0);
+        kmVec3Transform(&v3Scalar, &v3, &a);
+        kmSetSIMDFeatures(features);
+        kmVec3Transform(&v3Simd, &v3, &a);
+        vec3Diff = MAX(vec3Diff, maxDifference(&v3Scalar.x, &v3Simd.x, 3));
+
+        kmVec4 v4, v4Scalar, v4Simd;
+        kmVec4Fill(&v4, randomValue(), randomValue(), randomValue(), 1);
+        kmSetSIMDFeatures(0);
+        kmVec4Transform(&v4Scalar, &v4, &a);
+        kmSetSIMDFeatures(features);
+        kmVec4Transform(&v4Simd, &v4, &a);
+        vec4Diff = MAX(vec4Diff, maxDifference(&v4Scalar.x, &v4Simd.x, 4));
+    }
+
+    // singular matrices are rejected by both versions
+    kmMat4 singular, out;
+    memset(&singular, 0, sizeof(singular));
+    singular.mat[0] = singular.mat[5] = singular.mat[15] = 1;
+    kmSetSIMDFeatures(0);
+    singularOk = kmMat4Inverse(&out, &singular) == NULL;
+    kmSetSIMDFeatures(features);
+    singularOk = singularOk && kmMat4Inverse(&out, &singular) == NULL;
+
+    // odd count and strides, to go through the tail of the two vectors per iteration loop
+    {
+        static kmVec4 input[kArraySize * 2], scalar[kArraySize], simd[kArraySize];
+        kmMat4 m;
+        randomTransform(&m);
+        for (int i = 0; i < kArraySize * 2; ++i)
+        {
+            kmVec4Fill(&input[i], randomValue(), randomValue(), randomValue(), 1);
+        }
+        kmSetSIMDFeatures(0);
+        kmVec4TransformArray(scalar, 1, input, 2, &m, kArraySize - 1);
+        kmSetSIMDFeatures(features);
+        kmVec4TransformArray(simd, 1, input, 2, &m, kArraySize - 1);
+        arrayDiff = maxDifference(&scalar[0].x, &simd[0].x, (kArraySize - 1) * 4);
+    }
+
+    // ccTransformQuads against the code CCSprite::updateTransform used before
+    {
+        static ccV3F_C4B_T2F_Quad quads[kArraySize];
+        static ccQuadTransform transforms[kArraySize];
+        memset(quads, 0, sizeof(quads));
+        for (int i = 0; i < kArraySize; ++i)
+        {
+            ccQuadTransform& item = transforms[i];
+            item.transform = CCAffineTransformMake(CCRANDOM_MINUS1_1(), CCRANDOM_MINUS1_1(), CCRANDOM_MINUS1_1(), CCRANDOM_MINUS1_1(), randomValue(), randomValue());
+            item.x1 = randomValue();
+            item.y1 = randomValue();
+            item.x2 = item.x1 + CCRANDOM_0_1() * 100;
+            item.y2 = item.y1 + CCRANDOM_0_1() * 100;
+            item.z = randomValue();
+            item.quad = &quads[i];
+        }
+        ccTransformQuads(transforms, kArraySize);
+
+        for (int i = 0; i < kArraySize; ++i)
+        {
+            const ccQuadTransform& item = transforms[i];
+            float cr = item.transform.a, sr = item.transform.b, cr2 = item.transform.d, sr2 = -item.transform.c;
+            float expected[12] = {
+                item.x1 * cr - item.y2 * sr2 + item.transform.tx, item.x1 * sr + item.y2 * cr2 + item.transform.ty, item.z,
+                item.x1 * cr - item.y1 * sr2 + item.transform.tx, item.x1 * sr + item.y1 * cr2 + item.transform.ty, item.z,
+                item.x2 * cr - item.y2 * sr2 + item.transform.tx, item.x2 * sr + item.y2 * cr2 + item.transform.ty, item.z,
+                item.x2 * cr - item.y1 * sr2 + item.transform.tx, item.x2 * sr + item.y1 * cr2 + item.transform.ty, item.z,
+            };
+            const ccV3F_C4B_T2F* vertices[4] = { &quads[i].tl, &quads[i].bl, &quads[i].tr, &quads[i].br };
+            for (int j = 0; j < 4; ++j)
+            {
+                quadDiff = MAX(quadDiff, maxDifference(&expected[j * 3], &vertices[j]->vertices.x, 3));
+            }
+        }
+    }
+
+    appendLine(lines, "kmMat4Multiply        max diff %g %s", mulDiff, mulDiff == 0 ? "OK" : "FAIL");
+    appendLine(lines, "kmMat4Inverse         max rel diff %g %s", invDiff, invDiff < 1e-4f ? "OK" : "FAIL");
+    appendLine(lines, "kmMat4Inverse         singular %s", singularOk ? "OK" : "FAIL");
+    appendLine(lines, "kmVec3Transform       max diff %g %s", vec3Diff, vec3Diff == 0 ? "OK" : "FAIL");
+    appendLine(lines, "kmVec4Transform       max diff %g %s", vec4Diff, vec4Diff == 0 ? "OK" : "FAIL");
+    appendLine(lines, "kmVec4TransformArray  max diff %g %s", arrayDiff, arrayDiff == 0 ? "OK" : "FAIL");
+    appendLine(lines, "ccTransformQuads      max diff %g %s", quadDiff, quadDiff == 0 ? "OK" : "FAIL");
+    return lines;
+}
+
+////////////////////////////////////////////////////////
+//
+// MathSIMDBenchmarkTest
+//
+////////////////////////////////////////////////////////
+std::string MathSIMDBenchmarkTest::title()
+{
+    return "SIMD micro-benchmarks";
+}
+
+std::string MathSIMDBenchmarkTest::subtitle()
+{
+    return MathMainLayer::subtitle() + ", nanoseconds per call, see the console";
+}
+
+std::string MathSIMDBenchmarkTest::runTest()
+{
+    std::string lines;
+    int supported = kmSIMDFeatures();
+    const int masks[] = { 0, KM_SIMD_SSE2, KM_SIMD_SSE2 | KM_SIMD_AVX };
+
+    static kmVec4 input[kArraySize], output[kArraySize];
+    static ccV3F_C4B_T2F_Quad quads[kArraySize];
+    static ccQuadTransform transforms[kArraySize];
+    for (int i = 0; i < kArraySize; ++i)
+    {
+        kmVec4Fill(&input[i], randomValue(), randomValue(), randomValue(), 1);
+        transforms[i].transform = CCAffineTransformMake(1, 0, 0, 1, randomValue(), randomValue());
+        transforms[i].x1 = transforms[i].y1 = 0;
+        transforms[i].x2 = transforms[i].y2 = 32;
+        transforms[i].z = 0;
+        transforms[i].quad = &quads[i];
+    }
+
+    appendLine(lines, "%-9s %8s %8s %8s %8s", "", "mat4 mul", "mat4 inv", "vec3", "vec4[]");
+    for (unsigned int m = 0; m < sizeof(masks) / sizeof(masks[0]); ++m)
+    {
+        if ((masks[m] & supported) != masks[m])
+        {
+            continue;
+        }
+        kmSetSIMDFeatures(masks[m]);
+
+        kmMat4 a, b, c;
+        randomTransform(&a);
+        randomTransform(&b);
+        kmVec3 v = { 1, 2, 3 };
+
+        const int calls = 200000;
+        long long start = CCTime::getMonotonicTimeNs();
+        for (int i = 0; i < calls; ++i)
+        {
+            kmMat4Multiply(&c, &a, &b);
+            a.mat[12] = c.mat[12] * 1e-6f;
+        }
+        double mul = (double)(CCTime::getMonotonicTimeNs() - start) / calls;
+
+        start = CCTime::getMonotonicTimeNs();
+        for (int i = 0; i < calls; ++i)
+        {
+            kmMat4Inverse(&c, &a);
+            a.mat[13] = c.mat[13] * 1e-6f;
+        }
+        double inv = (double)(CCTime::getMonotonicTimeNs() - start) / calls;
+
+        start = CCTime::getMonotonicTimeNs();
+        for (int i = 0; i < calls; ++i)
+        {
+            kmVec3Transform(&v, &v, &a);
+        }
+        double vec3 = (double)(CCTime::getMonotonicTimeNs() - start) / calls;
+
+        start = CCTime::getMonotonicTimeNs();
+        for (int i = 0; i < calls / kArraySize; ++i)
+        {
+            kmVec4TransformArray(output, 1, input, 1, &a, kArraySize);
+        }
+        double vec4 = (double)(CCTime::getMonotonicTimeNs() - start) / (calls / kArraySize * kArraySize);
+
+        appendLine(lines, "%-9s %8.2f %8.2f %8.2f %8.2f", featuresName(masks[m]), mul, inv, vec3, vec4);
+    }
+
+    const int rounds = 200;
+    long long start = CCTime::getMonotonicTimeNs();
+    for (int i = 0; i < rounds; ++i)
+    {
+        ccTransformQuads(transforms, kArraySize);
+    }
+    double batched = (double)(CCTime::getMonotonicTimeNs() - start) / (rounds * kArraySize);
+
+    start = CCTime::getMonotonicTimeNs();
+    for (int i = 0; i < rounds; ++i)
+    {
+        for (int j = 0; j < kArraySize; ++j)
+        {
+            ccTransformQuads(&transforms[j], 1);
+        }
+    }
+    double single = (double)(CCTime::getMonotonicTimeNs() - start) / (rounds * kArraySize);
+
+    appendLine(lines, "ccTransformQuads: %.2f per quad batched, %.2f one by one", batched, single);
+    return lines;
+}
+
+void runMathTest()
+{
+    s_nMathCurCase = 0;
+    CCScene* pScene = CCScene::create();
+    CCLayer* pLayer = new MathSIMDCorrectnessTest(true, TEST_COUNT, s_nMathCurCase);
+
+    pScene->addChild(pLayer);
+    pLayer->release();
+
+    CCDirector::sharedDirector()->replaceScene(pScene);
+}
@@ -0,0 +1,53 @@
+#ifndef __PERFORMANCE_MATH_TEST_H__
+#define __PERFORMANCE_MATH_TEST_H__
+
+#include "PerformanceTest.h"
+#include <string>
+
+class MathMainLayer : public PerformBasicLayer
+{
+public:
+    MathMainLayer(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        : PerformBasicLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void showCurrentTest();
+    virtual void onEnter();
+    virtual std::string title();
+    virtual std::string subtitle();
+
+    /** runs the test and returns the lines to display */
+    virtual std::string runTest() = 0;
+};
+
+/** compares the SIMD kazmath kernels and ccTransformQuads with the scalar code */
+class MathSIMDCorrectnessTest : public MathMainLayer
+{
+public:
+    MathSIMDCorrectnessTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        : MathMainLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual std::string title();
+    virtual std::string runTest();
+};
+
+/** times the kazmath kernels with every instruction set supported by the CPU */
+class MathSIMDBenchmarkTest : public MathMainLayer
+{
+public:
+    MathSIMDBenchmarkTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        : MathMainLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual std::string runTest();
+};
+
+void runMathTest();
+
+#endif
@@ -4,7 +4,7 @@ enum {
     kMaxNodes = 50000,
     kNodesIncrease = 250,
 
-    TEST_COUNT = 7,
+    TEST_COUNT = 8,
 };
 
 enum {
@@ -290,6 +290,9 @@ void SpriteMenuLayer::showCurrentTest()
     case 6:
         pScene = new SpritePerformTest7;
         break;
+    case 7:
+        pScene = new SpritePerformTest8;
+        break;
     }
     s_nSpriteCurCase = m_nCurCase;
 
@@ -480,6 +483,22 @@ void performanceActions20(CCSprite* pSprite)
     pSprite->runAction(permanentScaleLoop);
 }
 
+void performanceActions5(CCSprite* pSprite)
+{
+    // most sprites of large batches don't move, the batch node only updates the others
+    CCSize size = CCDirector::sharedDirector()->getWinSize();
+    pSprite->setPosition(ccp((rand() % (int)size.width), (rand() % (int)size.height)));
+
+    if( CCRANDOM_0_1() < 0.05f )
+    {
+        float period = 0.5f + (rand() % 1000) / 500.0f;
+        CCRotateBy* rot = CCRotateBy::create(period, 360.0f * CCRANDOM_0_1());
+        CCActionInterval* rot_back = rot->reverse();
+        CCAction *permanentRotation = CCRepeatForever::create(CCSequence::create(rot, rot_back, NULL));
+        pSprite->runAction(permanentRotation);
+    }
+}
+
 void performanceRotationScale(CCSprite* pSprite)
 {
     CCSize size = CCDirector::sharedDirector()->getWinSize();
@@ -642,6 +661,24 @@ void SpritePerformTest7::doTest(CCSprite* sprite)
     performanceActions20(sprite);
 }
 
+////////////////////////////////////////////////////////
+//
+// SpritePerformTest8
+//
+////////////////////////////////////////////////////////
+std::string SpritePerformTest8::title()
+{
+    char str[32] = {0};
+    sprintf(str, "H (%d) actions 5%% moving", subtestNumber);
+    std::string strRet = str;
+    return strRet;
+}
+
+void SpritePerformTest8::doTest(CCSprite* sprite)
+{
+    performanceActions5(sprite);
+}
+
 void runSpriteTest()
 {
     SpriteMainScene* pScene = new SpritePerformTest1;
@@ -101,6 +101,13 @@ public:
     virtual std::string title();
 };
 
+class SpritePerformTest8 : public SpriteMainScene
+{
+public:
+    virtual void doTest(CCSprite* sprite);
+    virtual std::string title();
+};
+
 void runSpriteTest();
 
 #endif
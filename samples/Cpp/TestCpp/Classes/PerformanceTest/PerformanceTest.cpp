@@ -6,10 +6,12 @@
 #include "PerformanceTextureTest.h"
 #include "PerformanceTouchesTest.h"
 #include "PerformanceAllocTest.h"
+#include "PerformanceBenchmarkRunner.h"
+#include "PerformanceMathTest.h"
 
 enum
 {
-    MAX_COUNT = 6,
+    MAX_COUNT = 8,
     LINE_SPACE = 40,
     kItemTagBasic = 1000,
 };
@@ -22,6 +24,8 @@ const std::string testsName[MAX_COUNT] =
     "Perf Texture Test",
     "Perf Touches Test",
     "Perf Alloc Test",
+    "Perf Benchmark Runner",
+    "Perf Math SIMD Test",
 };
 
 ////////////////////////////////////////////////////////
@@ -75,6 +79,12 @@ void PerformanceMainLayer::menuCallback(CCObject* pSender)
     case 5:
         runAllocPerformanceTest();
         break;
+    case 6:
+        runBenchmarkRunner(false);
+        break;
+    case 7:
+        runMathTest();
+        break;
     default:
         break;
     }
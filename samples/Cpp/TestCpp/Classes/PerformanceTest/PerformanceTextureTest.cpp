@@ -1,4 +1,5 @@
 #include "PerformanceTextureTest.h"
+#include "support/zip_support/ZipUtils.h"
 
 enum
 {
@@ -127,6 +128,43 @@ void TextureTest::performTestsPNG(const char* filename)
     cache->removeTexture(texture);
 }
 
+void TextureTest::performTestsCCZ(const char* zlibFile, const char* lz4File)
+{
+    const int kIterations = 50;
+    const char* files[2] = { zlibFile, lz4File };
+    const char* names[2] = { "zlib", "lz4" };
+    struct timeval now;
+    CCTextureCache *cache = CCTextureCache::sharedTextureCache();
+
+    for (int f = 0; f < 2; ++f)
+    {
+        std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(files[f]);
+
+        // decompression only
+        int len = 0;
+        gettimeofday(&now, NULL);
+        for (int i = 0; i < kIterations && len >= 0; ++i)
+        {
+            unsigned char* data = NULL;
+            len = ZipUtils::ccInflateCCZFile(fullPath.c_str(), &data);
+            free(data);
+        }
+        if (len >= 0)
+            CCLog("%s inflate: %d bytes, ms:%f", names[f], len, calculateDeltaTime(&now) * 1000 / kIterations);
+        else
+            CCLog("%s inflate: ERROR", names[f]);
+
+        // full texture load
+        gettimeofday(&now, NULL);
+        CCTexture2D *texture = cache->addImage(files[f]);
+        if( texture )
+            CCLog("%s addImage ms:%f", names[f], calculateDeltaTime(&now) * 1000 );
+        else
+            CCLog("%s addImage ERROR", names[f]);
+        cache->removeTexture(texture);
+    }
+}
+
 void TextureTest::performTests()
 {
 //     CCTexture2D *texture;
@@ -176,6 +214,12 @@ void TextureTest::performTests()
 //     cache->removeTexture(texture);
 
 
+    CCLog("--- PVR.CCZ zlib vs lz4 128x128 ---");
+    performTestsCCZ("Images/test_image_rgba4444.pvr.ccz", "Images/test_image_rgba4444_lz4.pvr.ccz");
+
+    CCLog("--- PVR.CCZ zlib vs lz4 atlas ---");
+    performTestsCCZ("Images/nonencryptedAtlas.pvr.ccz", "Images/nonencryptedAtlas_lz4.pvr.ccz");
+
     CCLog("--- PNG 512x512 ---");
     performTestsPNG("Images/texture512x512.png");
 
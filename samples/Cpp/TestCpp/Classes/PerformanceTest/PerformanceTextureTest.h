@@ -31,6 +31,7 @@ public:
     virtual std::string title();
     virtual std::string subtitle();
     void performTestsPNG(const char* filename);
+    void performTestsCCZ(const char* zlibFile, const char* lz4File);
 
     static CCScene* scene();
 };
@@ -13,6 +13,7 @@ TESTLAYER_CREATE_FUNC(RenderTextureZbuffer);
 TESTLAYER_CREATE_FUNC(RenderTextureTestDepthStencil);
 TESTLAYER_CREATE_FUNC(RenderTextureTargetNode);
 TESTLAYER_CREATE_FUNC(SpriteRenderTextureBug);
+TESTLAYER_CREATE_FUNC(RenderTextureAsyncCapture);
 
 static NEWTESTFUNC createFunctions[] = {
     CF(RenderTextureSave),
@@ -21,6 +22,7 @@ static NEWTESTFUNC createFunctions[] = {
     CF(RenderTextureTestDepthStencil),
     CF(RenderTextureTargetNode),
     CF(SpriteRenderTextureBug),
+    CF(RenderTextureAsyncCapture),
 };
 
 #define MAX_LAYER   (sizeof(createFunctions)/sizeof(createFunctions[0]))
@@ -152,7 +154,8 @@ RenderTextureSave::RenderTextureSave()
     CCMenuItemFont::setFontSize(16);
     CCMenuItem *item1 = CCMenuItemFont::create("Save Image", this, menu_selector(RenderTextureSave::saveImage));
     CCMenuItem *item2 = CCMenuItemFont::create("Clear", this, menu_selector(RenderTextureSave::clearImage));
-    CCMenu *menu = CCMenu::create(item1, item2, NULL);
+    CCMenuItem *item3 = CCMenuItemFont::create("Save Image Async", this, menu_selector(RenderTextureSave::saveImageAsync));
+    CCMenu *menu = CCMenu::create(item1, item2, item3, NULL);
     this->addChild(menu);
     menu->alignItemsVertically();
     menu->setPosition(ccp(VisibleRect::rightTop().x - 80, VisibleRect::rightTop().y - 30));
@@ -204,6 +207,40 @@ void RenderTextureSave::saveImage(cocos2d::CCObject *pSender)
     counter++;
 }
 
+void RenderTextureSave::saveImageAsync(cocos2d::CCObject *pSender)
+{
+    static int counter = 0;
+
+    char png[32];
+    sprintf(png, "image-async-%d.png", counter);
+
+    // the file is written by a worker thread, imageSaved is called once it is done
+    m_pTarget->saveToFileAsync(png, kCCImageFormatPNG, this, callfuncO_selector(RenderTextureSave::imageSaved));
+
+    counter++;
+}
+
+void RenderTextureSave::imageSaved(CCObject *pPath)
+{
+    CCString *pFullPath = (CCString*)pPath;
+    if (! pFullPath)
+    {
+        CCLOG("Saving the image failed");
+        return;
+    }
+
+    CCSprite *sprite = CCSprite::create(pFullPath->getCString());
+    if (sprite)
+    {
+        sprite->setScale(0.3f);
+        addChild(sprite);
+        sprite->setPosition(ccp(VisibleRect::right().x - 40, 40));
+        sprite->setRotation(CCRANDOM_0_1() * 30);
+    }
+
+    CCLOG("Image saved %s", pFullPath->getCString());
+}
+
 RenderTextureSave::~RenderTextureSave()
 {
     m_pBrush->release();
@@ -727,3 +764,107 @@ std::string SpriteRenderTextureBug::subtitle()
 {
     return "Touch the screen. Sprite should appear on under the touch";
 }
+
+/**
+ * Impelmentation of RenderTextureAsyncCapture
+ */
+
+RenderTextureAsyncCapture::RenderTextureAsyncCapture()
+: m_pExpected(NULL)
+, m_dSyncTime(0)
+, m_dAsyncCallTime(0)
+, m_lAsyncStart(0)
+, m_nCount(0)
+{
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+
+    m_pTarget = CCRenderTexture::create(s.width, s.height, kCCTexture2DPixelFormat_RGBA8888);
+    m_pTarget->retain();
+    m_pTarget->setPosition(ccp(s.width / 2, s.height / 2));
+    m_pTarget->setScale(0.5f);
+    addChild(m_pTarget, -1);
+
+    m_pStatus = CCLabelTTF::create("", "Arial", 16);
+    m_pStatus->setPosition(ccp(s.width / 2, VisibleRect::bottom().y + 70));
+    addChild(m_pStatus);
+
+    CCMenuItemFont::setFontSize(16);
+    CCMenuItem *item = CCMenuItemFont::create("Capture", this, menu_selector(RenderTextureAsyncCapture::capture));
+    CCMenu *menu = CCMenu::create(item, NULL);
+    menu->setPosition(ccp(VisibleRect::rightTop().x - 80, VisibleRect::rightTop().y - 30));
+    addChild(menu);
+
+    capture(NULL);
+}
+
+RenderTextureAsyncCapture::~RenderTextureAsyncCapture()
+{
+    CC_SAFE_RELEASE(m_pExpected);
+    m_pTarget->release();
+}
+
+std::string RenderTextureAsyncCapture::title()
+{
+    return "Asynchronous capture";
+}
+
+std::string RenderTextureAsyncCapture::subtitle()
+{
+    return "The asynchronous capture should match the synchronous one";
+}
+
+void RenderTextureAsyncCapture::drawPattern()
+{
+    const CCSize& s = m_pTarget->getSprite()->getContentSize();
+
+    // every quadrant gets its own color so a wrong flip or row order can't match
+    m_pTarget->beginWithClear(CCRANDOM_0_1(), CCRANDOM_0_1(), CCRANDOM_0_1(), 1);
+    for (int i = 0; i < 4; i++)
+    {
+        CCLayerColor *pLayer = CCLayerColor::create(ccc4(rand() % 256, rand() % 256, rand() % 256, 255), s.width / 2 - 10, s.height / 2 - 10);
+        pLayer->setPosition(ccp((i % 2) * s.width / 2, (i / 2) * s.height / 2));
+        pLayer->visit();
+    }
+    m_pTarget->end();
+}
+
+void RenderTextureAsyncCapture::capture(CCObject *pSender)
+{
+    if (m_pExpected)
+    {
+        // a capture is still in flight
+        return;
+    }
+
+    drawPattern();
+
+    long long lStart = CCTime::getMonotonicTimeNs();
+    m_pExpected = m_pTarget->newCCImage(true);
+    m_dSyncTime = (CCTime::getMonotonicTimeNs() - lStart) / 1000000.0;
+
+    m_lAsyncStart = CCTime::getMonotonicTimeNs();
+    m_pTarget->newCCImageAsync(this, callfuncO_selector(RenderTextureAsyncCapture::captured), true);
+    m_dAsyncCallTime = (CCTime::getMonotonicTimeNs() - m_lAsyncStart) / 1000000.0;
+
+    m_pStatus->setString("Capturing...");
+}
+
+void RenderTextureAsyncCapture::captured(CCObject *pObject)
+{
+    CCImage *pImage = (CCImage*)pObject;
+    double dLatency = (CCTime::getMonotonicTimeNs() - m_lAsyncStart) / 1000000.0;
+
+    bool bMatch = pImage && m_pExpected
+        && pImage->getWidth() == m_pExpected->getWidth()
+        && pImage->getHeight() == m_pExpected->getHeight()
+        && memcmp(pImage->getData(), m_pExpected->getData(), pImage->getWidth() * pImage->getHeight() * 4) == 0;
+
+    m_nCount++;
+    char szStatus[256];
+    sprintf(szStatus, "#%d %s\nsync: %.2f ms, async: %.2f ms on the main thread, %.2f ms until the callback",
+            m_nCount, bMatch ? "Pixels match" : "Pixels DIFFER", m_dSyncTime, m_dAsyncCallTime, dLatency);
+    m_pStatus->setString(szStatus);
+    CCLOG("RenderTextureAsyncCapture: %s", szStatus);
+
+    CC_SAFE_RELEASE_NULL(m_pExpected);
+}
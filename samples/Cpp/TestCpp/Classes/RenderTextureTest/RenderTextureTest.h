@@ -26,6 +26,8 @@ public:
     virtual void ccTouchesMoved(CCSet* touches, CCEvent* event);
     void clearImage(CCObject *pSender);
     void saveImage(CCObject *pSender);
+    void saveImageAsync(CCObject *pSender);
+    void imageSaved(CCObject *pPath);
 
 private:
     CCRenderTexture *m_pTarget;
@@ -96,6 +98,29 @@ public:
     void touched(CCObject* sender);
 };
 
+class RenderTextureAsyncCapture : public RenderTextureTest
+{
+public:
+    RenderTextureAsyncCapture();
+    ~RenderTextureAsyncCapture();
+    virtual std::string title();
+    virtual std::string subtitle();
+
+    void capture(CCObject *pSender);
+    void captured(CCObject *pImage);
+
+private:
+    void drawPattern();
+
+    CCRenderTexture *m_pTarget;
+    CCLabelTTF      *m_pStatus;
+    CCImage         *m_pExpected;
+    double          m_dSyncTime;
+    double          m_dAsyncCallTime;
+    long long       m_lAsyncStart;
+    int             m_nCount;
+};
+
 class SpriteRenderTextureBug : public RenderTextureTest
 {
 public:
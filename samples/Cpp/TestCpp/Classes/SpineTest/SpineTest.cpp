@@ -27,6 +27,9 @@
 #include <iostream>
 #include <fstream>
 #include <string.h>
+#ifndef EMSCRIPTEN
+#include <thread>
+#endif
 
 using namespace cocos2d;
 using namespace cocos2d::extension;
@@ -65,11 +68,24 @@ bool SpineTestLayer::init () {
 	skeletonNode->setPosition(ccp(windowSize.width / 2, 20));
 	addChild(skeletonNode);
 
+	CCMenuItemFont* crowdItem = CCMenuItemFont::create("Crowd benchmark", this, menu_selector(SpineTestLayer::crowdCallback));
+	crowdItem->setFontSizeObj(20);
+	CCMenu* menu = CCMenu::create(crowdItem, NULL);
+	menu->setPosition(ccp(windowSize.width - 100, windowSize.height - 20));
+	addChild(menu);
+
 	scheduleUpdate();
 
 	return true;
 }
 
+void SpineTestLayer::crowdCallback (CCObject* sender) {
+	CCScene* scene = new SpineTestScene();
+	scene->addChild(SpineCrowdTestLayer::create(SpineCrowdTestLayer::kModeParallel, 500));
+	CCDirector::sharedDirector()->replaceScene(scene);
+	scene->release();
+}
+
 void SpineTestLayer::update (float deltaTime) {
     if (skeletonNode->states[0]->loop) {
         if (skeletonNode->states[0]->time > 2)
@@ -79,3 +95,111 @@ void SpineTestLayer::update (float deltaTime) {
             skeletonNode->setAnimation("walk", true);
     }
 }
+
+//------------------------------------------------------------------
+//
+// SpineCrowdTestLayer
+//
+//------------------------------------------------------------------
+static const char* crowdModeNames[SpineCrowdTestLayer::kModeCount] = {
+	"serial update",
+	"parallel update",
+	"parallel update, reduced rate"
+};
+
+SpineCrowdTestLayer* SpineCrowdTestLayer::create (int mode, int count) {
+	SpineCrowdTestLayer* layer = new SpineCrowdTestLayer();
+	if (layer->init(mode, count)) {
+		layer->autorelease();
+		return layer;
+	}
+	delete layer;
+	return NULL;
+}
+
+bool SpineCrowdTestLayer::init (int mode, int count) {
+	if (!CCLayer::init()) return false;
+
+	CCSize windowSize = CCDirector::sharedDirector()->getWinSize();
+
+	// the crowd is twice as wide as the screen and scrolls, so about half of it is culled
+	CCNode* crowd = CCNode::create();
+	addChild(crowd);
+	crowd->runAction(CCRepeatForever::create(CCSequence::create(
+		CCMoveBy::create(8, ccp(-windowSize.width, 0)),
+		CCMoveBy::create(8, ccp(windowSize.width, 0)),
+		NULL)));
+
+	int columns = (int)ceilf(sqrtf(count * 4.0f));
+	int rows = (count + columns - 1) / columns;
+	for (int i = 0; i < count; i++) {
+		int column = i % columns;
+		int row = i / columns;
+		// every skeleton shares the data loaded by the first one
+		CCSkeletonAnimation* skeleton = CCSkeletonAnimation::createWithFile("spine/spineboy.json", "spine/spineboy.atlas", 0.2f);
+		skeleton->setAnimation("walk", true);
+		skeleton->states[0]->time = CCRANDOM_0_1();
+		skeleton->batchRendering = true;
+		skeleton->preferenceRootParent = this;
+		skeleton->setPosition(ccp((column + 0.5f) * windowSize.width * 2 / columns, 10 + row * (windowSize.height - 80) / rows));
+		// back rows are drawn first
+		crowd->addChild(skeleton, rows - row);
+		skeletons.push_back(skeleton);
+	}
+
+	modeLabel = CCLabelTTF::create("", "Arial", 20);
+	modeLabel->setPosition(ccp(windowSize.width / 2, windowSize.height - 50));
+	addChild(modeLabel, 1);
+
+	CCMenuItemFont* modeItem = CCMenuItemFont::create("Change mode", this, menu_selector(SpineCrowdTestLayer::modeCallback));
+	modeItem->setFontSizeObj(20);
+	CCMenu* menu = CCMenu::create(modeItem, NULL);
+	menu->setPosition(ccp(windowSize.width - 80, windowSize.height - 20));
+	addChild(menu, 1);
+
+	this->mode = mode;
+
+	return true;
+}
+
+void SpineCrowdTestLayer::onEnter () {
+	CCLayer::onEnter();
+	// not in init: the next scene is created before the previous one exits and resets the threads
+	applyMode();
+}
+
+void SpineCrowdTestLayer::onExit () {
+	CCSkeleton::setParallelUpdateThreads(0);
+	CCLayer::onExit();
+}
+
+void SpineCrowdTestLayer::modeCallback (CCObject* sender) {
+	mode = (mode + 1) % kModeCount;
+	applyMode();
+}
+
+void SpineCrowdTestLayer::applyMode () {
+	unsigned int threads = 0;
+	if (mode != kModeSerial) {
+#ifndef EMSCRIPTEN
+		// the main thread poses skeletons too
+		unsigned int cores = std::thread::hardware_concurrency();
+		threads = cores > 1 ? cores - 1 : 1;
+#else
+		threads = 1;
+#endif
+	}
+	CCSkeleton::setParallelUpdateThreads(threads);
+
+	bool reducedRate = mode == kModeParallelReducedRate;
+	float backRowY = CCDirector::sharedDirector()->getWinSize().height / 2;
+	for (size_t i = 0; i < skeletons.size(); i++) {
+		CCSkeletonAnimation* skeleton = skeletons[i];
+		skeleton->updateInterval = reducedRate && skeleton->getPositionY() > backRowY ? 1 / 20.0f : 0;
+		skeleton->hiddenUpdateInterval = reducedRate ? 0.5f : -1;
+	}
+
+	char text[96];
+	sprintf(text, "%d skeletons, %s", (int)skeletons.size(), crowdModeNames[mode]);
+	modeLabel->setString(text);
+}
@@ -45,7 +45,36 @@ public:
 	virtual bool init ();
 	virtual void update (float deltaTime);
 
+	void crowdCallback (cocos2d::CCObject* sender);
+
 	CREATE_FUNC (SpineTestLayer);
 };
 
+/* Animates a crowd of skeletons, half of them off screen, to compare the serial update with the parallel one. */
+class SpineCrowdTestLayer: public cocos2d::CCLayer {
+public:
+	enum {
+		kModeSerial,
+		kModeParallel,
+		// parallel, the back rows are posed at 20 Hz and the skeletons off screen at 2 Hz
+		kModeParallelReducedRate,
+		kModeCount
+	};
+
+	static SpineCrowdTestLayer* create (int mode, int count);
+
+	virtual bool init (int mode, int count);
+	virtual void onEnter ();
+	virtual void onExit ();
+
+	void modeCallback (cocos2d::CCObject* sender);
+
+private:
+	std::vector<cocos2d::extension::CCSkeletonAnimation*> skeletons;
+	cocos2d::CCLabelTTF* modeLabel;
+	int mode;
+
+	void applyMode ();
+};
+
 #endif // _EXAMPLELAYER_H_
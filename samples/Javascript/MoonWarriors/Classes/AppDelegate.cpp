@@ -49,6 +49,10 @@ bool AppDelegate::applicationDidFinishLaunching()
     
     CCScriptEngineProtocol *pEngine = ScriptingCore::getInstance();
     CCScriptEngineManager::sharedManager()->setScriptEngine(pEngine);
+    // the first launch compiles the scripts and caches their bytecode, the next ones decode it
+    sc->setBytecodeCacheEnabled(true);
+    long long start = CCTime::getMonotonicTimeNs();
+
 #if JSB_ENABLE_DEBUGGER
     ScriptingCore::getInstance()->enableDebugger();
     ScriptingCore::getInstance()->runScript("main.debug.js");
@@ -56,6 +60,9 @@ bool AppDelegate::applicationDidFinishLaunching()
     ScriptingCore::getInstance()->runScript("MoonWarriors-jsb.js");
 #endif
 
+    CCLog("startup scripts: %.1f ms", (CCTime::getMonotonicTimeNs() - start) / 1000000.0);
+    sc->logBytecodeCacheStats();
+
     return true;
 }
 
@@ -72,6 +72,10 @@ bool AppDelegate::applicationDidFinishLaunching()
     CCFileUtils::sharedFileUtils()->addSearchPath("res/scenetest/UIComponentTest");
     CCFileUtils::sharedFileUtils()->addSearchPath("res/scenetest/TriggerTest");
     
+    // the first launch compiles the scripts and caches their bytecode, the next ones decode it
+    sc->setBytecodeCacheEnabled(true);
+    long long start = CCTime::getMonotonicTimeNs();
+
 #ifdef JS_OBFUSCATED
     ScriptingCore::getInstance()->runScript("game.js");
 #else
@@ -80,6 +84,9 @@ bool AppDelegate::applicationDidFinishLaunching()
 #endif // JSB_ENABLE_DEBUGGER
     ScriptingCore::getInstance()->runScript("tests-boot-jsb.js");
 #endif
+
+    CCLog("startup scripts: %.1f ms", (CCTime::getMonotonicTimeNs() - start) / 1000000.0);
+    sc->logBytecodeCacheStats();
     return true;
 }
 
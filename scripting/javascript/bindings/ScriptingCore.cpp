@@ -11,8 +11,14 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <time.h>
 #include <vector>
 #include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 #include "ScriptingCore.h"
 #include "jsdbgapi.h"
 #include "cocos2d.h"
@@ -23,10 +29,13 @@
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
 #include <io.h>
 #include <WS2tcpip.h>
+#include <sys/utime.h>
 #else
 #include <sys/socket.h>
 #include <unistd.h>
 #include <netdb.h>
+#include <dirent.h>
+#include <utime.h>
 #endif
 #include <pthread.h>
 
@@ -52,6 +61,7 @@
 #endif // #if DEBUG
 
 #define BYTE_CODE_FILE_EXT ".jsc"
+#define BYTE_CODE_CACHE_DIRECTORY "jsb-bytecode-cache/"
 
 pthread_t debugThread;
 string inData;
@@ -344,12 +354,14 @@ ScriptingCore::ScriptingCore()
 , cx_(NULL)
 , global_(NULL)
 , debugGlobal_(NULL)
+, bytecodeCacheEnabled_(false)
 {
     // set utf8 strings internally (we don't need utf16)
     // XXX: Removed in SpiderMonkey 19.0
     //JS_SetCStringsAreUTF8();
     this->addRegisterCallback(registerDefaultClasses);
     this->runLoop = new SimpleRunLoop();
+    resetBytecodeCacheStats();
 }
 
 void ScriptingCore::string_report(jsval val) {
@@ -487,6 +499,356 @@ static std::string RemoveFileExt(const std::string& filePath) {
     }
 }
 
+/*
+ The bytecode cache holds a file per script, named after the hash of the full path of the script.
+ The file starts with a JSBytecodeCacheHeader followed by the output of JS_EncodeScript. The header
+ identifies the source and the engine that encoded it, any difference is a miss and the script is
+ compiled and cached again. The cache is local to the device, so the header is in the native byte order.
+ */
+struct JSBytecodeCacheHeader
+{
+    char magic[4];
+    uint32_t engine;        // hash of the SpiderMonkey version and the pointer size
+    uint32_t sourceLength;
+    uint32_t compileTime;   // microseconds the compilation took
+    uint64_t sourceHash;
+};
+
+static const char JS_BYTECODE_CACHE_MAGIC[4] = { 'J', 'S', 'B', 'C' };
+
+/** FNV-1a, enough to tell two versions of a script apart */
+static uint64_t bytecodeCacheHash(const unsigned char *data, size_t length, uint64_t hash = 14695981039346656037ULL)
+{
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint32_t bytecodeCacheEngine()
+{
+    const char *version = JS_GetImplementationVersion();
+    uint64_t hash = bytecodeCacheHash((const unsigned char *)version, strlen(version));
+    return (uint32_t)(hash ^ (hash >> 32)) + (uint32_t)sizeof(void *);
+}
+
+static double bytecodeCacheElapsed(long long start)
+{
+    return (CCTime::getMonotonicTimeNs() - start) / 1000000.0;
+}
+
+static bool bytecodeCacheCreateDirectory(const std::string &path)
+{
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32)
+    if (mkdir(path.c_str(), S_IRWXU | S_IRWXG | S_IRWXO) != 0 && errno != EEXIST) {
+        return false;
+    }
+#else
+    if (!CreateDirectoryA(path.c_str(), NULL) && ERROR_ALREADY_EXISTS != GetLastError()) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+// Cache files not used for that long are removed, they belong to scripts renamed or deleted.
+// A hit refreshes the date of a file once a day.
+#ifndef JSB_BYTECODE_CACHE_MAX_AGE_DAYS
+#define JSB_BYTECODE_CACHE_MAX_AGE_DAYS 30
+#endif
+
+#define BYTE_CODE_CACHE_DAY (24 * 60 * 60)
+
+// the cache files are written by a writer thread started with the first job, it is joined
+// by ScriptingCore::cleanup() or at exit once the queue is empty
+static std::mutex _bytecodeCacheMutex;
+static std::condition_variable _bytecodeCacheWriterCondition;  // the writer waits for files
+static std::condition_variable _bytecodeCacheWrittenCondition; // flushBytecodeCache() waits for the writer
+static std::deque<std::pair<std::string, std::string> > _bytecodeCacheQueue; // an empty file refreshes the date
+static std::string _bytecodeCachePruneDirectory;              // pruned before the next file
+static std::thread *_bytecodeCacheWriterThread = NULL;
+static bool _bytecodeCacheWriterQuit = false;
+static bool _bytecodeCacheWriting = false;
+
+static void bytecodeCacheWriteFile(const std::string &path, const std::string &data)
+{
+    if (data.empty()) {
+        utime(path.c_str(), NULL);
+        return;
+    }
+
+    // write aside then rename, so an interrupted write never leaves a truncated cache file
+    std::string tmpPath = path + ".tmp";
+    FILE *fp = fopen(tmpPath.c_str(), "wb");
+    if (!fp) {
+        CCLOG("jsb: can not write the bytecode cache file %s", tmpPath.c_str());
+        return;
+    }
+    bool written = fwrite(data.data(), 1, data.size(), fp) == data.size();
+    written = (fclose(fp) == 0) && written;
+    remove(path.c_str());
+    if (!written || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        CCLOG("jsb: can not write the bytecode cache file %s", path.c_str());
+        remove(tmpPath.c_str());
+    }
+}
+
+/** removes the cache files not used for JSB_BYTECODE_CACHE_MAX_AGE_DAYS, and the leftovers of interrupted writes */
+static void bytecodeCachePrune(const std::string &directory)
+{
+    std::vector<std::string> names;
+#if (CC_TARGET_PLATFORM != CC_PLATFORM_WIN32)
+    DIR *dir = opendir(directory.c_str());
+    if (!dir) {
+        return;
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        names.push_back(entry->d_name);
+    }
+    closedir(dir);
+#else
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((directory + "*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    do {
+        names.push_back(data.cFileName);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#endif
+
+    time_t oldest = time(NULL) - (time_t)JSB_BYTECODE_CACHE_MAX_AGE_DAYS * BYTE_CODE_CACHE_DAY;
+    for (size_t i = 0; i < names.size(); i++) {
+        const std::string &name = names[i];
+        bool tmp = name.length() > 4 && name.compare(name.length() - 4, 4, ".tmp") == 0;
+        bool jsc = name.length() > 4 && name.compare(name.length() - 4, 4, BYTE_CODE_FILE_EXT) == 0;
+        std::string path = directory + name;
+        struct stat st;
+        if ((tmp || jsc) && stat(path.c_str(), &st) == 0 && (tmp || st.st_mtime < oldest)) {
+            remove(path.c_str());
+        }
+    }
+}
+
+static void bytecodeCacheWriterLoop()
+{
+    std::unique_lock<std::mutex> lock(_bytecodeCacheMutex);
+    while (true) {
+        if (!_bytecodeCachePruneDirectory.empty()) {
+            std::string directory;
+            directory.swap(_bytecodeCachePruneDirectory);
+            _bytecodeCacheWriting = true;
+            lock.unlock();
+
+            bytecodeCachePrune(directory);
+
+            lock.lock();
+            _bytecodeCacheWriting = false;
+            continue;
+        }
+
+        if (_bytecodeCacheQueue.empty()) {
+            _bytecodeCacheWrittenCondition.notify_all();
+            if (_bytecodeCacheWriterQuit) {
+                break;
+            }
+            _bytecodeCacheWriterCondition.wait(lock);
+            continue;
+        }
+
+        std::pair<std::string, std::string> file;
+        file.swap(_bytecodeCacheQueue.front());
+        _bytecodeCacheQueue.pop_front();
+        _bytecodeCacheWriting = true;
+        lock.unlock();
+
+        bytecodeCacheWriteFile(file.first, file.second);
+
+        lock.lock();
+        _bytecodeCacheWriting = false;
+    }
+}
+
+/** starts the writer thread if needed, with the mutex locked */
+static void bytecodeCacheStartWriter()
+{
+    if (!_bytecodeCacheWriterThread) {
+        _bytecodeCacheWriterQuit = false;
+        _bytecodeCacheWriterThread = new std::thread(bytecodeCacheWriterLoop);
+    }
+}
+
+/** writes the queued files and joins the writer thread */
+static void bytecodeCacheStopWriter()
+{
+    if (!_bytecodeCacheWriterThread) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_bytecodeCacheMutex);
+        _bytecodeCacheWriterQuit = true;
+    }
+    _bytecodeCacheWriterCondition.notify_one();
+    _bytecodeCacheWriterThread->join();
+    delete _bytecodeCacheWriterThread;
+    _bytecodeCacheWriterThread = NULL;
+}
+
+// Joins the writer when the program exits without destroying ScriptingCore,
+// it is destroyed before the writer state above.
+static struct BytecodeCacheWriterGuard
+{
+    ~BytecodeCacheWriterGuard()
+    {
+        bytecodeCacheStopWriter();
+    }
+} _bytecodeCacheWriterGuard;
+
+static void bytecodeCacheQueueFile(const std::string &path, std::string &data)
+{
+    {
+        std::lock_guard<std::mutex> lock(_bytecodeCacheMutex);
+        _bytecodeCacheQueue.push_back(std::make_pair(path, std::string()));
+        _bytecodeCacheQueue.back().second.swap(data);
+        bytecodeCacheStartWriter();
+    }
+    _bytecodeCacheWriterCondition.notify_one();
+}
+
+void ScriptingCore::setBytecodeCacheEnabled(bool enabled, const char *path)
+{
+    bytecodeCacheEnabled_ = enabled;
+    if (!enabled) {
+        return;
+    }
+
+    bytecodeCachePath_ = path ? path : CCFileUtils::sharedFileUtils()->getWritablePath() + BYTE_CODE_CACHE_DIRECTORY;
+    if (!bytecodeCachePath_.empty() && bytecodeCachePath_[bytecodeCachePath_.length() - 1] != '/') {
+        bytecodeCachePath_ += '/';
+    }
+    if (!bytecodeCacheCreateDirectory(bytecodeCachePath_)) {
+        CCLOG("jsb: can not create the bytecode cache directory %s", bytecodeCachePath_.c_str());
+        bytecodeCacheEnabled_ = false;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_bytecodeCacheMutex);
+        _bytecodeCachePruneDirectory = bytecodeCachePath_;
+        bytecodeCacheStartWriter();
+    }
+    _bytecodeCacheWriterCondition.notify_one();
+}
+
+void ScriptingCore::flushBytecodeCache()
+{
+    std::unique_lock<std::mutex> lock(_bytecodeCacheMutex);
+    while (!_bytecodeCacheQueue.empty() || !_bytecodeCachePruneDirectory.empty() || _bytecodeCacheWriting) {
+        _bytecodeCacheWrittenCondition.wait(lock);
+    }
+}
+
+void ScriptingCore::resetBytecodeCacheStats()
+{
+    memset(&bytecodeCacheStats_, 0, sizeof(bytecodeCacheStats_));
+}
+
+void ScriptingCore::logBytecodeCacheStats()
+{
+    const JSBytecodeCacheStats &stats = bytecodeCacheStats_;
+    CCLog("jsb bytecode cache: %u scripts decoded in %.1f ms, %u compiled in %.1f ms, %.1f ms of compilation saved",
+          stats.hits, stats.decodeTime, stats.misses, stats.compileTime, stats.savedTime);
+}
+
+JSScript* ScriptingCore::compileScriptWithCache(JSContext *cx, JSHandleObject global, JS::CompileOptions &options,
+                                                const std::string &fullPath, bool *sourceFound)
+{
+    unsigned long sourceLength = 0;
+    unsigned char *source = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &sourceLength);
+    *sourceFound = (source != NULL);
+    if (!source) {
+        return NULL;
+    }
+
+    uint64_t sourceHash = bytecodeCacheHash(source, sourceLength);
+    uint32_t engine = bytecodeCacheEngine();
+    char name[20];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)bytecodeCacheHash((const unsigned char *)fullPath.data(), fullPath.length()));
+    std::string cachePath = bytecodeCachePath_ + name + BYTE_CODE_FILE_EXT;
+
+    // a) decode the cached script when it was encoded from this source by this engine
+    JSScript *script = NULL;
+    long long start = CCTime::getMonotonicTimeNs();
+    FILE *fp = fopen(cachePath.c_str(), "rb");
+    if (fp) {
+        JSBytecodeCacheHeader header;
+        if (fread(&header, sizeof(header), 1, fp) == 1
+            && memcmp(header.magic, JS_BYTECODE_CACHE_MAGIC, sizeof(header.magic)) == 0
+            && header.engine == engine
+            && header.sourceLength == sourceLength
+            && header.sourceHash == sourceHash) {
+            fseek(fp, 0, SEEK_END);
+            long length = ftell(fp) - (long)sizeof(header);
+            fseek(fp, sizeof(header), SEEK_SET);
+            std::vector<unsigned char> data(length > 0 ? length : 0);
+            if (length > 0 && fread(&data[0], 1, length, fp) == (size_t)length) {
+                script = JS_DecodeScript(cx, &data[0], (uint32_t)length, NULL, NULL);
+                if (!script) {
+                    ReportException(cx);
+                }
+            }
+            if (script) {
+                double decodeTime = bytecodeCacheElapsed(start);
+                bytecodeCacheStats_.hits++;
+                bytecodeCacheStats_.decodeTime += decodeTime;
+                bytecodeCacheStats_.savedTime += header.compileTime / 1000.0 - decodeTime;
+            }
+        }
+        fclose(fp);
+
+        // keep the file from being pruned while the script is in use
+        struct stat st;
+        if (script && stat(cachePath.c_str(), &st) == 0 && st.st_mtime < time(NULL) - BYTE_CODE_CACHE_DAY) {
+            std::string touch;
+            bytecodeCacheQueueFile(cachePath, touch);
+        }
+    }
+
+    // b) compile it, the cache file is written by the writer thread
+    if (!script) {
+        start = CCTime::getMonotonicTimeNs();
+        script = JS::Compile(cx, global, options, (const char *)source, sourceLength);
+        double compileTime = bytecodeCacheElapsed(start);
+        if (script) {
+            bytecodeCacheStats_.misses++;
+            bytecodeCacheStats_.compileTime += compileTime;
+
+            uint32_t length = 0;
+            void *data = JS_EncodeScript(cx, script, &length);
+            if (data) {
+                JSBytecodeCacheHeader header;
+                memcpy(header.magic, JS_BYTECODE_CACHE_MAGIC, sizeof(header.magic));
+                header.engine = engine;
+                header.sourceLength = (uint32_t)sourceLength;
+                header.compileTime = (uint32_t)(compileTime * 1000.0);
+                header.sourceHash = sourceHash;
+
+                std::string file;
+                file.reserve(sizeof(header) + length);
+                file.append((const char *)&header, sizeof(header));
+                file.append((const char *)data, length);
+                js_free(data);
+                bytecodeCacheQueueFile(cachePath, file);
+            }
+        }
+    }
+
+    CC_SAFE_DELETE_ARRAY(source);
+    return script;
+}
+
 JSBool ScriptingCore::runScript(const char *path, JSObject* global, JSContext* cx)
 {
     if (!path) {
@@ -516,8 +878,16 @@ JSBool ScriptingCore::runScript(const char *path, JSObject* global, JSContext* c
         CC_SAFE_DELETE_ARRAY(data);
     }
     
-    // b) no jsc file, check js file
-    if (!script) {
+    // b) no jsc file, look in the bytecode cache
+    bool sourceFound = false;
+    if (!script && bytecodeCacheEnabled_) {
+        /* Clear any pending exception from previous failed decoding.  */
+        ReportException(cx);
+        script = compileScriptWithCache(cx, obj, options, fullPath, &sourceFound);
+    }
+
+    // c) compile the js file
+    if (!script && !sourceFound) {
         /* Clear any pending exception from previous failed decoding.  */
         ReportException(cx);
         
@@ -561,6 +931,7 @@ ScriptingCore::~ScriptingCore()
 void ScriptingCore::cleanup()
 {
     localStorageFree();
+    bytecodeCacheStopWriter();
     removeAllRoots(cx_);
     if (cx_)
     {
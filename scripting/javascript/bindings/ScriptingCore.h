@@ -27,6 +27,16 @@ typedef void (*sc_register_sth)(JSContext* cx, JSObject* global);
 void registerDefaultClasses(JSContext* cx, JSObject* global);
 
 
+/** what the bytecode cache of runScript saved since the last reset, the times are in milliseconds */
+struct JSBytecodeCacheStats
+{
+    unsigned int hits;      // scripts decoded from the cache
+    unsigned int misses;    // scripts compiled, and cached
+    double compileTime;     // compiling the misses
+    double decodeTime;      // decoding the hits
+    double savedTime;       // compile time recorded with the hits, minus their decode time
+};
+
 class SimpleRunLoop : public CCObject
 {
 public:
@@ -40,6 +50,9 @@ class ScriptingCore : public CCScriptEngineProtocol
 	JSObject  *global_;
 	JSObject  *debugGlobal_;
 	SimpleRunLoop* runLoop;
+	bool bytecodeCacheEnabled_;
+	std::string bytecodeCachePath_;
+	JSBytecodeCacheStats bytecodeCacheStats_;
 
 	ScriptingCore();
 public:
@@ -120,6 +133,23 @@ public:
 	 */
 	JSBool runScript(const char *path, JSObject* global = NULL, JSContext* cx = NULL);
 
+	/**
+	 * runScript keeps the bytecode of the scripts without a .jsc file in a cache directory,
+	 * the writable path by default. A script is compiled once, then decoded from the cache
+	 * until its source changes. The cache files are written in the background.
+	 */
+	void setBytecodeCacheEnabled(bool enabled, const char *path = NULL);
+	bool isBytecodeCacheEnabled() { return bytecodeCacheEnabled_; }
+
+	/**
+	 * waits for the cache files being written
+	 */
+	void flushBytecodeCache();
+
+	const JSBytecodeCacheStats& getBytecodeCacheStats() { return bytecodeCacheStats_; }
+	void resetBytecodeCacheStats();
+	void logBytecodeCacheStats();
+
 	/**
 	 * initialize everything
 	 */
@@ -206,6 +236,8 @@ public:
     
  private:
     void string_report(jsval val);
+    JSScript* compileScriptWithCache(JSContext *cx, JSHandleObject global, JS::CompileOptions &options,
+                                     const std::string &fullPath, bool *sourceFound);
 };
 
 // some utility functions
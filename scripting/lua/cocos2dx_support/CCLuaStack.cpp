@@ -44,6 +44,19 @@ extern "C" {
 #include "platform/ios/CCLuaObjcBridge.h"
 #endif
 
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID || CC_TARGET_PLATFORM == CC_PLATFORM_IOS || CC_TARGET_PLATFORM == CC_PLATFORM_MAC || CC_TARGET_PLATFORM == CC_PLATFORM_LINUX || CC_TARGET_PLATFORM == CC_PLATFORM_BLACKBERRY || CC_TARGET_PLATFORM == CC_PLATFORM_TIZEN)
+#define CC_LUA_BUNDLE_USE_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifndef EMSCRIPTEN
+#include <thread>
+#endif
+#include <string>
+
 namespace {
 int lua_print(lua_State * luastate)
 {
@@ -138,6 +151,12 @@ bool CCLuaStack::initWithLuaState(lua_State *L)
     return true;
 }
 
+CCLuaStack::~CCLuaStack(void)
+{
+    removeAllBundles();
+    cleanupXXTEAKeyAndSign();
+}
+
 void CCLuaStack::addSearchPath(const char* path)
 {
     lua_getglobal(m_state, "package");                                  /* L: package */
@@ -614,4 +633,329 @@ int CCLuaStack::luaLoadBuffer(lua_State* L, const char* chunk, int chunkSize, co
     return r;
 }
 
+// Bundles made by tools/lua-bundle/lua_bundle.py, the values are little endian:
+//   "LUAB", uint32 version, uint32 flags, uint32 module count
+//   module count x (uint32 name offset, uint32 name length, uint32 chunk offset, uint32 chunk size),
+//   sorted by name, the offsets are from the start of the file
+//   the names and the chunks
+// With kLuaBundleEncrypted every chunk is encrypted on its own with XXTEA, without sign.
+#define LUA_BUNDLE_VERSION      1
+#define LUA_BUNDLE_HEADER_SIZE  16
+#define LUA_BUNDLE_ENTRY_SIZE   16
+
+enum
+{
+    kLuaBundleEncrypted = 1,
+};
+
+static unsigned int luaBundleRead32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+/** A bundle of chunks, searched by module name. */
+class CCLuaBundle
+{
+public:
+    CCLuaBundle(const char* key, int keyLen)
+    : m_pData(NULL)
+    , m_uSize(0)
+    , m_bMapped(false)
+    , m_uCount(0)
+    , m_bEncrypted(false)
+    , m_bValid(false)
+    , m_key(key ? key : "", key ? keyLen : 0)
+    {
+    }
+
+    ~CCLuaBundle()
+    {
+        wait();
+        for (size_t i = 0; i < m_decrypted.size(); ++i)
+        {
+            free(m_decrypted[i]);
+        }
+        close();
+    }
+
+    /** Reads the bundle and decrypts all of its chunks, unless they are decrypted when required. */
+    bool load(const std::string& path, bool decryptAll)
+    {
+        m_bValid = open(path);
+        if (m_bValid && decryptAll && m_bEncrypted)
+        {
+            for (unsigned int i = 0; i < m_uCount; ++i)
+            {
+                decrypt(i);
+            }
+        }
+        return m_bValid;
+    }
+
+    void loadAsync(const std::string& path)
+    {
+#ifndef EMSCRIPTEN
+        m_loader = std::thread(&CCLuaBundle::load, this, path, true);
+#else
+        load(path, true);
+#endif
+    }
+
+    /** Waits for loadAsync. */
+    void wait()
+    {
+#ifndef EMSCRIPTEN
+        if (m_loader.joinable())
+        {
+            m_loader.join();
+        }
+#endif
+    }
+
+    bool isValid() const { return m_bValid; }
+    unsigned int getCount() const { return m_uCount; }
+
+    /** Returns the index of a module, -1 if the bundle does not hold it. */
+    int find(const char* name) const
+    {
+        size_t nameLen = strlen(name);
+        int low = 0;
+        int high = (int)m_uCount - 1;
+        while (low <= high)
+        {
+            int middle = low + (high - low) / 2;
+            const unsigned char* entry = m_pData + LUA_BUNDLE_HEADER_SIZE + middle * LUA_BUNDLE_ENTRY_SIZE;
+            const char* entryName = (const char*)m_pData + luaBundleRead32(entry);
+            size_t entryLen = luaBundleRead32(entry + 4);
+
+            int r = memcmp(name, entryName, nameLen < entryLen ? nameLen : entryLen);
+            if (r == 0)
+            {
+                r = nameLen < entryLen ? -1 : (nameLen > entryLen ? 1 : 0);
+            }
+            if (r == 0)
+            {
+                return middle;
+            }
+            if (r < 0)
+            {
+                high = middle - 1;
+            }
+            else
+            {
+                low = middle + 1;
+            }
+        }
+        return -1;
+    }
+
+    /** Returns the chunk of a module, valid until release(index). */
+    const char* chunk(unsigned int index, size_t* size)
+    {
+        if (m_bEncrypted)
+        {
+            if (!m_decrypted[index])
+            {
+                decrypt(index);
+            }
+            *size = m_decryptedSize[index];
+            return (const char*)m_decrypted[index];
+        }
+
+        const unsigned char* entry = m_pData + LUA_BUNDLE_HEADER_SIZE + index * LUA_BUNDLE_ENTRY_SIZE;
+        *size = luaBundleRead32(entry + 12);
+        return (const char*)m_pData + luaBundleRead32(entry + 8);
+    }
+
+    /** Frees the decrypted chunk, modules are required once. */
+    void release(unsigned int index)
+    {
+        if (m_bEncrypted && m_decrypted[index])
+        {
+            free(m_decrypted[index]);
+            m_decrypted[index] = NULL;
+            m_decryptedSize[index] = 0;
+        }
+    }
+
+private:
+    bool open(const std::string& path)
+    {
+#if CC_LUA_BUNDLE_USE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if (addr != MAP_FAILED)
+                {
+                    m_pData = (const unsigned char*)addr;
+                    m_uSize = (size_t)st.st_size;
+                    m_bMapped = true;
+                }
+            }
+            ::close(fd);
+        }
+#endif
+
+        // not a plain file (android assets) or no mmap on this platform
+        if (!m_pData)
+        {
+            unsigned long size = 0;
+            m_pData = CCFileUtils::sharedFileUtils()->getFileData(path.c_str(), "rb", &size);
+            m_uSize = size;
+        }
+
+        if (!m_pData || m_uSize < LUA_BUNDLE_HEADER_SIZE || memcmp(m_pData, "LUAB", 4) != 0
+            || luaBundleRead32(m_pData + 4) != LUA_BUNDLE_VERSION)
+        {
+            CCLOG("[LUA ERROR] %s is not a lua bundle", path.c_str());
+            return false;
+        }
+
+        m_bEncrypted = (luaBundleRead32(m_pData + 8) & kLuaBundleEncrypted) != 0;
+        m_uCount = luaBundleRead32(m_pData + 12);
+        if ((m_uSize - LUA_BUNDLE_HEADER_SIZE) / LUA_BUNDLE_ENTRY_SIZE < m_uCount)
+        {
+            CCLOG("[LUA ERROR] the index of the lua bundle %s is truncated", path.c_str());
+            m_uCount = 0;
+            return false;
+        }
+        for (unsigned int i = 0; i < m_uCount; ++i)
+        {
+            const unsigned char* entry = m_pData + LUA_BUNDLE_HEADER_SIZE + i * LUA_BUNDLE_ENTRY_SIZE;
+            size_t nameOffset = luaBundleRead32(entry), nameLen = luaBundleRead32(entry + 4);
+            size_t chunkOffset = luaBundleRead32(entry + 8), chunkSize = luaBundleRead32(entry + 12);
+            if (nameOffset > m_uSize || nameLen > m_uSize - nameOffset
+                || chunkOffset > m_uSize || chunkSize > m_uSize - chunkOffset)
+            {
+                CCLOG("[LUA ERROR] the lua bundle %s is truncated", path.c_str());
+                m_uCount = 0;
+                return false;
+            }
+        }
+
+        if (m_bEncrypted)
+        {
+            if (m_key.empty())
+            {
+                CCLOG("[LUA ERROR] the lua bundle %s is encrypted, set the XXTEA key first", path.c_str());
+                m_uCount = 0;
+                return false;
+            }
+            m_decrypted.resize(m_uCount, NULL);
+            m_decryptedSize.resize(m_uCount, 0);
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (!m_pData)
+        {
+            return;
+        }
+#if CC_LUA_BUNDLE_USE_MMAP
+        if (m_bMapped)
+        {
+            munmap((void*)m_pData, m_uSize);
+        }
+        else
+#endif
+        {
+            delete[] m_pData;
+        }
+        m_pData = NULL;
+    }
+
+    void decrypt(unsigned int index)
+    {
+        const unsigned char* entry = m_pData + LUA_BUNDLE_HEADER_SIZE + index * LUA_BUNDLE_ENTRY_SIZE;
+        xxtea_long len = 0;
+        m_decrypted[index] = xxtea_decrypt((unsigned char*)m_pData + luaBundleRead32(entry + 8),
+                                           (xxtea_long)luaBundleRead32(entry + 12),
+                                           (unsigned char*)m_key.data(),
+                                           (xxtea_long)m_key.size(),
+                                           &len);
+        m_decryptedSize[index] = m_decrypted[index] ? len : 0;
+    }
+
+    const unsigned char* m_pData;
+    size_t m_uSize;
+    bool m_bMapped;
+    unsigned int m_uCount;
+    bool m_bEncrypted;
+    bool m_bValid;
+    std::string m_key;
+    std::vector<unsigned char*> m_decrypted;
+    std::vector<xxtea_long> m_decryptedSize;
+#ifndef EMSCRIPTEN
+    std::thread m_loader;
+#endif
+};
+
+bool CCLuaStack::addBundle(const char* path, bool lazyDecrypt)
+{
+    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(path);
+    CCLuaBundle* bundle = new CCLuaBundle(m_xxteaEnabled ? m_xxteaKey : NULL, m_xxteaKeyLen);
+    if (!bundle->load(fullPath, !lazyDecrypt))
+    {
+        delete bundle;
+        return false;
+    }
+    CCLOG("lua bundle %s: %u modules", path, bundle->getCount());
+    m_bundles.push_back(bundle);
+    return true;
+}
+
+void CCLuaStack::addBundleAsync(const char* path)
+{
+    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(path);
+    CCLuaBundle* bundle = new CCLuaBundle(m_xxteaEnabled ? m_xxteaKey : NULL, m_xxteaKeyLen);
+    bundle->loadAsync(fullPath);
+    m_bundles.push_back(bundle);
+}
+
+void CCLuaStack::removeAllBundles(void)
+{
+    for (size_t i = 0; i < m_bundles.size(); ++i)
+    {
+        delete m_bundles[i];
+    }
+    m_bundles.clear();
+}
+
+bool CCLuaStack::loadBundleChunk(lua_State* L, const char* moduleName)
+{
+    for (size_t i = m_bundles.size(); i > 0; --i)
+    {
+        CCLuaBundle* bundle = m_bundles[i - 1];
+        bundle->wait();
+        if (!bundle->isValid())
+        {
+            continue;
+        }
+
+        int index = bundle->find(moduleName);
+        if (index < 0)
+        {
+            continue;
+        }
+
+        size_t size = 0;
+        const char* chunk = bundle->chunk(index, &size);
+        if (!chunk)
+        {
+            CCLOG("[LUA ERROR] can not decrypt \"%s\", wrong XXTEA key?", moduleName);
+            continue;
+        }
+        luaLoadBuffer(L, chunk, (int)size, moduleName);
+        bundle->release(index);
+        return true;
+    }
+    return false;
+}
+
 NS_CC_END
@@ -33,7 +33,12 @@ extern "C" {
 #include "cocoa/CCObject.h"
 #include "CCLuaValue.h"
 
+#include <vector>
+
 NS_CC_BEGIN
+
+class CCLuaBundle;
+
 /** Lua support for cocos2d-x
  *  @js NA
  *  @lua NA
@@ -43,6 +48,7 @@ class CCLuaStack : public CCObject
 public:
     static CCLuaStack *create(void);
     static CCLuaStack *attach(lua_State *L);
+    virtual ~CCLuaStack(void);
     
     /**
      @brief Method used to get a pointer to the lua_State that the script module is attached to.
@@ -124,7 +130,32 @@ public:
     void setXXTEAKeyAndSign(const char *key, int keyLen, const char *sign, int signLen);
     void cleanupXXTEAKeyAndSign();
     int luaLoadBuffer(lua_State* L, const char* chunk, int chunkSize, const char* chunkName);
-    
+
+    /**
+     @brief Adds a bundle of precompiled modules made with tools/lua-bundle/lua_bundle.py.
+     require looks for the modules in the bundles before the files of package.path,
+     the last bundle added is searched first. The bundle is mapped when it is a plain file.
+     An encrypted bundle needs the XXTEA key to be set before it is added.
+     @param path of the bundle
+     @param lazyDecrypt decrypt each module when it is required instead of all of them now
+     @return false if the file can not be read or is not a bundle
+     */
+    bool addBundle(const char* path, bool lazyDecrypt = false);
+
+    /**
+     @brief Same as addBundle(path) but the bundle is read and decrypted on a background thread,
+     while the splash screen is shown for instance. The first require that needs it waits for the thread.
+     */
+    void addBundleAsync(const char* path);
+
+    void removeAllBundles(void);
+
+    /**
+     @brief Loads the chunk of a module from the bundles and pushes it on the stack.
+     @param moduleName name given to require, the parts separated by dots
+     @return false if no bundle holds the module
+     */
+    bool loadBundleChunk(lua_State* L, const char* moduleName);
     
 protected:
     CCLuaStack(void)
@@ -148,6 +179,7 @@ protected:
     int   m_xxteaKeyLen;
     char* m_xxteaSign;
     int   m_xxteaSignLen;
+    std::vector<CCLuaBundle*> m_bundles;
 };
 
 NS_CC_END
@@ -52,6 +52,15 @@ extern "C"
             }
         }
         
+        // the bundles added to the stack come first, they are indexed by the dotted module name
+        CCLuaStack* stack = CCLuaEngine::defaultEngine()->getLuaStack();
+        std::string moduleName(filename);
+        std::replace(moduleName.begin(), moduleName.end(), '/', '.');
+        if (stack->loadBundleChunk(L, moduleName.c_str()))
+        {
+            return 1;
+        }
+        
         pos = filename.find_first_of(".");
         while (pos != std::string::npos)
         {
@@ -105,7 +114,6 @@ extern "C"
         
         if (NULL != chunk)
         {
-            CCLuaStack* stack = CCLuaEngine::defaultEngine()->getLuaStack();
             stack->luaLoadBuffer(L, (char*)chunk, (int)chunkSize, chunkName.c_str());
             free(chunk);
         }
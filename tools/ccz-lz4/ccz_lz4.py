@@ -0,0 +1,202 @@
+#!/usr/bin/python
+# ccz_lz4.py
+# Compress a file (or re-compress a zlib .ccz file) into an lz4 CCZ container
+# Copyright (c) 2013 cocos2d-x.org
+#
+# The output keeps the regular 16 bytes CCZ header ('CCZ!', compression type 4)
+# followed by the block table read by ZipUtils::ccInflateLZ4Blocks:
+#
+#   uint32 block size, uint32 block count, uint32 compressed size per block
+#
+# all big endian. Blocks are compressed independently so the engine can decode
+# them in parallel. The python-lz4 module is used when installed, otherwise a
+# slower pure python encoder produces the same format.
+
+from __future__ import print_function
+
+import struct
+import sys
+import zlib
+
+CCZ_COMPRESSION_ZLIB = 0
+CCZ_COMPRESSION_LZ4 = 4
+CCZ_LZ4_BLOCK_STORED = 0x80000000
+
+DEFAULT_BLOCK_SIZE = 256 * 1024
+
+MIN_MATCH = 4
+LAST_LITERALS = 5
+MF_LIMIT = 12
+MAX_OFFSET = 0xffff
+
+try:
+    import lz4.block as lz4block
+except ImportError:
+    lz4block = None
+
+
+def dumpUsage():
+    print("Usage: ccz_lz4.py [-hc] [-block SIZE_IN_KB] INPUT OUTPUT")
+    print("Options:")
+    print("  -hc      Use the high compression encoder, slower to encode, same decode speed")
+    print("  -block   Size of the independently decoded blocks, 256 by default, 0 for a single block")
+    print("")
+    print("INPUT can be a raw file (e.g. .pvr) or a zlib compressed .ccz file, which is inflated first.")
+    print("")
+    print("Sample: ./ccz_lz4.py -hc atlas.pvr.ccz atlas-lz4.pvr.ccz")
+    print("")
+
+
+def writeLength(out, length):
+    while length >= 255:
+        out.append(255)
+        length -= 255
+    out.append(length)
+
+
+def writeSequence(out, src, anchor, literalEnd, matchLength, offset):
+    literalLength = literalEnd - anchor
+    token = min(literalLength, 15) << 4
+    if matchLength is not None:
+        token |= min(matchLength - MIN_MATCH, 15)
+    out.append(token)
+    if literalLength >= 15:
+        writeLength(out, literalLength - 15)
+    out.extend(src[anchor:literalEnd])
+    if matchLength is not None:
+        out.append(offset & 0xff)
+        out.append(offset >> 8)
+        if matchLength - MIN_MATCH >= 15:
+            writeLength(out, matchLength - MIN_MATCH - 15)
+
+
+def compressBlockPython(src, highCompression):
+    """Greedy LZ4 block encoder, with short hash chains in high compression mode."""
+    n = len(src)
+    out = bytearray()
+    anchor = 0
+    if n < MF_LIMIT + 1:
+        writeSequence(out, src, 0, n, None, 0)
+        return bytes(out)
+
+    depth = 16 if highCompression else 1
+    head = {}
+    chain = {}
+    matchLimit = n - LAST_LITERALS
+    i = 0
+    while i < n - MF_LIMIT:
+        key = bytes(src[i:i + MIN_MATCH])
+        candidate = head.get(key)
+        if depth > 1 and candidate is not None:
+            chain[i] = candidate
+        head[key] = i
+
+        bestLength = 0
+        bestOffset = 0
+        tries = depth
+        while candidate is not None and tries > 0 and i - candidate <= MAX_OFFSET:
+            length = MIN_MATCH
+            while i + length < matchLimit and src[candidate + length] == src[i + length]:
+                length += 1
+            if length > bestLength:
+                bestLength = length
+                bestOffset = i - candidate
+            candidate = chain.get(candidate)
+            tries -= 1
+
+        if bestLength < MIN_MATCH:
+            i += 1
+            continue
+
+        writeSequence(out, src, anchor, i, bestLength, bestOffset)
+        end = i + bestLength
+        # keep the dictionary fed with the positions inside the match
+        for j in range(i + 1, min(end, n - MF_LIMIT)):
+            key = bytes(src[j:j + MIN_MATCH])
+            if depth > 1 and key in head:
+                chain[j] = head[key]
+            head[key] = j
+        i = end
+        anchor = end
+
+    writeSequence(out, src, anchor, n, None, 0)
+    return bytes(out)
+
+
+def compressBlock(src, highCompression):
+    if lz4block is not None:
+        mode = 'high_compression' if highCompression else 'default'
+        return lz4block.compress(src, mode=mode, store_size=False)
+    return compressBlockPython(bytearray(src), highCompression)
+
+
+def readInput(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if not data:
+        raise ValueError("%s is empty" % path)
+    if len(data) >= 16 and data[0:3] == b'CCZ':
+        sig, compression, version, reserved, length = struct.unpack('>4sHHII', data[:16])
+        if sig != b'CCZ!':
+            raise ValueError("%s is an encrypted ccz file, decrypt it first" % path)
+        if compression == CCZ_COMPRESSION_LZ4:
+            raise ValueError("%s is already lz4 compressed" % path)
+        if compression != CCZ_COMPRESSION_ZLIB:
+            raise ValueError("%s uses an unsupported compression method %d" % (path, compression))
+        data = zlib.decompress(data[16:])
+        if len(data) != length:
+            raise ValueError("%s has a wrong uncompressed length" % path)
+        if not data:
+            raise ValueError("%s holds no data" % path)
+    return data
+
+
+def writeCCZ(path, data, blockSize, highCompression):
+    if blockSize <= 0:
+        blockSize = max(len(data), 1)
+    blocks = []
+    for start in range(0, max(len(data), 1), blockSize):
+        raw = data[start:start + blockSize]
+        packed = compressBlock(raw, highCompression)
+        if len(packed) >= len(raw):
+            blocks.append((len(raw) | CCZ_LZ4_BLOCK_STORED, raw))
+        else:
+            blocks.append((len(packed), packed))
+
+    with open(path, 'wb') as f:
+        f.write(struct.pack('>4sHHII', b'CCZ!', CCZ_COMPRESSION_LZ4, 2, 0, len(data)))
+        f.write(struct.pack('>II', blockSize, len(blocks)))
+        for size, payload in blocks:
+            f.write(struct.pack('>I', size))
+        for size, payload in blocks:
+            f.write(payload)
+    return 16 + 8 + 4 * len(blocks) + sum(len(payload) for size, payload in blocks)
+
+
+def main(argv):
+    highCompression = False
+    blockSize = DEFAULT_BLOCK_SIZE
+    files = []
+    i = 0
+    while i < len(argv):
+        if argv[i] == '-hc':
+            highCompression = True
+        elif argv[i] == '-block' and i + 1 < len(argv):
+            i += 1
+            blockSize = int(argv[i]) * 1024
+        else:
+            files.append(argv[i])
+        i += 1
+
+    if len(files) != 2:
+        dumpUsage()
+        return 1
+
+    data = readInput(files[0])
+    compressed = writeCCZ(files[1], data, blockSize, highCompression)
+    print("%s: %d -> %d bytes" % (files[1], len(data), compressed))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,153 @@
+#!/usr/bin/python
+# server.py
+# Local stand-in for game API servers, used to measure CCHttpClient throughput and latency
+# Copyright (c) 2013 cocos2d-x.org
+#
+# Every GET, POST, PUT or DELETE request is answered with HTTP/1.1 keep-alive,
+# after an optional delay and with a body of the requested size:
+#
+#   http://localhost:8080/?delay=50&size=1024
+#
+# delay is in milliseconds, size in bytes. Requests are served concurrently.
+# GET requests with a "Range: bytes=N-" header get the rest of the body as a
+# 206 answer (416 past its end), add ranges=0 to the query to ignore them.
+# The number of requests and of TCP connections are printed every few seconds,
+# which shows whether the client reuses its connections.
+
+from __future__ import print_function
+
+import socket
+import sys
+import threading
+import time
+
+try:
+    from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+    from SocketServer import ThreadingMixIn
+    from urlparse import urlparse, parse_qs
+except ImportError:
+    from http.server import BaseHTTPRequestHandler, HTTPServer
+    from socketserver import ThreadingMixIn
+    from urllib.parse import urlparse, parse_qs
+
+stats = {'requests': 0, 'connections': 0}
+statsLock = threading.Lock()
+
+
+def dumpUsage():
+    print("Usage: server.py [-port PORT] [-delay MS] [-size BYTES]")
+    print("Options:")
+    print("  -port   port to listen on, 8080 by default")
+    print("  -delay  default delay of the responses in ms, 0 by default")
+    print("  -size   default size of the response bodies in bytes, 64 by default")
+    print("")
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    defaultDelay = 0
+    defaultSize = 64
+
+    def setup(self):
+        BaseHTTPRequestHandler.setup(self)
+        # headers and body are written separately, don't let Nagle delay the body
+        self.request.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        with statsLock:
+            stats['connections'] += 1
+
+    def log_message(self, format, *args):
+        pass
+
+    def respond(self):
+        query = parse_qs(urlparse(self.path).query)
+        delay = int(query.get('delay', [self.defaultDelay])[0])
+        size = int(query.get('size', [self.defaultSize])[0])
+        ranges = query.get('ranges', ['1'])[0] != '0'
+
+        length = int(self.headers.get('Content-Length') or 0)
+        if length:
+            self.rfile.read(length)
+
+        if delay:
+            time.sleep(delay / 1000.0)
+
+        # the body depends on the offset so that a badly resumed download shows
+        body = bytes(bytearray(i % 251 for i in range(size)))
+        status = 200
+        contentRange = None
+        requested = self.headers.get('Range')
+        if ranges and self.command == 'GET' and requested and requested.startswith('bytes='):
+            first = int(requested[len('bytes='):].split('-')[0])
+            if first >= size:
+                status = 416
+                contentRange = 'bytes */%d' % size
+                body = b''
+            else:
+                status = 206
+                contentRange = 'bytes %d-%d/%d' % (first, size - 1, size)
+                body = body[first:]
+
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(len(body)))
+        if contentRange:
+            self.send_header('Content-Range', contentRange)
+        self.end_headers()
+        self.wfile.write(body)
+        with statsLock:
+            stats['requests'] += 1
+
+    do_GET = respond
+    do_POST = respond
+    do_PUT = respond
+    do_DELETE = respond
+
+
+class Server(ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+
+
+def printStats():
+    last = None
+    while True:
+        time.sleep(2)
+        with statsLock:
+            current = (stats['requests'], stats['connections'])
+        if current != last:
+            print("%d requests on %d connections" % current)
+            last = current
+
+
+def main(argv):
+    port = 8080
+    i = 0
+    while i < len(argv):
+        if argv[i] == '-port' and i + 1 < len(argv):
+            i += 1
+            port = int(argv[i])
+        elif argv[i] == '-delay' and i + 1 < len(argv):
+            i += 1
+            Handler.defaultDelay = int(argv[i])
+        elif argv[i] == '-size' and i + 1 < len(argv):
+            i += 1
+            Handler.defaultSize = int(argv[i])
+        else:
+            dumpUsage()
+            return 1
+        i += 1
+
+    thread = threading.Thread(target=printStats)
+    thread.daemon = True
+    thread.start()
+
+    server = Server(('', port), Handler)
+    print("Listening on http://localhost:%d/" % port)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
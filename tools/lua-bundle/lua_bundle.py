@@ -0,0 +1,191 @@
+#!/usr/bin/python
+# lua_bundle.py
+# Pack lua modules into the bundle format read by CCLuaStack::addBundle
+# Copyright (c) 2013 cocos2d-x.org
+#
+# Every module found under the source directories is compiled with luac and
+# stored in one file, indexed by its module name: the path relative to the
+# source directory without the extension, with '.' between the directories,
+# the name given to require(). The layout is described above CCLuaBundle in
+# scripting/lua/cocos2dx_support/CCLuaStack.cpp.
+#
+# Lua 5.1 bytecode depends on the size of int, size_t and lua_Number and on
+# the byte order, use a luac built for the target (32 bit luac for armv7).
+# --source stores the sources instead, they load on every platform but are
+# compiled at require time.
+
+from __future__ import print_function
+
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+MAGIC = b'LUAB'
+VERSION = 1
+
+FLAG_ENCRYPTED = 1
+
+HEADER_SIZE = 16
+ENTRY_SIZE = 16
+
+XXTEA_DELTA = 0x9e3779b9
+
+
+class ConvertError(Exception):
+    pass
+
+
+def xxteaEncrypt(data, key):
+    """Same output as xxtea_encrypt in scripting/lua/xxtea, decrypted by xxtea_decrypt."""
+    key = (key + b'\0' * 16)[:16]
+    k = struct.unpack('<4I', key)
+
+    length = len(data)
+    padded = data + b'\0' * ((4 - length % 4) % 4)
+    v = list(struct.unpack('<%dI' % (len(padded) // 4), padded)) + [length]
+
+    n = len(v) - 1
+    z = v[n]
+    total = 0
+    q = 6 + 52 // (n + 1)
+    while q > 0:
+        q -= 1
+        total = (total + XXTEA_DELTA) & 0xffffffff
+        e = (total >> 2) & 3
+        for p in range(n + 1):
+            y = v[(p + 1) % (n + 1)]
+            mx = ((((z >> 5) ^ (y << 2)) + ((y >> 3) ^ (z << 4))) ^ ((total ^ y) + (k[(p & 3) ^ e] ^ z))) & 0xffffffff
+            v[p] = (v[p] + mx) & 0xffffffff
+            z = v[p]
+    return struct.pack('<%dI' % len(v), *v)
+
+
+def moduleName(root, path):
+    name = os.path.splitext(os.path.relpath(path, root))[0]
+    return '.'.join(name.split(os.sep))
+
+
+def findModules(roots):
+    modules = {}
+    for root in roots:
+        for dirpath, dirnames, filenames in os.walk(root):
+            dirnames.sort()
+            for filename in sorted(filenames):
+                if os.path.splitext(filename)[1] not in ('.lua', '.luac'):
+                    continue
+                path = os.path.join(dirpath, filename)
+                name = moduleName(root, path)
+                if name in modules:
+                    raise ConvertError("%s and %s are both module %s" % (modules[name], path, name))
+                modules[name] = path
+    return modules
+
+
+def compileModule(path, luac, strip):
+    with open(path, 'rb') as f:
+        data = f.read()
+    # already compiled, or stored as source
+    if luac is None or data.startswith(b'\x1bLua'):
+        return data
+
+    fd, output = tempfile.mkstemp(suffix='.luac')
+    os.close(fd)
+    try:
+        command = [luac, '-o', output]
+        if strip:
+            command.append('-s')
+        command.append(path)
+        if subprocess.call(command) != 0:
+            raise ConvertError("%s failed on %s" % (luac, path))
+        with open(output, 'rb') as f:
+            return f.read()
+    finally:
+        os.remove(output)
+
+
+def pack(modules, luac, strip, key):
+    names = sorted(modules.keys(), key=lambda name: name.encode('utf-8'))
+    encodedNames = [name.encode('utf-8') for name in names]
+    chunks = []
+    for name in names:
+        chunk = compileModule(modules[name], luac, strip)
+        if key:
+            chunk = xxteaEncrypt(chunk, key)
+        chunks.append(chunk)
+
+    offset = HEADER_SIZE + ENTRY_SIZE * len(names)
+    index = bytearray()
+    nameOffsets = []
+    for encoded in encodedNames:
+        nameOffsets.append(offset)
+        offset += len(encoded)
+    for i, chunk in enumerate(chunks):
+        index += struct.pack('<4I', nameOffsets[i], len(encodedNames[i]), offset, len(chunk))
+        offset += len(chunk)
+
+    out = bytearray(MAGIC)
+    out += struct.pack('<3I', VERSION, FLAG_ENCRYPTED if key else 0, len(names))
+    out += index
+    for encoded in encodedNames:
+        out += encoded
+    for chunk in chunks:
+        out += chunk
+    return out
+
+
+def dumpUsage():
+    print("Usage: lua_bundle.py [--luac LUAC] [--strip] [--source] [--key KEY] OUTPUT SOURCE_DIR...")
+    print("")
+    print("Packs the .lua and .luac files under SOURCE_DIR into the bundle OUTPUT.")
+    print("  --luac LUAC  luac matching the target, defaults to luac in the PATH")
+    print("  --strip      strip the debug information, error messages lose their line numbers")
+    print("  --source     store the sources, the modules are compiled at require time")
+    print("  --key KEY    encrypt the modules, KEY is the key given to CCLuaStack::setXXTEAKeyAndSign")
+    print("")
+    print("Sample: ./lua_bundle.py --luac luac32 --strip game.luab ../../samples/Lua/TestLua/Resources/luaScript")
+    print("")
+
+
+def main():
+    args = sys.argv[1:]
+    luac = 'luac'
+    strip = False
+    key = None
+    while args and args[0].startswith('--'):
+        option = args.pop(0)
+        if option == '--strip':
+            strip = True
+        elif option == '--source':
+            luac = None
+        elif option in ('--luac', '--key') and args:
+            value = args.pop(0)
+            if option == '--luac':
+                luac = value
+            else:
+                key = value.encode('utf-8')
+        else:
+            dumpUsage()
+            return 1
+
+    if len(args) < 2:
+        dumpUsage()
+        return 1
+
+    outputPath = args[0]
+    try:
+        modules = findModules(args[1:])
+        data = pack(modules, luac, strip, key)
+    except (ConvertError, OSError) as e:
+        print("%s: %s" % (outputPath, e), file=sys.stderr)
+        return 1
+
+    with open(outputPath, 'wb') as f:
+        f.write(data)
+    print("%d modules -> %s: %d bytes" % (len(modules), outputPath, len(data)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,89 @@
+#!/usr/bin/python
+# compare.py
+# Compare two benchmark.json files written by the TestCpp benchmark runner
+# Copyright (c) 2013 cocos2d-x.org
+#
+# The runner is started with COCOS2D_BENCHMARK=1 (see PerformanceBenchmarkRunner.h).
+# For every scenario found in both files the chosen statistic of the chosen
+# metric is compared, and the script exits with 1 when at least one scenario
+# is slower than the threshold, so it can be used to gate regressions.
+
+from __future__ import print_function
+
+import json
+import sys
+
+METRICS = ['update', 'visit', 'draw', 'swap', 'total', 'dt', 'drawCalls', 'allocations', 'allocatedBytes']
+STATISTICS = ['mean', 'p50', 'p90', 'p99', 'max']
+
+
+def dumpUsage():
+    print("Usage: compare.py [-metric NAME] [-stat NAME] [-threshold PERCENT] BASELINE.json CURRENT.json")
+    print("Options:")
+    print("  -metric     %s, total by default" % ', '.join(METRICS))
+    print("  -stat       %s, p50 by default" % ', '.join(STATISTICS))
+    print("  -threshold  allowed slow down in percent, 5 by default")
+    print("")
+    print("Sample: ./compare.py -stat p90 -threshold 10 master.json branch.json")
+    print("")
+
+
+def loadScenarios(path):
+    with open(path) as f:
+        results = json.load(f)
+    return results.get('label', ''), dict((s['name'], s) for s in results['scenarios'])
+
+
+def main(argv):
+    metric = 'total'
+    stat = 'p50'
+    threshold = 5.0
+    files = []
+    i = 0
+    while i < len(argv):
+        if argv[i] == '-metric' and i + 1 < len(argv):
+            i += 1
+            metric = argv[i]
+        elif argv[i] == '-stat' and i + 1 < len(argv):
+            i += 1
+            stat = argv[i]
+        elif argv[i] == '-threshold' and i + 1 < len(argv):
+            i += 1
+            threshold = float(argv[i])
+        else:
+            files.append(argv[i])
+        i += 1
+
+    if len(files) != 2 or metric not in METRICS or stat not in STATISTICS:
+        dumpUsage()
+        return 2
+
+    baseLabel, base = loadScenarios(files[0])
+    currentLabel, current = loadScenarios(files[1])
+
+    print("%s.%s: %s -> %s" % (metric, stat, baseLabel or files[0], currentLabel or files[1]))
+    regressions = 0
+    for name in sorted(base):
+        if name not in current:
+            print("  %-45s missing" % name)
+            continue
+        before = base[name][metric][stat]
+        after = current[name][metric][stat]
+        if before > 0:
+            change = (after - before) * 100.0 / before
+        else:
+            change = 0.0 if after == 0 else 100.0
+        marker = ''
+        if change > threshold:
+            marker = '  REGRESSION'
+            regressions += 1
+        print("  %-45s %10.4f %10.4f %+7.1f%%%s" % (name, before, after, change, marker))
+
+    if regressions:
+        print("%d scenario(s) slower than %.1f%%" % (regressions, threshold))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
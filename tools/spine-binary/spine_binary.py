@@ -0,0 +1,233 @@
+#!/usr/bin/python
+# spine_binary.py
+# Convert spine JSON skeletons into the binary format read by SkeletonBinary
+# Copyright (c) 2013 cocos2d-x.org
+#
+# The binary file holds the same data as the JSON with names resolved to
+# indices, so CCSkeleton loads it without parsing any text. CCSkeleton detects
+# the format from the 'SPNB' header, the file name does not matter. The layout
+# is described at the top of extensions/spine/SkeletonBinary.cpp, values are
+# written unscaled and the scale passed to CCSkeleton is applied at load time.
+
+from __future__ import print_function
+
+from collections import OrderedDict
+import json
+import os
+import struct
+import sys
+
+MAGIC = b'SPNB'
+VERSION = 1
+
+TIMELINE_ROTATE = 0
+TIMELINE_TRANSLATE = 1
+TIMELINE_SCALE = 2
+TIMELINE_COLOR = 3
+TIMELINE_ATTACHMENT = 4
+
+CURVE_LINEAR = 0
+CURVE_STEPPED = 1
+CURVE_BEZIER = 2
+
+ATTACHMENT_TYPES = {'region': 0, 'regionSequence': 1}
+
+
+class ConvertError(Exception):
+    pass
+
+
+class Writer(object):
+    def __init__(self):
+        self.out = bytearray()
+
+    def byte(self, value):
+        self.out.append(value & 0xff)
+
+    def varint(self, value):
+        if value < 0:
+            raise ConvertError("negative count or index: %d" % value)
+        while True:
+            b = value & 0x7f
+            value >>= 7
+            if value:
+                self.out.append(b | 0x80)
+            else:
+                self.out.append(b)
+                return
+
+    def float(self, value):
+        self.out += struct.pack('<f', value)
+
+    def string(self, value):
+        if value is None:
+            self.varint(0)
+            return
+        data = value.encode('utf-8')
+        if b'\0' in data:
+            raise ConvertError("name contains a zero byte: %r" % value)
+        self.varint(len(data) + 1)
+        self.out += data
+        self.out.append(0)
+
+    def color(self, value):
+        if value is None:
+            value = 'ffffffff'
+        if len(value) != 8:
+            raise ConvertError("invalid color: %s" % value)
+        for i in range(4):
+            self.byte(int(value[i * 2:i * 2 + 2], 16))
+
+
+def indexByName(items, name, what):
+    for i, item in enumerate(items):
+        if item['name'] == name:
+            return i
+    raise ConvertError("%s not found: %s" % (what, name))
+
+
+def writeCurves(w, frames):
+    # the engine stores a curve between each pair of frames, the last one is unused
+    for frame in frames[:-1]:
+        curve = frame.get('curve')
+        if curve == 'stepped':
+            w.byte(CURVE_STEPPED)
+        elif isinstance(curve, list):
+            w.byte(CURVE_BEZIER)
+            for value in curve[:4]:
+                w.float(value)
+        else:
+            w.byte(CURVE_LINEAR)
+
+
+def writeTimeline(w, timelineType, index, frames):
+    if not frames:
+        raise ConvertError("empty timeline")
+    w.byte(timelineType)
+    w.varint(index)
+    w.varint(len(frames))
+    for frame in frames:
+        w.float(frame.get('time', 0))
+        if timelineType == TIMELINE_ROTATE:
+            w.float(frame.get('angle', 0))
+        elif timelineType == TIMELINE_COLOR:
+            w.color(frame.get('color'))
+        elif timelineType == TIMELINE_ATTACHMENT:
+            w.string(frame.get('name'))
+        else:
+            w.float(frame.get('x', 0))
+            w.float(frame.get('y', 0))
+    if timelineType != TIMELINE_ATTACHMENT:
+        writeCurves(w, frames)
+
+
+def convert(root):
+    w = Writer()
+    w.out += MAGIC
+    w.byte(VERSION)
+
+    bones = root.get('bones', [])
+    w.varint(len(bones))
+    for i, bone in enumerate(bones):
+        w.string(bone['name'])
+        parent = bone.get('parent')
+        w.varint(indexByName(bones[:i], parent, "Parent bone") + 1 if parent else 0)
+        w.float(bone.get('length', 0))
+        w.float(bone.get('x', 0))
+        w.float(bone.get('y', 0))
+        w.float(bone.get('rotation', 0))
+        w.float(bone.get('scaleX', 1))
+        w.float(bone.get('scaleY', 1))
+
+    slots = root.get('slots', [])
+    w.varint(len(slots))
+    for slot in slots:
+        w.string(slot['name'])
+        w.varint(indexByName(bones, slot['bone'], "Slot bone"))
+        w.color(slot.get('color'))
+        w.string(slot.get('attachment'))
+
+    skins = root.get('skins', {})
+    w.varint(len(skins))
+    for skinName, skinSlots in skins.items():
+        w.string(skinName)
+        w.varint(len(skinSlots))
+        for slotName, attachments in skinSlots.items():
+            w.varint(indexByName(slots, slotName, "Skin slot"))
+            w.varint(len(attachments))
+            for skinAttachmentName, attachment in attachments.items():
+                w.string(skinAttachmentName)
+                w.string(attachment.get('name'))
+                typeName = attachment.get('type', 'region')
+                if typeName not in ATTACHMENT_TYPES:
+                    raise ConvertError("Unknown attachment type: %s" % typeName)
+                w.byte(ATTACHMENT_TYPES[typeName])
+                w.float(attachment.get('x', 0))
+                w.float(attachment.get('y', 0))
+                w.float(attachment.get('scaleX', 1))
+                w.float(attachment.get('scaleY', 1))
+                w.float(attachment.get('rotation', 0))
+                w.float(attachment.get('width', 32))
+                w.float(attachment.get('height', 32))
+
+    animations = root.get('animations', {})
+    w.varint(len(animations))
+    for animationName, animation in animations.items():
+        w.string(animationName)
+        timelines = []
+        for boneName, boneTimelines in animation.get('bones', {}).items():
+            boneIndex = indexByName(bones, boneName, "Bone")
+            for timelineName, frames in boneTimelines.items():
+                types = {'rotate': TIMELINE_ROTATE, 'translate': TIMELINE_TRANSLATE, 'scale': TIMELINE_SCALE}
+                if timelineName not in types:
+                    raise ConvertError("Invalid timeline type for a bone: %s" % timelineName)
+                timelines.append((types[timelineName], boneIndex, frames))
+        for slotName, slotTimelines in animation.get('slots', {}).items():
+            slotIndex = indexByName(slots, slotName, "Slot")
+            for timelineName, frames in slotTimelines.items():
+                types = {'color': TIMELINE_COLOR, 'attachment': TIMELINE_ATTACHMENT}
+                if timelineName not in types:
+                    raise ConvertError("Invalid timeline type for a slot: %s" % timelineName)
+                timelines.append((types[timelineName], slotIndex, frames))
+        w.varint(len(timelines))
+        for timelineType, index, frames in timelines:
+            writeTimeline(w, timelineType, index, frames)
+
+    return w.out
+
+
+def dumpUsage():
+    print("Usage: spine_binary.py INPUT [OUTPUT]")
+    print("")
+    print("Converts a spine JSON skeleton, OUTPUT defaults to INPUT with the .skb extension.")
+    print("")
+    print("Sample: ./spine_binary.py spineboy.json spineboy.skb")
+    print("")
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        dumpUsage()
+        return 1
+
+    inputPath = sys.argv[1]
+    outputPath = sys.argv[2] if len(sys.argv) == 3 else os.path.splitext(inputPath)[0] + '.skb'
+
+    # keep the key order of the file, the engine adds skins, timelines and attachments in that order
+    with open(inputPath, 'rb') as f:
+        root = json.loads(f.read().decode('utf-8'), object_pairs_hook=OrderedDict)
+
+    try:
+        data = convert(root)
+    except ConvertError as e:
+        print("%s: %s" % (inputPath, e), file=sys.stderr)
+        return 1
+
+    with open(outputPath, 'wb') as f:
+        f.write(data)
+    print("%s: %d bytes -> %s: %d bytes" % (inputPath, os.path.getsize(inputPath), outputPath, len(data)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,157 @@
+#!/usr/bin/python
+# server.py
+# Local websocket echo server, used to measure the round trip latency of the WebSocket extension
+# Copyright (c) 2013 cocos2d-x.org
+#
+# Every text or binary message is sent back as is:
+#
+#   ws://localhost:8081/
+#
+# Only the parts of RFC 6455 the client needs are implemented: the opening
+# handshake, masked client frames, ping and close. Extensions are declined.
+
+from __future__ import print_function
+
+import base64
+import hashlib
+import socket
+import struct
+import sys
+import threading
+
+WS_GUID = b'258EAFA5-E914-47DA-95CA-C5AB0DC85B11'
+
+OPCODE_CONTINUATION = 0x0
+OPCODE_CLOSE = 0x8
+OPCODE_PING = 0x9
+OPCODE_PONG = 0xa
+
+
+def dumpUsage():
+    print("Usage: server.py [-port PORT]")
+    print("Options:")
+    print("  -port   port to listen on, 8081 by default")
+    print("")
+
+
+def readExactly(sock, size):
+    data = b''
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise EOFError()
+        data += chunk
+    return data
+
+
+def handshake(sock):
+    request = b''
+    while b'\r\n\r\n' not in request:
+        chunk = sock.recv(4096)
+        if not chunk:
+            raise EOFError()
+        request += chunk
+
+    headers = {}
+    for line in request.split(b'\r\n')[1:]:
+        if b':' in line:
+            name, value = line.split(b':', 1)
+            headers[name.strip().lower()] = value.strip()
+
+    accept = base64.b64encode(hashlib.sha1(headers[b'sec-websocket-key'] + WS_GUID).digest())
+    response = [b'HTTP/1.1 101 Switching Protocols',
+                b'Upgrade: websocket',
+                b'Connection: Upgrade',
+                b'Sec-WebSocket-Accept: ' + accept]
+    protocols = headers.get(b'sec-websocket-protocol')
+    if protocols:
+        # the client expects one of the protocols it asked for
+        response.append(b'Sec-WebSocket-Protocol: ' + protocols.split(b',')[0].strip())
+    sock.sendall(b'\r\n'.join(response) + b'\r\n\r\n')
+
+
+def readFrame(sock):
+    first, second = struct.unpack('!BB', readExactly(sock, 2))
+    fin = first & 0x80
+    opcode = first & 0x0f
+    length = second & 0x7f
+    if length == 126:
+        length = struct.unpack('!H', readExactly(sock, 2))[0]
+    elif length == 127:
+        length = struct.unpack('!Q', readExactly(sock, 8))[0]
+    mask = readExactly(sock, 4) if second & 0x80 else None
+    payload = bytearray(readExactly(sock, length))
+    if mask:
+        for i in range(length):
+            payload[i] ^= ord(mask[i % 4:i % 4 + 1])
+    return fin, opcode, bytes(payload)
+
+
+def writeFrame(sock, fin, opcode, payload):
+    header = struct.pack('!B', (0x80 if fin else 0) | opcode)
+    length = len(payload)
+    if length < 126:
+        header += struct.pack('!B', length)
+    elif length < 65536:
+        header += struct.pack('!BH', 126, length)
+    else:
+        header += struct.pack('!BQ', 127, length)
+    sock.sendall(header + payload)
+
+
+def serve(sock, address):
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    messages = 0
+    try:
+        handshake(sock)
+        while True:
+            fin, opcode, payload = readFrame(sock)
+            if opcode == OPCODE_CLOSE:
+                writeFrame(sock, True, OPCODE_CLOSE, payload[:2])
+                break
+            if opcode == OPCODE_PING:
+                writeFrame(sock, True, OPCODE_PONG, payload)
+                continue
+            if opcode == OPCODE_PONG:
+                continue
+            # fragments are echoed one by one, with their own opcode and fin bit
+            writeFrame(sock, fin, opcode, payload)
+            if fin:
+                messages += 1
+    except (EOFError, socket.error, KeyError):
+        pass
+    finally:
+        sock.close()
+    print("%s:%d disconnected after %d messages" % (address[0], address[1], messages))
+
+
+def main(argv):
+    port = 8081
+    i = 0
+    while i < len(argv):
+        if argv[i] == '-port' and i + 1 < len(argv):
+            i += 1
+            port = int(argv[i])
+        else:
+            dumpUsage()
+            return 1
+        i += 1
+
+    listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    listener.bind(('', port))
+    listener.listen(16)
+    print("Listening on ws://localhost:%d/" % port)
+    try:
+        while True:
+            sock, address = listener.accept()
+            thread = threading.Thread(target=serve, args=(sock, address))
+            thread.daemon = True
+            thread.start()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))